@@ -14,6 +14,8 @@
 #include <zephyr/types.h>
 
 #include <user_settings_list.h>
+#include <user_settings_stats.h>
+#include <user_settings_trace.h>
 #include <user_settings_protocol_types.h>
 
 #include <user_settings_protocol_binary.h>
@@ -62,19 +64,28 @@ static ssize_t prv_on_receive_write(struct bt_conn *conn, const struct bt_gatt_a
 {
 	LOG_DBG("Received data, handle %d, conn %p", attr->handle, (void *)conn);
 
-	/* decode and execute */
-	int err =
-		usp_executor_parse_and_execute(&prv_usp_binary_executor, (uint8_t *)buf, len, NULL);
+	int err;
+	if (IS_ENABLED(CONFIG_USER_SETTINGS_BT_SERVICE_ASYNC)) {
+		/* decode here, execute in the executor thread */
+		err = usp_executor_async_submit(&prv_usp_binary_executor, (uint8_t *)buf, len,
+						NULL);
+	} else {
+		/* decode and execute */
+		err = usp_executor_parse_and_execute(&prv_usp_binary_executor, (uint8_t *)buf, len,
+						     NULL);
+	}
 	if (!err) {
 		return len;
 	}
 
-	LOG_DBG("usp_executor_parse_and_execute, err: %d", err);
+	LOG_DBG("Executing command failed, err: %d", err);
 	switch (err) {
 	case -ENOENT:
 		return BT_GATT_ERR(BT_ATT_ERR_ATTRIBUTE_NOT_FOUND);
 	case -EPROTO:
 		return BT_GATT_ERR(BT_ATT_ERR_NOT_SUPPORTED);
+	case -EBUSY:
+		return BT_GATT_ERR(BT_ATT_ERR_PREPARE_QUEUE_FULL);
 	default:
 		return BT_GATT_ERR(BT_ATT_ERR_UNLIKELY);
 	}
@@ -84,7 +95,8 @@ static ssize_t prv_on_receive_write(struct bt_conn *conn, const struct bt_gatt_a
 BT_GATT_SERVICE_DEFINE(prv_uss_service,
 	BT_GATT_PRIMARY_SERVICE(BT_UUID_USS_SERVICE),
 	BT_GATT_CHARACTERISTIC(BT_UUID_USS_CHAR,
-			       BT_GATT_CHRC_NOTIFY | BT_GATT_CHRC_WRITE,
+			       BT_GATT_CHRC_NOTIFY | BT_GATT_CHRC_WRITE |
+			       BT_GATT_CHRC_WRITE_WITHOUT_RESP,
 			       BT_GATT_PERM_WRITE, NULL, prv_on_receive_write, NULL),
 	BT_GATT_CCC(NULL, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
 );
@@ -115,11 +127,15 @@ static int prv_send_notification(uint8_t *data, size_t len, void *user_data)
 	const struct bt_gatt_attr *attr = &prv_uss_service.attrs[2];
 
 	if (!bt_gatt_is_subscribed(prv_bt_conn, attr, BT_GATT_CCC_NOTIFY)) {
+		USER_SETTINGS_STATS_INC(bt_notify_fail);
 		return -ENOTCONN;
 	}
 
+	USER_SETTINGS_TRACE_ENTER("bt_notify", len);
 	ret = bt_gatt_notify(prv_bt_conn, attr, data, len);
+	USER_SETTINGS_TRACE_EXIT("bt_notify", len, ret);
 	if (ret < 0) {
+		USER_SETTINGS_STATS_INC(bt_notify_fail);
 		return -EIO;
 	}
 
@@ -16,6 +16,16 @@
  * - BT_ATT_ERR_NOT_SUPPORTED (0x06) if the command could not be parsed
  * - BT_ATT_ERR_UNLIKELY (0x0e) if notification response could not be sent or if some other error
  *  occurred
+ * - BT_ATT_ERR_PREPARE_QUEUE_FULL (0x09) if CONFIG_USER_SETTINGS_BT_SERVICE_ASYNC is enabled and
+ *  the command queue is full. The command can be retried later.
+ *
+ * With CONFIG_USER_SETTINGS_BT_SERVICE_ASYNC, commands are executed after the write has been
+ * acknowledged, so only decoding errors and a full queue are reported as ATT errors.
+ *
+ * The characteristic also supports write without response. To send several commands per
+ * connection event without waiting for responses, set the sequence flag in the command type (see
+ * the binary protocol README). Each response then carries the sequence number of its command, and
+ * a final done response reports the result of the command.
  *
  * @par
  * COPYRIGHT NOTICE: (c) 2023 Irnas.  All rights reserved.
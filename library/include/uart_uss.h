@@ -0,0 +1,46 @@
+/** @file uart_uss.h
+ *
+ * @brief UART transport for user settings
+ *
+ * The service uses the binary user settings protocol over a UART line. Each command and each
+ * response is encoded with COBS (Consistent Overhead Byte Stuffing) and terminated with a 0x00
+ * byte, so frames can be found in the byte stream without a length field.
+ *
+ * Details on the binary protocol can be found in library/protocol/binary
+ *
+ * Received commands are executed in the system work queue. Commands that fail are logged, but no
+ * response is sent for them. Use sequence numbers (see the binary protocol README) to get the
+ * result of each command.
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2023 Irnas.  All rights reserved.
+ */
+
+#ifndef UART_USS_H
+#define UART_USS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <zephyr/device.h>
+
+/**
+ * @brief Start the UART service on a UART device
+ *
+ * The device must support the asynchronous UART API. The service takes over the device.
+ *
+ * @param[in] dev The UART device
+ *
+ * @retval 0 on success
+ * @retval -ENODEV if the device is not ready
+ * @retval -EALREADY if the service was already started
+ * @retval Other negative error code returned by the UART driver
+ */
+int uart_uss_init(const struct device *dev);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UART_USS_H */
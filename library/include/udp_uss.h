@@ -0,0 +1,45 @@
+/** @file udp_uss.h
+ *
+ * @brief UDP transport for user settings
+ *
+ * The service uses the binary user settings protocol over UDP. Each datagram received on the
+ * port is one command. Each response is sent back to the sender of the command as a separate
+ * datagram.
+ *
+ * Details on the binary protocol can be found in library/protocol/binary
+ *
+ * Commands that fail are logged, but no response is sent for them. Use sequence numbers (see the
+ * binary protocol README) to get the result of each command.
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2023 Irnas.  All rights reserved.
+ */
+
+#ifndef UDP_USS_H
+#define UDP_USS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <zephyr/types.h>
+
+/**
+ * @brief Start the UDP service
+ *
+ * Opens a UDP socket bound to @p port on all IPv4 addresses and starts a thread that executes
+ * the received commands.
+ *
+ * @param[in] port The UDP port to listen on
+ *
+ * @retval 0 on success
+ * @retval -EALREADY if the service was already started
+ * @retval Other negative error code if the socket could not be created or bound
+ */
+int udp_uss_init(uint16_t port);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UDP_USS_H */
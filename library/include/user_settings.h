@@ -61,6 +61,126 @@ void user_settings_add(uint16_t id, const char *key, enum user_setting_type type
 void user_settings_add_sized(uint16_t id, const char *key, enum user_setting_type type,
 			     size_t max_size);
 
+/**
+ * @brief Add a user setting with a compile-time default value
+ *
+ * Behaves the same as user_settings_add(), but the setting gets a default value that is
+ * referenced in place. No NVS record and no RAM copy is made for it, so it should be const data
+ * (i.e. a static const variable or a literal), which lives in flash.
+ *
+ * The default counts as set, so user_settings_set_default_with_*() returns -EALREADY for
+ * a different default, unless CONFIG_USER_SETTINGS_DEFAULT_OVERWRITE is enabled. A default
+ * set at runtime is stored to NVS as usual and replaces the compile-time default, also on
+ * later boots.
+ *
+ * Must be called before user_settings_load().
+ *
+ * @param[in] id The ID of the setting to add. Must be unique to all other settings
+ * @param[in] key The key of the setting to add. Must be unique to all other settings. The string
+ * behind the pointer must live for the lifetime of the program (should be static/hardcoded)
+ * @param[in] type The type of the setting to add
+ * @param[in] default_data The default value. Must live for the lifetime of the program
+ * @param[in] default_len The length of the default value (in bytes)
+ */
+void user_settings_add_with_default(uint16_t id, const char *key, enum user_setting_type type,
+				    const void *default_data, size_t default_len);
+
+/**
+ * @brief Add a user setting with unknown size and a compile-time default value
+ *
+ * Behaves the same as user_settings_add_with_default(), but should be used for the string and
+ * bytes type. For strings, @p default_len must include the NULL terminator.
+ *
+ * @param[in] id The ID of the setting to add. Must be unique to all other settings
+ * @param[in] key The key of the setting to add. Must be unique to all other settings. The string
+ * behind the pointer must live for the lifetime of the program (should be static/hardcoded)
+ * @param[in] type The type of the setting to add
+ * @param[in] max_size The maximum size of the value
+ * @param[in] default_data The default value. Must live for the lifetime of the program
+ * @param[in] default_len The length of the default value (in bytes)
+ */
+void user_settings_add_sized_with_default(uint16_t id, const char *key,
+					  enum user_setting_type type, size_t max_size,
+					  const void *default_data, size_t default_len);
+
+/**
+ * @brief Add an array setting
+ *
+ * An array holds @p count elements of @p elem_type, which must be a numeric or bool type. All
+ * elements are stored as one value, so related values need one list entry, one NVS record and
+ * one change notification. Values set with user_settings_set_with_*() must hold all elements,
+ * single elements can be changed with user_settings_set_elem_with_*().
+ *
+ * @param[in] id The ID of the setting to add. Must be unique to all other settings
+ * @param[in] key The key of the setting to add. Must be unique to all other settings. The string
+ * behind the pointer must live for the lifetime of the program (should be static/hardcoded)
+ * @param[in] elem_type The type of the elements
+ * @param[in] count The number of elements
+ */
+void user_settings_add_array(uint16_t id, const char *key, enum user_setting_type elem_type,
+			     size_t count);
+
+/**
+ * @brief Add an array setting with a compile-time default value
+ *
+ * Behaves the same as user_settings_add_array(), with a default value as described for
+ * user_settings_add_with_default(). The default value must hold all elements.
+ *
+ * @param[in] id The ID of the setting to add. Must be unique to all other settings
+ * @param[in] key The key of the setting to add. Must be unique to all other settings. The string
+ * behind the pointer must live for the lifetime of the program (should be static/hardcoded)
+ * @param[in] elem_type The type of the elements
+ * @param[in] count The number of elements
+ * @param[in] default_data The default value. Must live for the lifetime of the program
+ * @param[in] default_len The length of the default value (in bytes)
+ */
+void user_settings_add_array_with_default(uint16_t id, const char *key,
+					  enum user_setting_type elem_type, size_t count,
+					  const void *default_data, size_t default_len);
+
+/**
+ * @brief Add a record setting
+ *
+ * A record holds related values, usually the members of a struct of the application, described
+ * by a table of fields (see USER_SETTINGS_RECORD_FIELD()). All fields are stored as one value, so
+ * setting the whole record with user_settings_set_with_*() changes them together with one NVS
+ * record and one change notification, and the on change callbacks never see a half updated
+ * record. Values must hold all @p size bytes, single fields can be changed with
+ * user_settings_set_field_with_*(). The value can be copied into the struct with
+ * user_settings_read_with_*().
+ *
+ * The size of a record is limited to 255 bytes.
+ *
+ * @param[in] id The ID of the setting to add. Must be unique to all other settings
+ * @param[in] key The key of the setting to add. Must be unique to all other settings. The string
+ * behind the pointer must live for the lifetime of the program (should be static/hardcoded)
+ * @param[in] fields The fields of the record. Must live for the lifetime of the program
+ * @param[in] num_fields The number of fields
+ * @param[in] size The size of the record, i.e. sizeof() of the struct
+ */
+void user_settings_add_record(uint16_t id, const char *key,
+			      const struct user_settings_record_field *fields, size_t num_fields,
+			      size_t size);
+
+/**
+ * @brief Add a record setting with a compile-time default value
+ *
+ * Behaves the same as user_settings_add_record(), with a default value as described for
+ * user_settings_add_with_default(). The size of the record is @p default_len.
+ *
+ * @param[in] id The ID of the setting to add. Must be unique to all other settings
+ * @param[in] key The key of the setting to add. Must be unique to all other settings. The string
+ * behind the pointer must live for the lifetime of the program (should be static/hardcoded)
+ * @param[in] fields The fields of the record. Must live for the lifetime of the program
+ * @param[in] num_fields The number of fields
+ * @param[in] default_data The default value. Must live for the lifetime of the program
+ * @param[in] default_len The length of the default value, i.e. sizeof() of the struct
+ */
+void user_settings_add_record_with_default(uint16_t id, const char *key,
+					   const struct user_settings_record_field *fields,
+					   size_t num_fields, const void *default_data,
+					   size_t default_len);
+
 /**
  * @brief Load add setting values and default from NVS
  *
@@ -71,11 +191,24 @@ void user_settings_add_sized(uint16_t id, const char *key, enum user_setting_typ
  * If no default exists for a setting, its value's memory will be set to 0. It is recommended
  * that each setting has a default value to make reasoning about setting validity easier.
  *
+ * Each setting that has a stored value calls the on change callbacks while it is loaded, unless
+ * CONFIG_USER_SETTINGS_LOAD_QUIET is enabled. The callback set with
+ * user_settings_set_on_load_cb() is called once after all settings are loaded.
+ *
  * @retval 0 on success
  * @retval -EIO if loading values from NVS fails
  */
 int user_settings_load(void);
 
+/**
+ * @brief Set the callback that is called when user_settings_load() completes
+ *
+ * Must be called before user_settings_load(). See user_settings_on_load_t.
+ *
+ * @param[in] on_load_cb The callback function. NULL to disable the notification.
+ */
+void user_settings_set_on_load_cb(user_settings_on_load_t on_load_cb);
+
 /**
  * @brief Set the default value of a setting
  *
@@ -108,7 +241,9 @@ int user_settings_load(void);
  * CONFIG_USER_SETTINGS_DEFAULT_OVERWRITE=n.
  * @retval -ENOMEM if len is >= then the max_size specified when adding the setting with
  * user_settings_add() or user_settings_add_sized()
- * @retval -EIO if the setting value could not be stored to NVS
+ * @retval -EINVAL if the new default value is rejected by the constraints of the setting
+ * @retval -EIO if the setting value could not be stored to NVS or space for it could not be
+ * allocated
  */
 int user_settings_set_default_with_key(char *key, void *data, size_t len);
 
@@ -133,6 +268,10 @@ int user_settings_set_default_with_id(uint16_t id, void *data, size_t len);
  * This will reset all setting values to their defaults and store those to NVS.
  * If no default exists for a setting, the value remains unchanged.
  *
+ * Settings that already have their default value are not written, and keep their value and
+ * changed flag. The on change callbacks are called once for each restored setting, after all
+ * settings are restored. With CONFIG_USER_SETTINGS_RESTORE_DELETE, the stored values are deleted
+ * instead of overwritten and settings without a default are left without a value.
  */
 void user_settings_restore_defaults(void);
 
@@ -141,7 +280,8 @@ void user_settings_restore_defaults(void);
  *
  * This will reset key specific setting value to its default and store it to NVS.
  * If no default exists for a setting, the value is still deleted. Calls to
- * @user_settings_get_with_*() will return NULL.
+ * @user_settings_get_with_*() will return NULL. Nothing is written if the value is already the
+ * same as the default value.
  *
  * @param[in] key The key of the setting to set
  *
@@ -198,9 +338,14 @@ bool user_settings_exists_with_id(uint16_t id);
  * @param[in] data The default value
  * @param[in] len The length of the value (in bytes)
  *
+ * The value is checked against the constraints of the setting (see
+ * user_settings_set_range_with_key()) before anything is stored.
+ *
  * @retval 0 On success
  * @retval -ENOMEM If the new value is larger than the max_size
- * @retval -EIO if the setting value could not be stored to NVS
+ * @retval -EINVAL If the new value is rejected by the constraints of the setting
+ * @retval -EIO if the setting value could not be stored to NVS or space for it could not be
+ * allocated
  */
 int user_settings_set_with_key(char *key, void *data, size_t len);
 
@@ -310,6 +455,410 @@ void *user_settings_get_default_with_id(uint16_t id, size_t *len);
  */
 void user_settings_set_global_on_change_cb(user_settings_on_change_t on_change_cb);
 
+/**
+ * @brief Set the callback for batches of changed settings
+ *
+ * See user_settings_on_change_batch_t.
+ *
+ * @param[in] on_change_cb The callback function. NULL to disable the
+ * notification.
+ */
+void user_settings_set_batch_on_change_cb(user_settings_on_change_batch_t on_change_cb);
+
+/**
+ * @brief A subscription to changes of one or more settings
+ *
+ * The subscription is owned by the caller and must stay valid until it is unsubscribed. No memory
+ * is allocated for it. The fields are private, use user_settings_subscribe_*() to fill them in.
+ */
+struct user_settings_subscription {
+	/** @cond INTERNAL_HIDDEN */
+	sys_snode_t node;
+	user_settings_on_change_t cb;
+	/* The setting of a subscription to a single setting, NULL for the other kinds */
+	struct user_setting *setting;
+	uint16_t first_id;
+	uint16_t last_id;
+	/* The key prefix of a prefix subscription, NULL for the other kinds */
+	const char *prefix;
+	size_t prefix_len;
+	/** @endcond */
+};
+
+/**
+ * @brief Subscribe to changes of a single setting
+ *
+ * Unlike user_settings_set_on_change_cb_with_key(), any number of subscriptions can be added to a
+ * setting. The callback is called the same way as the on change callbacks.
+ *
+ * This will assert if no setting with the provided key exists.
+ *
+ * @param[in] sub The subscription. Must stay valid until user_settings_unsubscribe().
+ * @param[in] key The key of the setting
+ * @param[in] cb The callback
+ */
+void user_settings_subscribe_with_key(struct user_settings_subscription *sub, char *key,
+				      user_settings_on_change_t cb);
+
+/**
+ * @brief Subscribe to changes of a single setting
+ *
+ * See user_settings_subscribe_with_key()
+ *
+ * @param[in] sub The subscription. Must stay valid until user_settings_unsubscribe().
+ * @param[in] id The ID of the setting
+ * @param[in] cb The callback
+ */
+void user_settings_subscribe_with_id(struct user_settings_subscription *sub, uint16_t id,
+				     user_settings_on_change_t cb);
+
+/**
+ * @brief Subscribe to changes of all settings with an ID in a range
+ *
+ * Range and prefix subscriptions are checked on every change, so prefer single setting
+ * subscriptions when there are many subscribers.
+ *
+ * @param[in] sub The subscription. Must stay valid until user_settings_unsubscribe().
+ * @param[in] first_id The first ID of the range
+ * @param[in] last_id The last ID of the range (inclusive)
+ * @param[in] cb The callback
+ */
+void user_settings_subscribe_id_range(struct user_settings_subscription *sub, uint16_t first_id,
+				      uint16_t last_id, user_settings_on_change_t cb);
+
+/**
+ * @brief Subscribe to changes of all settings with a key that starts with a prefix
+ *
+ * See user_settings_subscribe_id_range()
+ *
+ * @param[in] sub The subscription. Must stay valid until user_settings_unsubscribe().
+ * @param[in] prefix The key prefix, i.e. "lte_". Must stay valid until the subscription is
+ * removed.
+ * @param[in] cb The callback
+ */
+void user_settings_subscribe_key_prefix(struct user_settings_subscription *sub,
+					const char *prefix, user_settings_on_change_t cb);
+
+/**
+ * @brief Remove a subscription
+ *
+ * Can be called from the callback of the subscription. Does nothing if @p sub is not subscribed.
+ *
+ * @param[in] sub The subscription
+ */
+void user_settings_unsubscribe(struct user_settings_subscription *sub);
+
+#if defined(CONFIG_USER_SETTINGS_NOTIFY_ASYNC)
+/**
+ * @brief Set the work queue that calls the on change callbacks
+ *
+ * By default, the callbacks are called from the system work queue. Use a dedicated work queue if
+ * the callbacks are slow or must run at another priority.
+ *
+ * @param[in] work_q The work queue. NULL to use the system work queue.
+ */
+void user_settings_set_notify_work_q(struct k_work_q *work_q);
+#endif
+
+/**
+ * @brief Copy the value of a setting into a buffer
+ *
+ * Copies the value, or the default value if no value is set. Unlike user_settings_get_with_key(),
+ * the value of a lazy setting that is not cached is read directly into @p buf, without going
+ * through the cache.
+ *
+ * This will assert if no setting with the provided key exists.
+ *
+ * @param[in] key The key of the setting to read
+ * @param[out] buf The buffer to copy the value into
+ * @param[in] len The length of the buffer
+ *
+ * @return The length of the value on success
+ * @retval -ENODATA if the setting has no value and no default value
+ * @retval -ENOMEM if the buffer is too small
+ * @retval -EIO if the value of a lazy setting could not be read
+ */
+int user_settings_read_with_key(char *key, void *buf, size_t len);
+
+/**
+ * @brief Copy the value of a setting into a buffer
+ *
+ * See user_settings_read_with_key()
+ *
+ * @param[in] id The ID of the setting to read
+ * @param[out] buf The buffer to copy the value into
+ * @param[in] len The length of the buffer
+ *
+ * @return See user_settings_read_with_key()
+ */
+int user_settings_read_with_id(uint16_t id, void *buf, size_t len);
+
+/**
+ * @brief Copy one element of an array setting into a buffer
+ *
+ * Copies from the value, or the default value if no value is set.
+ *
+ * This will assert if no setting with the provided key exists.
+ *
+ * @param[in] key The key of the setting to read
+ * @param[in] index The index of the element
+ * @param[out] buf The buffer to copy the element into
+ * @param[in] len The length of the buffer
+ *
+ * @return The size of the element on success
+ * @retval -EINVAL if the setting is not an array or @p index is out of range
+ * @retval -ENOMEM if the buffer is too small
+ * @retval -ENODATA if the setting has no value and no default value
+ */
+int user_settings_get_elem_with_key(char *key, size_t index, void *buf, size_t len);
+
+/**
+ * @brief Copy one element of an array setting into a buffer
+ *
+ * See user_settings_get_elem_with_key()
+ *
+ * @param[in] id The ID of the setting to read
+ * @param[in] index The index of the element
+ * @param[out] buf The buffer to copy the element into
+ * @param[in] len The length of the buffer
+ *
+ * @return See user_settings_get_elem_with_key()
+ */
+int user_settings_get_elem_with_id(uint16_t id, size_t index, void *buf, size_t len);
+
+/**
+ * @brief Set one element of an array setting
+ *
+ * The other elements keep their value, or the default value if no value is set (0 if neither
+ * exists). The settings backend stores whole values, so the array is written as one record and
+ * the on change callbacks are called once. Nothing is written if the element already has the new
+ * value. A buffer of the size of the array is allocated from the user settings heap while the
+ * new value is put together.
+ *
+ * This will assert if no setting with the provided key exists.
+ *
+ * @param[in] key The key of the setting to set
+ * @param[in] index The index of the element
+ * @param[in] data The new value of the element
+ * @param[in] len The length of the new value, must be the size of an element
+ *
+ * @retval 0 On success
+ * @retval -EINVAL if the setting is not an array, @p index is out of range, @p len is not the
+ * size of an element or the new value is rejected by the validator
+ * @retval -ENOMEM if the buffer could not be allocated
+ * @retval -EIO if the value could not be stored
+ */
+int user_settings_set_elem_with_key(char *key, size_t index, const void *data, size_t len);
+
+/**
+ * @brief Set one element of an array setting
+ *
+ * See user_settings_set_elem_with_key()
+ *
+ * @param[in] id The ID of the setting to set
+ * @param[in] index The index of the element
+ * @param[in] data The new value of the element
+ * @param[in] len The length of the new value, must be the size of an element
+ *
+ * @return See user_settings_set_elem_with_key()
+ */
+int user_settings_set_elem_with_id(uint16_t id, size_t index, const void *data, size_t len);
+
+/**
+ * @brief Copy one field of a record setting into a buffer
+ *
+ * Copies from the value, or the default value if no value is set.
+ *
+ * This will assert if no setting with the provided key exists.
+ *
+ * @param[in] key The key of the setting to read
+ * @param[in] name The name of the field
+ * @param[out] buf The buffer to copy the field into
+ * @param[in] len The length of the buffer
+ *
+ * @return The size of the field on success
+ * @retval -EINVAL if the setting is not a record or has no field @p name
+ * @retval -ENOMEM if the buffer is too small
+ * @retval -ENODATA if the setting has no value and no default value
+ */
+int user_settings_get_field_with_key(char *key, const char *name, void *buf, size_t len);
+
+/**
+ * @brief Copy one field of a record setting into a buffer
+ *
+ * See user_settings_get_field_with_key()
+ *
+ * @param[in] id The ID of the setting to read
+ * @param[in] name The name of the field
+ * @param[out] buf The buffer to copy the field into
+ * @param[in] len The length of the buffer
+ *
+ * @return See user_settings_get_field_with_key()
+ */
+int user_settings_get_field_with_id(uint16_t id, const char *name, void *buf, size_t len);
+
+/**
+ * @brief Set one field of a record setting
+ *
+ * Behaves the same as user_settings_set_elem_with_key(), for a field of a record. To change
+ * several fields together, set the whole record with user_settings_set_with_key() instead.
+ *
+ * This will assert if no setting with the provided key exists.
+ *
+ * @param[in] key The key of the setting to set
+ * @param[in] name The name of the field
+ * @param[in] data The new value of the field
+ * @param[in] len The length of the new value, must be the size of the field
+ *
+ * @retval 0 On success
+ * @retval -EINVAL if the setting is not a record, has no field @p name, @p len is not the size of
+ * the field or the new value is rejected by the validator
+ * @retval -ENOMEM if the buffer could not be allocated
+ * @retval -EIO if the value could not be stored
+ */
+int user_settings_set_field_with_key(char *key, const char *name, const void *data, size_t len);
+
+/**
+ * @brief Set one field of a record setting
+ *
+ * See user_settings_set_field_with_key()
+ *
+ * @param[in] id The ID of the setting to set
+ * @param[in] name The name of the field
+ * @param[in] data The new value of the field
+ * @param[in] len The length of the new value, must be the size of the field
+ *
+ * @return See user_settings_set_field_with_key()
+ */
+int user_settings_set_field_with_id(uint16_t id, const char *name, const void *data, size_t len);
+
+/**
+ * @brief Copy a part of the value of a string or bytes setting into a buffer
+ *
+ * Use this to read values that are larger than the buffers of the caller in chunks. Copies from
+ * the value, or the default value if no value is set.
+ *
+ * This will assert if no setting with the provided key exists.
+ *
+ * @param[in] key The key of the setting to read
+ * @param[in] offset The offset in the value to start reading at
+ * @param[out] buf The buffer to copy the chunk into
+ * @param[in] len The length of the buffer
+ *
+ * @return The number of bytes copied. 0 if @p offset is at or past the end of the value.
+ * @retval -EINVAL if the setting is not of the string or bytes type
+ * @retval -ENODATA if the setting has no value and no default value
+ * @retval -EIO if the value of a lazy setting could not be read
+ */
+int user_settings_read_at_with_key(char *key, size_t offset, void *buf, size_t len);
+
+/**
+ * @brief Copy a part of the value of a string or bytes setting into a buffer
+ *
+ * See user_settings_read_at_with_key()
+ *
+ * @param[in] id The ID of the setting to read
+ * @param[in] offset The offset in the value to start reading at
+ * @param[out] buf The buffer to copy the chunk into
+ * @param[in] len The length of the buffer
+ *
+ * @return See user_settings_read_at_with_key()
+ */
+int user_settings_read_at_with_id(uint16_t id, size_t offset, void *buf, size_t len);
+
+/**
+ * @brief Write a chunk of a new value of a string or bytes setting
+ *
+ * The chunks are collected in a buffer of the max size of the setting, allocated from the user
+ * settings heap. The new value is only stored by user_settings_write_commit_with_key(), so the
+ * old value stays valid while the chunks are written. Only one setting can be written in chunks
+ * at a time. Values of string settings must include the terminating NULL character.
+ *
+ * This will assert if no setting with the provided key exists.
+ *
+ * @param[in] key The key of the setting to write
+ * @param[in] offset The offset of the chunk in the value. A chunk at offset 0 starts a new write
+ * and discards any write in progress. Other chunks must directly follow the previous one.
+ * @param[in] data The chunk
+ * @param[in] len The length of the chunk
+ *
+ * @retval 0 On success
+ * @retval -EINVAL if the setting is not of the string or bytes type, or if @p offset does not
+ * follow the previous chunk of this setting
+ * @retval -ENOMEM if the value does not fit into the setting or the buffer could not be
+ * allocated. The write is discarded.
+ */
+int user_settings_write_at_with_key(char *key, size_t offset, const void *data, size_t len);
+
+/**
+ * @brief Write a chunk of a new value of a string or bytes setting
+ *
+ * See user_settings_write_at_with_key()
+ *
+ * @param[in] id The ID of the setting to write
+ * @param[in] offset The offset of the chunk in the value
+ * @param[in] data The chunk
+ * @param[in] len The length of the chunk
+ *
+ * @return See user_settings_write_at_with_key()
+ */
+int user_settings_write_at_with_id(uint16_t id, size_t offset, const void *data, size_t len);
+
+/**
+ * @brief Store the value written with user_settings_write_at_with_key()
+ *
+ * Behaves the same as user_settings_set_with_key() with the collected value. The collected value
+ * is discarded afterwards, also if storing it failed.
+ *
+ * This will assert if no setting with the provided key exists.
+ *
+ * @param[in] key The key of the setting
+ *
+ * @retval 0 On success
+ * @retval -EINVAL if no chunked write of this setting is in progress
+ * @retval -EIO if the value could not be stored
+ */
+int user_settings_write_commit_with_key(char *key);
+
+/**
+ * @brief Store the value written with user_settings_write_at_with_id()
+ *
+ * See user_settings_write_commit_with_key()
+ *
+ * @param[in] id The ID of the setting
+ *
+ * @return See user_settings_write_commit_with_key()
+ */
+int user_settings_write_commit_with_id(uint16_t id);
+
+/**
+ * @brief Mark a string or bytes setting lazy
+ *
+ * The value of a lazy setting is not read into RAM by user_settings_load(). It is read from NVS
+ * when it is needed and kept in a cache of CONFIG_USER_SETTINGS_LAZY_CACHE_ENTRIES values, where
+ * the least recently used value is dropped first. Use this for large values that are rarely
+ * read, i.e. certificates.
+ *
+ * A pointer returned by user_settings_get_with_key() for a lazy setting is only valid until
+ * another lazy value is fetched. Use user_settings_read_with_key() to read the value into a
+ * buffer of the caller instead.
+ *
+ * Must be called before user_settings_load(). Will assert if the setting does not exist or is
+ * not of the string or bytes type.
+ *
+ * @param[in] key The key of the setting
+ */
+void user_settings_set_lazy_with_key(char *key);
+
+/**
+ * @brief Mark a string or bytes setting lazy
+ *
+ * See user_settings_set_lazy_with_key()
+ *
+ * @param[in] id The ID of the setting
+ */
+void user_settings_set_lazy_with_id(uint16_t id);
+
 /**
  * @brief Set the on change callback for changes to a specific setting
  *
@@ -341,6 +890,134 @@ void user_settings_set_on_change_cb_with_key(char *key, user_settings_on_change_
  */
 void user_settings_set_on_change_cb_with_id(uint16_t id, user_settings_on_change_t on_change_cb);
 
+/**
+ * @brief Limit the values of an integer setting to a range
+ *
+ * Values that are smaller than @p min, larger than @p max or not @p min plus a multiple of
+ * @p step are rejected with -EINVAL by the set functions, before anything is stored. For the
+ * unsigned types, the bounds are compared as unsigned values. Values loaded from NVS and the
+ * default value given when the setting was added are not checked.
+ *
+ * The constraints are reported in the full binary protocol encoding (GET FULL), so clients can
+ * check values before sending them.
+ *
+ * Will assert if the setting does not exist, is not of an integer type or if @p max is smaller
+ * than @p min.
+ *
+ * @param[in] key The key of the setting
+ * @param[in] min The smallest allowed value
+ * @param[in] max The largest allowed value
+ * @param[in] step The step between allowed values, 0 or 1 to allow every value in the range
+ *
+ * @retval 0 on success
+ * @retval -ENOMEM if the constraints could not be allocated from the user settings heap
+ */
+int user_settings_set_range_with_key(char *key, int64_t min, int64_t max, uint64_t step);
+
+/**
+ * @brief Limit the values of an integer setting to a range
+ *
+ * See user_settings_set_range_with_key()
+ *
+ * @param[in] id The ID of the setting
+ * @param[in] min The smallest allowed value
+ * @param[in] max The largest allowed value
+ * @param[in] step The step between allowed values, 0 or 1 to allow every value in the range
+ *
+ * @return See user_settings_set_range_with_key()
+ */
+int user_settings_set_range_with_id(uint16_t id, int64_t min, int64_t max, uint64_t step);
+
+/**
+ * @brief Limit the values of an integer setting to a list of allowed values
+ *
+ * Other values are rejected with -EINVAL by the set functions, like with
+ * user_settings_set_range_with_key(). If a range is also set, a value must satisfy both.
+ *
+ * Will assert if the setting does not exist, is not of an integer type or if @p count is not
+ * between 1 and 255.
+ *
+ * @param[in] key The key of the setting
+ * @param[in] values The allowed values. The array is not copied and must stay valid. NULL to
+ * allow any value again.
+ * @param[in] count The number of values
+ *
+ * @retval 0 on success
+ * @retval -ENOMEM if the constraints could not be allocated from the user settings heap
+ */
+int user_settings_set_enum_with_key(char *key, const int64_t *values, size_t count);
+
+/**
+ * @brief Limit the values of an integer setting to a list of allowed values
+ *
+ * See user_settings_set_enum_with_key()
+ *
+ * @param[in] id The ID of the setting
+ * @param[in] values The allowed values. The array is not copied and must stay valid. NULL to
+ * allow any value again.
+ * @param[in] count The number of values
+ *
+ * @return See user_settings_set_enum_with_key()
+ */
+int user_settings_set_enum_with_id(uint16_t id, const int64_t *values, size_t count);
+
+/**
+ * @brief Set a callback that validates new values of a setting
+ *
+ * The callback is called by the set functions after the range and enum constraints passed,
+ * before anything is stored. Values it rejects are not stored and the set functions return
+ * -EINVAL. It can be set for settings of any type.
+ *
+ * Will assert if the setting does not exist.
+ *
+ * @param[in] key The key of the setting
+ * @param[in] validator The callback. NULL to remove it.
+ *
+ * @retval 0 on success
+ * @retval -ENOMEM if the constraints could not be allocated from the user settings heap
+ */
+int user_settings_set_validator_with_key(char *key, user_settings_validator_t validator);
+
+/**
+ * @brief Set a callback that validates new values of a setting
+ *
+ * See user_settings_set_validator_with_key()
+ *
+ * @param[in] id The ID of the setting
+ * @param[in] validator The callback. NULL to remove it.
+ *
+ * @return See user_settings_set_validator_with_key()
+ */
+int user_settings_set_validator_with_id(uint16_t id, user_settings_validator_t validator);
+
+/**
+ * @brief Check a value against the constraints of a setting without setting it
+ *
+ * Will assert if the setting does not exist.
+ *
+ * @param[in] key The key of the setting
+ * @param[in] data The value to check
+ * @param[in] len The length of the value (in bytes)
+ *
+ * @retval 0 if the value would be accepted
+ * @retval -ENOMEM if the value is larger than the max_size
+ * @retval -EINVAL if the value is rejected by the constraints of the setting
+ */
+int user_settings_validate_with_key(char *key, const void *data, size_t len);
+
+/**
+ * @brief Check a value against the constraints of a setting without setting it
+ *
+ * See user_settings_validate_with_key()
+ *
+ * @param[in] id The ID of the setting
+ * @param[in] data The value to check
+ * @param[in] len The length of the value (in bytes)
+ *
+ * @return See user_settings_validate_with_key()
+ */
+int user_settings_validate_with_id(uint16_t id, const void *data, size_t len);
+
 /**
  * @brief Check if a setting has its value set
  *
@@ -481,6 +1158,55 @@ enum user_setting_type user_settings_get_type_with_key(char *key);
  */
 enum user_setting_type user_settings_get_type_with_id(uint16_t id);
 
+/**
+ * @brief Get the type of the elements of an array setting
+ *
+ * This will assert if no setting with the provided key exists or if it is not an array. The
+ * number of elements is the max length of the setting divided by the size of this type.
+ *
+ * @param[in] key A valid user setting key
+ *
+ * @return The type of the elements.
+ */
+enum user_setting_type user_settings_get_elem_type_with_key(char *key);
+
+/**
+ * @brief Get the type of the elements of an array setting
+ *
+ * See user_settings_get_elem_type_with_key()
+ *
+ * @param[in] id A valid user setting id
+ *
+ * @return The type of the elements.
+ */
+enum user_setting_type user_settings_get_elem_type_with_id(uint16_t id);
+
+/**
+ * @brief Get the fields of a record setting
+ *
+ * This will assert if no setting with the provided key exists or if it is not a record.
+ *
+ * @param[in] key A valid user setting key
+ * @param[out] num_fields The number of fields
+ *
+ * @return The table of fields the record was added with.
+ */
+const struct user_settings_record_field *user_settings_get_record_fields_with_key(char *key,
+										  size_t *num_fields);
+
+/**
+ * @brief Get the fields of a record setting
+ *
+ * See user_settings_get_record_fields_with_key()
+ *
+ * @param[in] id A valid user setting id
+ * @param[out] num_fields The number of fields
+ *
+ * @return The table of fields the record was added with.
+ */
+const struct user_settings_record_field *user_settings_get_record_fields_with_id(uint16_t id,
+										 size_t *num_fields);
+
 /**
  * @brief Start iteration over all user settings
  *
@@ -502,7 +1228,10 @@ bool user_settings_iter_next(char **key, uint16_t *id);
 /**
  * @brief Get next settings ID and KEY in the iteration
  *
- * Only returns settings with a set changed flag.
+ * Only returns settings with a set changed flag. Only the changed settings are visited, in the
+ * order in which they were marked changed, not in the order they were added. The changed flag of
+ * any setting, including the one just returned, can be cleared during the iteration. Settings
+ * whose flag is cleared before they are reached are skipped.
  *
  * @param[out] key The key of the next changed settings.
  * @param[out] id The ID of the next changed settings.
@@ -568,6 +1297,184 @@ void user_settings_clear_changed(void);
  */
 bool user_settings_any_changed(void);
 
+/* Forward declaration of an internal user setting representation */
+struct user_setting;
+
+/**
+ * @brief Position in a binary blob exported in chunks
+ *
+ * Zero initialize it before the first chunk. Only offset may be read, the other fields are
+ * private. The position and the running CRC are kept in the struct, so each chunk only encodes
+ * what follows it.
+ */
+struct user_settings_export_cursor {
+	/** The number of bytes of the blob already written */
+	size_t offset;
+	/** The setting whose record is written next (private) */
+	struct user_setting *setting;
+	/** The number of bytes of the current part of the blob already written (private) */
+	size_t part_offset;
+	/** The total length of the blob (private) */
+	uint32_t total_len;
+	/** The CRC of the bytes already written (private) */
+	uint32_t crc;
+	/** The number of records in the blob (private) */
+	uint16_t count;
+	/** The part of the blob that is written next (private) */
+	uint8_t state;
+};
+
+/**
+ * @brief Export all settings into a compact binary blob, one chunk at a time.
+ *
+ * The blob contains the value, the default value and the changed flag of every setting and ends
+ * with a CRC32. It can be applied to another device with the same settings with
+ * user_settings_import_binary(). Use it like user_settings_json_write_all():
+ *
+ *	struct user_settings_export_cursor cursor = {0};
+ *	int len;
+ *	while ((len = user_settings_export_binary(buf, sizeof(buf), &cursor)) > 0) {
+ *		send(buf, len);
+ *	}
+ *
+ * Settings should not be changed until the whole blob has been written. After an error the export
+ * must be started again with a zero initialized cursor.
+ *
+ * @param[out] buf The buffer to write the next chunk into
+ * @param[in] len The length of the buffer
+ * @param[in,out] cursor The position in the blob. Must be zero initialized for the first chunk.
+ * Its offset is advanced by the number of bytes written.
+ *
+ * @return The number of bytes written into @p buf. 0 if the whole blob was already written.
+ * @retval -EINVAL if @p buf is NULL or @p len is 0
+ * @retval -EIO if the value of a lazy setting could not be read
+ */
+int user_settings_export_binary(uint8_t *buf, size_t len,
+				struct user_settings_export_cursor *cursor);
+
+/**
+ * @brief Import a blob created with user_settings_export_binary()
+ *
+ * The CRC and all records are validated before anything is stored, so an invalid blob does not
+ * change any setting. Only values, defaults and changed flags that differ from the current ones
+ * are written. Settings that have no value in the blob are reset to their default value. Defaults
+ * that are not in the blob are kept.
+ *
+ * The settings backend has no transactions over multiple keys. The current settings are exported
+ * into a temporary buffer first, and if storing fails midway, the settings already stored are
+ * rolled back to it before -EIO is returned. Defaults that did not exist before the import are
+ * deleted again. The on change callbacks are called after the import, for every setting that
+ * was written.
+ *
+ * The temporary buffer is allocated from the settings heap and is as large as an export of all
+ * current settings, so CONFIG_USER_SETTINGS_HEAP_SIZE must leave that much space free.
+ *
+ * @param[in] blob The blob
+ * @param[in] len The length of the blob
+ *
+ * @retval 0 On success
+ * @retval -EINVAL if the blob is malformed, the CRC does not match or a value is rejected by the
+ * constraints of its setting
+ * @retval -ENOENT if the blob contains a setting ID that does not exist or has another type
+ * @retval -ENOMEM if a value in the blob is larger than the max size of its setting
+ * @retval -EALREADY if a setting already has a different default and
+ * CONFIG_USER_SETTINGS_DEFAULT_OVERWRITE is disabled
+ * @retval -ENOMEM if the current settings do not fit into the heap for the rollback
+ * @retval -EIO if a value could not be stored to NVS
+ */
+int user_settings_import_binary(const uint8_t *blob, size_t len);
+
+/**
+ * @brief Collect a chunk of a blob to import with user_settings_import_binary_commit()
+ *
+ * The blob is collected in a static buffer of CONFIG_USER_SETTINGS_IMPORT_BUF_SIZE bytes.
+ *
+ * @param[in] offset The offset of the chunk in the blob. A chunk at offset 0 starts a new import.
+ * Other chunks must directly follow the previous one.
+ * @param[in] data The chunk
+ * @param[in] len The length of the chunk
+ *
+ * @retval 0 On success
+ * @retval -EINVAL if @p offset does not follow the previous chunk
+ * @retval -ENOMEM if the blob does not fit into the buffer. The import is discarded.
+ * @retval -ENOTSUP if CONFIG_USER_SETTINGS_IMPORT_BUF_SIZE is 0
+ */
+int user_settings_import_binary_chunk(size_t offset, const uint8_t *data, size_t len);
+
+/**
+ * @brief Import the blob collected with user_settings_import_binary_chunk()
+ *
+ * The collected blob is discarded afterwards, also if importing it failed.
+ *
+ * @return See user_settings_import_binary()
+ * @retval -ENOTSUP if CONFIG_USER_SETTINGS_IMPORT_BUF_SIZE is 0
+ */
+int user_settings_import_binary_commit(void);
+
+/**
+ * @brief Get the flash write counters of a setting
+ *
+ * The counters are kept with CONFIG_USER_SETTINGS_WEAR_STATS. Every record written to or deleted
+ * from NVS for the value, the default value or the changed flag of the setting is counted. Sets
+ * that are skipped because the value did not change are counted separately.
+ *
+ * This will assert if the key does not exist.
+ *
+ * @param[in] key A valid user setting key
+ * @param[out] stats The counters
+ *
+ * @retval 0 On success
+ * @retval -ENOTSUP if CONFIG_USER_SETTINGS_WEAR_STATS is disabled
+ */
+int user_settings_get_wear_stats_with_key(char *key, struct user_settings_wear_stats *stats);
+
+/**
+ * @brief Get the flash write counters of a setting
+ *
+ * Same as user_settings_get_wear_stats_with_key(). This will assert if the ID does not exist.
+ *
+ * @param[in] id A valid user setting ID
+ * @param[out] stats The counters
+ *
+ * @retval 0 On success
+ * @retval -ENOTSUP if CONFIG_USER_SETTINGS_WEAR_STATS is disabled
+ */
+int user_settings_get_wear_stats_with_id(uint16_t id, struct user_settings_wear_stats *stats);
+
+/**
+ * @brief Get the sums of the flash write counters of all settings and the write rate
+ *
+ * The write rate is the average since boot.
+ *
+ * @param[out] totals The totals
+ *
+ * @retval 0 On success
+ * @retval -ENOTSUP if CONFIG_USER_SETTINGS_WEAR_STATS is disabled
+ */
+int user_settings_get_wear_totals(struct user_settings_wear_totals *totals);
+
+/**
+ * @brief Store the flash write counters to NVS
+ *
+ * Only the counters of settings that were written since they were last stored are written.
+ * Skipped sets are stored along with them. Call this before a planned reboot, so no counts are
+ * lost.
+ *
+ * @retval 0 On success
+ * @retval -ENOTSUP if CONFIG_USER_SETTINGS_WEAR_STATS_PERSIST is disabled
+ * @retval -EIO if the counters could not be stored
+ */
+int user_settings_save_wear_stats(void);
+
+/**
+ * @brief Reset the flash write counters of all settings and delete the stored counters
+ *
+ * @retval 0 On success
+ * @retval -ENOTSUP if CONFIG_USER_SETTINGS_WEAR_STATS is disabled
+ * @retval -EIO if the stored counters could not be deleted
+ */
+int user_settings_reset_wear_stats(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,169 @@
+/** @file user_settings_cron.h
+ *
+ * @brief Schedules of cron job settings
+ *
+ * The value of a cron job setting is the string "mm-hh-dd" (minute, hour and day of the week,
+ * day 0 is Sunday). Each field is either a two digit number or "**", which matches every value of
+ * the field. Values are validated when they are set, and the library keeps the parsed form of
+ * each cron job setting in RAM, so consumers do not have to parse the strings again.
+ *
+ * The next fire times of all cron job settings are kept in a min-heap, which is updated whenever
+ * a cron job setting changes. A scheduler can then call user_settings_cron_peek() to find out
+ * how long to sleep, and user_settings_cron_pop() to take the jobs that are due.
+ *
+ * All times are UTC, in seconds since the Unix epoch.
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2023 Irnas.  All rights reserved.
+ */
+
+#ifndef USER_SETTINGS_CRON_H
+#define USER_SETTINGS_CRON_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief A parsed cron job schedule
+ *
+ * Bit n of each field is set if the job runs at value n of that field.
+ */
+struct user_settings_cron {
+	/** Minutes of the hour, 0 - 59 */
+	uint64_t minutes;
+	/** Hours of the day, 0 - 23 */
+	uint32_t hours;
+	/** Days of the week, 0 (Sunday) - 6 */
+	uint8_t days_of_week;
+};
+
+/**
+ * @brief Parse a cron job string
+ *
+ * @param[in] str The string, in the "mm-hh-dd" format. It does not have to be NULL terminated.
+ * @param[in] len The length of @p str, 8, or 9 if the NULL terminator is included
+ * @param[out] cron The parsed schedule
+ *
+ * @retval 0 On success
+ * @retval -EINVAL if @p str is not a valid cron job string
+ */
+int user_settings_cron_parse(const char *str, size_t len, struct user_settings_cron *cron);
+
+/**
+ * @brief Get the next time a schedule fires
+ *
+ * @param[in] cron The schedule
+ * @param[in] now The current time
+ * @param[out] next The start of the first minute after @p now that matches the schedule
+ *
+ * @retval 0 On success
+ * @retval -EINVAL if @p now is negative or the schedule never fires
+ */
+int user_settings_cron_next(const struct user_settings_cron *cron, int64_t now, int64_t *next);
+
+/**
+ * @brief Get the parsed schedule of a cron job setting
+ *
+ * This will assert if the key does not exist or the setting is not a cron job.
+ *
+ * @param[in] key A valid user setting key
+ * @param[out] cron The schedule
+ *
+ * @retval 0 On success
+ * @retval -ENODATA if the setting has no value and no default
+ */
+int user_settings_get_cron_with_key(char *key, struct user_settings_cron *cron);
+
+/**
+ * @brief Get the parsed schedule of a cron job setting
+ *
+ * Same as user_settings_get_cron_with_key(). This will assert if the ID does not exist or the
+ * setting is not a cron job.
+ *
+ * @param[in] id A valid user setting ID
+ * @param[out] cron The schedule
+ *
+ * @retval 0 On success
+ * @retval -ENODATA if the setting has no value and no default
+ */
+int user_settings_get_cron_with_id(uint16_t id, struct user_settings_cron *cron);
+
+/**
+ * @brief Get the next time a cron job setting fires
+ *
+ * This will assert if the key does not exist or the setting is not a cron job.
+ *
+ * @param[in] key A valid user setting key
+ * @param[in] now The current time
+ * @param[out] next The start of the first minute after @p now that matches the setting
+ *
+ * @retval 0 On success
+ * @retval -ENODATA if the setting has no value and no default
+ * @retval -EINVAL if @p now is negative
+ */
+int user_settings_cron_next_with_key(char *key, int64_t now, int64_t *next);
+
+/**
+ * @brief Get the next time a cron job setting fires
+ *
+ * Same as user_settings_cron_next_with_key(). This will assert if the ID does not exist or the
+ * setting is not a cron job.
+ *
+ * @param[in] id A valid user setting ID
+ * @param[in] now The current time
+ * @param[out] next The start of the first minute after @p now that matches the setting
+ *
+ * @retval 0 On success
+ * @retval -ENODATA if the setting has no value and no default
+ * @retval -EINVAL if @p now is negative
+ */
+int user_settings_cron_next_with_id(uint16_t id, int64_t now, int64_t *next);
+
+/**
+ * @brief Get the cron job setting that fires first
+ *
+ * The first call builds the heap of next fire times after @p now. Settings that change later
+ * are rescheduled after the time of the change, which is estimated from @p now of the last call
+ * of this function or user_settings_cron_pop() and the system uptime.
+ *
+ * This must be called after user_settings_load().
+ *
+ * @param[in] now The current time
+ * @param[out] id The ID of the setting
+ * @param[out] next When the setting fires. This is <= @p now if it is due.
+ *
+ * @retval 0 On success
+ * @retval -ENODATA if no cron job setting has a value or default
+ * @retval -ENOMEM if the heap could not be allocated
+ * @retval -EINVAL if @p now is negative
+ */
+int user_settings_cron_peek(int64_t now, uint16_t *id, int64_t *next);
+
+/**
+ * @brief Take a cron job setting that is due
+ *
+ * If the setting that fires first is due at @p now, its ID is returned and it is rescheduled to
+ * its next fire time after @p now. Call this until it returns -EAGAIN to take all due settings.
+ *
+ * This must be called after user_settings_load().
+ *
+ * @param[in] now The current time
+ * @param[out] id The ID of the setting that is due
+ *
+ * @retval 0 On success
+ * @retval -EAGAIN if no setting is due
+ * @retval -ENODATA if no cron job setting has a value or default
+ * @retval -ENOMEM if the heap could not be allocated
+ * @retval -EINVAL if @p now is negative
+ */
+int user_settings_cron_pop(int64_t now, uint16_t *id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_SETTINGS_CRON_H */
@@ -14,6 +14,7 @@ extern "C" {
 #endif
 
 #include <zephyr/kernel.h>
+#include <zephyr/settings/settings.h>
 #include <user_settings_types.h>
 /* JSON parser */
 #include <cJSON.h>
@@ -67,6 +68,193 @@ int user_settings_get_changed_json(cJSON **settings);
  */
 int user_settings_get_all_json(cJSON **settings);
 
+/**
+ * @brief Create a JSON with the flash write counters, with CONFIG_USER_SETTINGS_WEAR_STATS
+ *
+ * The JSON has the form
+ * {"totals": {"writes": W, "bytes": B, "skipped": S, "boot_writes": BW, "writes_per_hour": R},
+ * "settings": {"key": {"writes": W, "bytes": B, "skipped": S}, ...}}. Only settings with non-zero
+ * counters are listed. See user_settings_get_wear_totals() for the meaning of the fields.
+ *
+ * The caller is expected to free the created cJSON structure.
+ *
+ * @param[out] stats Created json
+ * @retval 0 On success
+ * @retval -ENOMEM If we failed to allocate JSON struct
+ * @retval -ENOTSUP if CONFIG_USER_SETTINGS_WEAR_STATS is disabled
+ */
+int user_settings_get_wear_stats_json(cJSON **stats);
+
+/* Forward declaration of an internal user setting representation */
+struct user_setting;
+
+/**
+ * @brief Position in a JSON document written in chunks
+ *
+ * Zero initialize it before the first chunk. Only offset may be read, the other fields are
+ * private. The position is kept in the struct, so each chunk only writes what follows it and
+ * several documents can be written at the same time.
+ */
+struct user_settings_json_cursor {
+	/** The number of bytes of the document already written */
+	size_t offset;
+	/** The setting whose member is written next (private) */
+	struct user_setting *setting;
+	/** The number of bytes of the current part of the document already written (private) */
+	size_t part_offset;
+	/** The part of the document that is written next (private) */
+	uint8_t state;
+};
+
+/**
+ * @brief Write all settings as a flat JSON object into a buffer, one chunk at a time.
+ *
+ * This produces the same structure as user_settings_get_all_json(), but does not allocate any
+ * memory. The document is written directly into @p buf. If it does not fit, call this function
+ * again with the same @p cursor to get the next chunk.
+ *
+ * Usage:
+ *
+ *	struct user_settings_json_cursor cursor = {0};
+ *	int len;
+ *	while ((len = user_settings_json_write_all(buf, sizeof(buf), &cursor)) > 0) {
+ *		send(buf, len);
+ *	}
+ *
+ * The output is not NULL terminated. Settings should not be changed until the whole document has
+ * been written, otherwise the chunks will not fit together.
+ *
+ * @param[out] buf The buffer to write the next chunk into
+ * @param[in] len The length of the buffer
+ * @param[in,out] cursor The position in the document. Must be zero initialized for the first
+ * chunk. Its offset is advanced by the number of bytes written.
+ *
+ * @return The number of bytes written into @p buf. 0 if the whole document was already written.
+ * @retval -EINVAL if @p buf is NULL or @p len is 0
+ * @retval -EIO if the value of a lazy setting could not be read
+ */
+int user_settings_json_write_all(char *buf, size_t len, struct user_settings_json_cursor *cursor);
+
+/**
+ * @brief Write all settings marked changed as a flat JSON object into a buffer, one chunk at a time.
+ *
+ * This produces the same structure as user_settings_get_changed_json() and is used in the same
+ * way as user_settings_json_write_all(). Only the changed settings are visited, so the cost does
+ * not depend on the total number of settings. Settings are written in the order they were marked
+ * changed.
+ *
+ * Calling this function will not clear the changed flag of any user setting.
+ *
+ * @param[out] buf The buffer to write the next chunk into
+ * @param[in] len The length of the buffer
+ * @param[in,out] cursor The position in the document. Must be zero initialized for the first
+ * chunk. Its offset is advanced by the number of bytes written.
+ *
+ * @return The number of bytes written into @p buf. 0 if the whole document was already written.
+ * @retval -EINVAL if @p buf is NULL or @p len is 0
+ * @retval -EIO if the value of a lazy setting could not be read
+ */
+int user_settings_json_write_changed(char *buf, size_t len,
+				     struct user_settings_json_cursor *cursor);
+
+/**
+ * @brief State of the streaming JSON parser
+ *
+ * All fields are private. The struct is owned by the caller so that parsing does not use any
+ * heap and only a bounded amount of stack. Initialize it with user_settings_json_parser_init().
+ */
+struct user_settings_json_parser {
+	/** Current state of the parser (private) */
+	uint8_t state;
+	/** Kind of the value being parsed (private) */
+	uint8_t value_kind;
+	/** Set if the previous string character was a backslash (private) */
+	bool in_escape;
+	/** Number of hex digits of a unicode escape left to read (private) */
+	uint8_t unicode_left;
+	/** Code point of the unicode escape being read (private) */
+	uint16_t unicode;
+	/** Set if the current value does not fit into the value buffer (private) */
+	bool overflow;
+	/** Set if the current value is not valid for the setting type (private) */
+	bool invalid;
+	/** Set if only the high nibble of the last hex decoded byte was read (private) */
+	bool half_byte;
+	/** Set while the elements of an array value are scanned (private) */
+	bool in_array;
+	/** Set while the fields of a record value are scanned (private) */
+	bool in_record;
+	/** Set while a string inside of a skipped value is scanned (private) */
+	bool skip_in_string;
+	/** Number of open arrays and objects of a skipped value (private) */
+	uint16_t skip_depth;
+	/** Mark settings changed even if their value is the same (private) */
+	bool always_mark_changed;
+	/** First error that stopped the parser, 0 if none (private) */
+	int err;
+	/** The setting the current key refers to, NULL if unknown (private) */
+	struct user_setting *setting;
+	/** The field of a record the current field name refers to, NULL if unknown (private) */
+	const struct user_settings_record_field *field;
+	/** Decoded key of the current member (private) */
+	char key[SETTINGS_MAX_NAME_LEN + 1];
+	/** Length of the key (private) */
+	size_t key_len;
+	/** Decoded value of the current member, with space for the NULL terminator of strings and
+	 * tokens (private) */
+	uint8_t value[CONFIG_USER_SETTINGS_JSON_PARSER_VALUE_SIZE + 1];
+	/** Length of the value, or of the current element token of an array or field name or
+	 * token of a record (private) */
+	size_t value_len;
+	/** Length of the decoded elements of an array value or of a record value, tokens follow
+	 * them (private) */
+	size_t array_len;
+};
+
+/**
+ * @brief Initialize the streaming JSON parser
+ *
+ * @param[out] parser The parser to initialize
+ * @param[in] always_mark_changed See user_settings_set_from_json()
+ */
+void user_settings_json_parser_init(struct user_settings_json_parser *parser,
+				    bool always_mark_changed);
+
+/**
+ * @brief Feed the next fragment of a JSON document to the streaming parser
+ *
+ * This accepts the same flat structure as user_settings_set_from_json(), but without building
+ * a cJSON tree first. Each setting is applied as soon as its value has been scanned, so the
+ * document can be fed in arbitrary fragments as they arrive from the network.
+ *
+ * As with user_settings_set_from_json(), unknown keys and values of the wrong type are logged and
+ * skipped, including nested objects and arrays. String, bytes, array and record values larger than
+ * CONFIG_USER_SETTINGS_JSON_PARSER_VALUE_SIZE are rejected with -ENOMEM. Fields missing from the
+ * object of a record keep their value.
+ *
+ * @param[in] parser The parser
+ * @param[in] data The next fragment of the document
+ * @param[in] len The length of the fragment
+ *
+ * @retval 0 On success
+ * @retval -ENOMEM If a new value is larger than the max_size or the value buffer
+ * @retval -EIO if a setting value could not be stored to NVS
+ * @retval -EINVAL if the document is not a valid flat JSON object
+ */
+int user_settings_json_parser_feed(struct user_settings_json_parser *parser, const char *data,
+				   size_t len);
+
+/**
+ * @brief Check that the whole document was fed to the streaming parser
+ *
+ * @param[in] parser The parser
+ *
+ * @retval 0 if a complete JSON object was parsed
+ * @retval -EINVAL if the document is incomplete
+ * @retval Other negative error code returned by user_settings_json_parser_feed() before
+ */
+int user_settings_json_parser_finish(struct user_settings_json_parser *parser);
+
 #ifdef __cplusplus
 }
 #endif
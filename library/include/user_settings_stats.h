@@ -0,0 +1,152 @@
+/** @file user_settings_stats.h
+ *
+ * @brief Statistics of user settings operations
+ *
+ * With CONFIG_USER_SETTINGS_STATS, the library counts its operations in the "usettings" stats
+ * group. The group is registered by user_settings_init(), so it can also be read with the
+ * mcumgr stat group. Without it, the counting macros compile to nothing and the functions return
+ * -ENOTSUP.
+ *
+ * The order of the counters is part of the STATS protocol command, new counters must only be
+ * added at the end of the group.
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2023 Irnas.  All rights reserved.
+ */
+
+#ifndef USER_SETTINGS_STATS_H
+#define USER_SETTINGS_STATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(CONFIG_USER_SETTINGS_STATS)
+
+#include <zephyr/stats/stats.h>
+
+/* clang-format off */
+STATS_SECT_START(user_settings)
+	/* core */
+	STATS_SECT_ENTRY32(get_key)
+	STATS_SECT_ENTRY32(get_id)
+	STATS_SECT_ENTRY32(set_key)
+	STATS_SECT_ENTRY32(set_id)
+	STATS_SECT_ENTRY32(set_unchanged)
+	STATS_SECT_ENTRY32(lookup_miss)
+	STATS_SECT_ENTRY32(err_nomem)
+	STATS_SECT_ENTRY32(err_io)
+	STATS_SECT_ENTRY32(writes)
+	STATS_SECT_ENTRY32(write_err)
+	/* protocol commands, in the order of enum user_settings_protocol_command_type */
+	STATS_SECT_ENTRY32(cmd_get)
+	STATS_SECT_ENTRY32(cmd_get_full)
+	STATS_SECT_ENTRY32(cmd_list)
+	STATS_SECT_ENTRY32(cmd_list_full)
+	STATS_SECT_ENTRY32(cmd_set)
+	STATS_SECT_ENTRY32(cmd_set_default)
+	STATS_SECT_ENTRY32(cmd_restore)
+	STATS_SECT_ENTRY32(cmd_list_some)
+	STATS_SECT_ENTRY32(cmd_list_some_full)
+	STATS_SECT_ENTRY32(cmd_list_changed)
+	STATS_SECT_ENTRY32(cmd_list_changed_full)
+	STATS_SECT_ENTRY32(cmd_export)
+	STATS_SECT_ENTRY32(cmd_import)
+	STATS_SECT_ENTRY32(cmd_import_commit)
+	STATS_SECT_ENTRY32(cmd_read_at)
+	STATS_SECT_ENTRY32(cmd_write_at)
+	STATS_SECT_ENTRY32(cmd_write_commit)
+	STATS_SECT_ENTRY32(cmd_wear_stats)
+	STATS_SECT_ENTRY32(cmd_wear_totals)
+	STATS_SECT_ENTRY32(cmd_stats)
+	STATS_SECT_ENTRY32(cmd_err)
+	/* Bluetooth service */
+	STATS_SECT_ENTRY32(bt_notify_fail)
+#if defined(CONFIG_USER_SETTINGS_STATS_LATENCY)
+	/* settings backend write latency */
+	STATS_SECT_ENTRY32(write_lt_1ms)
+	STATS_SECT_ENTRY32(write_lt_10ms)
+	STATS_SECT_ENTRY32(write_lt_100ms)
+	STATS_SECT_ENTRY32(write_ge_100ms)
+	STATS_SECT_ENTRY32(write_max_us)
+#endif
+STATS_SECT_END;
+/* clang-format on */
+
+extern STATS_SECT_DECL(user_settings) user_settings_stats;
+
+/**
+ * @brief Increment a counter of the user settings stats group
+ *
+ * @param[in] name The name of the counter, i.e. set_key
+ */
+#define USER_SETTINGS_STATS_INC(name) STATS_INC(user_settings_stats, name)
+
+#else
+
+#define USER_SETTINGS_STATS_INC(name)
+
+#endif /* CONFIG_USER_SETTINGS_STATS */
+
+/**
+ * @brief Register the user settings stats group
+ *
+ * This is called by user_settings_init().
+ *
+ * @retval 0 on success
+ * @retval -EIO if the group could not be registered
+ */
+int user_settings_stats_init(void);
+
+/**
+ * @brief Count the execution of a protocol command
+ *
+ * Commands that failed are also counted in cmd_err.
+ *
+ * @param[in] type The command type (enum user_settings_protocol_command_type)
+ * @param[in] ret The result of the command
+ */
+void user_settings_stats_count_command(uint8_t type, int ret);
+
+/**
+ * @brief Read the counters of the user settings stats group
+ *
+ * The counters are read in the order of the group.
+ *
+ * @param[out] values The counters
+ * @param[in] max_values The number of counters that fit in @p values
+ *
+ * @retval Positive number - The number of counters read
+ * @retval -ENOMEM if @p values is too small to hold all counters
+ * @retval -ENOTSUP if CONFIG_USER_SETTINGS_STATS is disabled
+ */
+int user_settings_stats_read(uint32_t *values, size_t max_values);
+
+/**
+ * @brief Print the counters of the user settings stats group
+ *
+ * @param[in] print The function that is called with the name and value of each counter
+ * @param[in] arg The argument to pass to @p print
+ *
+ * @retval 0 on success
+ * @retval -ENOTSUP if CONFIG_USER_SETTINGS_STATS is disabled
+ */
+int user_settings_stats_walk(void (*print)(const char *name, uint32_t value, void *arg),
+			     void *arg);
+
+/**
+ * @brief Clear all counters of the user settings stats group
+ *
+ * @retval 0 on success
+ * @retval -ENOTSUP if CONFIG_USER_SETTINGS_STATS is disabled
+ */
+int user_settings_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_SETTINGS_STATS_H */
@@ -18,7 +18,9 @@ extern "C" {
 /**
  * @brief Callback type to notify the application of a changed setting
  *
- * The callback is called from the same thread that updated the setting.
+ * The callback is called from the same thread that updated the setting. With
+ * CONFIG_USER_SETTINGS_NOTIFY_ASYNC, it is called from a work queue instead, once for any number
+ * of changes to the setting since the previous call.
  *
  * The consumer can then get the value of the setting via user_settings_get_with_*()
  * and respond accordingly.
@@ -28,6 +30,80 @@ extern "C" {
  */
 typedef void (*user_settings_on_change_t)(uint32_t id, const char *key);
 
+/**
+ * @brief Callback called with the IDs of a batch of changed settings
+ *
+ * The callback is called after the on change callbacks of the settings in the batch. Without
+ * CONFIG_USER_SETTINGS_NOTIFY_ASYNC, each batch holds a single setting. With it, a batch holds
+ * up to CONFIG_USER_SETTINGS_NOTIFY_ASYNC_EVENTS settings that changed since the previous batch,
+ * each one once.
+ *
+ * @param[in] ids The IDs of the changed settings. Only valid during the call.
+ * @param[in] count The number of IDs
+ */
+typedef void (*user_settings_on_change_batch_t)(const uint16_t *ids, size_t count);
+
+/**
+ * @brief Callback called once when user_settings_load() completes
+ *
+ * Bit N of @p loaded is set if the setting with ID N got its value from NVS, i.e.
+ * loaded[id / 32] & BIT(id % 32). Settings that were not loaded have their default value or no
+ * value at all. With CONFIG_USER_SETTINGS_LOAD_QUIET, this replaces the on change callbacks for
+ * the loaded settings.
+ *
+ * @param[in] loaded Bitmap of the loaded settings, indexed by ID. Only valid during the call.
+ * NULL if the bitmap could not be allocated from the user settings heap, then all settings must
+ * be treated as loaded.
+ * @param[in] max_id The highest ID of all settings, the bitmap holds max_id + 1 bits
+ */
+typedef void (*user_settings_on_load_t)(const uint32_t *loaded, uint16_t max_id);
+
+/**
+ * @brief Callback to validate a new value of a setting
+ *
+ * The callback is called before the value is stored, after the range and enum constraints of the
+ * setting passed. It is called for values set by the application, through the protocol, JSON
+ * or a bulk import and for new default values, but not for values loaded from NVS.
+ *
+ * @param[in] id The ID of the setting
+ * @param[in] key The key of the setting
+ * @param[in] data The new value
+ * @param[in] len The length of the new value
+ *
+ * @return true if the value is valid and may be stored
+ */
+typedef bool (*user_settings_validator_t)(uint32_t id, const char *key, const void *data,
+					  size_t len);
+
+/**
+ * @brief Flash write counters of a setting, with CONFIG_USER_SETTINGS_WEAR_STATS
+ */
+struct user_settings_wear_stats {
+	/** Number of records written to or deleted from NVS for the setting. This includes the
+	 * value, the default value and the changed flag. */
+	uint32_t writes;
+
+	/** Number of data bytes in the written records, without the NVS overhead */
+	uint32_t bytes;
+
+	/** Number of sets that did not write anything because the value did not change */
+	uint32_t skipped;
+};
+
+/**
+ * @brief Flash write counters of all settings, with CONFIG_USER_SETTINGS_WEAR_STATS
+ */
+struct user_settings_wear_totals {
+	/** The sums of the counters of all settings */
+	struct user_settings_wear_stats sum;
+
+	/** Number of records written since boot */
+	uint32_t boot_writes;
+
+	/** Estimated write rate, from the writes since boot and the uptime */
+	uint32_t writes_per_hour;
+};
+
 /**
  * @brief Type of user setting
  *
@@ -52,9 +128,51 @@ enum user_setting_type {
 
 	USER_SETTINGS_TYPE_BYTES,
 
-	USER_SETTINGS_TYPE_CRON_JOB
+	USER_SETTINGS_TYPE_CRON_JOB,
+
+	/** IEEE 754 single precision, stored as a native float */
+	USER_SETTINGS_TYPE_F32,
+
+	/** IEEE 754 double precision, stored as a native double */
+	USER_SETTINGS_TYPE_F64,
+
+	/** Fixed number of elements of a fixed size type, stored as one value */
+	USER_SETTINGS_TYPE_ARRAY,
+
+	/** Named fields of fixed size types, described by a table of struct
+	 * user_settings_record_field and stored as one value */
+	USER_SETTINGS_TYPE_RECORD,
 };
 
+/**
+ * @brief Field of a record setting
+ *
+ * A record setting is usually a struct of the application, described by a table with one entry
+ * for each member that is stored. The table must live for the lifetime of the program.
+ */
+struct user_settings_record_field {
+	/** Name of the field, used in JSON and the shell */
+	const char *name;
+
+	/** Type of the field. Must be a numeric or bool type */
+	enum user_setting_type type;
+
+	/** Offset of the field in the record (in bytes) */
+	uint8_t offset;
+};
+
+/**
+ * @brief Describe a member of a struct as a field of a record setting
+ *
+ * @param _struct The struct type of the record
+ * @param _member The member, also used as the name of the field
+ * @param _type The type of the field (enum user_setting_type)
+ */
+#define USER_SETTINGS_RECORD_FIELD(_struct, _member, _type)                                        \
+	{                                                                                          \
+		.name = #_member, .type = _type, .offset = offsetof(_struct, _member),             \
+	}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,72 @@
+/** @file user_settings_zbus.h
+ *
+ * @brief zbus bridge for user settings change events
+ *
+ * With CONFIG_USER_SETTINGS_ZBUS, each change of a setting is published as a struct
+ * user_settings_zbus_msg on user_settings_chan. Modules can then observe the channel with zbus
+ * listeners, subscribers or message subscribers instead of registering on change callbacks.
+ *
+ * Messages are published where the on change callbacks are called, so with
+ * CONFIG_USER_SETTINGS_NOTIFY_ASYNC they are published from the work queue and coalesced the same
+ * way.
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2023 Irnas.  All rights reserved.
+ */
+
+#ifndef USER_SETTINGS_ZBUS_H
+#define USER_SETTINGS_ZBUS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <zephyr/zbus/zbus.h>
+#include <user_settings_types.h>
+
+/**
+ * @brief A change of a setting
+ *
+ * Values of settings with a fixed size of up to 8 bytes (all types except string, bytes, cron job,
+ * array and record) are carried inline, so observers do not have to look them up. Other values
+ * must be read with user_settings_get_with_id() or user_settings_read_with_id().
+ */
+struct user_settings_zbus_msg {
+	/** The ID of the changed setting */
+	uint16_t id;
+
+	/** The type of the changed setting (enum user_setting_type) */
+	uint8_t type;
+
+	/** True if the value is carried in the value field */
+	bool is_inline;
+
+	/** The length of the new value, or of the default value if the value was deleted. 0 if the
+	 * setting has neither. */
+	uint16_t len;
+
+	/** The new value, only valid if is_inline is set */
+	union {
+		bool b;
+		uint8_t u8;
+		uint16_t u16;
+		uint32_t u32;
+		uint64_t u64;
+		int8_t i8;
+		int16_t i16;
+		int32_t i32;
+		int64_t i64;
+		float f32;
+		double f64;
+		uint8_t raw[8];
+	} value;
+};
+
+/** The channel that setting changes are published on */
+ZBUS_CHAN_DECLARE(user_settings_chan);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_SETTINGS_ZBUS_H */
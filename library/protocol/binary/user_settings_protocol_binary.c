@@ -11,9 +11,21 @@
 #include <user_settings_list.h>
 
 #include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
 
 #include <string.h>
 
+/**
+ * @brief Check if a value fits the 1 byte length of the encoding
+ *
+ * Only strings and bytes can be longer. Longer values are encoded with length 0 and no value
+ * bytes, clients read them with the READ AT command instead.
+ */
+static bool prv_len_fits(size_t len)
+{
+	return len <= UINT8_MAX;
+}
+
 /**
  * @brief Calculate the required bytes to encode a user setting
  *
@@ -36,7 +48,7 @@ static int prv_encode_required_bytes(struct user_setting *user_setting)
 	/* calculate base up to length */
 	int base = 2 + strlen(user_setting->key) + 1 + 1 + 1;
 
-	if (user_setting->is_set) {
+	if (user_setting->is_set && prv_len_fits(user_setting->data_len)) {
 		base += user_setting->data_len;
 	}
 	return base;
@@ -54,54 +66,167 @@ static int prv_encode_required_bytes_full(struct user_setting *user_setting)
 	/* Start with short format and add 1 for default len and 1 for max len */
 	int base = prv_encode_required_bytes(user_setting) + 1 + 1;
 
-	if (user_setting->default_is_set) {
+	if (user_setting->default_is_set && prv_len_fits(user_setting->default_data_len)) {
 		base += user_setting->default_data_len;
 	}
+
+	/* element type of arrays */
+	if (user_setting->type == USER_SETTINGS_TYPE_ARRAY) {
+		base += 1;
+	}
+
+	/* field count and for each field the type, offset and NULL terminated name of records */
+	if (user_setting->type == USER_SETTINGS_TYPE_RECORD) {
+		base += 1;
+		for (size_t i = 0; i < user_setting->num_fields; i++) {
+			base += 1 + 1 + strlen(user_setting->fields[i].name) + 1;
+		}
+	}
+
+	const struct user_setting_constraints *c = user_setting->constraints;
+	if (c) {
+		/* 1 byte flags, min, max and step and the count and the enum values */
+		base += 1;
+		if (c->has_range) {
+			base += 3 * user_setting->max_size;
+		}
+		if (c->enum_values) {
+			base += 1 + c->num_enum_values * user_setting->max_size;
+		}
+	}
 	return base;
 }
 
-int user_settings_protocol_binary_decode_command(uint8_t *buffer, size_t len,
-						 struct user_settings_protocol_command *command)
+/**
+ * @brief Encode a number of a constraint in the size of the setting value, little endian
+ *
+ * @return The number of bytes written
+ */
+static int prv_encode_constraint_number(struct user_setting *user_setting, uint64_t number,
+					uint8_t *buffer)
 {
-	__ASSERT(buffer, "buffer must be provided");
-	__ASSERT(command, "command must be provided");
+	uint8_t le[sizeof(number)];
 
-	memset(command, 0, sizeof(struct user_settings_protocol_command));
+	sys_put_le64(number, le);
+	memcpy(buffer, le, user_setting->max_size);
+	return user_setting->max_size;
+}
 
-	if (len == 0) {
-		return -EPROTO;
+/**
+ * @brief Encode the constraints of a setting
+ *
+ * @return The number of bytes written
+ */
+static int prv_encode_constraints(struct user_setting *user_setting, uint8_t *buffer)
+{
+	const struct user_setting_constraints *c = user_setting->constraints;
+	int i = 0;
+
+	buffer[i++] = (c->has_range ? USP_BINARY_CONSTRAINT_RANGE : 0) |
+		      (c->enum_values ? USP_BINARY_CONSTRAINT_ENUM : 0) |
+		      (c->validator ? USP_BINARY_CONSTRAINT_VALIDATOR : 0);
+
+	if (c->has_range) {
+		i += prv_encode_constraint_number(user_setting, c->min, &buffer[i]);
+		i += prv_encode_constraint_number(user_setting, c->max, &buffer[i]);
+		i += prv_encode_constraint_number(user_setting, c->step, &buffer[i]);
 	}
 
-	/* first byte is type */
+	if (c->enum_values) {
+		buffer[i++] = c->num_enum_values;
+		for (size_t n = 0; n < c->num_enum_values; n++) {
+			i += prv_encode_constraint_number(user_setting, c->enum_values[n],
+							  &buffer[i]);
+		}
+	}
+
+	return i;
+}
+
+/**
+ * @brief Encode the fields of a record setting
+ *
+ * @param[in] user_setting The record setting
+ * @param[out] buffer The buffer to encode into, must be large enough
+ *
+ * @return The number of bytes written
+ */
+static int prv_encode_record_fields(struct user_setting *user_setting, uint8_t *buffer)
+{
+	int i = 0;
+
+	buffer[i++] = user_setting->num_fields;
+
+	for (size_t n = 0; n < user_setting->num_fields; n++) {
+		const struct user_settings_record_field *field = &user_setting->fields[n];
+		size_t name_len = strlen(field->name) + 1;
+
+		buffer[i++] = field->type;
+		buffer[i++] = field->offset;
+		memcpy(&buffer[i], field->name, name_len);
+		i += name_len;
+	}
+
+	return i;
+}
+
+/**
+ * @brief Decode the fields of a command that follow the command type and sequence number
+ *
+ * @param[in] buffer The buffer with the fields
+ * @param[in] len The length of the buffer
+ * @param[in,out] command The command with the type already set
+ *
+ * @return The number of bytes decoded, or a negative error code
+ */
+static int prv_decode_fields(uint8_t *buffer, size_t len,
+			     struct user_settings_protocol_command *command)
+{
 	int i = 0;
-	command->type = buffer[i++];
 
 	/* If command is get or set, key must be provided */
 	switch (command->type) {
 	case USPC_LIST:
 	case USPC_LIST_FULL:
-	case USPC_RESTORE: {
+	case USPC_RESTORE:
+	case USPC_LIST_CHANGED:
+	case USPC_LIST_CHANGED_FULL:
+	case USPC_EXPORT:
+	case USPC_IMPORT_COMMIT:
+	case USPC_WEAR_TOTALS:
+	case USPC_STATS: {
 		/* No additional fields  */
 		return i;
 	}
+	case USPC_IMPORT: {
+		/* 1 byte length, 4 byte offset and at least 1 byte of the chunk */
+		if (len < 1 + 4 + 1 || buffer[i] != len - 1) {
+			return -EPROTO;
+		}
+		command->value_len = buffer[i++];
+		memcpy(command->value, &buffer[i], command->value_len);
+		i += command->value_len;
+		return i;
+	}
 	case USPC_GET:
-	case USPC_GET_FULL: {
+	case USPC_GET_FULL:
+	case USPC_WRITE_COMMIT:
+	case USPC_WEAR_STATS: {
 		/* Key only */
-		if (len != sizeof(command->type) + sizeof(command->id)) {
+		if (len != sizeof(command->id)) {
 			return -EPROTO;
 		}
-		command->id = *(uint16_t *)&buffer[i];
+		command->id = sys_get_le16(&buffer[i]);
 		i += 2;
 		return i;
 	}
 	case USPC_SET:
 	case USPC_SET_DEFAULT: {
 		/* key and data (the + 1 is there since at least 1 byte of data is required) */
-		if (len <
-		    sizeof(command->type) + sizeof(command->id) + sizeof(command->value_len) + 1) {
+		if (len < sizeof(command->id) + sizeof(command->value_len) + 1) {
 			return -EPROTO;
 		}
-		command->id = *(uint16_t *)&buffer[i];
+		command->id = sys_get_le16(&buffer[i]);
 		i += 2;
 		command->value_len = *(uint8_t *)&buffer[i++];
 
@@ -110,16 +235,44 @@ int user_settings_protocol_binary_decode_command(uint8_t *buffer, size_t len,
 
 		return i;
 	}
+	case USPC_READ_AT: {
+		/* key, 4 byte offset and 1 byte maximum chunk length */
+		if (len != sizeof(command->id) + 4 + 1) {
+			return -EPROTO;
+		}
+		command->id = sys_get_le16(&buffer[i]);
+		i += 2;
+		command->value_len = 4 + 1;
+		memcpy(command->value, &buffer[i], command->value_len);
+		i += command->value_len;
+		return i;
+	}
+	case USPC_WRITE_AT: {
+		/* key, 1 byte length, 4 byte offset and at least 1 byte of the chunk */
+		if (len < sizeof(command->id) + 1 + 4 + 1 ||
+		    buffer[sizeof(command->id)] != len - sizeof(command->id) - 1) {
+			return -EPROTO;
+		}
+		command->id = sys_get_le16(&buffer[i]);
+		i += 2;
+		command->value_len = buffer[i++];
+		memcpy(command->value, &buffer[i], command->value_len);
+		i += command->value_len;
+		return i;
+	}
 	case USPC_LIST_SOME:
 	case USPC_LIST_SOME_FULL: {
-		/* key, 1 byte for number of setting IDs and N*2 bytes for the IDs */
-		size_t id_buffer_len = len - sizeof(command->type) - 1;
+		/* 1 byte for number of setting IDs and N*2 bytes for the IDs */
+		if (len < 1) {
+			return -EPROTO;
+		}
+		size_t id_buffer_len = len - 1;
 		uint8_t num_ids = buffer[i++];
 		if (id_buffer_len / 2 != num_ids) {
 			return -EPROTO;
 		}
 		command->value_len = num_ids * 2;
-		memcpy(command->value, &buffer[sizeof(command->type) + 1], id_buffer_len);
+		memcpy(command->value, &buffer[1], id_buffer_len);
 		i += command->value_len;
 		return i;
 	}
@@ -129,6 +282,63 @@ int user_settings_protocol_binary_decode_command(uint8_t *buffer, size_t len,
 	}
 }
 
+int user_settings_protocol_binary_decode_command(uint8_t *buffer, size_t len,
+						 struct user_settings_protocol_command *command)
+{
+	__ASSERT(buffer, "buffer must be provided");
+	__ASSERT(command, "command must be provided");
+
+	memset(command, 0, sizeof(struct user_settings_protocol_command));
+
+	if (len == 0) {
+		return -EPROTO;
+	}
+
+	/* first byte is type */
+	int i = 0;
+	command->type = buffer[i++];
+
+	/* If the sequence flag is set, a 2 byte sequence number follows the type */
+	if (command->type & USP_BINARY_SEQ_FLAG) {
+		if (len < sizeof(command->type) + sizeof(command->seq)) {
+			return -EPROTO;
+		}
+		command->type &= ~USP_BINARY_SEQ_FLAG;
+		command->has_seq = true;
+		command->seq = sys_get_le16(&buffer[i]);
+		i += 2;
+	}
+
+	int ret = prv_decode_fields(&buffer[i], len - i, command);
+	if (ret < 0) {
+		return ret;
+	}
+	return i + ret;
+}
+
+int user_settings_protocol_binary_encode_header(struct user_settings_protocol_command *command,
+						enum user_settings_protocol_response_kind kind,
+						int status, uint8_t *buffer, size_t len)
+{
+	__ASSERT(command, "command must be provided");
+	__ASSERT(buffer, "buffer must be provided");
+
+	/* 2 byte sequence number, 1 byte kind and 1 byte status for the done response */
+	size_t required = 2 + 1 + (kind == USP_RESPONSE_DONE ? 1 : 0);
+	if (len < required) {
+		return -ENOMEM;
+	}
+
+	sys_put_le16(command->seq, &buffer[0]);
+	buffer[2] = kind;
+	if (kind == USP_RESPONSE_DONE) {
+		/* errno values fit into one byte */
+		buffer[3] = (uint8_t)(-status);
+	}
+
+	return required;
+}
+
 int user_settings_protocol_binary_encode(struct user_setting *user_setting, uint8_t *buffer,
 					 size_t len)
 {
@@ -153,14 +363,19 @@ int user_settings_protocol_binary_encode(struct user_setting *user_setting, uint
 	/* type */
 	buffer[i++] = user_setting->type;
 
-	if (user_setting->is_set) {
+	if (user_setting->is_set && prv_len_fits(user_setting->data_len)) {
+		/* lazy values are fetched here */
+		const void *data = user_settings_list_data_get(user_setting, NULL);
+		if (!data) {
+			return -EIO;
+		}
 		/* length */
 		buffer[i++] = user_setting->data_len;
 		/* value */
-		memcpy(&buffer[i], user_setting->data, user_setting->data_len);
+		memcpy(&buffer[i], data, user_setting->data_len);
 		i += user_setting->data_len;
 	} else {
-		/* set length to 0 */
+		/* set length to 0, also for values that are too long */
 		buffer[i++] = 0;
 	}
 
@@ -177,6 +392,8 @@ int user_settings_protocol_binary_encode_full(struct user_setting *user_setting,
 	 * 1 byte default length (if 0 no default value is set)
 	 * length bytes default value
 	 * 1 byte max_len
+	 * 1 byte element type (only arrays)
+	 * the fields (only records)
 	 */
 
 	if (len < prv_encode_required_bytes_full(user_setting)) {
@@ -184,20 +401,38 @@ int user_settings_protocol_binary_encode_full(struct user_setting *user_setting,
 	}
 
 	int i = user_settings_protocol_binary_encode(user_setting, buffer, len);
+	if (i < 0) {
+		return i;
+	}
 
-	if (user_setting->default_is_set) {
+	if (user_setting->default_is_set && prv_len_fits(user_setting->default_data_len)) {
 		/* length */
 		buffer[i++] = user_setting->default_data_len;
 		/* value */
 		memcpy(&buffer[i], user_setting->default_data, user_setting->default_data_len);
 		i += user_setting->default_data_len;
 	} else {
-		/* set length to 0 */
+		/* set length to 0, also for default values that are too long */
 		buffer[i++] = 0;
 	}
 
-	/* max length */
-	buffer[i++] = user_setting->max_size;
+	/* max length, 255 for settings that can be longer */
+	buffer[i++] = MIN(user_setting->max_size, UINT8_MAX);
+
+	/* element type, the number of elements follows from the max length */
+	if (user_setting->type == USER_SETTINGS_TYPE_ARRAY) {
+		buffer[i++] = user_setting->elem_type;
+	}
+
+	/* the fields, so clients can encode and decode the value field by field */
+	if (user_setting->type == USER_SETTINGS_TYPE_RECORD) {
+		i += prv_encode_record_fields(user_setting, &buffer[i]);
+	}
+
+	/* constraints, only if the setting has any */
+	if (user_setting->constraints) {
+		i += prv_encode_constraints(user_setting, &buffer[i]);
+	}
 
 	return i;
 }
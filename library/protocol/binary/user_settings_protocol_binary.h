@@ -20,6 +20,26 @@ extern "C" {
 #include <stddef.h>
 #include <user_settings_protocol_types.h>
 
+/**
+ * @brief Set in the command type byte if a 2 byte sequence number follows it
+ */
+#define USP_BINARY_SEQ_FLAG 0x80
+
+/**
+ * @brief The full encoding of a setting has a range constraint
+ */
+#define USP_BINARY_CONSTRAINT_RANGE 0x01
+
+/**
+ * @brief The full encoding of a setting has a list of allowed values
+ */
+#define USP_BINARY_CONSTRAINT_ENUM 0x02
+
+/**
+ * @brief The setting has a validator callback, which the client can not check
+ */
+#define USP_BINARY_CONSTRAINT_VALIDATOR 0x04
+
 /**
  * @brief Decode command in binary format to a command in user settings protocol structure
  * representation
@@ -31,17 +51,26 @@ extern "C" {
  * - len bytes	value
  *
  * For each supported command type the following fields must be provided:
- * - USPC_LIST, USPC_LIST_FULL, USPC_RESTORE must only provide the command type
- * - USPC_GET, USPC_GET_FULL must provide the command type and the setting key
+ * - USPC_LIST, USPC_LIST_FULL, USPC_RESTORE, USPC_WEAR_TOTALS, USPC_STATS must only provide the
+ *   command type
+ * - USPC_GET, USPC_GET_FULL, USPC_WRITE_COMMIT, USPC_WEAR_STATS must provide the command type and
+ *   the setting key
  * - USPC_SET, USPC_SET_DEFAULT must provide the command type, the setting key, the length and the
  *   value
  * - USPC_LIST_SOME, USPC_LIST_SOME_FULL must provide the command type, the value length and the
  *   value as a list of 2 byte setting keys
+ * - USPC_READ_AT must provide the command type, the setting key, a 4 byte offset and a 1 byte
+ *   maximum chunk length
+ * - USPC_WRITE_AT must provide the command type, the setting key, the length and the value as a
+ *   4 byte offset followed by the chunk
  *
  * @param[in] buffer The buffer to decode
  * @param[in] len The length of the buffer
  * @param[out] command The decoded command
  *
+ * If USP_BINARY_SEQ_FLAG is set in the command type byte, a 2 byte sequence number follows the
+ * command type byte and is stored in the command. The other fields follow the sequence number.
+ *
  * @retval Positive number - The number of bytes decoded
  * @retval -EPROTO if decoding failed
  * @retval -ENOTSUP if the command is not supported
@@ -59,11 +88,14 @@ int user_settings_protocol_binary_decode_command(uint8_t *buffer, size_t len,
  * - 1 byte	length of the value (LEN) or 0 if the value is not set
  * - LEN bytes 	value (or nothing if LEN is 0)
  *
+ * Values longer than 255 bytes are encoded as if they were not set, read them with USPC_READ_AT.
+ *
  * @param[in] user_setting The setting to encode
  * @param[out] buffer The buffer to encode into
  * @param[in] len The length of the buffer
  *
- * @return The number of bytes written or -ENOMEM if the provided buffer is to small
+ * @return The number of bytes written or -ENOMEM if the provided buffer is to small or -EIO if
+ * the value of a lazy setting could not be fetched
  */
 int user_settings_protocol_binary_encode(struct user_setting *user_setting, uint8_t *buffer,
 					 size_t len);
@@ -75,17 +107,47 @@ int user_settings_protocol_binary_encode(struct user_setting *user_setting, uint
  * to the end:
  * - 1 byte 		default length (DEFAULT_LEN) or 0 if the default value is not set
  * - DEFAULT_LEN bytes	default value (or nothing if DEFAULT_LEN is 0)
- * - 1 byte 		maximum length of the value
+ * - 1 byte 		maximum length of the value, at most 255
+ *
+ * Default values longer than 255 bytes are encoded as if they were not set.
+ *
+ * If the setting has constraints, they follow (see USP_BINARY_CONSTRAINT_RANGE). Numbers are
+ * encoded little endian in the size of the value (SIZE):
+ * - 1 byte 		constraint flags
+ * - 3 * SIZE bytes	minimum, maximum and step, if USP_BINARY_CONSTRAINT_RANGE is set
+ * - 1 byte 		number of allowed values (COUNT), if USP_BINARY_CONSTRAINT_ENUM is set
+ * - COUNT * SIZE bytes	allowed values, if USP_BINARY_CONSTRAINT_ENUM is set
  *
  * @param[in] user_setting The setting to encode
  * @param[out] buffer The buffer to encode into
  * @param[in] len The length of the buffer
  *
- * @return The number of bytes written or -ENOMEM if the provided buffer is to small
+ * @return The number of bytes written or -ENOMEM if the provided buffer is to small or -EIO if
+ * the value of a lazy setting could not be fetched
  */
 int user_settings_protocol_binary_encode_full(struct user_setting *user_setting, uint8_t *buffer,
 					      size_t len);
 
+/**
+ * @brief Encode the response header of a command with a sequence number
+ *
+ * The header is defined as follows (all numbers are little endian):
+ * - 2 byte	sequence number of the command
+ * - 1 byte	kind (from enum user_settings_protocol_response_kind)
+ * - 1 byte	status, only for USP_RESPONSE_DONE. 0 on success, otherwise the positive errno
+ *
+ * @param[in] command The command that is being responded to
+ * @param[in] kind The kind of the response
+ * @param[in] status The result of the command (0 or negative error code) for USP_RESPONSE_DONE
+ * @param[out] buffer The buffer to encode into
+ * @param[in] len The length of the buffer
+ *
+ * @return The number of bytes written or -ENOMEM if the provided buffer is to small
+ */
+int user_settings_protocol_binary_encode_header(struct user_settings_protocol_command *command,
+						enum user_settings_protocol_response_kind kind,
+						int status, uint8_t *buffer, size_t len);
+
 /**
  * @brief Define a protocol executor using the binary protocol
  *
@@ -99,6 +161,7 @@ int user_settings_protocol_binary_encode_full(struct user_setting *user_setting,
 		.decode_command = user_settings_protocol_binary_decode_command,                    \
 		.encode = user_settings_protocol_binary_encode,                                    \
 		.encode_full = user_settings_protocol_binary_encode_full,                          \
+		.encode_header = user_settings_protocol_binary_encode_header,                      \
 		.resp_buffer = buffer,                                                             \
 		.resp_buffer_len = len,                                                            \
 		.write_response = write_response_fn,                                               \
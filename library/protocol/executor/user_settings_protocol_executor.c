@@ -10,101 +10,174 @@
 
 #include <user_settings.h>
 #include <user_settings_list.h>
+#include <user_settings_stats.h>
+#include <user_settings_trace.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+
+#if defined(CONFIG_USER_SETTINGS_STATS)
+/* The stats group has a counter for each command type, see user_settings_stats_count_command() */
+BUILD_ASSERT(offsetof(STATS_SECT_DECL(user_settings), cmd_err) -
+			     offsetof(STATS_SECT_DECL(user_settings), cmd_get) ==
+		     (USPC_NUM_COMMANDS - 1) * sizeof(uint32_t),
+	     "Add a command counter to the user settings stats group");
+#endif
+
+/* The settings core is not thread safe. The UART, UDP, Bluetooth and shell transports each run
+ * their executor in a different thread, so commands of all executors are serialized here. */
+static K_MUTEX_DEFINE(prv_exec_lock);
 
 /**
- * @brief Execute a GET command
+ * @brief Encode a setting and write it as a response
  *
- * Fetch the specified setting, encode it using the provided @p encode function and write it as a
- * response.
+ * If the command has a sequence number, the response header is encoded in front of the setting.
  *
  * @param[in] usp_executor The executor
- * @param[in] id The setting ID
+ * @param[in] cmd The command that is being responded to
+ * @param[in] us The setting to encode
  * @param[in] encode the encode function to use
  * @param[in] user_data The user data to pass to the write_response function
  *
  * @retval 0 on success
- * @retval -ENOENT setting ID does not exists
  * @retval -ENOMEM if the resp_buffer is to small to fit the encoded response
  * @retval -EIO if writing the response failed
  */
-static int prv_exec_get_common(struct usp_executor *usp_executor, uint16_t id, uspe_encode_t encode,
-			       void *user_data)
+static int prv_write_setting(struct usp_executor *usp_executor,
+			     struct user_settings_protocol_command *cmd, struct user_setting *us,
+			     uspe_encode_t encode, void *user_data)
 {
-	struct user_setting *us = user_settings_list_get_by_id(id);
-	if (!us) {
-		/* Setting with this ID not found */
-		return -ENOENT;
+	int header_len = 0;
+	if (cmd->has_seq) {
+		header_len = usp_executor->encode_header(cmd, USP_RESPONSE_DATA, 0,
+							 usp_executor->resp_buffer,
+							 usp_executor->resp_buffer_len);
+		if (header_len < 0) {
+			return header_len;
+		}
 	}
 
 	/* encode setting */
-	int ret = encode(us, usp_executor->resp_buffer, usp_executor->resp_buffer_len);
+	USER_SETTINGS_TRACE_ENTER("encode", us->id);
+	int ret = encode(us, &usp_executor->resp_buffer[header_len],
+			 usp_executor->resp_buffer_len - header_len);
+	USER_SETTINGS_TRACE_EXIT("encode", us->id, ret);
 	if (ret < 0) {
-		__ASSERT(ret == -ENOMEM, "The encode function must only return the -ENOMEM error");
+		__ASSERT(ret == -ENOMEM || ret == -EIO,
+			 "The encode function must only return the -ENOMEM or -EIO error");
 		return ret;
 	}
 
 	/* Write encoded setting */
-	ret = usp_executor->write_response(usp_executor->resp_buffer, ret, user_data);
+	ret = usp_executor->write_response(usp_executor->resp_buffer, header_len + ret, user_data);
 	if (ret < 0) {
 		return -EIO;
 	}
 	return 0;
 }
 
-static int prv_exec_get(struct usp_executor *usp_executor, uint16_t id, void *user_data)
+/**
+ * @brief Execute a GET command
+ *
+ * Fetch the specified setting, encode it using the provided @p encode function and write it as a
+ * response.
+ *
+ * @param[in] usp_executor The executor
+ * @param[in] cmd The command that is being responded to
+ * @param[in] id The setting ID
+ * @param[in] encode the encode function to use
+ * @param[in] user_data The user data to pass to the write_response function
+ *
+ * @retval 0 on success
+ * @retval -ENOENT setting ID does not exists
+ * @retval -ENOMEM if the resp_buffer is to small to fit the encoded response
+ * @retval -EIO if writing the response failed
+ */
+static int prv_exec_get_common(struct usp_executor *usp_executor,
+			       struct user_settings_protocol_command *cmd, uint16_t id,
+			       uspe_encode_t encode, void *user_data)
+{
+	struct user_setting *us = user_settings_list_get_by_id(id);
+	if (!us) {
+		/* Setting with this ID not found */
+		USER_SETTINGS_STATS_INC(lookup_miss);
+		return -ENOENT;
+	}
+
+	return prv_write_setting(usp_executor, cmd, us, encode, user_data);
+}
+
+static int prv_exec_get(struct usp_executor *usp_executor,
+			struct user_settings_protocol_command *cmd, void *user_data)
 {
-	return prv_exec_get_common(usp_executor, id, usp_executor->encode, user_data);
+	return prv_exec_get_common(usp_executor, cmd, cmd->id, usp_executor->encode, user_data);
 }
 
-static int prv_exec_get_full(struct usp_executor *usp_executor, uint16_t id, void *user_data)
+static int prv_exec_get_full(struct usp_executor *usp_executor,
+			     struct user_settings_protocol_command *cmd, void *user_data)
 {
-	return prv_exec_get_common(usp_executor, id, usp_executor->encode_full, user_data);
+	return prv_exec_get_common(usp_executor, cmd, cmd->id, usp_executor->encode_full,
+				   user_data);
 }
 
 /**
  * @brief Execute a LIST command
  *
- * Iterate over all settings, encode them and write each one as a response.
+ * Iterate over all settings (or only the ones marked changed), encode them and write each one as a
+ * response.
  *
  * @param[in] usp_executor The executor
+ * @param[in] cmd The command that is being responded to
  * @param[in] encode The encode function to use
+ * @param[in] changed_only If true, only visit settings marked changed
  * @param[in] user_data The user data to pass to the write_response function
  *
  * @retval 0 on success
  * @retval -ENOMEM if the resp_buffer is to small to fit the encoded response
  * @retval -EIO if writing the response failed
  */
-static int prv_exec_list_common(struct usp_executor *usp_executor, uspe_encode_t encode,
-				void *user_data)
+static int prv_exec_list_common(struct usp_executor *usp_executor,
+				struct user_settings_protocol_command *cmd, uspe_encode_t encode,
+				bool changed_only, void *user_data)
 {
 	/* encode and write each setting */
 	int ret;
-	struct user_setting *us;
+	struct user_setting *us = NULL;
+	struct user_setting *(*next)(struct user_setting *us) =
+		changed_only ? user_settings_list_changed_next : user_settings_list_next;
 
-	user_settings_list_iter_start();
-	while ((us = user_settings_list_iter_next()) != NULL) {
-		ret = encode(us, usp_executor->resp_buffer, usp_executor->resp_buffer_len);
+	/* the stateless iterators do not interfere with other iterations */
+	while ((us = next(us)) != NULL) {
+		ret = prv_write_setting(usp_executor, cmd, us, encode, user_data);
 		if (ret < 0) {
-			__ASSERT(ret == -ENOMEM,
-				 "The encode function must only return the -ENOMEM error");
 			return ret;
 		}
-		ret = usp_executor->write_response(usp_executor->resp_buffer, ret, user_data);
-		if (ret < 0) {
-			return -EIO;
-		}
 	}
 	return 0;
 }
 
-static int prv_exec_list(struct usp_executor *usp_executor, void *user_data)
+static int prv_exec_list(struct usp_executor *usp_executor,
+			 struct user_settings_protocol_command *cmd, void *user_data)
+{
+	return prv_exec_list_common(usp_executor, cmd, usp_executor->encode, false, user_data);
+}
+
+static int prv_exec_list_full(struct usp_executor *usp_executor,
+			      struct user_settings_protocol_command *cmd, void *user_data)
+{
+	return prv_exec_list_common(usp_executor, cmd, usp_executor->encode_full, false, user_data);
+}
+
+static int prv_exec_list_changed(struct usp_executor *usp_executor,
+				 struct user_settings_protocol_command *cmd, void *user_data)
 {
-	return prv_exec_list_common(usp_executor, usp_executor->encode, user_data);
+	return prv_exec_list_common(usp_executor, cmd, usp_executor->encode, true, user_data);
 }
 
-static int prv_exec_list_full(struct usp_executor *usp_executor, void *user_data)
+static int prv_exec_list_changed_full(struct usp_executor *usp_executor,
+				      struct user_settings_protocol_command *cmd, void *user_data)
 {
-	return prv_exec_list_common(usp_executor, usp_executor->encode_full, user_data);
+	return prv_exec_list_common(usp_executor, cmd, usp_executor->encode_full, true, user_data);
 }
 
 /**
@@ -116,6 +189,7 @@ static int prv_exec_list_full(struct usp_executor *usp_executor, void *user_data
  *
  * @retval 0 on success
  * @retval -ENOENT if the setting ID does not exists
+ * @retval -EINVAL if the new value is rejected by the constraints of the setting
  * @retval -ENOEXEC if setting the new value failed
  */
 static int prv_exec_set(uint16_t id, uint8_t *value, uint8_t value_len)
@@ -124,7 +198,9 @@ static int prv_exec_set(uint16_t id, uint8_t *value, uint8_t value_len)
 		return -ENOENT;
 	}
 	int ret = user_settings_set_with_id(id, value, value_len);
-	if (ret < 0) {
+	if (ret == -EINVAL) {
+		return ret;
+	} else if (ret < 0) {
 		return -ENOEXEC;
 	}
 	return 0;
@@ -139,6 +215,7 @@ static int prv_exec_set(uint16_t id, uint8_t *value, uint8_t value_len)
  *
  * @retval 0 on success
  * @retval -ENOENT if the setting ID does not exists
+ * @retval -EINVAL if the new default value is rejected by the constraints of the setting
  * @retval -ENOEXEC if setting the new default value failed
  */
 static int prv_exec_set_default(uint16_t id, uint8_t *value, uint8_t value_len)
@@ -147,7 +224,9 @@ static int prv_exec_set_default(uint16_t id, uint8_t *value, uint8_t value_len)
 		return -ENOENT;
 	}
 	int ret = user_settings_set_default_with_id(id, value, value_len);
-	if (ret < 0) {
+	if (ret == -EINVAL) {
+		return ret;
+	} else if (ret < 0) {
 		return -ENOEXEC;
 	}
 	return 0;
@@ -170,6 +249,7 @@ static int prv_exec_restore(void)
  * Iterate over all setting ID's provided, encode them and write each one as a response.
  *
  * @param[in] usp_executor The executor
+ * @param[in] cmd The command that is being responded to
  * @param[in] num_ids The number of setting ID's provided
  * @param[in] ids The setting ID's provided
  * @param[in] user_data The user data to pass to the write_response function
@@ -179,12 +259,13 @@ static int prv_exec_restore(void)
  * @retval -ENOMEM if the resp_buffer is to small to fit the encoded response
  * @retval -EIO if writing the response failed
  */
-static int prv_exec_list_some(struct usp_executor *usp_executor, uint8_t num_ids, uint16_t *ids,
-			      void *user_data)
+static int prv_exec_list_some(struct usp_executor *usp_executor,
+			      struct user_settings_protocol_command *cmd, uint8_t num_ids,
+			      uint16_t *ids, void *user_data)
 {
 	for (int i = 0; i < num_ids; i++) {
-		int ret =
-			prv_exec_get_common(usp_executor, ids[i], usp_executor->encode, user_data);
+		int ret = prv_exec_get_common(usp_executor, cmd, ids[i], usp_executor->encode,
+					      user_data);
 		if (ret < 0) {
 			return ret;
 		}
@@ -198,6 +279,7 @@ static int prv_exec_list_some(struct usp_executor *usp_executor, uint8_t num_ids
  * Iterate over all setting ID's provided, encode them and write each one as a response.
  *
  * @param[in] usp_executor The executor
+ * @param[in] cmd The command that is being responded to
  * @param[in] num_ids The number of setting ID's provided
  * @param[in] ids The setting ID's provided
  * @param[in] user_data The user data to pass to the write_response function
@@ -207,12 +289,13 @@ static int prv_exec_list_some(struct usp_executor *usp_executor, uint8_t num_ids
  * @retval -ENOMEM if the resp_buffer is to small to fit the encoded response
  * @retval -EIO if writing the response failed
  */
-static int prv_exec_list_some_full(struct usp_executor *usp_executor, uint8_t num_ids,
+static int prv_exec_list_some_full(struct usp_executor *usp_executor,
+				   struct user_settings_protocol_command *cmd, uint8_t num_ids,
 				   uint16_t *ids, void *user_data)
 {
 	for (int i = 0; i < num_ids; i++) {
-		int ret = prv_exec_get_common(usp_executor, ids[i], usp_executor->encode_full,
-					      user_data);
+		int ret = prv_exec_get_common(usp_executor, cmd, ids[i],
+					      usp_executor->encode_full, user_data);
 		if (ret < 0) {
 			return ret;
 		}
@@ -230,42 +313,394 @@ int usp_executor_parse_and_execute(struct usp_executor *usp_executor, uint8_t *b
 {
 	int ret;
 	struct user_settings_protocol_command cmd = {0};
+	uint8_t first_byte = len > 0 ? buffer[0] : 0;
+
+	USER_SETTINGS_TRACE_ENTER("parse_exec", first_byte);
 
 	/* decode command first */
+	USER_SETTINGS_TRACE_ENTER("decode", first_byte);
 	ret = usp_executor->decode_command(buffer, len, &cmd);
+	USER_SETTINGS_TRACE_EXIT("decode", first_byte, ret);
+
+	if (ret >= 0) {
+		ret = usp_executor_execute(usp_executor, &cmd, user_data);
+	} else {
+		/* not a valid command, only counted as an error */
+		user_settings_stats_count_command(0, ret);
+	}
+
+	USER_SETTINGS_TRACE_EXIT("parse_exec", first_byte, ret);
+
+	return ret;
+}
+
+/**
+ * @brief Execute an EXPORT command
+ *
+ * Write the bulk blob in chunks that fill the resp_buffer, each chunk as a separate response.
+ *
+ * @param[in] usp_executor The executor
+ * @param[in] cmd The command that is being responded to
+ * @param[in] user_data The user data to pass to the write_response function
+ *
+ * @retval 0 on success
+ * @retval -ENOMEM if the resp_buffer is to small to fit the response header and any data
+ * @retval -EIO if writing the response failed or the value of a lazy setting could not be read
+ */
+static int prv_exec_export(struct usp_executor *usp_executor,
+			   struct user_settings_protocol_command *cmd, void *user_data)
+{
+	int header_len = 0;
+	if (cmd->has_seq) {
+		header_len = usp_executor->encode_header(cmd, USP_RESPONSE_DATA, 0,
+							 usp_executor->resp_buffer,
+							 usp_executor->resp_buffer_len);
+		if (header_len < 0) {
+			return header_len;
+		}
+	}
+
+	if (header_len == usp_executor->resp_buffer_len) {
+		return -ENOMEM;
+	}
+
+	struct user_settings_export_cursor cursor = {0};
+	int ret;
+	while ((ret = user_settings_export_binary(&usp_executor->resp_buffer[header_len],
+						  usp_executor->resp_buffer_len - header_len,
+						  &cursor)) > 0) {
+		ret = usp_executor->write_response(usp_executor->resp_buffer, header_len + ret,
+						   user_data);
+		if (ret < 0) {
+			return -EIO;
+		}
+	}
+
+	return ret;
+}
+
+/**
+ * @brief Execute an IMPORT command
+ *
+ * @param[in] value 4 byte offset followed by the chunk
+ * @param[in] value_len The length of the value
+ *
+ * @retval 0 on success
+ * @retval -ENOTSUP if chunked imports are disabled
+ * @retval -ENOEXEC if the chunk could not be added
+ */
+static int prv_exec_import(uint8_t *value, uint8_t value_len)
+{
+	uint32_t offset = sys_get_le32(value);
+	int ret = user_settings_import_binary_chunk(offset, &value[4], value_len - 4);
+	if (ret == -ENOTSUP) {
+		return ret;
+	}
+	return ret < 0 ? -ENOEXEC : 0;
+}
+
+/**
+ * @brief Execute an IMPORT_COMMIT command
+ *
+ * @retval 0 on success
+ * @retval -ENOTSUP if chunked imports are disabled
+ * @retval -ENOEXEC if the import failed
+ */
+static int prv_exec_import_commit(void)
+{
+	int ret = user_settings_import_binary_commit();
+	if (ret == -ENOTSUP) {
+		return ret;
+	}
+	return ret < 0 ? -ENOEXEC : 0;
+}
+
+/**
+ * @brief Execute a READ_AT command
+ *
+ * Write a chunk of the value of a setting as a response. The chunk is shorter than requested (or
+ * empty) at the end of the value.
+ *
+ * @param[in] usp_executor The executor
+ * @param[in] cmd The command that is being responded to. The value holds a 4 byte offset and the
+ * 1 byte maximum length of the chunk.
+ * @param[in] user_data The user data to pass to the write_response function
+ *
+ * @retval 0 on success
+ * @retval -ENOENT if the setting ID does not exists
+ * @retval -ENOMEM if the resp_buffer is to small to fit the response header
+ * @retval -ENOEXEC if the value could not be read
+ * @retval -EIO if writing the response failed
+ */
+static int prv_exec_read_at(struct usp_executor *usp_executor,
+			    struct user_settings_protocol_command *cmd, void *user_data)
+{
+	if (!user_settings_exists_with_id(cmd->id)) {
+		return -ENOENT;
+	}
+
+	int header_len = 0;
+	if (cmd->has_seq) {
+		header_len = usp_executor->encode_header(cmd, USP_RESPONSE_DATA, 0,
+							 usp_executor->resp_buffer,
+							 usp_executor->resp_buffer_len);
+		if (header_len < 0) {
+			return header_len;
+		}
+	}
+
+	uint32_t offset = sys_get_le32(cmd->value);
+	size_t len = MIN(cmd->value[4], usp_executor->resp_buffer_len - header_len);
+	int ret = user_settings_read_at_with_id(cmd->id, offset,
+						&usp_executor->resp_buffer[header_len], len);
+	if (ret < 0) {
+		return -ENOEXEC;
+	}
+
+	ret = usp_executor->write_response(usp_executor->resp_buffer, header_len + ret, user_data);
+	if (ret < 0) {
+		return -EIO;
+	}
+	return 0;
+}
+
+/**
+ * @brief Execute a WRITE_AT command
+ *
+ * @param[in] id The setting ID
+ * @param[in] value 4 byte offset followed by the chunk
+ * @param[in] value_len The length of the value
+ *
+ * @retval 0 on success
+ * @retval -ENOENT if the setting ID does not exists
+ * @retval -ENOEXEC if the chunk could not be written
+ */
+static int prv_exec_write_at(uint16_t id, uint8_t *value, uint8_t value_len)
+{
+	if (!user_settings_exists_with_id(id)) {
+		return -ENOENT;
+	}
+	uint32_t offset = sys_get_le32(value);
+	int ret = user_settings_write_at_with_id(id, offset, &value[4], value_len - 4);
+	return ret < 0 ? -ENOEXEC : 0;
+}
+
+/**
+ * @brief Execute a WRITE_COMMIT command
+ *
+ * @param[in] id The setting ID
+ *
+ * @retval 0 on success
+ * @retval -ENOENT if the setting ID does not exists
+ * @retval -ENOEXEC if storing the written value failed
+ */
+static int prv_exec_write_commit(uint16_t id)
+{
+	if (!user_settings_exists_with_id(id)) {
+		return -ENOENT;
+	}
+	int ret = user_settings_write_commit_with_id(id);
+	return ret < 0 ? -ENOEXEC : 0;
+}
+
+/**
+ * @brief Write the flash write counters as a response
+ *
+ * The counters are encoded as little endian 4 byte numbers after the response header.
+ *
+ * @param[in] usp_executor The executor
+ * @param[in] cmd The command that is being responded to
+ * @param[in] values The counters
+ * @param[in] num_values The number of counters
+ * @param[in] user_data The user data to pass to the write_response function
+ *
+ * @retval 0 on success
+ * @retval -ENOMEM if the resp_buffer is to small to fit the response
+ * @retval -EIO if writing the response failed
+ */
+static int prv_write_counters(struct usp_executor *usp_executor,
+			      struct user_settings_protocol_command *cmd, const uint32_t *values,
+			      size_t num_values, void *user_data)
+{
+	int header_len = 0;
+	if (cmd->has_seq) {
+		header_len = usp_executor->encode_header(cmd, USP_RESPONSE_DATA, 0,
+							 usp_executor->resp_buffer,
+							 usp_executor->resp_buffer_len);
+		if (header_len < 0) {
+			return header_len;
+		}
+	}
+
+	if (usp_executor->resp_buffer_len < header_len + num_values * 4) {
+		return -ENOMEM;
+	}
+
+	for (size_t i = 0; i < num_values; i++) {
+		sys_put_le32(values[i], &usp_executor->resp_buffer[header_len + i * 4]);
+	}
+
+	int ret = usp_executor->write_response(usp_executor->resp_buffer,
+					       header_len + num_values * 4, user_data);
+	if (ret < 0) {
+		return -EIO;
+	}
+	return 0;
+}
+
+/**
+ * @brief Execute a WEAR_STATS command
+ *
+ * @param[in] usp_executor The executor
+ * @param[in] cmd The command that is being responded to
+ * @param[in] user_data The user data to pass to the write_response function
+ *
+ * @retval 0 on success
+ * @retval -ENOENT if the setting ID does not exists
+ * @retval -ENOTSUP if the counters are disabled
+ * @retval -ENOMEM if the resp_buffer is to small to fit the response
+ * @retval -EIO if writing the response failed
+ */
+static int prv_exec_wear_stats(struct usp_executor *usp_executor,
+			       struct user_settings_protocol_command *cmd, void *user_data)
+{
+	if (!user_settings_exists_with_id(cmd->id)) {
+		return -ENOENT;
+	}
+
+	struct user_settings_wear_stats stats;
+	int ret = user_settings_get_wear_stats_with_id(cmd->id, &stats);
 	if (ret < 0) {
 		return ret;
 	}
 
-	switch (cmd.type) {
+	uint32_t values[] = {stats.writes, stats.bytes, stats.skipped};
+	return prv_write_counters(usp_executor, cmd, values, ARRAY_SIZE(values), user_data);
+}
+
+/**
+ * @brief Execute a WEAR_TOTALS command
+ *
+ * @param[in] usp_executor The executor
+ * @param[in] cmd The command that is being responded to
+ * @param[in] user_data The user data to pass to the write_response function
+ *
+ * @retval 0 on success
+ * @retval -ENOTSUP if the counters are disabled
+ * @retval -ENOMEM if the resp_buffer is to small to fit the response
+ * @retval -EIO if writing the response failed
+ */
+static int prv_exec_wear_totals(struct usp_executor *usp_executor,
+				struct user_settings_protocol_command *cmd, void *user_data)
+{
+	struct user_settings_wear_totals totals;
+	int ret = user_settings_get_wear_totals(&totals);
+	if (ret < 0) {
+		return ret;
+	}
+
+	uint32_t values[] = {totals.sum.writes, totals.sum.bytes, totals.sum.skipped,
+			     totals.boot_writes, totals.writes_per_hour};
+	return prv_write_counters(usp_executor, cmd, values, ARRAY_SIZE(values), user_data);
+}
+
+/**
+ * @brief Execute a STATS command
+ *
+ * @param[in] usp_executor The executor
+ * @param[in] cmd The command that is being responded to
+ * @param[in] user_data The user data to pass to the write_response function
+ *
+ * @retval 0 on success
+ * @retval -ENOTSUP if the stats group is disabled
+ * @retval -ENOMEM if the resp_buffer is to small to fit the response
+ * @retval -EIO if writing the response failed
+ */
+static int prv_exec_stats(struct usp_executor *usp_executor,
+			  struct user_settings_protocol_command *cmd, void *user_data)
+{
+#if defined(CONFIG_USER_SETTINGS_STATS)
+	uint32_t values[(sizeof(user_settings_stats) - sizeof(struct stats_hdr)) / sizeof(uint32_t)];
+
+	int num_values = user_settings_stats_read(values, ARRAY_SIZE(values));
+	if (num_values < 0) {
+		return num_values;
+	}
+
+	return prv_write_counters(usp_executor, cmd, values, num_values, user_data);
+#else
+	return -ENOTSUP;
+#endif
+}
+
+/**
+ * @brief Execute a decoded command without sending the done response
+ */
+static int prv_execute(struct usp_executor *usp_executor,
+		       struct user_settings_protocol_command *cmd, void *user_data)
+{
+	switch (cmd->type) {
 	case USPC_GET: {
-		return prv_exec_get(usp_executor, cmd.id, user_data);
+		return prv_exec_get(usp_executor, cmd, user_data);
 	}
 	case USPC_GET_FULL: {
-		return prv_exec_get_full(usp_executor, cmd.id, user_data);
+		return prv_exec_get_full(usp_executor, cmd, user_data);
 	}
 	case USPC_LIST: {
-		return prv_exec_list(usp_executor, user_data);
+		return prv_exec_list(usp_executor, cmd, user_data);
 	}
 	case USPC_LIST_FULL: {
-		return prv_exec_list_full(usp_executor, user_data);
+		return prv_exec_list_full(usp_executor, cmd, user_data);
 	}
 	case USPC_SET: {
-		return prv_exec_set(cmd.id, cmd.value, cmd.value_len);
+		return prv_exec_set(cmd->id, cmd->value, cmd->value_len);
 	}
 	case USPC_SET_DEFAULT: {
-		return prv_exec_set_default(cmd.id, cmd.value, cmd.value_len);
+		return prv_exec_set_default(cmd->id, cmd->value, cmd->value_len);
 	}
 	case USPC_RESTORE: {
 		return prv_exec_restore();
 	}
 	case USPC_LIST_SOME: {
-		return prv_exec_list_some(usp_executor, cmd.value_len / 2, (uint16_t *)cmd.value,
-					  user_data);
+		return prv_exec_list_some(usp_executor, cmd, cmd->value_len / 2,
+					  (uint16_t *)cmd->value, user_data);
 	}
 	case USPC_LIST_SOME_FULL: {
-		return prv_exec_list_some_full(usp_executor, cmd.value_len / 2,
-					       (uint16_t *)cmd.value, user_data);
+		return prv_exec_list_some_full(usp_executor, cmd, cmd->value_len / 2,
+					       (uint16_t *)cmd->value, user_data);
+	}
+	case USPC_LIST_CHANGED: {
+		return prv_exec_list_changed(usp_executor, cmd, user_data);
+	}
+	case USPC_LIST_CHANGED_FULL: {
+		return prv_exec_list_changed_full(usp_executor, cmd, user_data);
+	}
+	case USPC_EXPORT: {
+		return prv_exec_export(usp_executor, cmd, user_data);
+	}
+	case USPC_IMPORT: {
+		return prv_exec_import(cmd->value, cmd->value_len);
+	}
+	case USPC_IMPORT_COMMIT: {
+		return prv_exec_import_commit();
+	}
+	case USPC_READ_AT: {
+		return prv_exec_read_at(usp_executor, cmd, user_data);
+	}
+	case USPC_WRITE_AT: {
+		return prv_exec_write_at(cmd->id, cmd->value, cmd->value_len);
+	}
+	case USPC_WRITE_COMMIT: {
+		return prv_exec_write_commit(cmd->id);
+	}
+	case USPC_WEAR_STATS: {
+		return prv_exec_wear_stats(usp_executor, cmd, user_data);
+	}
+	case USPC_WEAR_TOTALS: {
+		return prv_exec_wear_totals(usp_executor, cmd, user_data);
+	}
+	case USPC_STATS: {
+		return prv_exec_stats(usp_executor, cmd, user_data);
 	}
 
 	default: {
@@ -276,3 +711,45 @@ int usp_executor_parse_and_execute(struct usp_executor *usp_executor, uint8_t *b
 	}
 	}
 }
+
+/**
+ * @brief Execute a decoded command and send the done response, with prv_exec_lock held
+ */
+static int prv_execute_locked(struct usp_executor *usp_executor,
+			      struct user_settings_protocol_command *cmd, void *user_data)
+{
+	USER_SETTINGS_TRACE_ENTER("exec", cmd->type);
+	int ret = prv_execute(usp_executor, cmd, user_data);
+	USER_SETTINGS_TRACE_EXIT("exec", cmd->type, ret);
+
+	user_settings_stats_count_command(cmd->type, ret);
+
+	if (!cmd->has_seq) {
+		return ret;
+	}
+
+	/* Commands with a sequence number are always completed with a done response, so the
+	 * client can match the result even if it did not wait for the previous command */
+	int header_len = usp_executor->encode_header(cmd, USP_RESPONSE_DONE, ret,
+						     usp_executor->resp_buffer,
+						     usp_executor->resp_buffer_len);
+	if (header_len < 0) {
+		return ret < 0 ? ret : header_len;
+	}
+
+	int err = usp_executor->write_response(usp_executor->resp_buffer, header_len, user_data);
+	if (err < 0 && ret == 0) {
+		return -EIO;
+	}
+	return ret;
+}
+
+int usp_executor_execute(struct usp_executor *usp_executor,
+			 struct user_settings_protocol_command *cmd, void *user_data)
+{
+	k_mutex_lock(&prv_exec_lock, K_FOREVER);
+	int ret = prv_execute_locked(usp_executor, cmd, user_data);
+	k_mutex_unlock(&prv_exec_lock);
+
+	return ret;
+}
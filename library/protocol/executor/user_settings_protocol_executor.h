@@ -27,6 +27,10 @@ typedef int (*uspe_decode_command_t)(uint8_t *buffer, size_t len,
 
 typedef int (*uspe_encode_t)(struct user_setting *user_setting, uint8_t *buffer, size_t len);
 
+typedef int (*uspe_encode_header_t)(struct user_settings_protocol_command *command,
+				    enum user_settings_protocol_response_kind kind, int status,
+				    uint8_t *buffer, size_t len);
+
 typedef int (*uspe_write_response_t)(uint8_t *buffer, size_t len, void *user_data);
 /**
  * @brief The protocol executor
@@ -57,7 +61,8 @@ struct usp_executor {
 	 * @param[out] buffer The buffer to encode into
 	 * @param[in] len The length of the buffer
 	 *
-	 * @return The number of bytes written or -ENOMEM if the provided buffer is to small
+	 * @return The number of bytes written, -ENOMEM if the provided buffer is to small or -EIO if
+	 * the value could not be read
 	 */
 	uspe_encode_t encode;
 
@@ -70,10 +75,30 @@ struct usp_executor {
 	 * @param[out] buffer The buffer to encode into
 	 * @param[in] len The length of the buffer
 	 *
-	 * @return The number of bytes written or -ENOMEM if the provided buffer is to small
+	 * @return The number of bytes written, -ENOMEM if the provided buffer is to small or -EIO if
+	 * the value could not be read
 	 */
 	uspe_encode_t encode_full;
 
+	/**
+	 * @brief Encode the response header for a command with a sequence number
+	 *
+	 * Only used for commands decoded with has_seq set. Each response to such a command starts
+	 * with a USP_RESPONSE_DATA header, followed by the encoded setting. After the command is
+	 * executed, a USP_RESPONSE_DONE header with the result is written as the last response.
+	 * Can be NULL if the decoder never sets has_seq.
+	 *
+	 * @param[in] command The command that is being responded to
+	 * @param[in] kind The kind of the response
+	 * @param[in] status The result of the command, only for USP_RESPONSE_DONE
+	 * @param[out] buffer The buffer to encode into
+	 * @param[in] len The length of the buffer
+	 *
+	 * @return The number of bytes written, -ENOMEM if the provided buffer is to small or -EIO if
+	 * the value could not be read
+	 */
+	uspe_encode_header_t encode_header;
+
 	/**
 	 * @brief Write a response from the executor into the protocol transport
 	 *
@@ -120,6 +145,96 @@ struct usp_executor {
 int usp_executor_parse_and_execute(struct usp_executor *usp_executor, uint8_t *buffer, size_t len,
 				   void *user_data);
 
+/**
+ * @brief Execute an already decoded user settings protocol command
+ *
+ * If the command has a sequence number, a done response with the result is written after the
+ * command was executed, also if it failed.
+ *
+ * Commands of all executors are serialized, so transports may call this from different threads.
+ *
+ * @param[in] usp_executor The executor to use
+ * @param[in] cmd The decoded command
+ * @param[in] user_data The user data to pass to the write_response function
+ *
+ * @retval 0 on success
+ * @retval -ENOTSUP if the command type is not known
+ * @retval -ENOENT if the command specifies a setting ID that does not exists
+ * @retval -ENOMEM if the provided resp_buffer is to small to fit the encoded response
+ * @retval -EIO if writing the response failed (see write_response above for details)
+ * @retval -ENOEXEC if the operation on user settings failed (i.e. setting a new value)
+ */
+int usp_executor_execute(struct usp_executor *usp_executor,
+			 struct user_settings_protocol_command *cmd, void *user_data);
+
+/**
+ * @brief Statistics of the asynchronous executor
+ */
+struct usp_executor_async_stats {
+	/** Number of commands accepted into the queue */
+	uint32_t submitted;
+	/** Number of commands executed (successfully or not) */
+	uint32_t executed;
+	/** Number of executed commands that returned an error */
+	uint32_t failed;
+	/** Number of commands rejected because the queue was full */
+	uint32_t dropped;
+	/** Number of commands currently waiting in the queue */
+	uint32_t queue_depth;
+	/** Highest number of commands that were waiting in the queue at the same time */
+	uint32_t max_queue_depth;
+	/** Time from submit until execution finished for the last command, in microseconds */
+	uint32_t last_latency_us;
+	/** Highest time from submit until execution finished, in microseconds */
+	uint32_t max_latency_us;
+	/** Sum of all latencies, in microseconds. Divide by executed to get the average */
+	uint64_t total_latency_us;
+};
+
+/**
+ * @brief Decode a command and queue it for asynchronous execution
+ *
+ * The command is decoded in the caller's context, so protocol errors are returned immediately.
+ * The decoded command is then copied into a queue and executed later by a dedicated thread.
+ * Responses are written with the write_response function of @p usp_executor from that thread.
+ * Errors returned while executing the command are logged and counted in the statistics.
+ *
+ * The resp_buffer of @p usp_executor is used by the worker thread, so the same executor must not
+ * be used with usp_executor_parse_and_execute() at the same time.
+ *
+ * Requires CONFIG_USER_SETTINGS_PROTOCOL_EXECUTOR_ASYNC.
+ *
+ * @param[in] usp_executor The executor to use
+ * @param[in] buffer The raw buffer to parse
+ * @param[in] len The length of the buffer
+ * @param[in] user_data The user data to pass to the write_response function
+ *
+ * @retval 0 if the command was queued
+ * @retval -EPROTO if decoding failed
+ * @retval -ENOTSUP if the command is not supported in this protocol format
+ * @retval -EBUSY if the queue is full
+ */
+int usp_executor_async_submit(struct usp_executor *usp_executor, uint8_t *buffer, size_t len,
+			      void *user_data);
+
+/**
+ * @brief Get the statistics of the asynchronous executor
+ *
+ * Requires CONFIG_USER_SETTINGS_PROTOCOL_EXECUTOR_ASYNC.
+ *
+ * @param[out] stats The current statistics
+ */
+void usp_executor_async_stats_get(struct usp_executor_async_stats *stats);
+
+/**
+ * @brief Reset the statistics of the asynchronous executor
+ *
+ * The current queue depth is kept.
+ *
+ * Requires CONFIG_USER_SETTINGS_PROTOCOL_EXECUTOR_ASYNC.
+ */
+void usp_executor_async_stats_reset(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,151 @@
+/** @file user_settings_protocol_executor_async.c
+ *
+ * @brief Asynchronous execution of user settings protocol commands
+ *
+ * Commands are decoded in the caller's context, copied into a message queue and executed by a
+ * dedicated thread. This keeps slow commands (LIST, RESTORE, flash writes) out of i.e. the
+ * Bluetooth RX thread.
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2023 Irnas. All rights reserved.
+ */
+
+#include "user_settings_protocol_executor.h"
+
+#include <user_settings_stats.h>
+#include <user_settings_trace.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(usp_executor_async, CONFIG_USER_SETTINGS_LOG_LEVEL);
+
+/**
+ * @brief A decoded command waiting for execution
+ */
+struct prv_async_cmd {
+	/** The executor to execute the command with */
+	struct usp_executor *usp_executor;
+	/** The user data to pass to the write_response function */
+	void *user_data;
+	/** Cycle count when the command was submitted */
+	uint32_t submitted_at;
+	/** The decoded command */
+	struct user_settings_protocol_command cmd;
+};
+
+K_MSGQ_DEFINE(prv_cmd_msgq, sizeof(struct prv_async_cmd),
+	      CONFIG_USER_SETTINGS_PROTOCOL_EXECUTOR_ASYNC_QUEUE_SIZE, 4);
+
+static struct k_spinlock prv_stats_lock;
+static struct usp_executor_async_stats prv_stats;
+
+int usp_executor_async_submit(struct usp_executor *usp_executor, uint8_t *buffer, size_t len,
+			      void *user_data)
+{
+	struct prv_async_cmd item = {
+		.usp_executor = usp_executor,
+		.user_data = user_data,
+	};
+
+	/* decode in the caller's context so protocol errors can be returned immediately */
+	USER_SETTINGS_TRACE_ENTER("decode", len > 0 ? buffer[0] : 0);
+	int ret = usp_executor->decode_command(buffer, len, &item.cmd);
+	USER_SETTINGS_TRACE_EXIT("decode", len > 0 ? buffer[0] : 0, ret);
+	if (ret < 0) {
+		user_settings_stats_count_command(0, ret);
+		return ret;
+	}
+
+	item.submitted_at = k_cycle_get_32();
+
+	/* Update the depth before the command is visible to the worker, so it can never go below
+	 * zero */
+	k_spinlock_key_t key = k_spin_lock(&prv_stats_lock);
+	prv_stats.queue_depth++;
+	k_spin_unlock(&prv_stats_lock, key);
+
+	ret = k_msgq_put(&prv_cmd_msgq, &item, K_NO_WAIT);
+
+	key = k_spin_lock(&prv_stats_lock);
+	if (ret < 0) {
+		prv_stats.queue_depth--;
+		prv_stats.dropped++;
+	} else {
+		prv_stats.submitted++;
+		prv_stats.max_queue_depth = MAX(prv_stats.max_queue_depth, prv_stats.queue_depth);
+	}
+	k_spin_unlock(&prv_stats_lock, key);
+
+	if (ret < 0) {
+		LOG_WRN("Command queue full, dropping command %d", item.cmd.type);
+		return -EBUSY;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Execute a single queued command and update the statistics
+ *
+ * @param[in] item The queued command
+ */
+static void prv_execute_queued(struct prv_async_cmd *item)
+{
+	k_spinlock_key_t key = k_spin_lock(&prv_stats_lock);
+	prv_stats.queue_depth--;
+	k_spin_unlock(&prv_stats_lock, key);
+
+	int ret = usp_executor_execute(item->usp_executor, &item->cmd, item->user_data);
+	if (ret < 0) {
+		LOG_ERR("usp_executor_execute, command %d, err: %d", item->cmd.type, ret);
+	}
+
+	uint32_t latency_us = k_cyc_to_us_floor32(k_cycle_get_32() - item->submitted_at);
+
+	key = k_spin_lock(&prv_stats_lock);
+	prv_stats.executed++;
+	if (ret < 0) {
+		prv_stats.failed++;
+	}
+	prv_stats.last_latency_us = latency_us;
+	prv_stats.max_latency_us = MAX(prv_stats.max_latency_us, latency_us);
+	prv_stats.total_latency_us += latency_us;
+	k_spin_unlock(&prv_stats_lock, key);
+}
+
+static void prv_executor_thread(void *p1, void *p2, void *p3)
+{
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	struct prv_async_cmd item;
+
+	while (true) {
+		k_msgq_get(&prv_cmd_msgq, &item, K_FOREVER);
+		prv_execute_queued(&item);
+	}
+}
+
+K_THREAD_DEFINE(prv_executor_tid, CONFIG_USER_SETTINGS_PROTOCOL_EXECUTOR_ASYNC_STACK_SIZE,
+		prv_executor_thread, NULL, NULL, NULL,
+		K_PRIO_PREEMPT(CONFIG_USER_SETTINGS_PROTOCOL_EXECUTOR_ASYNC_PRIORITY), 0, 0);
+
+void usp_executor_async_stats_get(struct usp_executor_async_stats *stats)
+{
+	k_spinlock_key_t key = k_spin_lock(&prv_stats_lock);
+	*stats = prv_stats;
+	k_spin_unlock(&prv_stats_lock, key);
+}
+
+void usp_executor_async_stats_reset(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&prv_stats_lock);
+	uint32_t queue_depth = prv_stats.queue_depth;
+	prv_stats = (struct usp_executor_async_stats){
+		.queue_depth = queue_depth,
+		.max_queue_depth = queue_depth,
+	};
+	k_spin_unlock(&prv_stats_lock, key);
+}
@@ -13,6 +13,7 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
 #include <zephyr/types.h>
 
 /**
@@ -47,11 +48,58 @@ enum user_settings_protocol_command_type {
 	 */
 	USPC_LIST_SOME_FULL = 9,
 
+	/** Get id, key, name, type, length and value for each setting marked changed. */
+	USPC_LIST_CHANGED = 10,
+
+	/** Get id, key, name, type, length, max length value, default value for each setting
+	 * marked changed. */
+	USPC_LIST_CHANGED_FULL = 11,
+
+	/** Export all settings as a bulk blob (see user_settings_export_binary()). */
+	USPC_EXPORT = 12,
+
+	/** Add a chunk to a bulk import. The value holds a 4 byte offset followed by the chunk. */
+	USPC_IMPORT = 13,
+
+	/** Apply the collected bulk import. */
+	USPC_IMPORT_COMMIT = 14,
+
+	/** Read a chunk of a string or bytes value (id must be provided). The value holds a 4 byte
+	 * offset followed by the 1 byte maximum length of the chunk. */
+	USPC_READ_AT = 15,
+
+	/** Write a chunk of a string or bytes value (id must be provided). The value holds a 4 byte
+	 * offset followed by the chunk. */
+	USPC_WRITE_AT = 16,
+
+	/** Store the value written with USPC_WRITE_AT (id must be provided). */
+	USPC_WRITE_COMMIT = 17,
+
+	/** Get the flash write counters of a setting (id must be provided). */
+	USPC_WEAR_STATS = 18,
+
+	/** Get the sums of the flash write counters of all settings and the write rate. */
+	USPC_WEAR_TOTALS = 19,
+
+	/** Get the counters of the user settings stats group. */
+	USPC_STATS = 20,
+
 	/** Internal use only. */
 	USPC_NUM_COMMANDS,
 
 } __attribute__((packed));
 
+/**
+ * @brief Kinds of responses to a command with a sequence number
+ */
+enum user_settings_protocol_response_kind {
+	/** The response contains an encoded setting. */
+	USP_RESPONSE_DATA = 0,
+
+	/** The command was executed. This is always the last response to a command. */
+	USP_RESPONSE_DONE = 1,
+};
+
 /**
  * @brief Decoded command
  *
@@ -64,11 +112,19 @@ struct user_settings_protocol_command {
 	/** Setting ID. Might not be set (based on chosen command). */
 	uint16_t id;
 
+	/** True if the command carries a sequence number. Responses are then prefixed with a
+	 * header and followed by a done response. */
+	bool has_seq;
+
+	/** Sequence number of the command, if has_seq is set. */
+	uint16_t seq;
+
 	/** if set, number of bytes in value. */
 	uint8_t value_len;
 
 	/** if value_len > 0, the decoded value.
-	 * Note that this is always safe since the maximum length of a setting is 255 bytes.
+	 * This always fits, since value_len is 1 byte. Longer values are written in chunks with
+	 * USPC_WRITE_AT.
 	 */
 	uint8_t value[256];
 
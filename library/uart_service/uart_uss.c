@@ -0,0 +1,295 @@
+/** @file uart_uss.c
+ *
+ * @brief UART transport for user settings
+ *
+ * Reception uses the asynchronous UART API with two RX buffers, so the driver (and DMA, if the
+ * driver uses it) can keep receiving into one buffer while the other one is handed to the COBS
+ * deframer. Complete frames are decoded in place and executed from the system work queue.
+ * Responses are COBS encoded directly from the executor response buffer into one of two TX
+ * buffers, so a response can be encoded while the previous one is still being sent.
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2023 Irnas. All rights reserved.
+ */
+
+#include <uart_uss.h>
+
+#include "uart_uss_cobs.h"
+
+#include <zephyr/drivers/uart.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+
+#include <user_settings_protocol_binary.h>
+#include <user_settings_protocol_executor.h>
+
+LOG_MODULE_REGISTER(uart_uss, CONFIG_USER_SETTINGS_UART_SERVICE_LOG_LEVEL);
+
+/** Longest command: type, sequence number, ID, length and 255 bytes of value */
+#define PRV_MAX_COMMAND_LEN 264
+
+/* Forward declared write response function */
+static int prv_write_response(uint8_t *buffer, size_t len, void *user_data);
+
+/* The UART device in use, NULL if the service is not started */
+static const struct device *prv_uart_dev;
+
+/* Response buffer and binary protocol executor */
+static uint8_t prv_resp_buffer[512];
+static struct usp_executor prv_usp_binary_executor = USP_BINARY_EXECUTOR_DECLARE(
+	prv_resp_buffer, sizeof(prv_resp_buffer), prv_write_response);
+
+/* RX buffers handed to the UART driver */
+static uint8_t prv_rx_bufs[2][CONFIG_USER_SETTINGS_UART_SERVICE_RX_BUF_SIZE];
+static uint8_t prv_rx_buf_idx;
+
+/**
+ * @brief A received frame
+ *
+ * While busy is set, the frame is owned by the work queue and the RX callback must not touch it.
+ */
+struct prv_rx_frame {
+	struct k_work work;
+	atomic_t busy;
+	size_t len;
+	uint8_t buf[UART_USS_COBS_MAX_ENCODED_LEN(PRV_MAX_COMMAND_LEN)];
+};
+
+static struct prv_rx_frame prv_rx_frames[2];
+/* The frame currently being received */
+static uint8_t prv_rx_frame_idx;
+/* Set if the bytes up to the next delimiter must be dropped */
+static bool prv_rx_dropping;
+
+/* TX buffers. prv_tx_count buffers starting at prv_tx_head are filled, the head one is being
+ * sent. */
+static uint8_t prv_tx_bufs[2][UART_USS_COBS_MAX_ENCODED_LEN(sizeof(prv_resp_buffer))];
+static size_t prv_tx_lens[2];
+static uint8_t prv_tx_head;
+static uint8_t prv_tx_count;
+static struct k_spinlock prv_tx_lock;
+K_SEM_DEFINE(prv_tx_free_sem, 2, 2);
+
+static void prv_rx_work_handler(struct k_work *work)
+{
+	struct prv_rx_frame *frame = CONTAINER_OF(work, struct prv_rx_frame, work);
+
+	int len = uart_uss_cobs_decode(frame->buf, frame->len);
+	if (len < 0) {
+		LOG_WRN("Received invalid COBS frame");
+	} else {
+		int err = usp_executor_parse_and_execute(&prv_usp_binary_executor, frame->buf, len,
+							 NULL);
+		if (err) {
+			LOG_DBG("usp_executor_parse_and_execute, err: %d", err);
+		}
+	}
+
+	/* Give the frame back to the RX callback */
+	frame->len = 0;
+	atomic_clear(&frame->busy);
+}
+
+/**
+ * @brief Handle one received byte
+ *
+ * Called from the UART callback (ISR context).
+ *
+ * @param[in] byte The received byte
+ */
+static void prv_rx_byte(uint8_t byte)
+{
+	struct prv_rx_frame *frame = &prv_rx_frames[prv_rx_frame_idx];
+
+	if (atomic_get(&frame->busy) && !prv_rx_dropping) {
+		/* Both frames are waiting for execution */
+		LOG_WRN("Executor busy, dropping frame");
+		prv_rx_dropping = true;
+	}
+
+	if (byte != 0x00) {
+		if (prv_rx_dropping) {
+			return;
+		}
+		if (frame->len == sizeof(frame->buf)) {
+			LOG_WRN("Frame too long, dropping it");
+			prv_rx_dropping = true;
+			return;
+		}
+		frame->buf[frame->len++] = byte;
+		return;
+	}
+
+	/* 0x00 ends a frame */
+	if (prv_rx_dropping) {
+		prv_rx_dropping = false;
+		if (!atomic_get(&frame->busy)) {
+			frame->len = 0;
+		}
+		return;
+	}
+	if (frame->len == 0) {
+		/* Empty frame, i.e. a delimiter sent to resynchronize */
+		return;
+	}
+
+	atomic_set(&frame->busy, 1);
+	k_work_submit(&frame->work);
+	prv_rx_frame_idx ^= 1;
+}
+
+/**
+ * @brief Start sending the next filled TX buffer
+ *
+ * Must be called with prv_tx_lock held.
+ */
+static int prv_tx_start_locked(void)
+{
+	return uart_tx(prv_uart_dev, prv_tx_bufs[prv_tx_head], prv_tx_lens[prv_tx_head],
+		       SYS_FOREVER_US);
+}
+
+/**
+ * @brief Release the TX buffer that was sent and start sending the next one
+ *
+ * Called from the UART callback (ISR context).
+ */
+static void prv_tx_done(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&prv_tx_lock);
+	prv_tx_head ^= 1;
+	prv_tx_count--;
+	if (prv_tx_count > 0) {
+		int err = prv_tx_start_locked();
+		if (err) {
+			LOG_ERR("uart_tx, err: %d", err);
+			prv_tx_head ^= 1;
+			prv_tx_count--;
+			k_sem_give(&prv_tx_free_sem);
+		}
+	}
+	k_spin_unlock(&prv_tx_lock, key);
+
+	k_sem_give(&prv_tx_free_sem);
+}
+
+/**
+ * @brief Send a response as a COBS frame
+ *
+ * @param[in] buffer The response to send
+ * @param[in] len The length of the response
+ * @param[in] user_data Not used
+ *
+ * @retval 0 on success
+ * @retval -EIO if no TX buffer became free in time or sending failed
+ */
+static int prv_write_response(uint8_t *buffer, size_t len, void *user_data)
+{
+	ARG_UNUSED(user_data);
+
+	if (k_sem_take(&prv_tx_free_sem, K_MSEC(CONFIG_USER_SETTINGS_UART_SERVICE_TX_TIMEOUT_MS))) {
+		return -EIO;
+	}
+
+	/* Responses are only written from the work queue, so the free buffer can not change
+	 * until prv_tx_count is incremented below */
+	k_spinlock_key_t key = k_spin_lock(&prv_tx_lock);
+	uint8_t idx = (prv_tx_head + prv_tx_count) % 2;
+	k_spin_unlock(&prv_tx_lock, key);
+
+	/* Encode while the other buffer may still be sending */
+	prv_tx_lens[idx] = uart_uss_cobs_encode(buffer, len, prv_tx_bufs[idx]);
+
+	int err = 0;
+	key = k_spin_lock(&prv_tx_lock);
+	prv_tx_count++;
+	if (prv_tx_count == 1) {
+		err = prv_tx_start_locked();
+		if (err) {
+			prv_tx_count--;
+		}
+	}
+	k_spin_unlock(&prv_tx_lock, key);
+
+	if (err) {
+		LOG_ERR("uart_tx, err: %d", err);
+		k_sem_give(&prv_tx_free_sem);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+static int prv_rx_enable(void)
+{
+	prv_rx_buf_idx = 1;
+	return uart_rx_enable(prv_uart_dev, prv_rx_bufs[0], sizeof(prv_rx_bufs[0]),
+			      CONFIG_USER_SETTINGS_UART_SERVICE_RX_TIMEOUT_US);
+}
+
+static void prv_uart_cb(const struct device *dev, struct uart_event *evt, void *user_data)
+{
+	ARG_UNUSED(user_data);
+
+	switch (evt->type) {
+	case UART_RX_RDY: {
+		for (size_t i = 0; i < evt->data.rx.len; i++) {
+			prv_rx_byte(evt->data.rx.buf[evt->data.rx.offset + i]);
+		}
+		break;
+	}
+	case UART_RX_BUF_REQUEST: {
+		uart_rx_buf_rsp(dev, prv_rx_bufs[prv_rx_buf_idx], sizeof(prv_rx_bufs[0]));
+		prv_rx_buf_idx ^= 1;
+		break;
+	}
+	case UART_RX_DISABLED: {
+		/* Reception stops on line errors, start it again */
+		int err = prv_rx_enable();
+		if (err) {
+			LOG_ERR("uart_rx_enable, err: %d", err);
+		}
+		break;
+	}
+	case UART_TX_DONE:
+	case UART_TX_ABORTED: {
+		prv_tx_done();
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+int uart_uss_init(const struct device *dev)
+{
+	if (prv_uart_dev) {
+		return -EALREADY;
+	}
+
+	if (!device_is_ready(dev)) {
+		return -ENODEV;
+	}
+
+	for (int i = 0; i < ARRAY_SIZE(prv_rx_frames); i++) {
+		k_work_init(&prv_rx_frames[i].work, prv_rx_work_handler);
+	}
+
+	int err = uart_callback_set(dev, prv_uart_cb, NULL);
+	if (err) {
+		LOG_ERR("uart_callback_set, err: %d", err);
+		return err;
+	}
+
+	prv_uart_dev = dev;
+
+	err = prv_rx_enable();
+	if (err) {
+		LOG_ERR("uart_rx_enable, err: %d", err);
+		prv_uart_dev = NULL;
+		return err;
+	}
+
+	return 0;
+}
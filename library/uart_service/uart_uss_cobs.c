@@ -0,0 +1,55 @@
+/** @file uart_uss_cobs.c
+ *
+ * @brief COBS (Consistent Overhead Byte Stuffing) framing of the UART service
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2023 Irnas. All rights reserved.
+ */
+
+#include "uart_uss_cobs.h"
+
+#include <errno.h>
+
+size_t uart_uss_cobs_encode(const uint8_t *src, size_t len, uint8_t *dst)
+{
+	size_t code_idx = 0;
+	size_t out = 1;
+	uint8_t code = 1;
+
+	for (size_t i = 0; i < len; i++) {
+		if (src[i] != 0x00) {
+			dst[out++] = src[i];
+			code++;
+		}
+		if (src[i] == 0x00 || code == 0xFF) {
+			dst[code_idx] = code;
+			code_idx = out++;
+			code = 1;
+		}
+	}
+	dst[code_idx] = code;
+	dst[out++] = 0x00;
+
+	return out;
+}
+
+int uart_uss_cobs_decode(uint8_t *buf, size_t len)
+{
+	size_t in = 0;
+	size_t out = 0;
+
+	while (in < len) {
+		uint8_t code = buf[in++];
+		if (code == 0x00 || in + code - 1 > len) {
+			return -EPROTO;
+		}
+		for (uint8_t i = 1; i < code; i++) {
+			buf[out++] = buf[in++];
+		}
+		if (code != 0xFF && in < len) {
+			buf[out++] = 0x00;
+		}
+	}
+
+	return out;
+}
@@ -0,0 +1,39 @@
+/** @file uart_uss_cobs.h
+ *
+ * @brief COBS (Consistent Overhead Byte Stuffing) framing of the UART service
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2023 Irnas.  All rights reserved.
+ */
+
+#ifndef UART_USS_COBS_H
+#define UART_USS_COBS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Longest COBS encoding of @p len bytes, including the 0x00 delimiter */
+#define UART_USS_COBS_MAX_ENCODED_LEN(len) ((len) + (len) / 254 + 2)
+
+/**
+ * @brief COBS encode a buffer
+ *
+ * @param[in] src The data to encode
+ * @param[in] len The length of the data
+ * @param[out] dst The buffer to encode into, at least UART_USS_COBS_MAX_ENCODED_LEN(len) long
+ *
+ * @return The number of bytes written, including the 0x00 delimiter
+ */
+size_t uart_uss_cobs_encode(const uint8_t *src, size_t len, uint8_t *dst);
+
+/**
+ * @brief COBS decode a frame in place
+ *
+ * @param[in,out] buf The frame without the 0x00 delimiter
+ * @param[in] len The length of the frame
+ *
+ * @return The length of the decoded data or -EPROTO if the frame is not valid
+ */
+int uart_uss_cobs_decode(uint8_t *buf, size_t len);
+
+#endif /* UART_USS_COBS_H */
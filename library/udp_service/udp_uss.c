@@ -0,0 +1,126 @@
+/** @file udp_uss.c
+ *
+ * @brief UDP transport for user settings
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2023 Irnas. All rights reserved.
+ */
+
+#include <udp_uss.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/net/socket.h>
+
+#include <user_settings_protocol_binary.h>
+#include <user_settings_protocol_executor.h>
+
+LOG_MODULE_REGISTER(udp_uss, CONFIG_USER_SETTINGS_UDP_SERVICE_LOG_LEVEL);
+
+/**
+ * @brief The sender of the command being executed, responses are sent back to it
+ */
+struct prv_udp_peer {
+	struct sockaddr addr;
+	socklen_t addr_len;
+};
+
+/* Forward declared write response function */
+static int prv_write_response(uint8_t *buffer, size_t len, void *user_data);
+
+/* The socket in use, -1 if the service is not started */
+static int prv_sock = -1;
+
+/* Response buffer and binary protocol executor */
+static uint8_t prv_resp_buffer[512];
+static struct usp_executor prv_usp_binary_executor = USP_BINARY_EXECUTOR_DECLARE(
+	prv_resp_buffer, sizeof(prv_resp_buffer), prv_write_response);
+
+/* Longest command: type, sequence number, ID, length and 255 bytes of value */
+static uint8_t prv_rx_buffer[264];
+
+static K_KERNEL_STACK_DEFINE(prv_udp_stack, CONFIG_USER_SETTINGS_UDP_SERVICE_STACK_SIZE);
+static struct k_thread prv_udp_thread;
+
+/**
+ * @brief Send a response as a datagram to the sender of the command
+ *
+ * @param[in] buffer The response to send
+ * @param[in] len The length of the response
+ * @param[in] user_data The sender of the command (struct prv_udp_peer)
+ *
+ * @retval 0 on success
+ * @retval -EIO if sending failed
+ */
+static int prv_write_response(uint8_t *buffer, size_t len, void *user_data)
+{
+	struct prv_udp_peer *peer = user_data;
+
+	ssize_t sent = zsock_sendto(prv_sock, buffer, len, 0, &peer->addr, peer->addr_len);
+	if (sent < 0) {
+		LOG_ERR("zsock_sendto, err: %d", errno);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+static void prv_udp_thread_fn(void *p1, void *p2, void *p3)
+{
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	struct prv_udp_peer peer;
+
+	while (true) {
+		peer.addr_len = sizeof(peer.addr);
+		ssize_t len = zsock_recvfrom(prv_sock, prv_rx_buffer, sizeof(prv_rx_buffer), 0,
+					     &peer.addr, &peer.addr_len);
+		if (len < 0) {
+			LOG_ERR("zsock_recvfrom, err: %d", errno);
+			continue;
+		}
+
+		int err = usp_executor_parse_and_execute(&prv_usp_binary_executor, prv_rx_buffer,
+							 len, &peer);
+		if (err) {
+			LOG_DBG("usp_executor_parse_and_execute, err: %d", err);
+		}
+	}
+}
+
+int udp_uss_init(uint16_t port)
+{
+	if (prv_sock >= 0) {
+		return -EALREADY;
+	}
+
+	int sock = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (sock < 0) {
+		LOG_ERR("zsock_socket, err: %d", errno);
+		return -errno;
+	}
+
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_addr.s_addr = htonl(INADDR_ANY),
+		.sin_port = htons(port),
+	};
+
+	if (zsock_bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		int err = -errno;
+		LOG_ERR("zsock_bind, err: %d", err);
+		zsock_close(sock);
+		return err;
+	}
+
+	prv_sock = sock;
+
+	k_thread_create(&prv_udp_thread, prv_udp_stack, K_KERNEL_STACK_SIZEOF(prv_udp_stack),
+			prv_udp_thread_fn, NULL, NULL, NULL,
+			K_PRIO_PREEMPT(CONFIG_USER_SETTINGS_UDP_SERVICE_PRIORITY), 0, K_NO_WAIT);
+	k_thread_name_set(&prv_udp_thread, "udp_uss");
+
+	return 0;
+}
@@ -8,7 +8,12 @@
 
 #include <user_settings.h>
 
+#include "user_settings_cron_update.h"
 #include "user_settings_list.h"
+#include "user_settings_set.h"
+#include "user_settings_trace.h"
+#include "user_settings_zbus_publish.h"
+#include <user_settings_stats.h>
 #include <user_settings_types.h>
 
 #include <stdio.h>
@@ -16,6 +21,8 @@
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/settings/settings.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/crc.h>
 
 LOG_MODULE_REGISTER(user_settings, CONFIG_USER_SETTINGS_LOG_LEVEL);
 
@@ -25,14 +32,291 @@ LOG_MODULE_REGISTER(user_settings, CONFIG_USER_SETTINGS_LOG_LEVEL);
 #define USER_SETTINGS_PREFIX              "user"
 #define USER_SETTINGS_DEFAULT_PREFIX      "user_default"
 #define USER_SETTINGS_CHANGED_FLAG_PREFIX "user_changed"
+#define USER_SETTINGS_WEAR_PREFIX         "user_wear"
 
-/* External callback */
+/* External callbacks */
 static user_settings_on_change_t prv_global_on_change_cb;
+static user_settings_on_change_batch_t prv_batch_on_change_cb;
+static user_settings_on_load_t prv_on_load_cb;
+
+/* Range and prefix subscriptions. Single setting subscriptions are kept with their setting. */
+static sys_slist_t prv_wildcard_subscriptions = SYS_SLIST_STATIC_INIT(&prv_wildcard_subscriptions);
 
 /* state of module */
 static bool prv_is_inited;
 static bool prv_is_loaded;
 
+/* While set, on change callbacks are only marked pending and called by prv_notify_flush() */
+static bool prv_notify_deferred;
+
+/**
+ * @brief Call the global and the setting on change callbacks
+ */
+static void prv_notify_call(struct user_setting *setting)
+{
+	struct user_settings_subscription *sub;
+	struct user_settings_subscription *tmp;
+
+	if (prv_global_on_change_cb) {
+		prv_global_on_change_cb(setting->id, setting->key);
+	}
+
+	if (setting->on_change_cb) {
+		setting->on_change_cb(setting->id, setting->key);
+	}
+
+#if defined(CONFIG_USER_SETTINGS_ZBUS)
+	user_settings_zbus_publish(setting);
+#endif
+
+	/* the SAFE variants let a callback unsubscribe itself */
+	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&setting->subscribers, sub, tmp, node) {
+		sub->cb(setting->id, setting->key);
+	}
+
+	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&prv_wildcard_subscriptions, sub, tmp, node) {
+		bool match = sub->prefix ? strncmp(setting->key, sub->prefix, sub->prefix_len) == 0
+					 : setting->id >= sub->first_id &&
+						   setting->id <= sub->last_id;
+		if (match) {
+			sub->cb(setting->id, setting->key);
+		}
+	}
+}
+
+#if defined(CONFIG_USER_SETTINGS_NOTIFY_ASYNC)
+/* Settings waiting for their on change callbacks, in the order they changed. A setting is queued
+ * at most once, further changes before the callbacks are called are coalesced. */
+static struct user_setting *prv_async_queue[CONFIG_USER_SETTINGS_NOTIFY_ASYNC_EVENTS];
+static size_t prv_async_head;
+static size_t prv_async_count;
+/* Set if a changed setting did not fit into the queue. Its notify_overflow flag is set, so the
+ * work handler finds it in the settings list. */
+static bool prv_async_overflow;
+static struct k_spinlock prv_async_lock;
+static struct k_work prv_async_work;
+/* NULL to use the system work queue */
+static struct k_work_q *prv_async_work_q;
+
+/**
+ * @brief Take the changed settings that did not fit into the queue
+ *
+ * The settings list is walked without the lock, which is only taken for each setting, so
+ * changes from interrupts are not blocked for the whole walk.
+ *
+ * @param[out] batch The changed settings, their notify_queued flag is cleared
+ *
+ * @return The number of changed settings taken, at most ARRAY_SIZE(prv_async_queue)
+ */
+static size_t prv_async_take_overflow(struct user_setting **batch)
+{
+	size_t n = 0;
+	struct user_setting *setting = NULL;
+
+	while (n < ARRAY_SIZE(prv_async_queue) &&
+	       (setting = user_settings_list_next(setting)) != NULL) {
+		k_spinlock_key_t key = k_spin_lock(&prv_async_lock);
+		if (setting->notify_overflow) {
+			setting->notify_overflow = false;
+			setting->notify_queued = false;
+			batch[n++] = setting;
+		}
+		k_spin_unlock(&prv_async_lock, key);
+	}
+
+	if (setting) {
+		/* the walk stopped early, the rest is found in the next round */
+		k_spinlock_key_t key = k_spin_lock(&prv_async_lock);
+		prv_async_overflow = true;
+		k_spin_unlock(&prv_async_lock, key);
+	}
+
+	return n;
+}
+
+/**
+ * @brief Take the next changed settings from the queue
+ *
+ * @param[out] batch The changed settings, their notify_queued flag is cleared
+ *
+ * @return The number of changed settings taken, at most ARRAY_SIZE(prv_async_queue)
+ */
+static size_t prv_async_take(struct user_setting **batch)
+{
+	size_t n = 0;
+
+	k_spinlock_key_t key = k_spin_lock(&prv_async_lock);
+
+	while (prv_async_count > 0) {
+		batch[n] = prv_async_queue[prv_async_head];
+		batch[n]->notify_queued = false;
+		n++;
+		prv_async_head = (prv_async_head + 1) % ARRAY_SIZE(prv_async_queue);
+		prv_async_count--;
+	}
+
+	bool overflow = n == 0 && prv_async_overflow;
+	if (overflow) {
+		/* set again by settings that overflow while the list is walked */
+		prv_async_overflow = false;
+	}
+
+	k_spin_unlock(&prv_async_lock, key);
+
+	return overflow ? prv_async_take_overflow(batch) : n;
+}
+
+static void prv_async_work_handler(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	struct user_setting *batch[ARRAY_SIZE(prv_async_queue)];
+	uint16_t ids[ARRAY_SIZE(prv_async_queue)];
+	size_t n;
+
+	while ((n = prv_async_take(batch)) > 0) {
+		for (size_t i = 0; i < n; i++) {
+			prv_notify_call(batch[i]);
+			ids[i] = batch[i]->id;
+		}
+
+		if (prv_batch_on_change_cb) {
+			prv_batch_on_change_cb(ids, n);
+		}
+	}
+}
+
+/**
+ * @brief Queue the on change callbacks of a setting for the work queue
+ */
+static void prv_async_queue_change(struct user_setting *setting)
+{
+	k_spinlock_key_t key = k_spin_lock(&prv_async_lock);
+
+	if (setting->notify_queued) {
+		/* coalesce with the change that is already queued */
+		k_spin_unlock(&prv_async_lock, key);
+		return;
+	}
+
+	setting->notify_queued = true;
+	if (prv_async_count < ARRAY_SIZE(prv_async_queue)) {
+		size_t tail = (prv_async_head + prv_async_count) % ARRAY_SIZE(prv_async_queue);
+		prv_async_queue[tail] = setting;
+		prv_async_count++;
+	} else {
+		setting->notify_overflow = true;
+		prv_async_overflow = true;
+	}
+
+	k_spin_unlock(&prv_async_lock, key);
+
+	if (prv_async_work_q) {
+		k_work_submit_to_queue(prv_async_work_q, &prv_async_work);
+	} else {
+		k_work_submit(&prv_async_work);
+	}
+}
+
+void user_settings_set_notify_work_q(struct k_work_q *work_q)
+{
+	prv_async_work_q = work_q;
+}
+#endif /* CONFIG_USER_SETTINGS_NOTIFY_ASYNC */
+
+/**
+ * @brief Notify about a changed setting
+ *
+ * Calls the on change callbacks directly, or queues them for the work queue with
+ * CONFIG_USER_SETTINGS_NOTIFY_ASYNC.
+ */
+static void prv_notify_change(struct user_setting *setting)
+{
+	user_settings_cron_update(setting);
+
+	if (prv_notify_deferred) {
+		setting->notify_pending = true;
+		return;
+	}
+
+#if defined(CONFIG_USER_SETTINGS_NOTIFY_ASYNC)
+	prv_async_queue_change(setting);
+#else
+	prv_notify_call(setting);
+
+	if (prv_batch_on_change_cb) {
+		uint16_t id = setting->id;
+		prv_batch_on_change_cb(&id, 1);
+	}
+#endif
+}
+
+/**
+ * @brief Stop deferring on change callbacks and call the ones that are pending
+ *
+ * Each setting is notified once, no matter how many times it changed while callbacks were
+ * deferred.
+ */
+static void prv_notify_flush(void)
+{
+	prv_notify_deferred = false;
+
+	struct user_setting *setting = NULL;
+	while ((setting = user_settings_list_next(setting)) != NULL) {
+		if (setting->notify_pending) {
+			setting->notify_pending = false;
+			prv_notify_change(setting);
+		}
+	}
+}
+
+/**
+ * @brief Notify about a value read by the settings backend
+ *
+ * With CONFIG_USER_SETTINGS_LOAD_QUIET, values read by user_settings_load() are only reported
+ * together, by prv_notify_load_complete().
+ */
+static void prv_notify_value_set(struct user_setting *setting)
+{
+	if (IS_ENABLED(CONFIG_USER_SETTINGS_LOAD_QUIET) && !prv_is_loaded) {
+		return;
+	}
+
+	prv_notify_change(setting);
+}
+
+/**
+ * @brief Call the on load callback with the bitmap of loaded settings
+ */
+static void prv_notify_load_complete(void)
+{
+	if (!prv_on_load_cb) {
+		return;
+	}
+
+	uint16_t max_id = 0;
+	struct user_setting *setting = NULL;
+	while ((setting = user_settings_list_next(setting)) != NULL) {
+		max_id = MAX(max_id, setting->id);
+	}
+
+	size_t bitmap_size = (max_id / 32 + 1) * sizeof(uint32_t);
+	uint32_t *loaded = user_settings_list_buf_alloc(bitmap_size);
+	if (loaded) {
+		memset(loaded, 0, bitmap_size);
+		/* nothing can be set before the load, so each set value was loaded */
+		while ((setting = user_settings_list_next(setting)) != NULL) {
+			if (setting->is_set) {
+				loaded[setting->id / 32] |= BIT(setting->id % 32);
+			}
+		}
+	}
+
+	prv_on_load_cb(loaded, max_id);
+
+	user_settings_list_buf_free(loaded);
+}
+
 /* ------------- default settings values handlers -------------  */
 
 /**
@@ -45,6 +329,7 @@ static int prv_default_set_cb(const char *key, size_t len, settings_read_cb read
 	/* Check if key exists in the settings list */
 	struct user_setting *setting = user_settings_list_get_by_key(key);
 	if (!setting) {
+		USER_SETTINGS_STATS_INC(lookup_miss);
 		return -ENOENT;
 	}
 
@@ -53,8 +338,20 @@ static int prv_default_set_cb(const char *key, size_t len, settings_read_cb read
 		return -EINVAL;
 	}
 
+	/* A value that uses the default value keeps the old default value */
+	rc = user_settings_list_data_pin(setting);
+	if (rc) {
+		return rc;
+	}
+
+	/* A compile-time default is overridden, it needs its own space now */
+	rc = user_settings_list_default_buf_alloc(setting);
+	if (rc) {
+		return rc;
+	}
+
 	/* Read the settings from NVS */
-	rc = read_cb(cb_arg, setting->default_data, setting->max_size);
+	rc = read_cb(cb_arg, setting->default_buf, setting->max_size);
 	if (rc < 0) {
 		LOG_ERR("read_cb, err: %d", rc);
 		return rc;
@@ -65,6 +362,7 @@ static int prv_default_set_cb(const char *key, size_t len, settings_read_cb read
 	}
 
 	/* Remember actual data length */
+	setting->default_data = setting->default_buf;
 	setting->default_data_len = rc;
 	setting->default_is_set = true;
 
@@ -81,6 +379,7 @@ static int prv_value_set_cb(const char *key, size_t len, settings_read_cb read_c
 	/* Check if key exists in the settings list */
 	struct user_setting *setting = user_settings_list_get_by_key(key);
 	if (!setting) {
+		USER_SETTINGS_STATS_INC(lookup_miss);
 		return -ENOENT;
 	}
 
@@ -89,14 +388,39 @@ static int prv_value_set_cb(const char *key, size_t len, settings_read_cb read_c
 		return -EINVAL;
 	}
 
+	if (setting->is_lazy) {
+		/* Only remember the length, the value is fetched when it is needed */
+		user_settings_list_lazy_drop(setting);
+		setting->data_len = len;
+		setting->is_set = true;
+
+		LOG_DBG("Lazy setting %s was found", setting->key);
+
+		prv_notify_value_set(setting);
+
+		return 0;
+	}
+
+	/* Space for the value is only allocated once a value is stored */
+	rc = user_settings_list_data_alloc(setting);
+	if (rc) {
+		return rc;
+	}
+
 	/* Read the settings from NVS */
 	rc = read_cb(cb_arg, setting->data, setting->max_size);
 	if (rc < 0) {
 		LOG_ERR("read_cb, err: %d", rc);
+		if (!setting->is_set) {
+			user_settings_list_data_free(setting);
+		}
 		return rc;
 	} else if (rc == 0) {
 		LOG_ERR("read_cb, this key value pair was deleted");
 		/* TODO: must we do something here? When does this even happen */
+		if (!setting->is_set) {
+			user_settings_list_data_free(setting);
+		}
 		return 0;
 	}
 
@@ -106,13 +430,62 @@ static int prv_value_set_cb(const char *key, size_t len, settings_read_cb read_c
 
 	LOG_DBG("Setting %s was read", setting->key);
 
-	/* Notify on change */
-	if (prv_global_on_change_cb) {
-		prv_global_on_change_cb(setting->id, setting->key);
+	prv_notify_value_set(setting);
+
+	return 0;
+}
+
+/**
+ * @brief Destination of a lazy setting fetch
+ */
+struct prv_fetch_arg {
+	void *buf;
+	size_t len;
+	int rc;
+};
+
+static int prv_fetch_direct_cb(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg,
+			       void *param)
+{
+	struct prv_fetch_arg *arg = param;
+
+	/* Only the exact key, not keys below it */
+	if (key != NULL) {
+		return 0;
 	}
 
-	if (setting->on_change_cb) {
-		setting->on_change_cb(setting->id, setting->key);
+	if (len != arg->len) {
+		arg->rc = -EIO;
+		return 0;
+	}
+
+	arg->rc = read_cb(cb_arg, arg->buf, arg->len);
+	return 0;
+}
+
+/**
+ * @brief Read the value of a lazy setting from NVS
+ *
+ * @param[in] s The setting
+ * @param[out] buf The buffer to read into, at least s->data_len bytes long
+ *
+ * @retval 0 on success
+ * @retval -EIO if the value could not be read
+ */
+static int prv_lazy_fetch(struct user_setting *s, void *buf)
+{
+	struct prv_fetch_arg arg = {
+		.buf = buf,
+		.len = s->data_len,
+		.rc = -ENOENT,
+	};
+
+	char key_with_prefix[SETTINGS_MAX_NAME_LEN + 1] = {0};
+	sprintf(key_with_prefix, USER_SETTINGS_PREFIX "/%s", s->key);
+	int err = settings_load_subtree_direct(key_with_prefix, prv_fetch_direct_cb, &arg);
+	if (err || arg.rc != s->data_len) {
+		LOG_ERR("Fetching %s failed, err: %d, rc: %d", s->key, err, arg.rc);
+		return -EIO;
 	}
 
 	return 0;
@@ -129,104 +502,466 @@ static int prv_changed_flag_set_cb(const char *key, size_t len, settings_read_cb
 	/* Check if key exists in the settings list */
 	struct user_setting *setting = user_settings_list_get_by_key(key);
 	if (!setting) {
+		USER_SETTINGS_STATS_INC(lookup_miss);
 		return -ENOENT;
 	}
 
 	/* Read the flag from NVS */
+	bool had_changed_recently = setting->has_changed_recently;
 	rc = read_cb(cb_arg, &setting->has_changed_recently, sizeof(setting->has_changed_recently));
 	if (rc < 0) {
 		LOG_ERR("read_cb, err: %d", rc);
+		setting->has_changed_recently = had_changed_recently;
 		return rc;
 	} else if (rc == 0) {
 		LOG_ERR("read_cb, this key value pair was deleted");
 		return 0;
 	}
 
+	/* Keep the list of changed settings in sync with the flag */
+	if (setting->has_changed_recently != had_changed_recently) {
+		user_settings_list_changed_update(setting);
+	}
+
 	LOG_DBG("Setting %s has_changed_recently flag was read: %d", setting->key,
 		setting->has_changed_recently);
 
 	return 0;
 }
 
-int user_settings_init(void)
-{
-	static struct settings_handler prv_default_sh = {
-		.name = USER_SETTINGS_DEFAULT_PREFIX,
-		.h_set = prv_default_set_cb,
-	};
-
-	static struct settings_handler prv_value_sh = {
-		.name = USER_SETTINGS_PREFIX,
-		.h_set = prv_value_set_cb,
-	};
-
-	static struct settings_handler prv_changed_sh = {
-		.name = USER_SETTINGS_CHANGED_FLAG_PREFIX,
-		.h_set = prv_changed_flag_set_cb,
-	};
-
-	__ASSERT(!prv_is_inited, "user_settings_init should only be called once");
-
-	int err;
+/* ------------- flash write counters -------------  */
 
-	user_settings_list_init();
+#if defined(CONFIG_USER_SETTINGS_WEAR_STATS)
+/* Records written since boot, for the rate estimate */
+static uint32_t prv_wear_boot_writes;
+#endif
 
-	/* can be safely called multiple times from different modules */
-	err = settings_subsys_init();
-	if (err) {
-		LOG_ERR("settings_subsys_init, err: %d", err);
-		return -EIO;
-	}
+#if defined(CONFIG_USER_SETTINGS_WEAR_STATS_PERSIST)
+/* Records written since the counters were last stored */
+static uint32_t prv_wear_unsaved_writes;
+/* Set when CONFIG_USER_SETTINGS_WEAR_STATS_SAVE_INTERVAL writes were counted. The counters are
+ * stored once the operation that wrote them is complete, see prv_wear_save_if_due(). */
+static bool prv_wear_save_due;
 
-	/* register handler for default values */
-	err = settings_register(&prv_default_sh);
-	if (err) {
-		LOG_ERR("settings_register, err: %d", err);
-		return -EIO;
+/**
+ * @brief This is called when the stored counters are loaded
+ */
+static int prv_wear_set_cb(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg)
+{
+	/* Check if key exists in the settings list */
+	struct user_setting *setting = user_settings_list_get_by_key(key);
+	if (!setting) {
+		USER_SETTINGS_STATS_INC(lookup_miss);
+		return -ENOENT;
 	}
 
-	/* register handler for set values */
-	err = settings_register(&prv_value_sh);
-	if (err) {
-		LOG_ERR("settings_register, err: %d", err);
-		return -EIO;
+	if (len != sizeof(setting->wear)) {
+		return -EINVAL;
 	}
 
-	/* register handler for changed flag */
-	err = settings_register(&prv_changed_sh);
-	if (err) {
-		LOG_ERR("settings_register, err: %d", err);
-		return -EIO;
+	struct user_settings_wear_stats stored;
+	int rc = read_cb(cb_arg, &stored, sizeof(stored));
+	if (rc < 0) {
+		LOG_ERR("read_cb, err: %d", rc);
+		return rc;
+	} else if (rc != sizeof(stored)) {
+		return 0;
 	}
 
-	prv_is_inited = true;
+	/* Nothing is counted before the settings are loaded */
+	setting->wear = stored;
 
 	return 0;
 }
 
-void user_settings_add(uint16_t id, const char *key, enum user_setting_type type)
+/**
+ * @brief Store the counters of all settings whose counters changed since they were last stored
+ *
+ * @retval 0 on success
+ * @retval -EIO if the counters of a setting could not be stored
+ */
+static int prv_wear_save(void)
 {
-	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
-	__ASSERT(type != USER_SETTINGS_TYPE_STR, "Use user_settings_add_sized for string type!");
-	__ASSERT(type != USER_SETTINGS_TYPE_BYTES, "Use user_settings_add_sized for bytes type!");
+	int ret = 0;
+	char key_with_prefix[SETTINGS_MAX_NAME_LEN + 1] = {0};
 
-	user_settings_list_add_fixed_size(id, key, type);
+	struct user_setting *s = NULL;
+	while ((s = user_settings_list_next(s)) != NULL) {
+		if (!s->wear_dirty) {
+			continue;
+		}
+
+		sprintf(key_with_prefix, USER_SETTINGS_WEAR_PREFIX "/%s", s->key);
+		int err = settings_save_one(key_with_prefix, &s->wear, sizeof(s->wear));
+		if (err) {
+			LOG_ERR("settings_save, err: %d", err);
+			ret = -EIO;
+			continue;
+		}
+		s->wear_dirty = false;
+	}
+
+	prv_wear_unsaved_writes = 0;
+	prv_wear_save_due = false;
+
+	return ret;
 }
+#endif /* CONFIG_USER_SETTINGS_WEAR_STATS_PERSIST */
 
-void user_settings_add_sized(uint16_t id, const char *key, enum user_setting_type type, size_t size)
+/**
+ * @brief Store the counters if enough writes were counted since they were last stored
+ *
+ * Called at the end of each operation that writes to NVS, so the counters are not stored in the
+ * middle of a set, restore or import. Nothing is stored while the on change callbacks are
+ * deferred, the operations that defer them call this after flushing them.
+ */
+static void prv_wear_save_if_due(void)
 {
-	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
-	__ASSERT(type == USER_SETTINGS_TYPE_STR || type == USER_SETTINGS_TYPE_BYTES,
-		 "This function only supports string and bytes types");
-
-	user_settings_list_add_variable_size(id, key, type, size);
+#if defined(CONFIG_USER_SETTINGS_WEAR_STATS_PERSIST)
+	if (prv_wear_save_due && !prv_notify_deferred) {
+		(void)prv_wear_save();
+	}
+#endif
 }
 
-int user_settings_load(void)
+/**
+ * @brief Count a record written to or deleted from NVS for a setting
+ *
+ * @param[in] s The setting
+ * @param[in] len The number of data bytes in the record
+ */
+static void prv_wear_count_write(struct user_setting *s, size_t len)
 {
-	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
+#if defined(CONFIG_USER_SETTINGS_WEAR_STATS)
+	s->wear.writes++;
+	s->wear.bytes += len;
+	s->wear_dirty = true;
+	prv_wear_boot_writes++;
+#endif
+
+#if defined(CONFIG_USER_SETTINGS_WEAR_STATS_PERSIST) &&                                            \
+	CONFIG_USER_SETTINGS_WEAR_STATS_SAVE_INTERVAL > 0
+	if (++prv_wear_unsaved_writes >= CONFIG_USER_SETTINGS_WEAR_STATS_SAVE_INTERVAL) {
+		prv_wear_save_due = true;
+	}
+#endif
+}
 
-	int err;
+/**
+ * @brief Count a set of a setting that did not write anything since the value did not change
+ *
+ * This does not mark the counters for storing, skipped sets are stored with the next write of
+ * the setting, so a skipped set never causes a flash write.
+ *
+ * @param[in] s The setting
+ */
+static void prv_wear_count_skip(struct user_setting *s)
+{
+#if defined(CONFIG_USER_SETTINGS_WEAR_STATS)
+	s->wear.skipped++;
+#endif
+}
+
+/**
+ * @brief Get the start time of a settings backend write, if its latency is counted
+ */
+static uint32_t prv_stats_write_start(void)
+{
+#if defined(CONFIG_USER_SETTINGS_STATS_LATENCY)
+	return k_cycle_get_32();
+#else
+	return 0;
+#endif
+}
+
+/**
+ * @brief Count a settings backend write in the stats group
+ *
+ * @param[in] start The value of prv_stats_write_start() before the write
+ * @param[in] err The result of the write
+ */
+static void prv_stats_write_end(uint32_t start, int err)
+{
+	ARG_UNUSED(start);
+
+	if (err) {
+		USER_SETTINGS_STATS_INC(write_err);
+		return;
+	}
+
+	USER_SETTINGS_STATS_INC(writes);
+
+#if defined(CONFIG_USER_SETTINGS_STATS_LATENCY)
+	uint32_t us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+
+	if (us < 1000) {
+		USER_SETTINGS_STATS_INC(write_lt_1ms);
+	} else if (us < 10000) {
+		USER_SETTINGS_STATS_INC(write_lt_10ms);
+	} else if (us < 100000) {
+		USER_SETTINGS_STATS_INC(write_lt_100ms);
+	} else {
+		USER_SETTINGS_STATS_INC(write_ge_100ms);
+	}
+
+	if (us > user_settings_stats.write_max_us) {
+		STATS_SET(user_settings_stats, write_max_us, us);
+	}
+#endif
+}
+
+/**
+ * @brief Store a record of a setting with settings_save_one(), traced and counted
+ *
+ * @param[in] s The setting the record belongs to
+ * @param[in] key_with_prefix The full key of the record
+ * @param[in] data The data to store
+ * @param[in] len The length of the data
+ *
+ * @return The result of settings_save_one()
+ */
+static int prv_backend_save(struct user_setting *s, const char *key_with_prefix, const void *data,
+			    size_t len)
+{
+	uint32_t start = prv_stats_write_start();
+
+	USER_SETTINGS_TRACE_ENTER("save", s->id);
+	int err = settings_save_one(key_with_prefix, data, len);
+	USER_SETTINGS_TRACE_EXIT("save", s->id, err);
+
+	prv_stats_write_end(start, err);
+	if (!err) {
+		prv_wear_count_write(s, len);
+	}
+
+	return err;
+}
+
+/**
+ * @brief Delete a record of a setting with settings_delete(), traced and counted
+ *
+ * @param[in] s The setting the record belongs to
+ * @param[in] key_with_prefix The full key of the record
+ *
+ * @return The result of settings_delete()
+ */
+static int prv_backend_delete(struct user_setting *s, const char *key_with_prefix)
+{
+	uint32_t start = prv_stats_write_start();
+
+	USER_SETTINGS_TRACE_ENTER("delete", s->id);
+	int err = settings_delete(key_with_prefix);
+	USER_SETTINGS_TRACE_EXIT("delete", s->id, err);
+
+	prv_stats_write_end(start, err);
+	if (!err) {
+		prv_wear_count_write(s, 0);
+	}
+
+	return err;
+}
+
+/**
+ * @brief Define a traced wrapper of a settings handler h_set callback
+ *
+ * The wrapper is named like the callback with a _traced suffix. The traced number is the length
+ * of the value.
+ */
+#define PRV_TRACED_H_SET(fn, name)                                                                 \
+	static int fn##_traced(const char *key, size_t len, settings_read_cb read_cb,              \
+			       void *cb_arg)                                                       \
+	{                                                                                          \
+		USER_SETTINGS_TRACE_ENTER(name, len);                                              \
+		int rc = fn(key, len, read_cb, cb_arg);                                            \
+		USER_SETTINGS_TRACE_EXIT(name, len, rc);                                           \
+		return rc;                                                                         \
+	}
+
+PRV_TRACED_H_SET(prv_default_set_cb, "h_default")
+PRV_TRACED_H_SET(prv_value_set_cb, "h_value")
+PRV_TRACED_H_SET(prv_changed_flag_set_cb, "h_changed")
+#if defined(CONFIG_USER_SETTINGS_WEAR_STATS_PERSIST)
+PRV_TRACED_H_SET(prv_wear_set_cb, "h_wear")
+#endif
+
+int user_settings_init(void)
+{
+	static struct settings_handler prv_default_sh = {
+		.name = USER_SETTINGS_DEFAULT_PREFIX,
+		.h_set = prv_default_set_cb_traced,
+	};
+
+	static struct settings_handler prv_value_sh = {
+		.name = USER_SETTINGS_PREFIX,
+		.h_set = prv_value_set_cb_traced,
+	};
+
+	static struct settings_handler prv_changed_sh = {
+		.name = USER_SETTINGS_CHANGED_FLAG_PREFIX,
+		.h_set = prv_changed_flag_set_cb_traced,
+	};
+
+#if defined(CONFIG_USER_SETTINGS_WEAR_STATS_PERSIST)
+	static struct settings_handler prv_wear_sh = {
+		.name = USER_SETTINGS_WEAR_PREFIX,
+		.h_set = prv_wear_set_cb_traced,
+	};
+#endif
+
+	__ASSERT(!prv_is_inited, "user_settings_init should only be called once");
+
+	int err;
+
+	user_settings_list_init();
+	user_settings_list_set_fetch_cb(prv_lazy_fetch);
+
+	err = user_settings_stats_init();
+	if (err) {
+		return err;
+	}
+
+#if defined(CONFIG_USER_SETTINGS_NOTIFY_ASYNC)
+	k_work_init(&prv_async_work, prv_async_work_handler);
+#endif
+
+	/* can be safely called multiple times from different modules */
+	err = settings_subsys_init();
+	if (err) {
+		LOG_ERR("settings_subsys_init, err: %d", err);
+		return -EIO;
+	}
+
+	/* register handler for default values */
+	err = settings_register(&prv_default_sh);
+	if (err) {
+		LOG_ERR("settings_register, err: %d", err);
+		return -EIO;
+	}
+
+	/* register handler for set values */
+	err = settings_register(&prv_value_sh);
+	if (err) {
+		LOG_ERR("settings_register, err: %d", err);
+		return -EIO;
+	}
+
+	/* register handler for changed flag */
+	err = settings_register(&prv_changed_sh);
+	if (err) {
+		LOG_ERR("settings_register, err: %d", err);
+		return -EIO;
+	}
+
+#if defined(CONFIG_USER_SETTINGS_WEAR_STATS_PERSIST)
+	/* register handler for stored flash write counters */
+	err = settings_register(&prv_wear_sh);
+	if (err) {
+		LOG_ERR("settings_register, err: %d", err);
+		return -EIO;
+	}
+#endif
+
+	prv_is_inited = true;
+
+	return 0;
+}
+
+void user_settings_add(uint16_t id, const char *key, enum user_setting_type type)
+{
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
+	__ASSERT(type != USER_SETTINGS_TYPE_STR, "Use user_settings_add_sized for string type!");
+	__ASSERT(type != USER_SETTINGS_TYPE_BYTES, "Use user_settings_add_sized for bytes type!");
+	__ASSERT(type != USER_SETTINGS_TYPE_ARRAY, "Use user_settings_add_array for array type!");
+	__ASSERT(type != USER_SETTINGS_TYPE_RECORD, "Use user_settings_add_record for record type!");
+
+	user_settings_list_add_fixed_size(id, key, type);
+}
+
+void user_settings_add_sized(uint16_t id, const char *key, enum user_setting_type type, size_t size)
+{
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
+	__ASSERT(type == USER_SETTINGS_TYPE_STR || type == USER_SETTINGS_TYPE_BYTES,
+		 "This function only supports string and bytes types");
+
+	user_settings_list_add_variable_size(id, key, type, size);
+}
+
+void user_settings_add_with_default(uint16_t id, const char *key, enum user_setting_type type,
+				    const void *default_data, size_t default_len)
+{
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
+	__ASSERT(!prv_is_loaded, "Settings with a default must be added before user_settings_load");
+	__ASSERT(type != USER_SETTINGS_TYPE_STR, "Use user_settings_add_sized for string type!");
+	__ASSERT(type != USER_SETTINGS_TYPE_BYTES, "Use user_settings_add_sized for bytes type!");
+	__ASSERT(type != USER_SETTINGS_TYPE_ARRAY, "Use user_settings_add_array for array type!");
+	__ASSERT(type != USER_SETTINGS_TYPE_RECORD, "Use user_settings_add_record for record type!");
+
+	user_settings_list_add_fixed_size_with_default(id, key, type, default_data, default_len);
+}
+
+void user_settings_add_sized_with_default(uint16_t id, const char *key,
+					  enum user_setting_type type, size_t max_size,
+					  const void *default_data, size_t default_len)
+{
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
+	__ASSERT(!prv_is_loaded, "Settings with a default must be added before user_settings_load");
+	__ASSERT(type == USER_SETTINGS_TYPE_STR || type == USER_SETTINGS_TYPE_BYTES,
+		 "This function only supports string and bytes types");
+
+	user_settings_list_add_variable_size_with_default(id, key, type, max_size, default_data,
+							  default_len);
+}
+
+void user_settings_add_array(uint16_t id, const char *key, enum user_setting_type elem_type,
+			     size_t count)
+{
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
+
+	user_settings_list_add_array(id, key, elem_type, count, NULL, 0);
+}
+
+void user_settings_add_array_with_default(uint16_t id, const char *key,
+					  enum user_setting_type elem_type, size_t count,
+					  const void *default_data, size_t default_len)
+{
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
+	__ASSERT(!prv_is_loaded, "Settings with a default must be added before user_settings_load");
+	__ASSERT(default_data, "Default value must not be NULL");
+
+	user_settings_list_add_array(id, key, elem_type, count, default_data, default_len);
+}
+
+void user_settings_add_record(uint16_t id, const char *key,
+			      const struct user_settings_record_field *fields, size_t num_fields,
+			      size_t size)
+{
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
+
+	user_settings_list_add_record(id, key, fields, num_fields, size, NULL, 0);
+}
+
+void user_settings_add_record_with_default(uint16_t id, const char *key,
+					   const struct user_settings_record_field *fields,
+					   size_t num_fields, const void *default_data,
+					   size_t default_len)
+{
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
+	__ASSERT(!prv_is_loaded, "Settings with a default must be added before user_settings_load");
+	__ASSERT(default_data, "Default value must not be NULL");
+
+	user_settings_list_add_record(id, key, fields, num_fields, default_len, default_data,
+				      default_len);
+}
+
+/**
+ * @brief Load the default values, values, changed flags and counters from NVS
+ *
+ * @retval 0 on success
+ * @retval -EIO if loading failed
+ */
+static int prv_load(void)
+{
+	int err;
 
 	/* load all default values */
 	err = settings_load_subtree(USER_SETTINGS_DEFAULT_PREFIX);
@@ -249,17 +984,57 @@ int user_settings_load(void)
 		return -EIO;
 	}
 
+#if defined(CONFIG_USER_SETTINGS_WEAR_STATS_PERSIST)
+	/* load flash write counters */
+	err = settings_load_subtree(USER_SETTINGS_WEAR_PREFIX);
+	if (err) {
+		LOG_ERR("Failed loading user_settings_wear subtree, err: %d", err);
+		return -EIO;
+	}
+#endif
+
+	return 0;
+}
+
+int user_settings_load(void)
+{
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
+
+	USER_SETTINGS_TRACE_ENTER("load", 0);
+	int err = prv_load();
+	USER_SETTINGS_TRACE_EXIT("load", 0, err);
+	if (err) {
+		return err;
+	}
+
 	prv_is_loaded = true;
 
+	/* parse the cron jobs, loaded values might not have been notified and defaults never are */
+	struct user_setting *setting = NULL;
+	while ((setting = user_settings_list_next(setting)) != NULL) {
+		user_settings_cron_update(setting);
+	}
+
+	prv_notify_load_complete();
+
 	return 0;
 }
 
+void user_settings_set_on_load_cb(user_settings_on_load_t on_load_cb)
+{
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
+	__ASSERT(!prv_is_loaded, "The on load callback must be set before user_settings_load");
+
+	prv_on_load_cb = on_load_cb;
+}
+
+static int prv_store_default(struct user_setting *s, const void *data, size_t len);
+static int prv_validate(struct user_setting *s, const void *data, size_t len);
+
 static int prv_user_settings_set_default(struct user_setting *s, void *data, size_t len)
 {
 	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
 
-	int err;
-
 	/* Check if new value is the same as existing value */
 	if (len == s->default_data_len && memcmp(data, s->default_data, s->default_data_len) == 0) {
 		LOG_DBG("Same default value as existing value.");
@@ -280,6 +1055,29 @@ static int prv_user_settings_set_default(struct user_setting *s, void *data, siz
 		return -ENOMEM;
 	}
 
+	int err = prv_validate(s, data, len);
+	if (err) {
+		return err;
+	}
+
+	err = prv_store_default(s, data, len);
+	prv_wear_save_if_due();
+
+	return err;
+}
+
+/**
+ * @brief Set the default value of a setting in RAM and store it to NVS
+ *
+ * No checks are done, the caller must make sure that @p len fits.
+ *
+ * @retval 0 on success
+ * @retval -EIO if the value could not be set or stored
+ */
+static int prv_store_default(struct user_setting *s, const void *data, size_t len)
+{
+	int err;
+
 	/* Use settings_runtime_set() so that prv_default_set_cb gets called, which will
 	 * set the setting default value in the settings list.
 	 * It will also set s->default_is_set
@@ -292,410 +1090,1429 @@ static int prv_user_settings_set_default(struct user_setting *s, void *data, siz
 		return -EIO;
 	}
 
-	/* Use settings_save_one() so that the default setting value is stored to NVS */
-	err = settings_save_one(key_with_prefix, data, len);
-	if (err) {
-		LOG_ERR("settings_save, err: %d", err);
-		return -EIO;
+	/* Use settings_save_one() so that the default setting value is stored to NVS */
+	err = prv_backend_save(s, key_with_prefix, data, len);
+	if (err) {
+		LOG_ERR("settings_save, err: %d", err);
+		return -EIO;
+	}
+
+	/* the default is the schedule of a cron job that has no value */
+	user_settings_cron_update(s);
+
+	return 0;
+}
+
+int user_settings_set_default_with_key(char *key, void *data, size_t len)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_key(key);
+	__ASSERT(s, "Key does not exists: %s", key);
+
+	return prv_user_settings_set_default(s, data, len);
+}
+
+int user_settings_set_default_with_id(uint16_t id, void *data, size_t len)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_id(id);
+	__ASSERT(s, "ID does not exists: %d", id);
+
+	return prv_user_settings_set_default(s, data, len);
+}
+
+/**
+ * @brief Persistently set the changed recently flag for a setting.
+ *
+ * @param[in] s The setting to set the flag for.
+ * @param[in] has_changed_recently The value of the flag.
+ *
+ * @return int 0 on success, negative errno code otherwise.
+ */
+static int prv_set_changed_recently_flag(struct user_setting *s, bool has_changed_recently)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	int err;
+
+	/* Check if value is the same */
+	if (has_changed_recently == s->has_changed_recently) {
+		LOG_DBG("Setting has_changed_recently flag to same value.");
+		return 0;
+	}
+
+	/* Use settings_runtime_set() so that prv_changed_flag_set_cb gets called, which will
+	 * set the flag in the settings list */
+	char key_with_prefix[SETTINGS_MAX_NAME_LEN + 1] = {0};
+	sprintf(key_with_prefix, USER_SETTINGS_CHANGED_FLAG_PREFIX "/%s", s->key);
+	err = settings_runtime_set(key_with_prefix, &has_changed_recently,
+				   sizeof(has_changed_recently));
+	if (err) {
+		LOG_ERR("settings_runtime_set, err: %d", err);
+		return -EIO;
+	}
+
+	/* Use settings_save_one() so that the flag is stored to NVS */
+	err = prv_backend_save(s, key_with_prefix, &has_changed_recently,
+			       sizeof(has_changed_recently));
+	if (err) {
+		LOG_ERR("settings_save, err: %d", err);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Set the value of a setting in RAM and store it to NVS
+ *
+ * The on change callbacks are called. The changed flag is not modified. No checks are done, the
+ * caller must make sure that @p len fits.
+ *
+ * @retval 0 on success
+ * @retval -EIO if the value could not be set or stored
+ */
+static int prv_store_value(struct user_setting *s, const void *data, size_t len)
+{
+	int err;
+
+	/* Use settings_runtime_set() so that prv_value_set_cb gets called, which will
+	 * set the setting value in the settings list */
+	char key_with_prefix[SETTINGS_MAX_NAME_LEN + 1] = {0};
+	sprintf(key_with_prefix, USER_SETTINGS_PREFIX "/%s", s->key);
+	err = settings_runtime_set(key_with_prefix, data, len);
+	if (err) {
+		LOG_ERR("settings_runtime_set, err: %d", err);
+		return -EIO;
+	}
+
+	/* Use settings_save_one() so that the setting is stored to NVS */
+	err = prv_backend_save(s, key_with_prefix, data, len);
+	if (err) {
+		LOG_ERR("settings_save, err: %d", err);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Delete the value of a setting from RAM and NVS, so the default value applies again
+ *
+ * The on change callbacks are called. The changed flag is not modified.
+ *
+ * @retval 0 on success
+ * @retval -EIO if the value could not be deleted from NVS
+ */
+static int prv_delete_value(struct user_setting *s)
+{
+	char key_with_prefix[SETTINGS_MAX_NAME_LEN + 1] = {0};
+	sprintf(key_with_prefix, USER_SETTINGS_PREFIX "/%s", s->key);
+	int err = prv_backend_delete(s, key_with_prefix);
+	if (err) {
+		LOG_ERR("settings_delete, err: %d", err);
+		return -EIO;
+	}
+
+	s->is_set = false;
+	s->data_len = 0;
+	user_settings_list_data_free(s);
+
+	prv_notify_change(s);
+
+	return 0;
+}
+
+/**
+ * @brief Delete the default value of a setting from RAM and NVS
+ *
+ * The on change callbacks are called if the setting has no value, which used the default value.
+ *
+ * @retval 0 on success
+ * @retval -EIO if the default value could not be deleted from NVS
+ */
+static int prv_delete_default(struct user_setting *s)
+{
+	char key_with_prefix[SETTINGS_MAX_NAME_LEN + 1] = {0};
+	sprintf(key_with_prefix, USER_SETTINGS_DEFAULT_PREFIX "/%s", s->key);
+	int err = prv_backend_delete(s, key_with_prefix);
+	if (err) {
+		LOG_ERR("settings_delete, err: %d", err);
+		return -EIO;
+	}
+
+	s->default_is_set = false;
+	s->default_data_len = 0;
+	user_settings_cron_update(s);
+
+	if (!s->is_set) {
+		prv_notify_change(s);
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Check if a setting has a signed integer type
+ */
+static bool prv_type_is_signed(enum user_setting_type type)
+{
+	return type >= USER_SETTINGS_TYPE_I8 && type <= USER_SETTINGS_TYPE_I64;
+}
+
+/**
+ * @brief Check if a setting has an integer type, the types range and enum constraints apply to
+ */
+static bool prv_type_is_integer(enum user_setting_type type)
+{
+	return type >= USER_SETTINGS_TYPE_U8 && type <= USER_SETTINGS_TYPE_I64;
+}
+
+/**
+ * @brief Read an integer value, sign extended for the signed types
+ */
+static int64_t prv_integer_get(enum user_setting_type type, const void *data, size_t len)
+{
+	uint64_t raw = 0;
+
+	/* values are stored in native byte order */
+	switch (len) {
+	case 1: {
+		uint8_t v;
+		memcpy(&v, data, sizeof(v));
+		return prv_type_is_signed(type) ? (int8_t)v : v;
+	}
+	case 2: {
+		uint16_t v;
+		memcpy(&v, data, sizeof(v));
+		return prv_type_is_signed(type) ? (int16_t)v : v;
+	}
+	case 4: {
+		uint32_t v;
+		memcpy(&v, data, sizeof(v));
+		return prv_type_is_signed(type) ? (int32_t)v : v;
+	}
+	default:
+		memcpy(&raw, data, sizeof(raw));
+		return (int64_t)raw;
+	}
+}
+
+/**
+ * @brief Compare two integer values of a setting
+ *
+ * @return true if @p a is smaller than @p b
+ */
+static bool prv_integer_less(enum user_setting_type type, int64_t a, int64_t b)
+{
+	return prv_type_is_signed(type) ? a < b : (uint64_t)a < (uint64_t)b;
+}
+
+/**
+ * @brief Check a new value of a setting against its constraints
+ *
+ * This is done before anything is stored, so a rejected value causes no flash writes and no on
+ * change callbacks.
+ *
+ * @retval 0 if the value is valid
+ * @retval -EINVAL if the value is rejected
+ */
+static int prv_validate(struct user_setting *s, const void *data, size_t len)
+{
+	const struct user_setting_constraints *c = s->constraints;
+
+	/* Arrays and records are always stored whole, see prv_user_settings_set_part() */
+	if ((s->type == USER_SETTINGS_TYPE_ARRAY || s->type == USER_SETTINGS_TYPE_RECORD) &&
+	    len != s->max_size) {
+		LOG_ERR("Value of %s must hold all %d bytes", s->key, s->max_size);
+		return -EINVAL;
+	}
+
+	struct user_settings_cron cron;
+	if (s->type == USER_SETTINGS_TYPE_CRON_JOB && user_settings_cron_parse(data, len, &cron)) {
+		LOG_ERR("Value of %s is not a valid cron job", s->key);
+		return -EINVAL;
+	}
+
+	if (!c) {
+		return 0;
+	}
+
+	if ((c->has_range || c->enum_values) && prv_type_is_integer(s->type)) {
+		if (len != s->max_size) {
+			LOG_ERR("Value of %s must be %d bytes", s->key, s->max_size);
+			return -EINVAL;
+		}
+
+		int64_t v = prv_integer_get(s->type, data, len);
+
+		if (c->has_range) {
+			if (prv_integer_less(s->type, v, c->min) ||
+			    prv_integer_less(s->type, c->max, v) ||
+			    (c->step > 1 && ((uint64_t)v - (uint64_t)c->min) % c->step != 0)) {
+				LOG_ERR("Value of %s is out of range", s->key);
+				return -EINVAL;
+			}
+		}
+
+		if (c->enum_values) {
+			size_t i = 0;
+			while (i < c->num_enum_values && c->enum_values[i] != v) {
+				i++;
+			}
+			if (i == c->num_enum_values) {
+				LOG_ERR("Value of %s is not one of the allowed values", s->key);
+				return -EINVAL;
+			}
+		}
+	}
+
+	if (c->validator && !c->validator(s->id, s->key, data, len)) {
+		LOG_ERR("Value of %s rejected by the validator", s->key);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Set and store the value of a setting, see prv_user_settings_set()
+ */
+static int prv_user_settings_set_value(struct user_setting *s, const void *data, size_t len)
+{
+	int err;
+
+	/* check space */
+	if (len > s->max_size) {
+		LOG_ERR("Value size to large. Max size is %d", s->max_size);
+		return -ENOMEM;
+	}
+
+	/* Check if value is the same. Lazy values are only compared if they are cached. */
+	const void *current = NULL;
+	if (s->is_set && (s->data || s->value_is_default)) {
+		current = user_settings_list_data_get(s, NULL);
+	}
+	if (current && len == s->data_len && memcmp(current, data, len) == 0) {
+		LOG_DBG("Setting to same value.");
+		prv_wear_count_skip(s);
+		USER_SETTINGS_STATS_INC(set_unchanged);
+		return 0;
+	}
+
+	err = prv_store_value(s, data, len);
+	if (err) {
+		return err;
+	}
+
+	/* Modify has changed flag */
+	err = prv_set_changed_recently_flag(s, true);
+	if (err) {
+		LOG_ERR("prv_set_changed_recently_flag, err: %d", err);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+static int prv_user_settings_set(struct user_setting *s, const void *data, size_t len)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	USER_SETTINGS_TRACE_ENTER("set", s->id);
+	/* Default values are not validated, so restoring one always works */
+	int err = data == s->default_data ? 0 : prv_validate(s, data, len);
+	if (!err) {
+		err = prv_user_settings_set_value(s, data, len);
+	}
+	USER_SETTINGS_TRACE_EXIT("set", s->id, err);
+
+	prv_wear_save_if_due();
+
+	if (err == -ENOMEM) {
+		USER_SETTINGS_STATS_INC(err_nomem);
+	} else if (err == -EIO) {
+		USER_SETTINGS_STATS_INC(err_io);
+	}
+
+	return err;
+}
+
+/**
+ * @brief Check if the value of a setting is the same as its default value
+ *
+ * @retval 1 if the value is the same as the default value
+ * @retval 0 if it differs or there is no default value
+ * @retval -EIO if the value of a lazy setting could not be read
+ */
+static int prv_value_is_default(struct user_setting *s)
+{
+	if (!s->default_is_set || s->data_len != s->default_data_len) {
+		return 0;
+	}
+
+	const void *value = user_settings_list_data_get(s, NULL);
+	if (!value) {
+		return -EIO;
+	}
+
+	return memcmp(value, s->default_data, s->data_len) == 0;
+}
+
+/**
+ * @brief Restore the value of a setting to its default value
+ *
+ * With CONFIG_USER_SETTINGS_RESTORE_DELETE, the stored value is deleted, so the default value
+ * applies without being written again. Otherwise the default value is written as the value,
+ * and the value buffer is freed, as the value is read from the default value until it changes.
+ * Settings that already have their default value are not written, and their changed flag is
+ * kept.
+ *
+ * @retval 0 on success
+ * @retval -EIO if the value or the changed flag could not be stored
+ */
+static int prv_settings_restore(struct user_setting *setting)
+{
+	/* if value in not set, do nothing */
+	if (!setting->is_set) {
+		return 0;
+	}
+
+	int ret = prv_value_is_default(setting);
+	if (ret < 0) {
+		return ret;
+	}
+	if (ret) {
+		prv_wear_count_skip(setting);
+		user_settings_list_data_use_default(setting);
+		return 0;
+	}
+
+	if (!IS_ENABLED(CONFIG_USER_SETTINGS_RESTORE_DELETE)) {
+		/* Set the setting to the same value as default */
+		int err = prv_user_settings_set(setting, setting->default_data,
+						setting->default_data_len);
+		if (!err && setting->default_is_set) {
+			/* The stored value is the default value, it needs no space of its own */
+			user_settings_list_data_use_default(setting);
+		}
+		return err;
+	}
+
+	int err = prv_delete_value(setting);
+	if (err) {
+		return err;
+	}
+
+	/* Restoring to the default counts as a change, same as setting the default value */
+	err = prv_set_changed_recently_flag(setting, true);
+	prv_wear_save_if_due();
+	if (err) {
+		LOG_ERR("prv_set_changed_recently_flag, err: %d", err);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+void user_settings_restore_defaults(void)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	/* The settings backend has no transactions, so the settings are still written one by one.
+	 * The on change callbacks are deferred until all settings are restored, so callbacks see
+	 * the final state and can not interfere with the iteration.
+	 */
+	prv_notify_deferred = true;
+
+	struct user_setting *setting = NULL;
+	while ((setting = user_settings_list_next(setting)) != NULL) {
+		int err = prv_settings_restore(setting);
+		if (err) {
+			LOG_ERR("Restoring %s failed, err: %d", setting->key, err);
+		}
+	}
+
+	prv_notify_flush();
+	prv_wear_save_if_due();
+}
+
+int user_settings_restore_default_with_key(char *key)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *setting = user_settings_list_get_by_key(key);
+	__ASSERT(setting, "Key does not exists: %s", key);
+
+	return prv_settings_restore(setting);
+}
+
+int user_settings_restore_default_with_id(uint16_t id)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *setting = user_settings_list_get_by_id(id);
+	__ASSERT(setting, "ID does not exists: %d", id);
+
+	return prv_settings_restore(setting);
+}
+
+bool user_settings_exists_with_key(char *key)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_key(key);
+	if (!s) {
+		USER_SETTINGS_STATS_INC(lookup_miss);
+	}
+	return s != NULL;
+}
+
+bool user_settings_exists_with_id(uint16_t id)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_id(id);
+	if (!s) {
+		USER_SETTINGS_STATS_INC(lookup_miss);
+	}
+	return s != NULL;
+}
+
+int user_settings_set_with_key(char *key, void *data, size_t len)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_key(key);
+	__ASSERT(s, "Key does not exists: %s", key);
+
+	USER_SETTINGS_STATS_INC(set_key);
+	return prv_user_settings_set(s, data, len);
+}
+
+int user_settings_set_with_id(uint16_t id, void *data, size_t len)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_id(id);
+	__ASSERT(s, "ID does not exists: %d", id);
+
+	USER_SETTINGS_STATS_INC(set_id);
+	return prv_user_settings_set(s, data, len);
+}
+
+int user_settings_set_setting(struct user_setting *us, const void *data, size_t len)
+{
+	/* counted like the set by key it replaces */
+	USER_SETTINGS_STATS_INC(set_key);
+	return prv_user_settings_set(us, data, len);
+}
+
+static void *prv_user_setting_get(struct user_setting *s, size_t *len)
+{
+	/* Compile-time defaults are in rodata, callers must not modify them */
+	return (void *)user_settings_list_value_get(s, len);
+}
+
+void *user_settings_get_with_key(char *key, size_t *len)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_key(key);
+	__ASSERT(s, "Key does not exists: %s", key);
+
+	USER_SETTINGS_STATS_INC(get_key);
+	return prv_user_setting_get(s, len);
+}
+
+void *user_settings_get_with_id(uint16_t id, size_t *len)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_id(id);
+	__ASSERT(s, "ID does not exists: %d", id);
+
+	USER_SETTINGS_STATS_INC(get_id);
+	return prv_user_setting_get(s, len);
+}
+
+static void *prv_user_setting_get_default(struct user_setting *s, size_t *len)
+{
+	if (s->default_is_set) {
+		if (len) {
+			*len = s->default_data_len;
+		}
+		/* Compile-time defaults are in rodata, callers must not modify them */
+		return (void *)s->default_data;
+	}
+
+	return NULL;
+}
+
+void *user_settings_get_default_with_key(char *key, size_t *len)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_key(key);
+	__ASSERT(s, "Key does not exists: %s", key);
+
+	return prv_user_setting_get_default(s, len);
+}
+
+void *user_settings_get_default_with_id(uint16_t id, size_t *len)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_id(id);
+	__ASSERT(s, "ID does not exists: %d", id);
+
+	return prv_user_setting_get_default(s, len);
+}
+
+void user_settings_set_global_on_change_cb(user_settings_on_change_t on_change_cb)
+{
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
+
+	prv_global_on_change_cb = on_change_cb;
+}
+
+void user_settings_set_batch_on_change_cb(user_settings_on_change_batch_t on_change_cb)
+{
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
+
+	prv_batch_on_change_cb = on_change_cb;
+}
+
+/**
+ * @brief Copy the current value of a setting into a buffer
+ */
+static int prv_user_setting_read(struct user_setting *s, void *buf, size_t len)
+{
+	/* Read values of lazy settings that are not cached directly, without caching them */
+	if (s->is_set && s->is_lazy && !s->data && !s->value_is_default) {
+		if (len < s->data_len) {
+			return -ENOMEM;
+		}
+		int err = prv_lazy_fetch(s, buf);
+		return err ? err : s->data_len;
+	}
+
+	size_t value_len;
+	const void *value = user_settings_list_value_get(s, &value_len);
+	if (!value) {
+		return -ENODATA;
+	}
+	if (len < value_len) {
+		return -ENOMEM;
+	}
+
+	memcpy(buf, value, value_len);
+	return value_len;
+}
+
+int user_settings_read_with_key(char *key, void *buf, size_t len)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_key(key);
+	__ASSERT(s, "Key does not exists: %s", key);
+
+	USER_SETTINGS_STATS_INC(get_key);
+	return prv_user_setting_read(s, buf, len);
+}
+
+int user_settings_read_with_id(uint16_t id, void *buf, size_t len)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_id(id);
+	__ASSERT(s, "ID does not exists: %d", id);
+
+	USER_SETTINGS_STATS_INC(get_id);
+	return prv_user_setting_read(s, buf, len);
+}
+
+/**
+ * @brief Copy a part of a fixed size value, an element of an array or a field of a record
+ */
+static int prv_user_settings_get_part(struct user_setting *s, size_t offset, size_t size,
+				      void *buf, size_t len)
+{
+	if (len < size) {
+		return -ENOMEM;
+	}
+
+	size_t value_len;
+	const uint8_t *value = user_settings_list_value_get(s, &value_len);
+	if (!value || offset + size > value_len) {
+		return -ENODATA;
+	}
+
+	memcpy(buf, &value[offset], size);
+	return size;
+}
+
+/**
+ * @brief Set a part of a fixed size value, an element of an array or a field of a record
+ *
+ * The value is stored as a whole, so the rest is copied from the current value (or the default)
+ * and the whole value is set. This writes a single record and calls the on change callbacks
+ * once, and nothing is written if the part already has the new value.
+ */
+static int prv_user_settings_set_part(struct user_setting *s, size_t offset, const void *data,
+				      size_t size)
+{
+	uint8_t *buf = user_settings_list_buf_alloc(s->max_size);
+	if (!buf) {
+		return -ENOMEM;
+	}
+
+	size_t value_len;
+	const void *value = user_settings_list_value_get(s, &value_len);
+	memset(buf, 0, s->max_size);
+	if (value) {
+		memcpy(buf, value, MIN(value_len, s->max_size));
+	}
+	memcpy(&buf[offset], data, size);
+
+	int err = prv_user_settings_set(s, buf, s->max_size);
+	user_settings_list_buf_free(buf);
+	return err;
+}
+
+/**
+ * @brief Copy one element of an array setting into a buffer
+ */
+static int prv_user_settings_get_elem(struct user_setting *s, size_t index, void *buf, size_t len)
+{
+	if (s->type != USER_SETTINGS_TYPE_ARRAY) {
+		return -EINVAL;
+	}
+
+	size_t elem_size = user_settings_list_array_elem_size(s);
+	if (index >= s->max_size / elem_size) {
+		return -EINVAL;
+	}
+
+	return prv_user_settings_get_part(s, index * elem_size, elem_size, buf, len);
+}
+
+int user_settings_get_elem_with_key(char *key, size_t index, void *buf, size_t len)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_key(key);
+	__ASSERT(s, "Key does not exists: %s", key);
+
+	USER_SETTINGS_STATS_INC(get_key);
+	return prv_user_settings_get_elem(s, index, buf, len);
+}
+
+int user_settings_get_elem_with_id(uint16_t id, size_t index, void *buf, size_t len)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_id(id);
+	__ASSERT(s, "ID does not exists: %d", id);
+
+	USER_SETTINGS_STATS_INC(get_id);
+	return prv_user_settings_get_elem(s, index, buf, len);
+}
+
+/**
+ * @brief Set one element of an array setting, see prv_user_settings_set_part()
+ */
+static int prv_user_settings_set_elem(struct user_setting *s, size_t index, const void *data,
+				      size_t len)
+{
+	if (s->type != USER_SETTINGS_TYPE_ARRAY) {
+		return -EINVAL;
+	}
+
+	size_t elem_size = user_settings_list_array_elem_size(s);
+	if (index >= s->max_size / elem_size || len != elem_size) {
+		return -EINVAL;
+	}
+
+	return prv_user_settings_set_part(s, index * elem_size, data, elem_size);
+}
+
+int user_settings_set_elem_with_key(char *key, size_t index, const void *data, size_t len)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_key(key);
+	__ASSERT(s, "Key does not exists: %s", key);
+
+	USER_SETTINGS_STATS_INC(set_key);
+	return prv_user_settings_set_elem(s, index, data, len);
+}
+
+int user_settings_set_elem_with_id(uint16_t id, size_t index, const void *data, size_t len)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_id(id);
+	__ASSERT(s, "ID does not exists: %d", id);
+
+	USER_SETTINGS_STATS_INC(set_id);
+	return prv_user_settings_set_elem(s, index, data, len);
+}
+
+/**
+ * @brief Copy one field of a record setting into a buffer
+ */
+static int prv_user_settings_get_field(struct user_setting *s, const char *name, void *buf,
+				       size_t len)
+{
+	if (s->type != USER_SETTINGS_TYPE_RECORD) {
+		return -EINVAL;
+	}
+
+	const struct user_settings_record_field *field =
+		user_settings_list_record_field_get(s, name);
+	if (!field) {
+		return -EINVAL;
+	}
+
+	return prv_user_settings_get_part(s, field->offset,
+					  user_settings_list_record_field_size(field), buf, len);
+}
+
+int user_settings_get_field_with_key(char *key, const char *name, void *buf, size_t len)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_key(key);
+	__ASSERT(s, "Key does not exists: %s", key);
+
+	USER_SETTINGS_STATS_INC(get_key);
+	return prv_user_settings_get_field(s, name, buf, len);
+}
+
+int user_settings_get_field_with_id(uint16_t id, const char *name, void *buf, size_t len)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_id(id);
+	__ASSERT(s, "ID does not exists: %d", id);
+
+	USER_SETTINGS_STATS_INC(get_id);
+	return prv_user_settings_get_field(s, name, buf, len);
+}
+
+/**
+ * @brief Set one field of a record setting, see prv_user_settings_set_part()
+ */
+static int prv_user_settings_set_field(struct user_setting *s, const char *name, const void *data,
+				       size_t len)
+{
+	if (s->type != USER_SETTINGS_TYPE_RECORD) {
+		return -EINVAL;
+	}
+
+	const struct user_settings_record_field *field =
+		user_settings_list_record_field_get(s, name);
+	if (!field || len != user_settings_list_record_field_size(field)) {
+		return -EINVAL;
+	}
+
+	return prv_user_settings_set_part(s, field->offset, data, len);
+}
+
+int user_settings_set_field_with_key(char *key, const char *name, const void *data, size_t len)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_key(key);
+	__ASSERT(s, "Key does not exists: %s", key);
+
+	USER_SETTINGS_STATS_INC(set_key);
+	return prv_user_settings_set_field(s, name, data, len);
+}
+
+int user_settings_set_field_with_id(uint16_t id, const char *name, const void *data, size_t len)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_id(id);
+	__ASSERT(s, "ID does not exists: %d", id);
+
+	USER_SETTINGS_STATS_INC(set_id);
+	return prv_user_settings_set_field(s, name, data, len);
+}
+
+/* The chunked write in progress. Only one setting can be written in chunks at a time. The chunks
+ * are staged in a buffer, as the settings backend stores a value in one write and the current value
+ * must stay intact until the write is committed. */
+static struct user_setting *prv_write_at_setting;
+static uint8_t *prv_write_at_buf;
+static size_t prv_write_at_len;
+
+/**
+ * @brief Discard the chunked write in progress, if any
+ */
+static void prv_write_at_discard(void)
+{
+	user_settings_list_buf_free(prv_write_at_buf);
+	prv_write_at_buf = NULL;
+	prv_write_at_setting = NULL;
+	prv_write_at_len = 0;
+}
+
+/**
+ * @brief Copy a part of the current value of a setting into a buffer
+ */
+static int prv_user_setting_read_at(struct user_setting *s, size_t offset, void *buf, size_t len)
+{
+	if (s->type != USER_SETTINGS_TYPE_STR && s->type != USER_SETTINGS_TYPE_BYTES) {
+		return -EINVAL;
+	}
+
+	size_t value_len;
+	const void *value = user_settings_list_value_get(s, &value_len);
+	if (!value) {
+		/* a lazy value that could not be fetched, or no value at all */
+		return s->is_set ? -EIO : -ENODATA;
+	}
+
+	if (offset >= value_len) {
+		return 0;
+	}
+
+	len = MIN(len, value_len - offset);
+	memcpy(buf, (const uint8_t *)value + offset, len);
+	return len;
+}
+
+int user_settings_read_at_with_key(char *key, size_t offset, void *buf, size_t len)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_key(key);
+	__ASSERT(s, "Key does not exists: %s", key);
+
+	return prv_user_setting_read_at(s, offset, buf, len);
+}
+
+int user_settings_read_at_with_id(uint16_t id, size_t offset, void *buf, size_t len)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_id(id);
+	__ASSERT(s, "ID does not exists: %d", id);
+
+	return prv_user_setting_read_at(s, offset, buf, len);
+}
+
+/**
+ * @brief Add a chunk to the chunked write of a setting
+ */
+static int prv_user_setting_write_at(struct user_setting *s, size_t offset, const void *data,
+				     size_t len)
+{
+	if (s->type != USER_SETTINGS_TYPE_STR && s->type != USER_SETTINGS_TYPE_BYTES) {
+		return -EINVAL;
+	}
+
+	/* A chunk at offset 0 starts a new write and discards any other write in progress */
+	if (offset == 0) {
+		prv_write_at_discard();
+		prv_write_at_buf = user_settings_list_buf_alloc(s->max_size);
+		if (!prv_write_at_buf) {
+			return -ENOMEM;
+		}
+		prv_write_at_setting = s;
+	}
+
+	if (s != prv_write_at_setting || offset != prv_write_at_len) {
+		return -EINVAL;
+	}
+
+	if (len > s->max_size - prv_write_at_len) {
+		prv_write_at_discard();
+		return -ENOMEM;
+	}
+
+	memcpy(&prv_write_at_buf[prv_write_at_len], data, len);
+	prv_write_at_len += len;
+
+	return 0;
+}
+
+int user_settings_write_at_with_key(char *key, size_t offset, const void *data, size_t len)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_key(key);
+	__ASSERT(s, "Key does not exists: %s", key);
+
+	return prv_user_setting_write_at(s, offset, data, len);
+}
+
+int user_settings_write_at_with_id(uint16_t id, size_t offset, const void *data, size_t len)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_id(id);
+	__ASSERT(s, "ID does not exists: %d", id);
+
+	return prv_user_setting_write_at(s, offset, data, len);
+}
+
+/**
+ * @brief Store the value collected by the chunked write of a setting
+ */
+static int prv_user_setting_write_commit(struct user_setting *s)
+{
+	if (s != prv_write_at_setting) {
+		return -EINVAL;
 	}
 
-	return 0;
+	int err = prv_user_settings_set(s, prv_write_at_buf, prv_write_at_len);
+	prv_write_at_discard();
+	return err;
 }
 
-int user_settings_set_default_with_key(char *key, void *data, size_t len)
+int user_settings_write_commit_with_key(char *key)
 {
 	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
 
 	struct user_setting *s = user_settings_list_get_by_key(key);
 	__ASSERT(s, "Key does not exists: %s", key);
 
-	return prv_user_settings_set_default(s, data, len);
+	return prv_user_setting_write_commit(s);
 }
 
-int user_settings_set_default_with_id(uint16_t id, void *data, size_t len)
+int user_settings_write_commit_with_id(uint16_t id)
 {
 	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
 
 	struct user_setting *s = user_settings_list_get_by_id(id);
 	__ASSERT(s, "ID does not exists: %d", id);
 
-	return prv_user_settings_set_default(s, data, len);
+	return prv_user_setting_write_commit(s);
 }
 
 /**
- * @brief Persistently set the changed recently flag for a setting.
- *
- * @param[in] s The setting to set the flag for.
- * @param[in] has_changed_recently The value of the flag.
- *
- * @return int 0 on success, negative errno code otherwise.
+ * @brief Mark a setting lazy
  */
-static int prv_set_changed_recently_flag(struct user_setting *s, bool has_changed_recently)
+static void prv_set_lazy(struct user_setting *s)
 {
-	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+	__ASSERT(!prv_is_loaded, "Settings must be marked lazy before user_settings_load");
+	__ASSERT(s->type == USER_SETTINGS_TYPE_STR || s->type == USER_SETTINGS_TYPE_BYTES,
+		 "Only string and bytes settings can be lazy");
 
-	int err;
+	s->is_lazy = true;
+}
 
-	/* Check if value is the same */
-	if (has_changed_recently == s->has_changed_recently) {
-		LOG_DBG("Setting has_changed_recently flag to same value.");
-		return 0;
-	}
+void user_settings_set_lazy_with_key(char *key)
+{
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
 
-	/* Use settings_runtime_set() so that prv_changed_flag_set_cb gets called, which will
-	 * set the flag in the settings list */
-	char key_with_prefix[SETTINGS_MAX_NAME_LEN + 1] = {0};
-	sprintf(key_with_prefix, USER_SETTINGS_CHANGED_FLAG_PREFIX "/%s", s->key);
-	err = settings_runtime_set(key_with_prefix, &has_changed_recently,
-				   sizeof(has_changed_recently));
-	if (err) {
-		LOG_ERR("settings_runtime_set, err: %d", err);
-		return -EIO;
-	}
+	struct user_setting *s = user_settings_list_get_by_key(key);
+	__ASSERT(s, "Key does not exists: %s", key);
 
-	/* Use settings_save_one() so that the flag is stored to NVS */
-	err = settings_save_one(key_with_prefix, &has_changed_recently,
-				sizeof(has_changed_recently));
-	if (err) {
-		LOG_ERR("settings_save, err: %d", err);
-		return -EIO;
-	}
+	prv_set_lazy(s);
+}
 
-	return 0;
+void user_settings_set_lazy_with_id(uint16_t id)
+{
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_id(id);
+	__ASSERT(s, "ID does not exists: %d", id);
+
+	prv_set_lazy(s);
 }
 
-static int prv_user_settings_set(struct user_setting *s, void *data, size_t len)
+void user_settings_set_on_change_cb_with_key(char *key, user_settings_on_change_t on_change_cb)
 {
-	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
 
-	int err;
+	struct user_setting *s = user_settings_list_get_by_key(key);
+	__ASSERT(s, "Key does not exists: %s", key);
 
-	/* check space */
-	if (len > s->max_size) {
-		LOG_ERR("Value size to large. Max size is %d", s->max_size);
-		return -ENOMEM;
-	}
+	s->on_change_cb = on_change_cb;
+}
 
-	/* Check if value is the same */
-	if (memcmp(s->data, data, len) == 0 && len == s->data_len) {
-		LOG_DBG("Setting to same value.");
-		return 0;
-	}
+void user_settings_set_on_change_cb_with_id(uint16_t id, user_settings_on_change_t on_change_cb)
+{
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
 
-	/* Use settings_runtime_set() so that prv_value_set_cb gets called, which will
-	 * set the setting value in the settings list */
-	char key_with_prefix[SETTINGS_MAX_NAME_LEN + 1] = {0};
-	sprintf(key_with_prefix, USER_SETTINGS_PREFIX "/%s", s->key);
-	err = settings_runtime_set(key_with_prefix, data, len);
-	if (err) {
-		LOG_ERR("settings_runtime_set, err: %d", err);
-		return -EIO;
-	}
+	struct user_setting *s = user_settings_list_get_by_id(id);
+	__ASSERT(s, "ID does not exists: %d", id);
 
-	/* Use settings_save_one() so that the setting is stored to NVS */
-	err = settings_save_one(key_with_prefix, data, len);
-	if (err) {
-		LOG_ERR("settings_save, err: %d", err);
-		return -EIO;
-	}
+	s->on_change_cb = on_change_cb;
+}
 
-	/* Modify has changed flag */
-	err = prv_set_changed_recently_flag(s, true);
+/**
+ * @brief Set the range of the values of an integer setting
+ */
+static int prv_set_range(struct user_setting *s, int64_t min, int64_t max, uint64_t step)
+{
+	__ASSERT(prv_type_is_integer(s->type), "Range is only supported for integer settings");
+	__ASSERT(!prv_integer_less(s->type, max, min), "Range of %s is empty", s->key);
+
+	int err = user_settings_list_constraints_alloc(s);
 	if (err) {
-		LOG_ERR("prv_set_changed_recently_flag, err: %d", err);
-		return -EIO;
+		return err;
 	}
 
+	s->constraints->has_range = true;
+	s->constraints->min = min;
+	s->constraints->max = max;
+	s->constraints->step = step;
 	return 0;
 }
 
-static void prv_settings_restore(struct user_setting *setting)
+int user_settings_set_range_with_key(char *key, int64_t min, int64_t max, uint64_t step)
 {
-	/* if value in not set, do nothing */
-	if (!setting->is_set) {
-		return;
-	}
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_key(key);
+	__ASSERT(s, "Key does not exists: %s", key);
 
-	/* Set the setting to the same value as default */
-	prv_user_settings_set(setting, setting->default_data, setting->default_data_len);
+	return prv_set_range(s, min, max, step);
 }
 
-void user_settings_restore_defaults(void)
+int user_settings_set_range_with_id(uint16_t id, int64_t min, int64_t max, uint64_t step)
 {
-	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
 
-	/* by using prv_user_settings_set on each setting, the values will get stored and the
-	 * on_change callbacks will be called correctly
-	 */
+	struct user_setting *s = user_settings_list_get_by_id(id);
+	__ASSERT(s, "ID does not exists: %d", id);
 
-	user_settings_list_iter_start();
-	struct user_setting *setting;
-	while ((setting = user_settings_list_iter_next()) != NULL) {
-		prv_settings_restore(setting);
-	}
+	return prv_set_range(s, min, max, step);
 }
 
-int user_settings_restore_default_with_key(char *key)
+/**
+ * @brief Set the allowed values of an integer setting
+ */
+static int prv_set_enum(struct user_setting *s, const int64_t *values, size_t count)
 {
-	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+	__ASSERT(prv_type_is_integer(s->type), "Enum is only supported for integer settings");
+	__ASSERT(!values || (count > 0 && count <= UINT8_MAX),
+		 "Enum of %s must have 1 to 255 values", s->key);
 
-	struct user_setting *setting = user_settings_list_get_by_key(key);
-	__ASSERT(setting, "Key does not exists: %s", key);
+	int err = user_settings_list_constraints_alloc(s);
+	if (err) {
+		return err;
+	}
 
-	prv_settings_restore(setting);
+	s->constraints->enum_values = values;
+	s->constraints->num_enum_values = values ? count : 0;
 	return 0;
 }
 
-int user_settings_restore_default_with_id(uint16_t id)
+int user_settings_set_enum_with_key(char *key, const int64_t *values, size_t count)
 {
-	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
 
-	struct user_setting *setting = user_settings_list_get_by_id(id);
-	__ASSERT(setting, "ID does not exists: %d", id);
+	struct user_setting *s = user_settings_list_get_by_key(key);
+	__ASSERT(s, "Key does not exists: %s", key);
 
-	prv_settings_restore(setting);
-	return 0;
+	return prv_set_enum(s, values, count);
 }
 
-bool user_settings_exists_with_key(char *key)
+int user_settings_set_enum_with_id(uint16_t id, const int64_t *values, size_t count)
 {
-	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
 
-	struct user_setting *s = user_settings_list_get_by_key(key);
-	return s != NULL;
+	struct user_setting *s = user_settings_list_get_by_id(id);
+	__ASSERT(s, "ID does not exists: %d", id);
+
+	return prv_set_enum(s, values, count);
 }
 
-bool user_settings_exists_with_id(uint16_t id)
+/**
+ * @brief Set the validator callback of a setting
+ */
+static int prv_set_validator(struct user_setting *s, user_settings_validator_t validator)
 {
-	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+	int err = user_settings_list_constraints_alloc(s);
+	if (err) {
+		return err;
+	}
 
-	struct user_setting *s = user_settings_list_get_by_id(id);
-	return s != NULL;
+	s->constraints->validator = validator;
+	return 0;
 }
 
-int user_settings_set_with_key(char *key, void *data, size_t len)
+int user_settings_set_validator_with_key(char *key, user_settings_validator_t validator)
 {
-	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
 
 	struct user_setting *s = user_settings_list_get_by_key(key);
 	__ASSERT(s, "Key does not exists: %s", key);
 
-	return prv_user_settings_set(s, data, len);
+	return prv_set_validator(s, validator);
 }
 
-int user_settings_set_with_id(uint16_t id, void *data, size_t len)
+int user_settings_set_validator_with_id(uint16_t id, user_settings_validator_t validator)
 {
-	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
 
 	struct user_setting *s = user_settings_list_get_by_id(id);
 	__ASSERT(s, "ID does not exists: %d", id);
 
-	return prv_user_settings_set(s, data, len);
+	return prv_set_validator(s, validator);
 }
 
-static void *prv_user_setting_get(struct user_setting *s, size_t *len)
+int user_settings_validate_with_key(char *key, const void *data, size_t len)
 {
-	if (s->is_set) {
-		if (len) {
-			*len = s->data_len;
-		}
-		return s->data;
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_key(key);
+	__ASSERT(s, "Key does not exists: %s", key);
+
+	if (len > s->max_size) {
+		return -ENOMEM;
 	}
+	return prv_validate(s, data, len);
+}
 
-	if (s->default_is_set) {
-		if (len) {
-			*len = s->default_data_len;
-		}
-		return s->default_data;
+int user_settings_validate_with_id(uint16_t id, const void *data, size_t len)
+{
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_id(id);
+	__ASSERT(s, "ID does not exists: %d", id);
+
+	if (len > s->max_size) {
+		return -ENOMEM;
 	}
+	return prv_validate(s, data, len);
+}
 
-	return NULL;
+/**
+ * @brief Subscribe to changes of a single setting
+ */
+static void prv_subscribe(struct user_settings_subscription *sub, struct user_setting *s,
+			  user_settings_on_change_t cb)
+{
+	__ASSERT(cb, "Subscription callback must be provided");
+
+	*sub = (struct user_settings_subscription){
+		.cb = cb,
+		.setting = s,
+	};
+	sys_slist_append(&s->subscribers, &sub->node);
 }
 
-void *user_settings_get_with_key(char *key, size_t *len)
+void user_settings_subscribe_with_key(struct user_settings_subscription *sub, char *key,
+				      user_settings_on_change_t cb)
 {
-	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
 
 	struct user_setting *s = user_settings_list_get_by_key(key);
 	__ASSERT(s, "Key does not exists: %s", key);
 
-	return prv_user_setting_get(s, len);
+	prv_subscribe(sub, s, cb);
 }
 
-void *user_settings_get_with_id(uint16_t id, size_t *len)
+void user_settings_subscribe_with_id(struct user_settings_subscription *sub, uint16_t id,
+				     user_settings_on_change_t cb)
 {
-	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
 
 	struct user_setting *s = user_settings_list_get_by_id(id);
 	__ASSERT(s, "ID does not exists: %d", id);
 
-	return prv_user_setting_get(s, len);
+	prv_subscribe(sub, s, cb);
 }
 
-static void *prv_user_setting_get_default(struct user_setting *s, size_t *len)
+void user_settings_subscribe_id_range(struct user_settings_subscription *sub, uint16_t first_id,
+				      uint16_t last_id, user_settings_on_change_t cb)
 {
-	if (s->default_is_set) {
-		if (len) {
-			*len = s->default_data_len;
-		}
-		return s->default_data;
-	}
+	__ASSERT(cb, "Subscription callback must be provided");
+	__ASSERT(first_id <= last_id, "Invalid ID range");
 
-	return NULL;
+	*sub = (struct user_settings_subscription){
+		.cb = cb,
+		.first_id = first_id,
+		.last_id = last_id,
+	};
+	sys_slist_append(&prv_wildcard_subscriptions, &sub->node);
 }
 
-void *user_settings_get_default_with_key(char *key, size_t *len)
+void user_settings_subscribe_key_prefix(struct user_settings_subscription *sub,
+					const char *prefix, user_settings_on_change_t cb)
 {
-	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+	__ASSERT(cb, "Subscription callback must be provided");
+	__ASSERT(prefix, "Prefix must be provided");
 
-	struct user_setting *s = user_settings_list_get_by_key(key);
-	__ASSERT(s, "Key does not exists: %s", key);
+	*sub = (struct user_settings_subscription){
+		.cb = cb,
+		.prefix = prefix,
+		.prefix_len = strlen(prefix),
+	};
+	sys_slist_append(&prv_wildcard_subscriptions, &sub->node);
+}
 
-	return prv_user_setting_get_default(s, len);
+void user_settings_unsubscribe(struct user_settings_subscription *sub)
+{
+	sys_slist_t *list = sub->setting ? &sub->setting->subscribers : &prv_wildcard_subscriptions;
+
+	sys_slist_find_and_remove(list, &sub->node);
 }
 
-void *user_settings_get_default_with_id(uint16_t id, size_t *len)
+/* this is only false if no default exists and no value was set */
+bool user_settings_is_set_with_key(char *key)
 {
 	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
 
-	struct user_setting *s = user_settings_list_get_by_id(id);
-	__ASSERT(s, "ID does not exists: %d", id);
+	struct user_setting *s = user_settings_list_get_by_key(key);
+	__ASSERT(s, "Key does not exists: %s", key);
 
-	return prv_user_setting_get_default(s, len);
+	return s->is_set;
 }
 
-void user_settings_set_global_on_change_cb(user_settings_on_change_t on_change_cb)
+/* this is only false if no default exists and no value was set */
+bool user_settings_is_set_with_id(uint16_t id)
 {
-	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
 
-	prv_global_on_change_cb = on_change_cb;
+	struct user_setting *s = user_settings_list_get_by_id(id);
+	__ASSERT(s, "Id does not exists: %d", id);
+
+	return s->is_set;
 }
 
-void user_settings_set_on_change_cb_with_key(char *key, user_settings_on_change_t on_change_cb)
+bool user_settings_has_default_with_key(char *key)
 {
-	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
 
 	struct user_setting *s = user_settings_list_get_by_key(key);
 	__ASSERT(s, "Key does not exists: %s", key);
 
-	s->on_change_cb = on_change_cb;
+	return s->default_is_set;
 }
 
-void user_settings_set_on_change_cb_with_id(uint16_t id, user_settings_on_change_t on_change_cb)
+bool user_settings_has_default_with_id(uint16_t id)
 {
-	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
 
 	struct user_setting *s = user_settings_list_get_by_id(id);
-	__ASSERT(s, "ID does not exists: %d", id);
+	__ASSERT(s, "Id does not exists: %d", id);
 
-	s->on_change_cb = on_change_cb;
+	return s->default_is_set;
 }
 
-/* this is only false if no default exists and no value was set */
-bool user_settings_is_set_with_key(char *key)
+uint16_t user_settings_key_to_id(char *key)
 {
 	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
 
 	struct user_setting *s = user_settings_list_get_by_key(key);
 	__ASSERT(s, "Key does not exists: %s", key);
 
-	return s->is_set;
+	return s->id;
 }
 
-/* this is only false if no default exists and no value was set */
-bool user_settings_is_set_with_id(uint16_t id)
+char *user_settings_id_to_key(uint16_t id)
 {
 	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
 
 	struct user_setting *s = user_settings_list_get_by_id(id);
 	__ASSERT(s, "Id does not exists: %d", id);
 
-	return s->is_set;
+	return s->key;
 }
 
-bool user_settings_has_default_with_key(char *key)
+size_t user_settings_get_max_len_with_key(char *key)
 {
 	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
 
 	struct user_setting *s = user_settings_list_get_by_key(key);
 	__ASSERT(s, "Key does not exists: %s", key);
 
-	return s->default_is_set;
+	return s->max_size;
 }
 
-bool user_settings_has_default_with_id(uint16_t id)
+size_t user_settings_get_max_len_with_id(uint16_t id)
 {
 	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
 
 	struct user_setting *s = user_settings_list_get_by_id(id);
 	__ASSERT(s, "Id does not exists: %d", id);
 
-	return s->default_is_set;
+	return s->max_size;
 }
 
-uint16_t user_settings_key_to_id(char *key)
+enum user_setting_type user_settings_get_type_with_key(char *key)
 {
 	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
 
 	struct user_setting *s = user_settings_list_get_by_key(key);
 	__ASSERT(s, "Key does not exists: %s", key);
 
-	return s->id;
+	return s->type;
 }
 
-char *user_settings_id_to_key(uint16_t id)
+enum user_setting_type user_settings_get_type_with_id(uint16_t id)
 {
 	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
 
 	struct user_setting *s = user_settings_list_get_by_id(id);
 	__ASSERT(s, "Id does not exists: %d", id);
 
-	return s->key;
+	return s->type;
 }
 
-size_t user_settings_get_max_len_with_key(char *key)
+enum user_setting_type user_settings_get_elem_type_with_key(char *key)
 {
 	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
 
 	struct user_setting *s = user_settings_list_get_by_key(key);
 	__ASSERT(s, "Key does not exists: %s", key);
+	__ASSERT(s->type == USER_SETTINGS_TYPE_ARRAY, "%s is not an array setting", key);
 
-	return s->max_size;
+	return s->elem_type;
 }
 
-size_t user_settings_get_max_len_with_id(uint16_t id)
+enum user_setting_type user_settings_get_elem_type_with_id(uint16_t id)
 {
 	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
 
 	struct user_setting *s = user_settings_list_get_by_id(id);
 	__ASSERT(s, "Id does not exists: %d", id);
+	__ASSERT(s->type == USER_SETTINGS_TYPE_ARRAY, "%d is not an array setting", id);
 
-	return s->max_size;
+	return s->elem_type;
 }
 
-enum user_setting_type user_settings_get_type_with_key(char *key)
+const struct user_settings_record_field *user_settings_get_record_fields_with_key(char *key,
+										  size_t *num_fields)
 {
 	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
 
 	struct user_setting *s = user_settings_list_get_by_key(key);
 	__ASSERT(s, "Key does not exists: %s", key);
+	__ASSERT(s->type == USER_SETTINGS_TYPE_RECORD, "%s is not a record setting", key);
 
-	return s->type;
+	*num_fields = s->num_fields;
+	return s->fields;
 }
 
-enum user_setting_type user_settings_get_type_with_id(uint16_t id)
+const struct user_settings_record_field *user_settings_get_record_fields_with_id(uint16_t id,
+										 size_t *num_fields)
 {
 	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
 
 	struct user_setting *s = user_settings_list_get_by_id(id);
 	__ASSERT(s, "Id does not exists: %d", id);
+	__ASSERT(s->type == USER_SETTINGS_TYPE_RECORD, "%d is not a record setting", id);
 
-	return s->type;
+	*num_fields = s->num_fields;
+	return s->fields;
 }
 
 void user_settings_iter_start(void)
 {
 	user_settings_list_iter_start();
+	user_settings_list_changed_iter_start();
 }
 
 bool user_settings_iter_next(char **key, uint16_t *id)
@@ -712,21 +2529,14 @@ bool user_settings_iter_next(char **key, uint16_t *id)
 
 bool user_settings_iter_next_changed(char **key, uint16_t *id)
 {
-	bool prv_has_changed = 0;
 	struct user_setting *setting;
-	while (!prv_has_changed) {
-		if ((setting = user_settings_list_iter_next()) != NULL) {
-			prv_has_changed = setting->has_changed_recently;
-			if (prv_has_changed) {
-				*key = setting->key;
-				*id = setting->id;
-			}
-		} else {
-			return false;
-		}
+	if ((setting = user_settings_list_changed_iter_next()) != NULL) {
+		*key = setting->key;
+		*id = setting->id;
+		return true;
+	} else {
+		return false;
 	}
-
-	return true;
 }
 
 void user_settings_set_changed_with_key(char *key)
@@ -737,6 +2547,7 @@ void user_settings_set_changed_with_key(char *key)
 	__ASSERT(s, "Key does not exists: %s", key);
 
 	prv_set_changed_recently_flag(s, true);
+	prv_wear_save_if_due();
 }
 
 void user_settings_set_changed_with_id(uint16_t id)
@@ -747,6 +2558,15 @@ void user_settings_set_changed_with_id(uint16_t id)
 	__ASSERT(s, "Id does not exists: %d", id);
 
 	prv_set_changed_recently_flag(s, true);
+	prv_wear_save_if_due();
+}
+
+void user_settings_set_changed_setting(struct user_setting *us)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	prv_set_changed_recently_flag(us, true);
+	prv_wear_save_if_due();
 }
 
 void user_settings_clear_changed_with_key(char *key)
@@ -757,6 +2577,7 @@ void user_settings_clear_changed_with_key(char *key)
 	__ASSERT(s, "Key does not exists: %s", key);
 
 	prv_set_changed_recently_flag(s, 0);
+	prv_wear_save_if_due();
 }
 
 void user_settings_clear_changed_with_id(uint16_t id)
@@ -767,27 +2588,608 @@ void user_settings_clear_changed_with_id(uint16_t id)
 	__ASSERT(s, "Id does not exists: %d", id);
 
 	prv_set_changed_recently_flag(s, 0);
+	prv_wear_save_if_due();
 }
 
 void user_settings_clear_changed(void)
 {
 	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
 
-	user_settings_list_iter_start();
+	/* Clearing the flag removes the setting from the list of changed settings, so only the
+	 * changed settings are visited */
 	struct user_setting *setting;
-	while ((setting = user_settings_list_iter_next()) != NULL) {
-		prv_set_changed_recently_flag(setting, 0);
+	while ((setting = user_settings_list_changed_peek()) != NULL) {
+		if (prv_set_changed_recently_flag(setting, 0) && setting->has_changed_recently) {
+			/* Stop if the flag could not be cleared, to not loop forever */
+			LOG_ERR("Failed to clear changed flag for setting %s", setting->key);
+			break;
+		}
 	}
+
+	prv_wear_save_if_due();
 }
 
 bool user_settings_any_changed(void)
 {
-	user_settings_list_iter_start();
-	struct user_setting *setting;
-	while ((setting = user_settings_list_iter_next()) != NULL) {
-		if (setting->has_changed_recently) {
-			return true;
+	return user_settings_list_changed_peek() != NULL;
+}
+
+/* ------------- bulk export and import -------------  */
+
+/* Magic and version at the start of a bulk blob */
+#define PRV_BULK_MAGIC_VERSION "USB\x01"
+/* magic and version, 4 byte total length, 2 byte number of records */
+#define PRV_BULK_HEADER_LEN    (4 + 4 + 2)
+/* 2 byte ID, 1 byte type, 1 byte flags */
+#define PRV_BULK_RECORD_LEN    (2 + 1 + 1)
+#define PRV_BULK_CRC_LEN       4
+
+#define PRV_BULK_FLAG_VALUE   BIT(0)
+#define PRV_BULK_FLAG_DEFAULT BIT(1)
+#define PRV_BULK_FLAG_CHANGED BIT(2)
+
+/**
+ * @brief Parts of a bulk blob, in the order they are written
+ */
+enum prv_bulk_part {
+	PRV_BULK_PART_HEADER = 0,
+	PRV_BULK_PART_RECORD,
+	PRV_BULK_PART_VALUE_LEN,
+	PRV_BULK_PART_VALUE,
+	PRV_BULK_PART_DEFAULT_LEN,
+	PRV_BULK_PART_DEFAULT,
+	PRV_BULK_PART_CRC,
+	PRV_BULK_PART_DONE,
+};
+
+static uint8_t prv_bulk_flags(struct user_setting *s)
+{
+	return (s->is_set ? PRV_BULK_FLAG_VALUE : 0) |
+	       (s->default_is_set ? PRV_BULK_FLAG_DEFAULT : 0) |
+	       (s->has_changed_recently ? PRV_BULK_FLAG_CHANGED : 0);
+}
+
+/**
+ * @brief Calculate the length of the bulk blob and the number of records in it
+ */
+static size_t prv_bulk_len(uint16_t *count)
+{
+	size_t len = PRV_BULK_HEADER_LEN + PRV_BULK_CRC_LEN;
+	*count = 0;
+
+	struct user_setting *s = NULL;
+	while ((s = user_settings_list_next(s)) != NULL) {
+		len += PRV_BULK_RECORD_LEN;
+		if (s->is_set) {
+			len += 2 + s->data_len;
+		}
+		if (s->default_is_set) {
+			len += 2 + s->default_data_len;
+		}
+		(*count)++;
+	}
+
+	return len;
+}
+
+/**
+ * @brief Get the bytes of the part of the blob the cursor is at
+ *
+ * @param[in] cursor The cursor
+ * @param[out] scratch Buffer for parts that are encoded, at least PRV_BULK_HEADER_LEN long
+ * @param[out] data The bytes of the part
+ * @param[out] data_len The length of the part
+ *
+ * @retval 0 on success
+ * @retval -EIO if the value of a lazy setting could not be read
+ */
+static int prv_bulk_part_get(struct user_settings_export_cursor *cursor, uint8_t *scratch,
+			     const uint8_t **data, size_t *data_len)
+{
+	struct user_setting *s = cursor->setting;
+
+	*data = scratch;
+
+	switch (cursor->state) {
+	case PRV_BULK_PART_HEADER:
+		memcpy(scratch, PRV_BULK_MAGIC_VERSION, 4);
+		sys_put_le32(cursor->total_len, &scratch[4]);
+		sys_put_le16(cursor->count, &scratch[8]);
+		*data_len = PRV_BULK_HEADER_LEN;
+		return 0;
+	case PRV_BULK_PART_RECORD:
+		sys_put_le16(s->id, &scratch[0]);
+		scratch[2] = s->type;
+		scratch[3] = prv_bulk_flags(s);
+		*data_len = PRV_BULK_RECORD_LEN;
+		return 0;
+	case PRV_BULK_PART_VALUE_LEN:
+		sys_put_le16(s->data_len, scratch);
+		*data_len = 2;
+		return 0;
+	case PRV_BULK_PART_VALUE:
+		/* only a lazy value that is split over chunks is fetched again */
+		*data = user_settings_list_data_get(s, NULL);
+		*data_len = s->data_len;
+		return *data ? 0 : -EIO;
+	case PRV_BULK_PART_DEFAULT_LEN:
+		sys_put_le16(s->default_data_len, scratch);
+		*data_len = 2;
+		return 0;
+	case PRV_BULK_PART_DEFAULT:
+		*data = s->default_data;
+		*data_len = s->default_data_len;
+		return 0;
+	default:
+		sys_put_le32(cursor->crc, scratch);
+		*data_len = PRV_BULK_CRC_LEN;
+		return 0;
+	}
+}
+
+/**
+ * @brief Move the cursor to the record of the setting after @p s, or to the CRC after the last one
+ */
+static void prv_bulk_next_record(struct user_settings_export_cursor *cursor,
+				 struct user_setting *s)
+{
+	cursor->setting = user_settings_list_next(s);
+	cursor->state = cursor->setting ? PRV_BULK_PART_RECORD : PRV_BULK_PART_CRC;
+}
+
+/**
+ * @brief Move the cursor to the next part of the blob
+ */
+static void prv_bulk_part_advance(struct user_settings_export_cursor *cursor)
+{
+	struct user_setting *s = cursor->setting;
+
+	cursor->part_offset = 0;
+
+	switch (cursor->state) {
+	case PRV_BULK_PART_HEADER:
+		prv_bulk_next_record(cursor, NULL);
+		break;
+	case PRV_BULK_PART_RECORD:
+		if (s->is_set) {
+			cursor->state = PRV_BULK_PART_VALUE_LEN;
+		} else if (s->default_is_set) {
+			cursor->state = PRV_BULK_PART_DEFAULT_LEN;
+		} else {
+			prv_bulk_next_record(cursor, s);
+		}
+		break;
+	case PRV_BULK_PART_VALUE:
+		if (s->default_is_set) {
+			cursor->state = PRV_BULK_PART_DEFAULT_LEN;
+		} else {
+			prv_bulk_next_record(cursor, s);
+		}
+		break;
+	case PRV_BULK_PART_DEFAULT:
+		prv_bulk_next_record(cursor, s);
+		break;
+	case PRV_BULK_PART_VALUE_LEN:
+	case PRV_BULK_PART_DEFAULT_LEN:
+		/* the value follows its length */
+		cursor->state++;
+		break;
+	default:
+		cursor->state = PRV_BULK_PART_DONE;
+		break;
+	}
+}
+
+int user_settings_export_binary(uint8_t *buf, size_t len,
+				struct user_settings_export_cursor *cursor)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	if (buf == NULL || len == 0) {
+		return -EINVAL;
+	}
+
+	if (cursor->offset == 0) {
+		/* the header holds the length of the whole blob */
+		cursor->total_len = prv_bulk_len(&cursor->count);
+	}
+
+	size_t written = 0;
+	uint8_t scratch[PRV_BULK_HEADER_LEN];
+
+	while (cursor->state != PRV_BULK_PART_DONE && written < len) {
+		const uint8_t *data;
+		size_t data_len;
+		int err = prv_bulk_part_get(cursor, scratch, &data, &data_len);
+		if (err) {
+			return err;
+		}
+
+		size_t copy = MIN(data_len - cursor->part_offset, len - written);
+		memcpy(&buf[written], &data[cursor->part_offset], copy);
+		if (cursor->state != PRV_BULK_PART_CRC) {
+			cursor->crc = crc32_ieee_update(cursor->crc, &data[cursor->part_offset], copy);
+		}
+		written += copy;
+		cursor->part_offset += copy;
+
+		if (cursor->part_offset == data_len) {
+			prv_bulk_part_advance(cursor);
+		}
+	}
+
+	cursor->offset += written;
+
+	return written;
+}
+
+/**
+ * @brief Read a length prefixed value of a bulk record
+ *
+ * @param[in] blob The blob
+ * @param[in] end The end of the records in the blob
+ * @param[in,out] pos Position of the length, advanced past the value
+ * @param[out] data The value
+ * @param[out] data_len The length of the value
+ *
+ * @retval 0 on success
+ * @retval -EINVAL if the value does not fit into the blob
+ */
+static int prv_bulk_read_value(const uint8_t *blob, size_t end, size_t *pos, const uint8_t **data,
+			       size_t *data_len)
+{
+	if (*pos + 2 > end) {
+		return -EINVAL;
+	}
+	*data_len = sys_get_le16(&blob[*pos]);
+	*pos += 2;
+
+	if (*pos + *data_len > end) {
+		return -EINVAL;
+	}
+	*data = &blob[*pos];
+	*pos += *data_len;
+
+	return 0;
+}
+
+/* What prv_bulk_walk() does with the records of a blob */
+enum prv_bulk_mode {
+	/* Only validate the records */
+	PRV_BULK_VALIDATE,
+	/* Store the records */
+	PRV_BULK_APPLY,
+	/* Store the records of a snapshot, also deleting defaults that the snapshot has not */
+	PRV_BULK_ROLLBACK,
+};
+
+/**
+ * @brief Walk all records of a bulk blob and validate or apply them
+ *
+ * @param[in] blob The blob, its header and CRC must already be validated
+ * @param[in] len The length of the blob
+ * @param[in] mode What to do with the records
+ *
+ * @retval 0 on success
+ * @retval -EINVAL if a record is malformed or a value is rejected by the constraints of its setting
+ * @retval -ENOENT if a record refers to an unknown setting ID or has a different type
+ * @retval -ENOMEM if a value is larger than the max size of the setting
+ * @retval -EALREADY if a different default is already set and it can not be overwritten
+ * @retval -EIO if a value could not be stored
+ */
+static int prv_bulk_walk(const uint8_t *blob, size_t len, enum prv_bulk_mode mode)
+{
+	size_t end = len - PRV_BULK_CRC_LEN;
+	size_t pos = PRV_BULK_HEADER_LEN;
+	uint16_t count = sys_get_le16(&blob[8]);
+	int err;
+
+	for (uint16_t i = 0; i < count; i++) {
+		if (pos + PRV_BULK_RECORD_LEN > end) {
+			return -EINVAL;
+		}
+
+		uint16_t id = sys_get_le16(&blob[pos]);
+		uint8_t type = blob[pos + 2];
+		uint8_t flags = blob[pos + 3];
+		pos += PRV_BULK_RECORD_LEN;
+
+		const uint8_t *value = NULL;
+		size_t value_len = 0;
+		if (flags & PRV_BULK_FLAG_VALUE) {
+			err = prv_bulk_read_value(blob, end, &pos, &value, &value_len);
+			if (err) {
+				return err;
+			}
+		}
+
+		const uint8_t *def = NULL;
+		size_t def_len = 0;
+		if (flags & PRV_BULK_FLAG_DEFAULT) {
+			err = prv_bulk_read_value(blob, end, &pos, &def, &def_len);
+			if (err) {
+				return err;
+			}
+		}
+
+		struct user_setting *s = user_settings_list_get_by_id(id);
+		if (!s || s->type != type) {
+			USER_SETTINGS_STATS_INC(lookup_miss);
+			LOG_ERR("Bulk record %d: setting ID %d does not exist or has another type",
+				i, id);
+			return -ENOENT;
+		}
+
+		if (value_len > s->max_size || def_len > s->max_size) {
+			return -ENOMEM;
+		}
+
+		if ((value && prv_validate(s, value, value_len)) ||
+		    (def && prv_validate(s, def, def_len))) {
+			return -EINVAL;
+		}
+
+		bool default_differs =
+			def && (!s->default_is_set || def_len != s->default_data_len ||
+				memcmp(def, s->default_data, def_len) != 0);
+
+		if (mode == PRV_BULK_VALIDATE) {
+			if (default_differs && s->default_is_set &&
+			    !IS_ENABLED(CONFIG_USER_SETTINGS_DEFAULT_OVERWRITE)) {
+				LOG_ERR("Setting %s already has a different default", s->key);
+				return -EALREADY;
+			}
+			continue;
+		}
+
+		/* Only write what differs */
+		const void *current = NULL;
+		if (value && s->is_set && value_len == s->data_len) {
+			current = user_settings_list_data_get(s, NULL);
+			if (!current) {
+				return -EIO;
+			}
+		}
+
+		if (value && (!current || memcmp(value, current, value_len) != 0)) {
+			err = prv_store_value(s, value, value_len);
+		} else if (!value && s->is_set) {
+			err = prv_delete_value(s);
+		} else {
+			if (value) {
+				prv_wear_count_skip(s);
+			}
+			err = 0;
+		}
+		if (err) {
+			return err;
+		}
+
+		if (default_differs) {
+			err = prv_store_default(s, def, def_len);
+		} else if (!def && s->default_is_set && mode == PRV_BULK_ROLLBACK) {
+			/* the default was added by the import that is rolled back */
+			err = prv_delete_default(s);
+		}
+		if (err) {
+			return err;
+		}
+
+		err = prv_set_changed_recently_flag(s, flags & PRV_BULK_FLAG_CHANGED);
+		if (err) {
+			return err;
+		}
+	}
+
+	if (pos != end) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int user_settings_import_binary(const uint8_t *blob, size_t len)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+	/* Check the header and the CRC */
+	if (len < PRV_BULK_HEADER_LEN + PRV_BULK_CRC_LEN ||
+	    memcmp(blob, PRV_BULK_MAGIC_VERSION, 4) != 0 || sys_get_le32(&blob[4]) != len) {
+		LOG_ERR("Invalid bulk blob header");
+		return -EINVAL;
+	}
+
+	uint32_t crc = crc32_ieee(blob, len - PRV_BULK_CRC_LEN);
+	if (crc != sys_get_le32(&blob[len - PRV_BULK_CRC_LEN])) {
+		LOG_ERR("Bulk blob CRC mismatch");
+		return -EINVAL;
+	}
+
+	/* Validate all records before anything is stored, so an invalid blob is not applied
+	 * partially */
+	int err = prv_bulk_walk(blob, len, PRV_BULK_VALIDATE);
+	if (err) {
+		return err;
+	}
+
+	/* The settings backend has no transactions, so the current settings are exported first.
+	 * If storing fails midway, applying the export writes back the settings already stored. */
+	uint16_t count;
+	size_t snapshot_len = prv_bulk_len(&count);
+	uint8_t *snapshot = user_settings_list_buf_alloc(snapshot_len);
+	if (!snapshot) {
+		LOG_ERR("No space to export the current settings for a rollback");
+		return -ENOMEM;
+	}
+
+	struct user_settings_export_cursor cursor = {0};
+	int ret = user_settings_export_binary(snapshot, snapshot_len, &cursor);
+	if (ret < 0) {
+		user_settings_list_buf_free(snapshot);
+		return ret;
+	}
+
+	/* Callbacks are deferred, so they do not see a partial import */
+	prv_notify_deferred = true;
+
+	err = prv_bulk_walk(blob, len, PRV_BULK_APPLY);
+	if (err) {
+		LOG_ERR("Import failed, err: %d, rolling back", err);
+		int rollback_err = prv_bulk_walk(snapshot, snapshot_len, PRV_BULK_ROLLBACK);
+		if (rollback_err) {
+			LOG_ERR("Rollback failed, err: %d", rollback_err);
 		}
 	}
-	return false;
+
+	prv_notify_flush();
+	prv_wear_save_if_due();
+	user_settings_list_buf_free(snapshot);
+
+	return err;
+}
+
+#if CONFIG_USER_SETTINGS_IMPORT_BUF_SIZE > 0
+static uint8_t prv_import_buf[CONFIG_USER_SETTINGS_IMPORT_BUF_SIZE];
+static size_t prv_import_len;
+#endif
+
+int user_settings_import_binary_chunk(size_t offset, const uint8_t *data, size_t len)
+{
+#if CONFIG_USER_SETTINGS_IMPORT_BUF_SIZE > 0
+	/* A chunk at offset 0 starts a new import */
+	if (offset == 0) {
+		prv_import_len = 0;
+	}
+
+	if (offset != prv_import_len) {
+		return -EINVAL;
+	}
+
+	if (len > sizeof(prv_import_buf) - prv_import_len) {
+		prv_import_len = 0;
+		return -ENOMEM;
+	}
+
+	memcpy(&prv_import_buf[prv_import_len], data, len);
+	prv_import_len += len;
+
+	return 0;
+#else
+	return -ENOTSUP;
+#endif
+}
+
+int user_settings_import_binary_commit(void)
+{
+#if CONFIG_USER_SETTINGS_IMPORT_BUF_SIZE > 0
+	int err = user_settings_import_binary(prv_import_buf, prv_import_len);
+	prv_import_len = 0;
+	return err;
+#else
+	return -ENOTSUP;
+#endif
+}
+
+static int prv_get_wear_stats(struct user_setting *s, struct user_settings_wear_stats *stats)
+{
+#if defined(CONFIG_USER_SETTINGS_WEAR_STATS)
+	*stats = s->wear;
+	return 0;
+#else
+	return -ENOTSUP;
+#endif
+}
+
+int user_settings_get_wear_stats_with_key(char *key, struct user_settings_wear_stats *stats)
+{
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_key(key);
+	__ASSERT(s, "Key does not exists: %s", key);
+
+	return prv_get_wear_stats(s, stats);
+}
+
+int user_settings_get_wear_stats_with_id(uint16_t id, struct user_settings_wear_stats *stats)
+{
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
+
+	struct user_setting *s = user_settings_list_get_by_id(id);
+	__ASSERT(s, "ID does not exists: %d", id);
+
+	return prv_get_wear_stats(s, stats);
+}
+
+int user_settings_get_wear_totals(struct user_settings_wear_totals *totals)
+{
+	__ASSERT(prv_is_inited, INIT_ASSERT_TEXT);
+
+#if defined(CONFIG_USER_SETTINGS_WEAR_STATS)
+	memset(totals, 0, sizeof(*totals));
+
+	struct user_setting *s = NULL;
+	while ((s = user_settings_list_next(s)) != NULL) {
+		totals->sum.writes += s->wear.writes;
+		totals->sum.bytes += s->wear.bytes;
+		totals->sum.skipped += s->wear.skipped;
+	}
+
+	totals->boot_writes = prv_wear_boot_writes;
+
+	/* Average since boot. The uptime is at least 1 ms to not divide by zero, so each write in
+	 * the first millisecond counts as 3,600,000 per hour. */
+	int64_t uptime_ms = MAX(k_uptime_get(), 1);
+	uint64_t per_hour = (uint64_t)prv_wear_boot_writes * 3600000 / uptime_ms;
+	totals->writes_per_hour = MIN(per_hour, UINT32_MAX);
+
+	return 0;
+#else
+	return -ENOTSUP;
+#endif
+}
+
+int user_settings_save_wear_stats(void)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+#if defined(CONFIG_USER_SETTINGS_WEAR_STATS_PERSIST)
+	return prv_wear_save();
+#else
+	return -ENOTSUP;
+#endif
+}
+
+int user_settings_reset_wear_stats(void)
+{
+	__ASSERT(prv_is_loaded, LOAD_ASSERT_TEXT);
+
+#if defined(CONFIG_USER_SETTINGS_WEAR_STATS)
+	int ret = 0;
+
+	struct user_setting *s = NULL;
+	while ((s = user_settings_list_next(s)) != NULL) {
+		memset(&s->wear, 0, sizeof(s->wear));
+		s->wear_dirty = false;
+
+#if defined(CONFIG_USER_SETTINGS_WEAR_STATS_PERSIST)
+		char key_with_prefix[SETTINGS_MAX_NAME_LEN + 1] = {0};
+		sprintf(key_with_prefix, USER_SETTINGS_WEAR_PREFIX "/%s", s->key);
+		int err = settings_delete(key_with_prefix);
+		if (err) {
+			LOG_ERR("settings_delete, err: %d", err);
+			ret = -EIO;
+		}
+#endif
+	}
+
+	prv_wear_boot_writes = 0;
+#if defined(CONFIG_USER_SETTINGS_WEAR_STATS_PERSIST)
+	prv_wear_unsaved_writes = 0;
+	prv_wear_save_due = false;
+#endif
+
+	return ret;
+#else
+	return -ENOTSUP;
+#endif
 }
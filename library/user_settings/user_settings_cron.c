@@ -0,0 +1,406 @@
+/** @file user_settings_cron.c
+ *
+ * @brief Schedules of cron job settings
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2023 Irnas. All rights reserved.
+ */
+
+#include <user_settings_cron.h>
+
+#include "user_settings_cron_update.h"
+#include "user_settings_list.h"
+
+#include <errno.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/math_extras.h>
+#include <zephyr/sys/util.h>
+
+LOG_MODULE_DECLARE(user_settings, CONFIG_USER_SETTINGS_LOG_LEVEL);
+
+#define PRV_MINUTES_MASK BIT64_MASK(60)
+#define PRV_HOURS_MASK   BIT64_MASK(24)
+#define PRV_DAYS_MASK    BIT64_MASK(7)
+
+#define PRV_MINUTES_PER_DAY (24 * 60)
+
+/* 1970-01-01 was a Thursday */
+#define PRV_EPOCH_DAY_OF_WEEK 4
+
+/* Heap of the cron job settings with a valid schedule, ordered by their next fire time. NULL
+ * until the first call of user_settings_cron_peek() or user_settings_cron_pop(). */
+static struct user_setting **prv_heap;
+static size_t prv_heap_len;
+
+/* The time passed to the last call of user_settings_cron_peek() or user_settings_cron_pop(), and
+ * the uptime at that call. Used to schedule settings that change between calls. */
+static int64_t prv_clock_now;
+static int64_t prv_clock_uptime_ms;
+
+/**
+ * @brief Parse one field of a cron job string
+ *
+ * @param[in] str The two characters of the field
+ * @param[in] limit The number of values of the field
+ * @param[out] mask The values the field matches
+ *
+ * @retval true if the field is valid
+ */
+static bool prv_parse_field(const char *str, uint8_t limit, uint64_t *mask)
+{
+	if (str[0] == '*' && str[1] == '*') {
+		*mask = BIT64_MASK(limit);
+		return true;
+	}
+
+	if (str[0] < '0' || str[0] > '9' || str[1] < '0' || str[1] > '9') {
+		return false;
+	}
+
+	uint8_t v = (str[0] - '0') * 10 + (str[1] - '0');
+	if (v >= limit) {
+		return false;
+	}
+
+	*mask = BIT64(v);
+	return true;
+}
+
+int user_settings_cron_parse(const char *str, size_t len, struct user_settings_cron *cron)
+{
+	uint64_t minutes, hours, days;
+
+	/* the stored value may include the NULL terminator */
+	if (len == 9 && str[8] == '\0') {
+		len = 8;
+	}
+
+	if (len != 8 || str[2] != '-' || str[5] != '-') {
+		return -EINVAL;
+	}
+
+	if (!prv_parse_field(&str[0], 60, &minutes) || !prv_parse_field(&str[3], 24, &hours) ||
+	    !prv_parse_field(&str[6], 7, &days)) {
+		return -EINVAL;
+	}
+
+	cron->minutes = minutes;
+	cron->hours = hours;
+	cron->days_of_week = days;
+
+	return 0;
+}
+
+int user_settings_cron_next(const struct user_settings_cron *cron, int64_t now, int64_t *next)
+{
+	if (now < 0 || !(cron->minutes & PRV_MINUTES_MASK) || !(cron->hours & PRV_HOURS_MASK) ||
+	    !(cron->days_of_week & PRV_DAYS_MASK)) {
+		return -EINVAL;
+	}
+
+	/* search from the first whole minute after now */
+	int64_t minutes = now / 60 + 1;
+	int64_t day = minutes / PRV_MINUTES_PER_DAY;
+	uint32_t minute_of_day = minutes % PRV_MINUTES_PER_DAY;
+
+	/* every day of the week is checked once, the first day again if it matched too late */
+	for (int i = 0; i <= 7; i++, day++, minute_of_day = 0) {
+		if (!(cron->days_of_week & BIT((day + PRV_EPOCH_DAY_OF_WEEK) % 7))) {
+			continue;
+		}
+
+		for (uint32_t hour = minute_of_day / 60; hour < 24; hour++) {
+			if (!(cron->hours & BIT(hour))) {
+				continue;
+			}
+
+			uint32_t first = hour == minute_of_day / 60 ? minute_of_day % 60 : 0;
+			uint64_t match = cron->minutes & PRV_MINUTES_MASK & ~BIT64_MASK(first);
+			if (match) {
+				*next = ((day * 24 + hour) * 60 + u64_count_trailing_zeros(match)) * 60;
+				return 0;
+			}
+		}
+	}
+
+	/* not reachable, each field matches at least one value */
+	return -EINVAL;
+}
+
+/**
+ * @brief Swap two entries of the heap and update their indexes
+ */
+static void prv_heap_swap(size_t a, size_t b)
+{
+	struct user_setting *us = prv_heap[a];
+
+	prv_heap[a] = prv_heap[b];
+	prv_heap[b] = us;
+	prv_heap[a]->cron->heap_index = a;
+	prv_heap[b]->cron->heap_index = b;
+}
+
+static bool prv_heap_less(size_t a, size_t b)
+{
+	return prv_heap[a]->cron->next < prv_heap[b]->cron->next;
+}
+
+static void prv_heap_sift_up(size_t i)
+{
+	while (i > 0 && prv_heap_less(i, (i - 1) / 2)) {
+		prv_heap_swap(i, (i - 1) / 2);
+		i = (i - 1) / 2;
+	}
+}
+
+static void prv_heap_sift_down(size_t i)
+{
+	while (true) {
+		size_t smallest = i;
+		size_t left = 2 * i + 1;
+		size_t right = left + 1;
+
+		if (left < prv_heap_len && prv_heap_less(left, smallest)) {
+			smallest = left;
+		}
+		if (right < prv_heap_len && prv_heap_less(right, smallest)) {
+			smallest = right;
+		}
+		if (smallest == i) {
+			return;
+		}
+
+		prv_heap_swap(i, smallest);
+		i = smallest;
+	}
+}
+
+/**
+ * @brief Restore the heap order after the next fire time of an entry changed
+ */
+static void prv_heap_fix(size_t i)
+{
+	struct user_setting *us = prv_heap[i];
+
+	prv_heap_sift_up(i);
+	prv_heap_sift_down(us->cron->heap_index);
+}
+
+static void prv_heap_insert(struct user_setting *us)
+{
+	/* the heap has space for all cron job settings */
+	prv_heap[prv_heap_len] = us;
+	us->cron->heap_index = prv_heap_len;
+	prv_heap_len++;
+	prv_heap_sift_up(prv_heap_len - 1);
+}
+
+static void prv_heap_remove(struct user_setting *us)
+{
+	size_t i = us->cron->heap_index;
+
+	us->cron->heap_index = -1;
+	prv_heap_len--;
+	if (i == prv_heap_len) {
+		return;
+	}
+
+	prv_heap[i] = prv_heap[prv_heap_len];
+	prv_heap[i]->cron->heap_index = i;
+	prv_heap_fix(i);
+}
+
+/**
+ * @brief Put a setting into the heap, or move it, with its next fire time after now
+ */
+static void prv_schedule(struct user_setting *us, int64_t now)
+{
+	/* cannot fail, the schedule is valid and now is not negative */
+	(void)user_settings_cron_next(&us->cron->schedule, now, &us->cron->next);
+
+	if (us->cron->heap_index < 0) {
+		prv_heap_insert(us);
+	} else {
+		prv_heap_fix(us->cron->heap_index);
+	}
+}
+
+void user_settings_cron_update(struct user_setting *us)
+{
+	if (!us->cron) {
+		return;
+	}
+
+	size_t len;
+	const char *value = user_settings_list_value_get(us, &len);
+
+	us->cron->is_valid = value && user_settings_cron_parse(value, len, &us->cron->schedule) == 0;
+
+	if (!prv_heap) {
+		/* the heap is built with the current schedules when it is first used */
+		return;
+	}
+
+	if (us->cron->is_valid) {
+		int64_t elapsed_ms = k_uptime_get() - prv_clock_uptime_ms;
+		prv_schedule(us, prv_clock_now + elapsed_ms / MSEC_PER_SEC);
+	} else if (us->cron->heap_index >= 0) {
+		prv_heap_remove(us);
+	}
+}
+
+/**
+ * @brief Remember the current time and build the heap on first use
+ *
+ * @retval 0 On success
+ * @retval -ENODATA if there are no cron job settings
+ * @retval -ENOMEM if the heap could not be allocated
+ * @retval -EINVAL if @p now is negative
+ */
+static int prv_clock_sync(int64_t now)
+{
+	if (now < 0) {
+		return -EINVAL;
+	}
+
+	prv_clock_now = now;
+	prv_clock_uptime_ms = k_uptime_get();
+
+	if (prv_heap) {
+		return 0;
+	}
+
+	size_t num_cron = 0;
+	struct user_setting *us = NULL;
+	while ((us = user_settings_list_next(us)) != NULL) {
+		if (us->cron) {
+			num_cron++;
+		}
+	}
+
+	if (num_cron == 0) {
+		return -ENODATA;
+	}
+
+	prv_heap = user_settings_list_buf_alloc(num_cron * sizeof(*prv_heap));
+	if (!prv_heap) {
+		return -ENOMEM;
+	}
+
+	while ((us = user_settings_list_next(us)) != NULL) {
+		if (us->cron && us->cron->is_valid) {
+			prv_schedule(us, now);
+		}
+	}
+
+	return 0;
+}
+
+int user_settings_cron_peek(int64_t now, uint16_t *id, int64_t *next)
+{
+	int err = prv_clock_sync(now);
+	if (err) {
+		return err;
+	}
+
+	if (prv_heap_len == 0) {
+		return -ENODATA;
+	}
+
+	*id = prv_heap[0]->id;
+	*next = prv_heap[0]->cron->next;
+
+	return 0;
+}
+
+int user_settings_cron_pop(int64_t now, uint16_t *id)
+{
+	int err = prv_clock_sync(now);
+	if (err) {
+		return err;
+	}
+
+	if (prv_heap_len == 0) {
+		return -ENODATA;
+	}
+
+	struct user_setting *us = prv_heap[0];
+	if (us->cron->next > now) {
+		return -EAGAIN;
+	}
+
+	*id = us->id;
+	prv_schedule(us, now);
+
+	return 0;
+}
+
+/**
+ * @brief Get the schedule of a cron job setting
+ *
+ * @retval 0 On success
+ * @retval -ENODATA if the setting has no value and no default
+ */
+static int prv_get_cron(struct user_setting *us, struct user_settings_cron *cron)
+{
+	if (!us->cron->is_valid) {
+		return -ENODATA;
+	}
+
+	*cron = us->cron->schedule;
+	return 0;
+}
+
+static struct user_setting *prv_get_with_key(char *key)
+{
+	struct user_setting *us = user_settings_list_get_by_key(key);
+	__ASSERT(us, "Key does not exists: %s", key);
+	__ASSERT(us->cron, "Setting %s is not a cron job", key);
+
+	return us;
+}
+
+static struct user_setting *prv_get_with_id(uint16_t id)
+{
+	struct user_setting *us = user_settings_list_get_by_id(id);
+	__ASSERT(us, "ID does not exists: %d", id);
+	__ASSERT(us->cron, "Setting %d is not a cron job", id);
+
+	return us;
+}
+
+int user_settings_get_cron_with_key(char *key, struct user_settings_cron *cron)
+{
+	return prv_get_cron(prv_get_with_key(key), cron);
+}
+
+int user_settings_get_cron_with_id(uint16_t id, struct user_settings_cron *cron)
+{
+	return prv_get_cron(prv_get_with_id(id), cron);
+}
+
+int user_settings_cron_next_with_key(char *key, int64_t now, int64_t *next)
+{
+	struct user_settings_cron cron;
+
+	int err = prv_get_cron(prv_get_with_key(key), &cron);
+	if (err) {
+		return err;
+	}
+
+	return user_settings_cron_next(&cron, now, next);
+}
+
+int user_settings_cron_next_with_id(uint16_t id, int64_t now, int64_t *next)
+{
+	struct user_settings_cron cron;
+
+	int err = prv_get_cron(prv_get_with_id(id), &cron);
+	if (err) {
+		return err;
+	}
+
+	return user_settings_cron_next(&cron, now, next);
+}
@@ -0,0 +1,24 @@
+/** @file user_settings_cron_update.h
+ *
+ * @brief Internal interface between the user settings module and the cron job schedules
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2023 Irnas.  All rights reserved.
+ */
+
+#ifndef USER_SETTINGS_CRON_UPDATE_H
+#define USER_SETTINGS_CRON_UPDATE_H
+
+#include "user_settings_list.h"
+
+/**
+ * @brief Parse the current value of a cron job setting and reschedule it
+ *
+ * Called by the user settings module whenever the value or default of a setting changes, and
+ * for all settings after they are loaded. Settings of other types are ignored.
+ *
+ * @param[in] us The changed setting
+ */
+void user_settings_cron_update(struct user_setting *us);
+
+#endif /* USER_SETTINGS_CRON_UPDATE_H */
@@ -8,6 +8,7 @@
 
 #include "user_settings_json.h"
 #include "user_settings_list.h"
+#include "user_settings_set.h"
 #include <zephyr/kernel.h>
 #include <user_settings.h>
 #include <user_settings_types.h>
@@ -15,12 +16,196 @@
 #include <cJSON.h>
 #include <cJSON_os.h>
 
+#include <float.h>
+#include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(user_settings_json, CONFIG_USER_SETTINGS_LOG_LEVEL);
 
+/* Used to encode BYTES settings as a hex string */
+static const char prv_hex_chars[] = "0123456789ABCDEF";
+
+/**
+ * @brief Store an integer as an element of a fixed size type, truncating it to the size
+ *
+ * @param[in] v The value
+ * @param[in] size The size of the type (in bytes)
+ * @param[out] out The element
+ */
+static void prv_int_to_elem(uint64_t v, size_t size, void *out)
+{
+	switch (size) {
+	case sizeof(uint8_t): {
+		uint8_t v8 = v;
+		memcpy(out, &v8, size);
+		break;
+	}
+	case sizeof(uint16_t): {
+		uint16_t v16 = v;
+		memcpy(out, &v16, size);
+		break;
+	}
+	case sizeof(uint32_t): {
+		uint32_t v32 = v;
+		memcpy(out, &v32, size);
+		break;
+	}
+	default:
+		memcpy(out, &v, size);
+		break;
+	}
+}
+
+/**
+ * @brief Convert a JSON number to an integer element, if it is in the range of the type
+ *
+ * @param[in] type The integer type of the element
+ * @param[in] size The size of the element (in bytes)
+ * @param[in] d The number
+ * @param[out] out The element
+ *
+ * @retval true On success
+ * @retval false If the number is not finite or out of the range of the type
+ */
+static bool prv_double_to_int_elem(enum user_setting_type type, size_t size, double d, void *out)
+{
+	/* 2 to the power of the number of bits, exact as a double */
+	double range = ldexp(1.0, 8 * size);
+
+	if (!isfinite(d)) {
+		return false;
+	}
+
+	if (type >= USER_SETTINGS_TYPE_I8 && type <= USER_SETTINGS_TYPE_I64) {
+		if (d < -range / 2 || d >= range / 2) {
+			return false;
+		}
+		prv_int_to_elem((int64_t)d, size, out);
+	} else {
+		if (d < 0 || d >= range) {
+			return false;
+		}
+		prv_int_to_elem((uint64_t)d, size, out);
+	}
+
+	return true;
+}
+
+/**
+ * @brief Convert a cJSON item to an element of an array or a field of a record setting
+ *
+ * @param[in] type The type of the element
+ * @param[in] size The size of the element (in bytes)
+ * @param[in] item The cJSON bool or number
+ * @param[out] out The element
+ *
+ * @retval true On success
+ * @retval false If the item does not match the type or is out of its range
+ */
+static bool prv_elem_from_json(enum user_setting_type type, size_t size, const cJSON *item,
+			       void *out)
+{
+	if (type == USER_SETTINGS_TYPE_BOOL) {
+		if (!cJSON_IsBool(item)) {
+			return false;
+		}
+		bool v = cJSON_IsTrue(item);
+		memcpy(out, &v, sizeof(v));
+		return true;
+	}
+
+	if (!cJSON_IsNumber(item)) {
+		return false;
+	}
+
+	if (type == USER_SETTINGS_TYPE_F32) {
+		if (!isfinite(item->valuedouble) || fabs(item->valuedouble) > FLT_MAX) {
+			return false;
+		}
+		float v = (float)item->valuedouble;
+		memcpy(out, &v, sizeof(v));
+	} else if (type == USER_SETTINGS_TYPE_F64) {
+		if (!isfinite(item->valuedouble)) {
+			return false;
+		}
+		memcpy(out, &item->valuedouble, sizeof(item->valuedouble));
+	} else {
+		return prv_double_to_int_elem(type, size, item->valuedouble, out);
+	}
+
+	return true;
+}
+
+/**
+ * @brief Set an array setting from a cJSON array with a bool or number for each element
+ *
+ * @retval 0 On success
+ * @retval -EINVAL If the number of elements or their types do not match the setting
+ * @retval Other negative error codes returned by user_settings_set_with_key()
+ */
+static int prv_array_from_json(cJSON *setting)
+{
+	struct user_setting *s = user_settings_list_get_by_key(setting->string);
+	size_t elem_size = user_settings_list_array_elem_size(s);
+
+	if (cJSON_GetArraySize(setting) != s->max_size / elem_size) {
+		return -EINVAL;
+	}
+
+	uint8_t value[s->max_size];
+	size_t i = 0;
+	cJSON *item;
+
+	cJSON_ArrayForEach(item, setting)
+	{
+		if (!prv_elem_from_json(s->elem_type, elem_size, item, &value[i])) {
+			return -EINVAL;
+		}
+		i += elem_size;
+	}
+
+	return user_settings_set_with_key(setting->string, value, sizeof(value));
+}
+
+/**
+ * @brief Set a record setting from a cJSON object with a bool or number for each field
+ *
+ * Fields missing from the object keep their value, so the record is always set as a whole.
+ *
+ * @retval 0 On success
+ * @retval -EINVAL If an item is not a field of the setting or does not match its type
+ * @retval Other negative error codes returned by user_settings_set_with_key()
+ */
+static int prv_record_from_json(cJSON *setting)
+{
+	struct user_setting *s = user_settings_list_get_by_key(setting->string);
+	uint8_t value[s->max_size];
+	cJSON *item;
+
+	size_t data_len;
+	const void *data = user_settings_list_value_get(s, &data_len);
+	memset(value, 0, sizeof(value));
+	if (data) {
+		memcpy(value, data, MIN(data_len, sizeof(value)));
+	}
+
+	cJSON_ArrayForEach(item, setting)
+	{
+		const struct user_settings_record_field *field =
+			user_settings_list_record_field_get(s, item->string);
+		if (!field || !prv_elem_from_json(field->type,
+						  user_settings_list_record_field_size(field), item,
+						  &value[field->offset])) {
+			return -EINVAL;
+		}
+	}
+
+	return user_settings_set_with_key(setting->string, value, sizeof(value));
+}
+
 /**
  * @brief Set value from JSON structure.
  * Function expects we have already checked that setting key and value are valid.
@@ -102,6 +287,20 @@ static int prv_set_from_json(enum user_setting_type type, cJSON *setting, bool a
 		}
 		break;
 	}
+	case USER_SETTINGS_TYPE_F32: {
+		if (cJSON_IsNumber(setting)) {
+			float v = (float)setting->valuedouble;
+			err = user_settings_set_with_key(setting->string, &v, sizeof(v));
+		}
+		break;
+	}
+	case USER_SETTINGS_TYPE_F64: {
+		if (cJSON_IsNumber(setting)) {
+			double v = setting->valuedouble;
+			err = user_settings_set_with_key(setting->string, &v, sizeof(v));
+		}
+		break;
+	}
 	case USER_SETTINGS_TYPE_STR: {
 		if (cJSON_IsString(setting)) {
 			char *v = setting->valuestring;
@@ -120,10 +319,14 @@ static int prv_set_from_json(enum user_setting_type type, cJSON *setting, bool a
 	}
 	case USER_SETTINGS_TYPE_BYTES: {
 		if (cJSON_IsString(setting)) {
-			/* convert hex string to byte array */
-			uint8_t bytes[1024];
 			size_t bytes_len = strlen(setting->valuestring) / 2;
+			if (bytes_len > user_settings_get_max_len_with_key(setting->string)) {
+				err = -ENOMEM;
+				break;
+			}
 
+			/* convert hex string to byte array */
+			uint8_t bytes[bytes_len];
 			for (size_t i = 0, j = 0; i < bytes_len; i++, j += 2) {
 				bytes[i] = (setting->valuestring[j] % 32 + 9) % 25 * 16 +
 					   (setting->valuestring[j + 1] % 32 + 9) % 25;
@@ -132,6 +335,18 @@ static int prv_set_from_json(enum user_setting_type type, cJSON *setting, bool a
 		}
 		break;
 	}
+	case USER_SETTINGS_TYPE_ARRAY: {
+		if (cJSON_IsArray(setting)) {
+			err = prv_array_from_json(setting);
+		}
+		break;
+	}
+	case USER_SETTINGS_TYPE_RECORD: {
+		if (cJSON_IsObject(setting)) {
+			err = prv_record_from_json(setting);
+		}
+		break;
+	}
 	default: {
 		LOG_ERR("Type not supported!");
 		err = -EINVAL;
@@ -155,6 +370,100 @@ static int prv_set_from_json(enum user_setting_type type, cJSON *setting, bool a
 	return 0;
 }
 
+/**
+ * @brief Create a cJSON bool or number from an element of an array or a field of a record
+ *
+ * @param[in] type The type of the element
+ * @param[in] data The element
+ * @return cJSON* The item. NULL if it could not be created.
+ */
+static cJSON *prv_json_from_elem(enum user_setting_type type, const void *data)
+{
+	switch (type) {
+	case USER_SETTINGS_TYPE_BOOL:
+		return *(const bool *)data ? cJSON_CreateTrue() : cJSON_CreateFalse();
+	case USER_SETTINGS_TYPE_U8:
+		return cJSON_CreateNumber(*(const uint8_t *)data);
+	case USER_SETTINGS_TYPE_U16:
+		return cJSON_CreateNumber(*(const uint16_t *)data);
+	case USER_SETTINGS_TYPE_U32:
+		return cJSON_CreateNumber(*(const uint32_t *)data);
+	case USER_SETTINGS_TYPE_U64:
+		return cJSON_CreateNumber(*(const uint64_t *)data);
+	case USER_SETTINGS_TYPE_I8:
+		return cJSON_CreateNumber(*(const int8_t *)data);
+	case USER_SETTINGS_TYPE_I16:
+		return cJSON_CreateNumber(*(const int16_t *)data);
+	case USER_SETTINGS_TYPE_I32:
+		return cJSON_CreateNumber(*(const int32_t *)data);
+	case USER_SETTINGS_TYPE_I64:
+		return cJSON_CreateNumber(*(const int64_t *)data);
+	case USER_SETTINGS_TYPE_F32:
+		return cJSON_CreateNumber(*(const float *)data);
+	case USER_SETTINGS_TYPE_F64:
+		return cJSON_CreateNumber(*(const double *)data);
+	default:
+		return NULL;
+	}
+}
+
+/**
+ * @brief Create a cJSON array from the value of an array setting
+ *
+ * @param[in] setting The array setting
+ * @param[in] data The value
+ * @param[in] data_len The length of the value (in bytes)
+ * @return cJSON* The array. NULL if it could not be created.
+ */
+static cJSON *prv_json_from_array(struct user_setting *setting, const uint8_t *data,
+				  size_t data_len)
+{
+	size_t elem_size = user_settings_list_array_elem_size(setting);
+	cJSON *array = cJSON_CreateArray();
+
+	for (size_t i = 0; array && i + elem_size <= data_len; i += elem_size) {
+		cJSON *item = prv_json_from_elem(setting->elem_type, &data[i]);
+		if (!item) {
+			cJSON_Delete(array);
+			return NULL;
+		}
+		cJSON_AddItemToArray(array, item);
+	}
+
+	return array;
+}
+
+/**
+ * @brief Create a cJSON object with the fields of the value of a record setting
+ *
+ * @param[in] setting The record setting
+ * @param[in] data The value
+ * @param[in] data_len The length of the value (in bytes)
+ * @return cJSON* The object. NULL if it could not be created.
+ */
+static cJSON *prv_json_from_record(struct user_setting *setting, const uint8_t *data,
+				   size_t data_len)
+{
+	cJSON *record = cJSON_CreateObject();
+
+	for (size_t i = 0; record && i < setting->num_fields; i++) {
+		const struct user_settings_record_field *field = &setting->fields[i];
+
+		if (field->offset + user_settings_list_record_field_size(field) > data_len) {
+			continue;
+		}
+
+		cJSON *item = prv_json_from_elem(field->type, &data[field->offset]);
+		if (!item) {
+			cJSON_Delete(record);
+			return NULL;
+		}
+		cJSON_AddItemToObject(record, field->name, item);
+	}
+
+	return record;
+}
+
 /**
  * @brief Create cJSON object of appropriate type from user setting struct.
  *
@@ -165,9 +474,16 @@ static cJSON *prv_json_from_setting(struct user_setting *setting)
 {
 	cJSON *json_setting = NULL;
 
+	size_t data_len;
+	const void *data = user_settings_list_value_get(setting, &data_len);
+	if (!data) {
+		/* neither a value nor a default, nothing to write */
+		return NULL;
+	}
+
 	switch (setting->type) {
 	case USER_SETTINGS_TYPE_BOOL: {
-		if (*(bool *)setting->data) {
+		if (*(const bool *)data) {
 			json_setting = cJSON_CreateTrue();
 		} else {
 			json_setting = cJSON_CreateFalse();
@@ -175,52 +491,83 @@ static cJSON *prv_json_from_setting(struct user_setting *setting)
 		break;
 	}
 	case USER_SETTINGS_TYPE_U8: {
-		json_setting = cJSON_CreateNumber((int)*(uint8_t *)setting->data);
+		json_setting = cJSON_CreateNumber((int)*(const uint8_t *)data);
 		break;
 	}
 	case USER_SETTINGS_TYPE_U16: {
-		json_setting = cJSON_CreateNumber((int)*(uint16_t *)setting->data);
+		json_setting = cJSON_CreateNumber((int)*(const uint16_t *)data);
 		break;
 	}
 	case USER_SETTINGS_TYPE_U32: {
-		json_setting = cJSON_CreateNumber((int)*(uint32_t *)setting->data);
+		json_setting = cJSON_CreateNumber((int)*(const uint32_t *)data);
 		break;
 	}
 	case USER_SETTINGS_TYPE_U64: {
-		json_setting = cJSON_CreateNumber((int)*(uint64_t *)setting->data);
+		json_setting = cJSON_CreateNumber((int)*(const uint64_t *)data);
 		break;
 	}
 	case USER_SETTINGS_TYPE_I8: {
-		json_setting = cJSON_CreateNumber((int)*(int8_t *)setting->data);
+		json_setting = cJSON_CreateNumber((int)*(const int8_t *)data);
 		break;
 	}
 	case USER_SETTINGS_TYPE_I16: {
-		json_setting = cJSON_CreateNumber((int)*(int16_t *)setting->data);
+		json_setting = cJSON_CreateNumber((int)*(const int16_t *)data);
 		break;
 	}
 	case USER_SETTINGS_TYPE_I32: {
-		json_setting = cJSON_CreateNumber((int)*(int32_t *)setting->data);
+		json_setting = cJSON_CreateNumber((int)*(const int32_t *)data);
 		break;
 	}
 	case USER_SETTINGS_TYPE_I64: {
-		json_setting = cJSON_CreateNumber((int)*(int64_t *)setting->data);
+		json_setting = cJSON_CreateNumber((int)*(const int64_t *)data);
+		break;
+	}
+	case USER_SETTINGS_TYPE_F32: {
+		/* every float is exactly representable as a double, which cJSON prints exactly */
+		float v;
+		memcpy(&v, data, sizeof(v));
+		json_setting = cJSON_CreateNumber(v);
+		break;
+	}
+	case USER_SETTINGS_TYPE_F64: {
+		double v;
+		memcpy(&v, data, sizeof(v));
+		json_setting = cJSON_CreateNumber(v);
 		break;
 	}
 	case USER_SETTINGS_TYPE_STR: {
-		json_setting = cJSON_CreateString((char *)setting->data);
+		json_setting = cJSON_CreateString((const char *)data);
+		break;
+	}
+	case USER_SETTINGS_TYPE_CRON_JOB: {
+		/* the value is not always NULL terminated */
+		char cron[10] = {0};
+
+		memcpy(cron, data, MIN(data_len, sizeof(cron) - 1));
+		json_setting = cJSON_CreateString(cron);
 		break;
 	}
 	case USER_SETTINGS_TYPE_BYTES: {
 		/* convert bytes to hex string */
-		char bytes[setting->data_len * 2 + 1];
-		uint8_t *data = setting->data;
+		char bytes[data_len * 2 + 1];
+		const uint8_t *bytes_data = data;
 
-		for (size_t i = 0; i < setting->data_len; i++) {
-			sprintf(bytes + 2 * i, "%02X", data[i]);
+		for (size_t i = 0; i < data_len; i++) {
+			bytes[2 * i] = prv_hex_chars[bytes_data[i] >> 4];
+			bytes[2 * i + 1] = prv_hex_chars[bytes_data[i] & 0x0F];
 		}
+		bytes[data_len * 2] = '\0';
 		json_setting = cJSON_CreateString(bytes);
 		break;
 	}
+	case USER_SETTINGS_TYPE_ARRAY: {
+		json_setting = prv_json_from_array(setting, data, data_len);
+		break;
+	}
+	case USER_SETTINGS_TYPE_RECORD: {
+		json_setting = prv_json_from_record(setting, data, data_len);
+		break;
+	}
 	default: {
 		LOG_ERR("Type not supported!");
 	}
@@ -287,9 +634,8 @@ int user_settings_get_all_json(cJSON **settings_out)
 	}
 
 	/* Iterate trough settings */
-	user_settings_list_iter_start();
-	struct user_setting *setting_data;
-	while ((setting_data = user_settings_list_iter_next()) != NULL) {
+	struct user_setting *setting_data = NULL;
+	while ((setting_data = user_settings_list_next(setting_data)) != NULL) {
 		cJSON *setting = prv_json_from_setting(setting_data);
 		if (setting != NULL) {
 			cJSON_AddItemToObject(settings, setting_data->key, setting);
@@ -310,15 +656,12 @@ int user_settings_get_changed_json(cJSON **settings_out)
 		return -ENOMEM;
 	}
 
-	/* Iterate trough settings */
-	user_settings_list_iter_start();
-	struct user_setting *setting_data;
-	while ((setting_data = user_settings_list_iter_next()) != NULL) {
-		if (setting_data->has_changed_recently) {
-			cJSON *setting = prv_json_from_setting(setting_data);
-			if (setting != NULL) {
-				cJSON_AddItemToObject(settings, setting_data->key, setting);
-			}
+	/* Iterate trough changed settings only */
+	struct user_setting *setting_data = NULL;
+	while ((setting_data = user_settings_list_changed_next(setting_data)) != NULL) {
+		cJSON *setting = prv_json_from_setting(setting_data);
+		if (setting != NULL) {
+			cJSON_AddItemToObject(settings, setting_data->key, setting);
 		}
 	}
 
@@ -326,3 +669,1408 @@ int user_settings_get_changed_json(cJSON **settings_out)
 
 	return 0;
 }
+
+/**
+ * @brief Add flash write counters as a JSON object
+ *
+ * @return The added object or NULL if it could not be allocated
+ */
+static cJSON *prv_json_add_wear_stats(cJSON *parent, const char *name,
+				      const struct user_settings_wear_stats *stats)
+{
+	cJSON *obj = cJSON_AddObjectToObject(parent, name);
+	if (obj == NULL || cJSON_AddNumberToObject(obj, "writes", stats->writes) == NULL ||
+	    cJSON_AddNumberToObject(obj, "bytes", stats->bytes) == NULL ||
+	    cJSON_AddNumberToObject(obj, "skipped", stats->skipped) == NULL) {
+		return NULL;
+	}
+
+	return obj;
+}
+
+int user_settings_get_wear_stats_json(cJSON **stats_out)
+{
+	struct user_settings_wear_totals totals;
+	int err = user_settings_get_wear_totals(&totals);
+	if (err) {
+		return err;
+	}
+
+	/* Create json root object */
+	cJSON *root = cJSON_CreateObject();
+	if (root == NULL) {
+		return -ENOMEM;
+	}
+
+	cJSON *json_totals = prv_json_add_wear_stats(root, "totals", &totals.sum);
+	if (json_totals == NULL ||
+	    cJSON_AddNumberToObject(json_totals, "boot_writes", totals.boot_writes) == NULL ||
+	    cJSON_AddNumberToObject(json_totals, "writes_per_hour", totals.writes_per_hour) ==
+		    NULL) {
+		cJSON_Delete(root);
+		return -ENOMEM;
+	}
+
+	cJSON *settings = cJSON_AddObjectToObject(root, "settings");
+	if (settings == NULL) {
+		cJSON_Delete(root);
+		return -ENOMEM;
+	}
+
+	/* Only settings with non-zero counters are listed */
+	struct user_setting *setting = NULL;
+	while ((setting = user_settings_list_next(setting)) != NULL) {
+		struct user_settings_wear_stats stats;
+		user_settings_get_wear_stats_with_id(setting->id, &stats);
+		if (stats.writes == 0 && stats.skipped == 0) {
+			continue;
+		}
+
+		if (prv_json_add_wear_stats(settings, setting->key, &stats) == NULL) {
+			cJSON_Delete(root);
+			return -ENOMEM;
+		}
+	}
+
+	*stats_out = root;
+
+	return 0;
+}
+
+/* Parts of a JSON document written in chunks, see struct user_settings_json_cursor */
+enum prv_cursor_state {
+	PRV_CURSOR_OPEN = 0,
+	PRV_CURSOR_FIRST_MEMBER,
+	PRV_CURSOR_MEMBER,
+	PRV_CURSOR_CLOSE,
+	PRV_CURSOR_DONE,
+};
+
+/**
+ * @brief State of a chunked JSON write
+ *
+ * Each part of the document (the braces and the members) is generated from its start. Bytes
+ * before @p skip were already written in previous chunks and are dropped, the following bytes
+ * are copied into @p buf until it is full.
+ */
+struct prv_json_writer {
+	/** The buffer to write into */
+	char *buf;
+	/** The length of the buffer */
+	size_t len;
+	/** The number of bytes written into the buffer */
+	size_t written;
+	/** The number of bytes of the current part still to be skipped */
+	size_t skip;
+	/** Set if the buffer was full before the current part was written completely */
+	bool truncated;
+	/** Negative error code if a value could not be read, 0 otherwise */
+	int err;
+};
+
+static bool prv_writer_is_full(struct prv_json_writer *w)
+{
+	return w->written == w->len;
+}
+
+static void prv_writer_put(struct prv_json_writer *w, const char *data, size_t data_len)
+{
+	if (w->skip >= data_len) {
+		w->skip -= data_len;
+		return;
+	}
+
+	data += w->skip;
+	data_len -= w->skip;
+	w->skip = 0;
+
+	size_t n = MIN(data_len, w->len - w->written);
+	memcpy(w->buf + w->written, data, n);
+	w->written += n;
+
+	if (n < data_len) {
+		w->truncated = true;
+	}
+}
+
+static void prv_writer_put_str(struct prv_json_writer *w, const char *str)
+{
+	prv_writer_put(w, str, strlen(str));
+}
+
+/**
+ * @brief Write a string as a quoted and escaped JSON string
+ *
+ * @param[in] w The writer
+ * @param[in] str The string to write. Does not need to be NULL terminated.
+ * @param[in] str_len The length of the string
+ */
+static void prv_writer_put_quoted(struct prv_json_writer *w, const char *str, size_t str_len)
+{
+	size_t run_start = 0;
+
+	prv_writer_put(w, "\"", 1);
+
+	for (size_t i = 0; i < str_len; i++) {
+		uint8_t c = str[i];
+		char esc[6];
+		size_t esc_len = 2;
+
+		if (c == '"' || c == '\\') {
+			esc[1] = c;
+		} else if (c == '\n') {
+			esc[1] = 'n';
+		} else if (c == '\r') {
+			esc[1] = 'r';
+		} else if (c == '\t') {
+			esc[1] = 't';
+		} else if (c < 0x20) {
+			esc[1] = 'u';
+			esc[2] = '0';
+			esc[3] = '0';
+			esc[4] = prv_hex_chars[c >> 4];
+			esc[5] = prv_hex_chars[c & 0x0F];
+			esc_len = 6;
+		} else {
+			continue;
+		}
+		esc[0] = '\\';
+
+		/* write the characters that need no escaping in one go */
+		prv_writer_put(w, &str[run_start], i - run_start);
+		prv_writer_put(w, esc, esc_len);
+		run_start = i + 1;
+	}
+
+	prv_writer_put(w, &str[run_start], str_len - run_start);
+	prv_writer_put(w, "\"", 1);
+}
+
+/**
+ * @brief Write a bool or number as a JSON value
+ *
+ * @param[in] w The writer
+ * @param[in] type The type of the value, a bool or numeric type
+ * @param[in] data The value
+ */
+static void prv_writer_put_number(struct prv_json_writer *w, enum user_setting_type type,
+				  const void *data)
+{
+	/* large enough for any 64 bit number and any double with 17 significant digits */
+	char num[32];
+
+	switch (type) {
+	case USER_SETTINGS_TYPE_BOOL:
+		prv_writer_put_str(w, *(const bool *)data ? "true" : "false");
+		return;
+	case USER_SETTINGS_TYPE_U8:
+		snprintf(num, sizeof(num), "%u", *(const uint8_t *)data);
+		break;
+	case USER_SETTINGS_TYPE_U16:
+		snprintf(num, sizeof(num), "%u", *(const uint16_t *)data);
+		break;
+	case USER_SETTINGS_TYPE_U32:
+		snprintf(num, sizeof(num), "%u", *(const uint32_t *)data);
+		break;
+	case USER_SETTINGS_TYPE_U64:
+		snprintf(num, sizeof(num), "%llu", *(const unsigned long long *)data);
+		break;
+	case USER_SETTINGS_TYPE_I8:
+		snprintf(num, sizeof(num), "%d", *(const int8_t *)data);
+		break;
+	case USER_SETTINGS_TYPE_I16:
+		snprintf(num, sizeof(num), "%d", *(const int16_t *)data);
+		break;
+	case USER_SETTINGS_TYPE_I32:
+		snprintf(num, sizeof(num), "%d", *(const int32_t *)data);
+		break;
+	case USER_SETTINGS_TYPE_I64:
+		snprintf(num, sizeof(num), "%lld", *(const long long *)data);
+		break;
+	case USER_SETTINGS_TYPE_F32:
+	case USER_SETTINGS_TYPE_F64: {
+		double v;
+		if (type == USER_SETTINGS_TYPE_F32) {
+			float f;
+			memcpy(&f, data, sizeof(f));
+			v = f;
+		} else {
+			memcpy(&v, data, sizeof(v));
+		}
+
+		/* JSON has no NaN or infinity */
+		if (!isfinite(v)) {
+			prv_writer_put_str(w, "null");
+			return;
+		}
+
+		/* 9 and 17 significant digits are enough to parse back the exact same value */
+		snprintf(num, sizeof(num), "%.*g", type == USER_SETTINGS_TYPE_F32 ? 9 : 17, v);
+		break;
+	}
+	default:
+		LOG_ERR("Type not supported!");
+		prv_writer_put_str(w, "null");
+		return;
+	}
+
+	prv_writer_put_str(w, num);
+}
+
+/**
+ * @brief Write the value of a setting as a JSON value
+ *
+ * If the setting has no value, its default value is written. If the value of a lazy setting can
+ * not be read, nothing is written and the error is set in @p w.
+ *
+ * @param[in] w The writer
+ * @param[in] setting The setting to write. Must have a value or a default value
+ */
+static void prv_writer_put_value(struct prv_json_writer *w, struct user_setting *setting)
+{
+	size_t data_len;
+	const void *data = user_settings_list_value_get(setting, &data_len);
+	if (!data) {
+		/* a lazy value is fetched again for each chunk, which can fail */
+		w->err = -EIO;
+		return;
+	}
+
+	switch (setting->type) {
+	case USER_SETTINGS_TYPE_STR:
+	case USER_SETTINGS_TYPE_CRON_JOB:
+		prv_writer_put_quoted(w, data, strnlen(data, data_len));
+		return;
+	case USER_SETTINGS_TYPE_BYTES: {
+		const uint8_t *bytes_data = data;
+
+		prv_writer_put(w, "\"", 1);
+		for (size_t i = 0; i < data_len && !w->truncated; i++) {
+			char hex[2] = {prv_hex_chars[bytes_data[i] >> 4],
+				       prv_hex_chars[bytes_data[i] & 0x0F]};
+			prv_writer_put(w, hex, sizeof(hex));
+		}
+		prv_writer_put(w, "\"", 1);
+		return;
+	}
+	case USER_SETTINGS_TYPE_ARRAY: {
+		const uint8_t *elems = data;
+		size_t elem_size = user_settings_list_array_elem_size(setting);
+
+		prv_writer_put(w, "[", 1);
+		for (size_t i = 0; i + elem_size <= data_len && !w->truncated; i += elem_size) {
+			if (i > 0) {
+				prv_writer_put(w, ",", 1);
+			}
+			prv_writer_put_number(w, setting->elem_type, &elems[i]);
+		}
+		prv_writer_put(w, "]", 1);
+		return;
+	}
+	case USER_SETTINGS_TYPE_RECORD: {
+		const uint8_t *record = data;
+		bool first = true;
+
+		prv_writer_put(w, "{", 1);
+		for (size_t i = 0; i < setting->num_fields && !w->truncated; i++) {
+			const struct user_settings_record_field *field = &setting->fields[i];
+
+			if (field->offset + user_settings_list_record_field_size(field) > data_len) {
+				continue;
+			}
+
+			if (!first) {
+				prv_writer_put(w, ",", 1);
+			}
+			first = false;
+
+			prv_writer_put_quoted(w, field->name, strlen(field->name));
+			prv_writer_put(w, ":", 1);
+			prv_writer_put_number(w, field->type, &record[field->offset]);
+		}
+		prv_writer_put(w, "}", 1);
+		return;
+	}
+	default:
+		prv_writer_put_number(w, setting->type, data);
+		return;
+	}
+}
+
+/**
+ * @brief Get the next setting with a value or a default, to be written after @p setting
+ *
+ * @param[in] setting The setting written before, NULL to get the first one
+ * @param[in] changed_only Only return settings marked changed
+ */
+static struct user_setting *prv_json_write_next(struct user_setting *setting, bool changed_only)
+{
+	do {
+		setting = changed_only ? user_settings_list_changed_next(setting)
+				       : user_settings_list_next(setting);
+	} while (setting && !user_settings_list_value_get(setting, NULL));
+
+	return setting;
+}
+
+/**
+ * @brief Write the part of the document the cursor is at
+ */
+static void prv_json_write_part(struct prv_json_writer *w,
+				const struct user_settings_json_cursor *cursor)
+{
+	switch (cursor->state) {
+	case PRV_CURSOR_OPEN:
+		prv_writer_put(w, "{", 1);
+		break;
+	case PRV_CURSOR_MEMBER:
+		prv_writer_put(w, ",", 1);
+		/* fallthrough */
+	case PRV_CURSOR_FIRST_MEMBER:
+		prv_writer_put_quoted(w, cursor->setting->key, strlen(cursor->setting->key));
+		prv_writer_put(w, ":", 1);
+		prv_writer_put_value(w, cursor->setting);
+		break;
+	case PRV_CURSOR_CLOSE:
+		prv_writer_put(w, "}", 1);
+		break;
+	}
+}
+
+/**
+ * @brief Move the cursor to the next part of the document
+ */
+static void prv_json_write_advance(struct user_settings_json_cursor *cursor, bool changed_only)
+{
+	switch (cursor->state) {
+	case PRV_CURSOR_OPEN:
+		cursor->setting = prv_json_write_next(NULL, changed_only);
+		cursor->state = cursor->setting ? PRV_CURSOR_FIRST_MEMBER : PRV_CURSOR_CLOSE;
+		break;
+	case PRV_CURSOR_FIRST_MEMBER:
+	case PRV_CURSOR_MEMBER:
+		cursor->setting = prv_json_write_next(cursor->setting, changed_only);
+		cursor->state = cursor->setting ? PRV_CURSOR_MEMBER : PRV_CURSOR_CLOSE;
+		break;
+	default:
+		cursor->state = PRV_CURSOR_DONE;
+		break;
+	}
+
+	cursor->part_offset = 0;
+}
+
+/**
+ * @brief Write the next chunk of a flat JSON object with all or only the changed settings
+ */
+static int prv_json_write(char *buf, size_t len, struct user_settings_json_cursor *cursor,
+			  bool changed_only)
+{
+	if (buf == NULL || len == 0) {
+		return -EINVAL;
+	}
+
+	struct prv_json_writer w = {
+		.buf = buf,
+		.len = len,
+	};
+
+	while (cursor->state != PRV_CURSOR_DONE && !prv_writer_is_full(&w)) {
+		size_t part_start = w.written;
+
+		w.skip = cursor->part_offset;
+		w.truncated = false;
+		prv_json_write_part(&w, cursor);
+
+		if (w.err) {
+			/* The cursor stays at this part, so it is written again by the next call. The
+			 * parts before it are returned first. */
+			if (part_start == 0) {
+				return w.err;
+			}
+			w.written = part_start;
+			break;
+		}
+
+		if (w.truncated) {
+			/* continue this part in the next chunk */
+			cursor->part_offset += w.written - part_start;
+			break;
+		}
+
+		prv_json_write_advance(cursor, changed_only);
+	}
+
+	cursor->offset += w.written;
+
+	return w.written;
+}
+
+int user_settings_json_write_all(char *buf, size_t len, struct user_settings_json_cursor *cursor)
+{
+	return prv_json_write(buf, len, cursor, false);
+}
+
+int user_settings_json_write_changed(char *buf, size_t len,
+				     struct user_settings_json_cursor *cursor)
+{
+	return prv_json_write(buf, len, cursor, true);
+}
+
+/* States of the streaming JSON parser */
+enum prv_parser_state {
+	PRV_PARSER_OBJECT_START = 0,
+	PRV_PARSER_KEY_OR_END,
+	PRV_PARSER_KEY,
+	PRV_PARSER_IN_KEY,
+	PRV_PARSER_COLON,
+	PRV_PARSER_VALUE,
+	PRV_PARSER_IN_STRING,
+	PRV_PARSER_IN_TOKEN,
+	PRV_PARSER_ARRAY_ELEM_OR_END,
+	PRV_PARSER_ARRAY_ELEM,
+	PRV_PARSER_IN_ARRAY_TOKEN,
+	PRV_PARSER_ARRAY_COMMA_OR_END,
+	PRV_PARSER_RECORD_FIELD_OR_END,
+	PRV_PARSER_RECORD_FIELD,
+	PRV_PARSER_IN_RECORD_FIELD,
+	PRV_PARSER_RECORD_COLON,
+	PRV_PARSER_RECORD_VALUE,
+	PRV_PARSER_IN_RECORD_TOKEN,
+	PRV_PARSER_RECORD_COMMA_OR_END,
+	PRV_PARSER_SKIP_VALUE,
+	PRV_PARSER_COMMA_OR_END,
+	PRV_PARSER_DONE,
+};
+
+/* Kinds of JSON values the streaming parser handles */
+enum prv_parser_value_kind {
+	/* A quoted string */
+	PRV_PARSER_VALUE_STRING = 0,
+	/* A number, true, false or null */
+	PRV_PARSER_VALUE_TOKEN,
+};
+
+static bool prv_is_space(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/**
+ * @brief Convert a hex character to its value
+ *
+ * @param[in] c The character
+ *
+ * @return The value of the character (0 - 15) or -1 if it is not a hex character
+ */
+static int prv_hex_to_nibble(char c)
+{
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	}
+	if (c >= 'a' && c <= 'f') {
+		return c - 'a' + 10;
+	}
+	if (c >= 'A' && c <= 'F') {
+		return c - 'A' + 10;
+	}
+	return -1;
+}
+
+/**
+ * @brief Store one decoded character of the current key or value
+ *
+ * Values of bytes settings are hex decoded while they are stored, so the value buffer only needs
+ * to be as large as the decoded value.
+ */
+static void prv_parser_push(struct user_settings_json_parser *p, char c)
+{
+	if (p->state == PRV_PARSER_IN_KEY) {
+		if (p->key_len < SETTINGS_MAX_NAME_LEN) {
+			p->key[p->key_len++] = c;
+		} else {
+			p->overflow = true;
+		}
+		return;
+	}
+
+	/* The value of an unknown key is scanned, but not stored */
+	if (!p->setting) {
+		return;
+	}
+
+	if (p->setting->type == USER_SETTINGS_TYPE_BYTES &&
+	    p->value_kind == PRV_PARSER_VALUE_STRING) {
+		int nibble = prv_hex_to_nibble(c);
+		if (nibble < 0) {
+			p->invalid = true;
+			return;
+		}
+
+		if (!p->half_byte) {
+			/* Bytes values are not NULL terminated */
+			if (p->value_len == CONFIG_USER_SETTINGS_JSON_PARSER_VALUE_SIZE) {
+				p->overflow = true;
+				return;
+			}
+			p->value[p->value_len] = nibble << 4;
+		} else {
+			p->value[p->value_len++] |= nibble;
+		}
+		p->half_byte = !p->half_byte;
+		return;
+	}
+
+	/* Tokens of array elements are stored after the elements decoded so far, field names and
+	 * tokens of records after the record value
+	 */
+	if (p->array_len + p->value_len < sizeof(p->value)) {
+		p->value[p->array_len + p->value_len++] = c;
+	} else {
+		p->overflow = true;
+	}
+}
+
+/**
+ * @brief Store a unicode code point from a \u escape as UTF-8
+ */
+static void prv_parser_push_code_point(struct user_settings_json_parser *p, uint16_t cp)
+{
+	if (cp < 0x80) {
+		prv_parser_push(p, cp);
+	} else if (cp < 0x800) {
+		prv_parser_push(p, 0xC0 | (cp >> 6));
+		prv_parser_push(p, 0x80 | (cp & 0x3F));
+	} else {
+		prv_parser_push(p, 0xE0 | (cp >> 12));
+		prv_parser_push(p, 0x80 | ((cp >> 6) & 0x3F));
+		prv_parser_push(p, 0x80 | (cp & 0x3F));
+	}
+}
+
+/**
+ * @brief Handle one character inside of a quoted string
+ *
+ * @retval 0 if the string continues
+ * @retval 1 if this was the closing quote
+ * @retval -EINVAL if the string is not valid JSON
+ */
+static int prv_parser_string_char(struct user_settings_json_parser *p, char c)
+{
+	if (p->unicode_left) {
+		int nibble = prv_hex_to_nibble(c);
+		if (nibble < 0) {
+			return -EINVAL;
+		}
+		p->unicode = (p->unicode << 4) | nibble;
+		if (--p->unicode_left == 0) {
+			prv_parser_push_code_point(p, p->unicode);
+		}
+		return 0;
+	}
+
+	if (p->in_escape) {
+		p->in_escape = false;
+		switch (c) {
+		case '"':
+		case '\\':
+		case '/':
+			prv_parser_push(p, c);
+			return 0;
+		case 'b':
+			prv_parser_push(p, '\b');
+			return 0;
+		case 'f':
+			prv_parser_push(p, '\f');
+			return 0;
+		case 'n':
+			prv_parser_push(p, '\n');
+			return 0;
+		case 'r':
+			prv_parser_push(p, '\r');
+			return 0;
+		case 't':
+			prv_parser_push(p, '\t');
+			return 0;
+		case 'u':
+			p->unicode_left = 4;
+			p->unicode = 0;
+			return 0;
+		default:
+			return -EINVAL;
+		}
+	}
+
+	if (c == '\\') {
+		p->in_escape = true;
+		return 0;
+	}
+
+	if (c == '"') {
+		return 1;
+	}
+
+	if ((uint8_t)c < 0x20) {
+		/* control characters must be escaped */
+		return -EINVAL;
+	}
+
+	prv_parser_push(p, c);
+	return 0;
+}
+
+/**
+ * @brief Look up the setting after its key has been scanned
+ */
+static void prv_parser_key_done(struct user_settings_json_parser *p)
+{
+	p->key[p->key_len] = '\0';
+
+	p->setting = p->overflow ? NULL : user_settings_list_get_by_key(p->key);
+	if (!p->setting) {
+		LOG_WRN("Key does not exists: %s!", p->key);
+	}
+}
+
+/**
+ * @brief Parse the current value token as an integer
+ *
+ * @param[in] p The parser
+ * @param[in] is_signed If the setting type is signed
+ * @param[out] out The parsed value
+ *
+ * @retval true If the token is a valid integer
+ * @retval false Otherwise
+ */
+static bool prv_parser_token_to_int(struct user_settings_json_parser *p, bool is_signed,
+				    uint64_t *out)
+{
+	char *end;
+	char *token = (char *)&p->value[p->array_len];
+
+	if (p->value_kind != PRV_PARSER_VALUE_TOKEN || p->value_len == 0) {
+		return false;
+	}
+
+	if (is_signed) {
+		*out = strtoll(token, &end, 10);
+	} else {
+		*out = strtoull(token, &end, 10);
+	}
+
+	return end == token + p->value_len;
+}
+
+/**
+ * @brief Parse the current value token as a floating point number
+ *
+ * @param[in] p The parser
+ * @param[out] out The parsed value
+ *
+ * @retval true If the token is a valid number
+ * @retval false Otherwise
+ */
+static bool prv_parser_token_to_double(struct user_settings_json_parser *p, double *out)
+{
+	char *end;
+	char *token = (char *)&p->value[p->array_len];
+
+	if (p->value_kind != PRV_PARSER_VALUE_TOKEN || p->value_len == 0) {
+		return false;
+	}
+
+	*out = strtod(token, &end);
+
+	return end == token + p->value_len;
+}
+
+/**
+ * @brief Parse the current value token as a bool or number of a fixed size type
+ *
+ * Integers are truncated to the size of the type.
+ *
+ * @param[in] p The parser
+ * @param[in] type The type, a bool or numeric type
+ * @param[in] size The size of the type (in bytes)
+ * @param[out] out The value
+ *
+ * @retval true If the token is valid for the type
+ * @retval false Otherwise
+ */
+static bool prv_parser_token_to_elem(struct user_settings_json_parser *p,
+				     enum user_setting_type type, size_t size, void *out)
+{
+	const char *token = (const char *)&p->value[p->array_len];
+	uint64_t v;
+	double d;
+
+	switch (type) {
+	case USER_SETTINGS_TYPE_BOOL: {
+		bool b;
+		if (p->value_kind == PRV_PARSER_VALUE_TOKEN && strcmp(token, "true") == 0) {
+			b = true;
+		} else if (p->value_kind == PRV_PARSER_VALUE_TOKEN && strcmp(token, "false") == 0) {
+			b = false;
+		} else {
+			return false;
+		}
+		memcpy(out, &b, sizeof(b));
+		return true;
+	}
+	case USER_SETTINGS_TYPE_U8:
+	case USER_SETTINGS_TYPE_U16:
+	case USER_SETTINGS_TYPE_U32:
+	case USER_SETTINGS_TYPE_U64:
+		if (!prv_parser_token_to_int(p, false, &v)) {
+			return false;
+		}
+		prv_int_to_elem(v, size, out);
+		return true;
+	case USER_SETTINGS_TYPE_I8:
+	case USER_SETTINGS_TYPE_I16:
+	case USER_SETTINGS_TYPE_I32:
+	case USER_SETTINGS_TYPE_I64:
+		if (!prv_parser_token_to_int(p, true, &v)) {
+			return false;
+		}
+		prv_int_to_elem(v, size, out);
+		return true;
+	case USER_SETTINGS_TYPE_F32: {
+		if (!prv_parser_token_to_double(p, &d)) {
+			return false;
+		}
+		float f = (float)d;
+		memcpy(out, &f, sizeof(f));
+		return true;
+	}
+	case USER_SETTINGS_TYPE_F64:
+		if (!prv_parser_token_to_double(p, &d)) {
+			return false;
+		}
+		memcpy(out, &d, sizeof(d));
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * @brief Set the setting from the scanned value
+ *
+ * @retval 0 On success
+ * @retval -EINVAL if the value does not match the setting type
+ * @retval Other negative error codes returned by user_settings_set_setting()
+ */
+static int prv_parser_set(struct user_settings_json_parser *p)
+{
+	struct user_setting *s = p->setting;
+	bool is_string = p->value_kind == PRV_PARSER_VALUE_STRING;
+
+	switch (s->type) {
+	case USER_SETTINGS_TYPE_BOOL:
+	case USER_SETTINGS_TYPE_U8:
+	case USER_SETTINGS_TYPE_U16:
+	case USER_SETTINGS_TYPE_U32:
+	case USER_SETTINGS_TYPE_U64:
+	case USER_SETTINGS_TYPE_I8:
+	case USER_SETTINGS_TYPE_I16:
+	case USER_SETTINGS_TYPE_I32:
+	case USER_SETTINGS_TYPE_I64:
+	case USER_SETTINGS_TYPE_F32:
+	case USER_SETTINGS_TYPE_F64: {
+		/* large enough for any of these types */
+		uint64_t v;
+		if (!prv_parser_token_to_elem(p, s->type, s->max_size, &v)) {
+			return -EINVAL;
+		}
+		return user_settings_set_setting(s, &v, s->max_size);
+	}
+	case USER_SETTINGS_TYPE_STR:
+		if (!is_string) {
+			return -EINVAL;
+		}
+		return user_settings_set_setting(s, p->value, p->value_len + 1);
+	case USER_SETTINGS_TYPE_CRON_JOB:
+		if (!is_string) {
+			return -EINVAL;
+		}
+		return user_settings_set_setting(s, p->value, p->value_len);
+	case USER_SETTINGS_TYPE_BYTES:
+		if (!is_string || p->half_byte) {
+			return -EINVAL;
+		}
+		return user_settings_set_setting(s, p->value, p->value_len);
+	case USER_SETTINGS_TYPE_ARRAY:
+		if (!p->in_array) {
+			return -EINVAL;
+		}
+		return user_settings_set_setting(s, p->value, p->array_len);
+	case USER_SETTINGS_TYPE_RECORD:
+		if (!p->in_record) {
+			return -EINVAL;
+		}
+		return user_settings_set_setting(s, p->value, p->array_len);
+	default:
+		LOG_ERR("Type not supported!");
+		return -EINVAL;
+	}
+}
+
+/**
+ * @brief Apply the scanned value to its setting
+ *
+ * @retval 0 On success or if the value was skipped
+ * @retval -ENOMEM If the new value is larger than the max_size or the value buffer
+ * @retval -EIO if the setting value could not be stored to NVS
+ */
+static int prv_parser_apply(struct user_settings_json_parser *p)
+{
+	int err;
+
+	if (!p->setting) {
+		return 0;
+	}
+
+	/* Values are NULL terminated, so that strings can be stored and tokens parsed. The
+	 * elements of arrays and fields of records are already decoded by prv_parser_elem_done()
+	 * and prv_parser_field_done().
+	 */
+	bool is_decoded = p->in_array || p->in_record;
+	if (p->overflow || (!is_decoded && p->value_len == sizeof(p->value))) {
+		LOG_ERR("Value too large for setting: %s", p->setting->key);
+		return -ENOMEM;
+	}
+
+	if (!is_decoded) {
+		p->value[p->value_len] = '\0';
+
+		if (p->value_kind == PRV_PARSER_VALUE_TOKEN &&
+		    strcmp((char *)p->value, "null") == 0) {
+			return 0;
+		}
+	}
+
+	err = p->invalid ? -EINVAL : prv_parser_set(p);
+	if (err == -EINVAL) {
+		LOG_ERR("Invalid json data for setting: %s", p->setting->key);
+		return 0;
+	} else if (err) {
+		LOG_ERR("Failed to store setting data: %d", err);
+		return err;
+	}
+
+	/* See prv_set_from_json() */
+	if (p->always_mark_changed) {
+		user_settings_set_changed_setting(p->setting);
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Decode the scanned element token of an array value after the elements before it
+ */
+static void prv_parser_elem_done(struct user_settings_json_parser *p)
+{
+	struct user_setting *s = p->setting;
+
+	/* Elements of unknown keys and values that are already rejected are only scanned */
+	if (!s || p->invalid || p->overflow) {
+		p->value_len = 0;
+		return;
+	}
+
+	size_t elem_size = user_settings_list_array_elem_size(s);
+	uint64_t elem;
+
+	/* The token needs space for its NULL terminator */
+	if (p->array_len + p->value_len == sizeof(p->value) ||
+	    p->array_len + elem_size > CONFIG_USER_SETTINGS_JSON_PARSER_VALUE_SIZE ||
+	    p->array_len + elem_size > s->max_size) {
+		p->overflow = true;
+	} else {
+		p->value[p->array_len + p->value_len] = '\0';
+
+		if (prv_parser_token_to_elem(p, s->elem_type, elem_size, &elem)) {
+			memcpy(&p->value[p->array_len], &elem, elem_size);
+			p->array_len += elem_size;
+		} else {
+			p->invalid = true;
+		}
+	}
+
+	p->value_len = 0;
+}
+
+/**
+ * @brief Start a record value with the current value of the record setting
+ *
+ * Fields that are not in the object keep their value. The field names and tokens are scanned
+ * after the record value.
+ */
+static void prv_parser_record_start(struct user_settings_json_parser *p)
+{
+	struct user_setting *s = p->setting;
+
+	if (s->max_size > CONFIG_USER_SETTINGS_JSON_PARSER_VALUE_SIZE) {
+		p->overflow = true;
+		return;
+	}
+
+	size_t data_len;
+	const void *data = user_settings_list_value_get(s, &data_len);
+	memset(p->value, 0, s->max_size);
+	if (data) {
+		memcpy(p->value, data, MIN(data_len, s->max_size));
+	}
+	p->array_len = s->max_size;
+}
+
+/**
+ * @brief Look up the field of a record after its name has been scanned
+ */
+static void prv_parser_field_name_done(struct user_settings_json_parser *p)
+{
+	p->field = NULL;
+
+	/* Fields of unknown keys and values that are already rejected are only scanned */
+	if (!p->setting || p->invalid || p->overflow) {
+		p->value_len = 0;
+		return;
+	}
+
+	if (p->array_len + p->value_len == sizeof(p->value)) {
+		p->overflow = true;
+	} else {
+		p->value[p->array_len + p->value_len] = '\0';
+
+		p->field = user_settings_list_record_field_get(p->setting,
+							       (char *)&p->value[p->array_len]);
+		if (!p->field) {
+			LOG_WRN("Field does not exists: %s!", (char *)&p->value[p->array_len]);
+			p->invalid = true;
+		}
+	}
+
+	p->value_len = 0;
+}
+
+/**
+ * @brief Decode the scanned token of a record field into the record value
+ */
+static void prv_parser_field_done(struct user_settings_json_parser *p)
+{
+	if (!p->setting || p->invalid || p->overflow) {
+		p->value_len = 0;
+		return;
+	}
+
+	size_t field_size = user_settings_list_record_field_size(p->field);
+	uint64_t field;
+
+	if (p->array_len + p->value_len == sizeof(p->value)) {
+		p->overflow = true;
+	} else {
+		p->value[p->array_len + p->value_len] = '\0';
+
+		/* null, i.e. for a float that is not finite, keeps the value of the field */
+		bool is_null = strcmp((char *)&p->value[p->array_len], "null") == 0;
+
+		if (prv_parser_token_to_elem(p, p->field->type, field_size, &field)) {
+			memcpy(&p->value[p->field->offset], &field, field_size);
+		} else if (!is_null) {
+			p->invalid = true;
+		}
+	}
+
+	p->value_len = 0;
+}
+
+/**
+ * @brief Start scanning a new key or value string
+ */
+static void prv_parser_start_string(struct user_settings_json_parser *p, uint8_t state)
+{
+	p->state = state;
+	p->in_escape = false;
+	p->unicode_left = 0;
+	p->overflow = false;
+}
+
+/**
+ * @brief Skip the rest of an array or object value that is not applied
+ *
+ * Used for values of unknown keys and for values that do not match the type of their setting,
+ * which can hold nested objects, nested arrays and strings. Only the nesting and the strings are
+ * tracked, so that the end of the value is found.
+ *
+ * @param[in] p The parser
+ * @param[in] depth The number of arrays and objects already open
+ * @param[in] invalid Set if the value belongs to a setting and is logged as invalid
+ */
+static void prv_parser_start_skip(struct user_settings_json_parser *p, uint16_t depth,
+				  bool invalid)
+{
+	p->invalid = p->invalid || invalid;
+	p->skip_depth = depth;
+	p->skip_in_string = false;
+	p->in_escape = false;
+	p->state = PRV_PARSER_SKIP_VALUE;
+}
+
+/**
+ * @brief Handle one character of a skipped value
+ *
+ * @retval 0 On success
+ * @retval Other negative error codes returned by prv_parser_apply()
+ */
+static int prv_parser_skip_char(struct user_settings_json_parser *p, char c)
+{
+	if (p->skip_in_string) {
+		if (p->in_escape) {
+			p->in_escape = false;
+		} else if (c == '\\') {
+			p->in_escape = true;
+		} else if (c == '"') {
+			p->skip_in_string = false;
+		}
+		return 0;
+	}
+
+	switch (c) {
+	case '"':
+		p->skip_in_string = true;
+		return 0;
+	case '[':
+	case '{':
+		p->skip_depth++;
+		return 0;
+	case ']':
+	case '}':
+		if (--p->skip_depth > 0) {
+			return 0;
+		}
+		p->state = PRV_PARSER_COMMA_OR_END;
+		return prv_parser_apply(p);
+	default:
+		return 0;
+	}
+}
+
+/**
+ * @brief Run one character through the parser state machine
+ *
+ * @retval 0 On success
+ * @retval -EINVAL if the document is not a valid flat JSON object
+ * @retval Other negative error codes returned by prv_parser_apply()
+ */
+static int prv_parser_char(struct user_settings_json_parser *p, char c)
+{
+	int ret;
+
+	switch (p->state) {
+	case PRV_PARSER_OBJECT_START:
+		if (prv_is_space(c)) {
+			return 0;
+		}
+		if (c != '{') {
+			return -EINVAL;
+		}
+		p->state = PRV_PARSER_KEY_OR_END;
+		return 0;
+	case PRV_PARSER_KEY_OR_END:
+		if (c == '}') {
+			p->state = PRV_PARSER_DONE;
+			return 0;
+		}
+		/* Fallthrough */
+	case PRV_PARSER_KEY:
+		if (prv_is_space(c)) {
+			return 0;
+		}
+		if (c != '"') {
+			return -EINVAL;
+		}
+		p->key_len = 0;
+		prv_parser_start_string(p, PRV_PARSER_IN_KEY);
+		return 0;
+	case PRV_PARSER_IN_KEY:
+		ret = prv_parser_string_char(p, c);
+		if (ret == 1) {
+			prv_parser_key_done(p);
+			p->state = PRV_PARSER_COLON;
+			return 0;
+		}
+		return ret;
+	case PRV_PARSER_COLON:
+		if (prv_is_space(c)) {
+			return 0;
+		}
+		if (c != ':') {
+			return -EINVAL;
+		}
+		p->state = PRV_PARSER_VALUE;
+		return 0;
+	case PRV_PARSER_VALUE:
+		if (prv_is_space(c)) {
+			return 0;
+		}
+		p->value_len = 0;
+		p->invalid = false;
+		p->half_byte = false;
+		p->in_array = false;
+		p->in_record = false;
+		p->array_len = 0;
+		if (c == '"') {
+			p->value_kind = PRV_PARSER_VALUE_STRING;
+			prv_parser_start_string(p, PRV_PARSER_IN_STRING);
+			return 0;
+		}
+		if (c == '-' || (c >= '0' && c <= '9') || c == 't' || c == 'f' || c == 'n') {
+			p->value_kind = PRV_PARSER_VALUE_TOKEN;
+			p->overflow = false;
+			p->state = PRV_PARSER_IN_TOKEN;
+			prv_parser_push(p, c);
+			return 0;
+		}
+		if ((c == '[' || c == '{') && !p->setting) {
+			/* The value of an unknown key can be any JSON value */
+			p->overflow = false;
+			prv_parser_start_skip(p, 1, false);
+			return 0;
+		}
+		if (c == '[') {
+			/* Arrays of bools and numbers, the values of array settings */
+			p->in_array = true;
+			p->overflow = false;
+			if (p->setting->type != USER_SETTINGS_TYPE_ARRAY) {
+				prv_parser_start_skip(p, 1, true);
+				return 0;
+			}
+			p->state = PRV_PARSER_ARRAY_ELEM_OR_END;
+			return 0;
+		}
+		if (c == '{') {
+			/* Objects of bools and numbers, the values of record settings */
+			p->in_record = true;
+			p->overflow = false;
+			if (p->setting->type != USER_SETTINGS_TYPE_RECORD) {
+				prv_parser_start_skip(p, 1, true);
+				return 0;
+			}
+			prv_parser_record_start(p);
+			p->state = PRV_PARSER_RECORD_FIELD_OR_END;
+			return 0;
+		}
+		return -EINVAL;
+	case PRV_PARSER_IN_STRING:
+		ret = prv_parser_string_char(p, c);
+		if (ret == 1) {
+			p->state = PRV_PARSER_COMMA_OR_END;
+			return prv_parser_apply(p);
+		}
+		return ret;
+	case PRV_PARSER_IN_TOKEN:
+		if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c == '-' || c == '+' ||
+		    c == '.' || c == 'E') {
+			prv_parser_push(p, c);
+			return 0;
+		}
+		ret = prv_parser_apply(p);
+		if (ret) {
+			return ret;
+		}
+		/* The character that ended the token still has to be handled */
+		p->state = PRV_PARSER_COMMA_OR_END;
+		return prv_parser_char(p, c);
+	case PRV_PARSER_ARRAY_ELEM_OR_END:
+		if (c == ']') {
+			p->state = PRV_PARSER_COMMA_OR_END;
+			return prv_parser_apply(p);
+		}
+		/* Fallthrough */
+	case PRV_PARSER_ARRAY_ELEM:
+		if (prv_is_space(c)) {
+			return 0;
+		}
+		if (c == '-' || (c >= '0' && c <= '9') || c == 't' || c == 'f' || c == 'n') {
+			p->value_kind = PRV_PARSER_VALUE_TOKEN;
+			p->state = PRV_PARSER_IN_ARRAY_TOKEN;
+			prv_parser_push(p, c);
+			return 0;
+		}
+		if (c == '"' || c == '[' || c == '{') {
+			/* Strings and nested structures are not array elements */
+			prv_parser_start_skip(p, 1, true);
+			return prv_parser_skip_char(p, c);
+		}
+		return -EINVAL;
+	case PRV_PARSER_IN_ARRAY_TOKEN:
+		if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c == '-' || c == '+' ||
+		    c == '.' || c == 'E') {
+			prv_parser_push(p, c);
+			return 0;
+		}
+		prv_parser_elem_done(p);
+		/* The character that ended the token still has to be handled */
+		p->state = PRV_PARSER_ARRAY_COMMA_OR_END;
+		return prv_parser_char(p, c);
+	case PRV_PARSER_ARRAY_COMMA_OR_END:
+		if (prv_is_space(c)) {
+			return 0;
+		}
+		if (c == ',') {
+			p->state = PRV_PARSER_ARRAY_ELEM;
+			return 0;
+		}
+		if (c == ']') {
+			p->state = PRV_PARSER_COMMA_OR_END;
+			return prv_parser_apply(p);
+		}
+		return -EINVAL;
+	case PRV_PARSER_RECORD_FIELD_OR_END:
+		if (c == '}') {
+			p->state = PRV_PARSER_COMMA_OR_END;
+			return prv_parser_apply(p);
+		}
+		/* Fallthrough */
+	case PRV_PARSER_RECORD_FIELD:
+		if (prv_is_space(c)) {
+			return 0;
+		}
+		if (c != '"') {
+			return -EINVAL;
+		}
+		/* Field names are scanned like values, overflow is kept for the whole record */
+		p->value_kind = PRV_PARSER_VALUE_STRING;
+		p->in_escape = false;
+		p->unicode_left = 0;
+		p->state = PRV_PARSER_IN_RECORD_FIELD;
+		return 0;
+	case PRV_PARSER_IN_RECORD_FIELD:
+		ret = prv_parser_string_char(p, c);
+		if (ret == 1) {
+			prv_parser_field_name_done(p);
+			p->state = PRV_PARSER_RECORD_COLON;
+			return 0;
+		}
+		return ret;
+	case PRV_PARSER_RECORD_COLON:
+		if (prv_is_space(c)) {
+			return 0;
+		}
+		if (c != ':') {
+			return -EINVAL;
+		}
+		p->state = PRV_PARSER_RECORD_VALUE;
+		return 0;
+	case PRV_PARSER_RECORD_VALUE:
+		if (prv_is_space(c)) {
+			return 0;
+		}
+		if (c == '-' || (c >= '0' && c <= '9') || c == 't' || c == 'f' || c == 'n') {
+			p->value_kind = PRV_PARSER_VALUE_TOKEN;
+			p->state = PRV_PARSER_IN_RECORD_TOKEN;
+			prv_parser_push(p, c);
+			return 0;
+		}
+		if (c == '"' || c == '[' || c == '{') {
+			/* Strings and nested structures are not record fields */
+			prv_parser_start_skip(p, 1, true);
+			return prv_parser_skip_char(p, c);
+		}
+		return -EINVAL;
+	case PRV_PARSER_IN_RECORD_TOKEN:
+		if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c == '-' || c == '+' ||
+		    c == '.' || c == 'E') {
+			prv_parser_push(p, c);
+			return 0;
+		}
+		prv_parser_field_done(p);
+		/* The character that ended the token still has to be handled */
+		p->state = PRV_PARSER_RECORD_COMMA_OR_END;
+		return prv_parser_char(p, c);
+	case PRV_PARSER_RECORD_COMMA_OR_END:
+		if (prv_is_space(c)) {
+			return 0;
+		}
+		if (c == ',') {
+			p->state = PRV_PARSER_RECORD_FIELD;
+			return 0;
+		}
+		if (c == '}') {
+			p->state = PRV_PARSER_COMMA_OR_END;
+			return prv_parser_apply(p);
+		}
+		return -EINVAL;
+	case PRV_PARSER_SKIP_VALUE:
+		return prv_parser_skip_char(p, c);
+	case PRV_PARSER_COMMA_OR_END:
+		if (prv_is_space(c)) {
+			return 0;
+		}
+		if (c == ',') {
+			p->state = PRV_PARSER_KEY;
+			return 0;
+		}
+		if (c == '}') {
+			p->state = PRV_PARSER_DONE;
+			return 0;
+		}
+		return -EINVAL;
+	case PRV_PARSER_DONE:
+		return prv_is_space(c) ? 0 : -EINVAL;
+	default:
+		__ASSERT(0, "Unknown parser state: %d", p->state);
+		return -EINVAL;
+	}
+}
+
+void user_settings_json_parser_init(struct user_settings_json_parser *parser,
+				    bool always_mark_changed)
+{
+	__ASSERT(parser, "parser must be provided");
+
+	memset(parser, 0, sizeof(*parser));
+	parser->state = PRV_PARSER_OBJECT_START;
+	parser->always_mark_changed = always_mark_changed;
+}
+
+int user_settings_json_parser_feed(struct user_settings_json_parser *parser, const char *data,
+				   size_t len)
+{
+	__ASSERT(parser, "parser must be provided");
+
+	if (parser->err) {
+		return parser->err;
+	}
+
+	for (size_t i = 0; i < len; i++) {
+		int err = prv_parser_char(parser, data[i]);
+		if (err) {
+			if (err == -EINVAL) {
+				LOG_ERR("Invalid json structure at character: %c", data[i]);
+			}
+			parser->err = err;
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+int user_settings_json_parser_finish(struct user_settings_json_parser *parser)
+{
+	__ASSERT(parser, "parser must be provided");
+
+	if (parser->err) {
+		return parser->err;
+	}
+
+	if (parser->state != PRV_PARSER_DONE) {
+		LOG_ERR("Incomplete json structure");
+		return -EINVAL;
+	}
+
+	return 0;
+}
@@ -18,9 +18,21 @@ K_HEAP_DEFINE(prv_heap, CONFIG_USER_SETTINGS_HEAP_SIZE);
 
 static sys_slist_t prv_user_settings_list;
 
+/* Settings with has_changed_recently set, linked through changed_node */
+static sys_slist_t prv_changed_list;
+
+/* Lazy settings whose value is in the cache, most recently used first */
+static struct user_setting *prv_lazy_cache[CONFIG_USER_SETTINGS_LAZY_CACHE_ENTRIES];
+static size_t prv_lazy_cache_count;
+
+/* Reads values of lazy settings from the storage backend */
+static user_settings_list_fetch_t prv_fetch_cb;
+
 void user_settings_list_init(void)
 {
 	sys_slist_init(&prv_user_settings_list);
+	sys_slist_init(&prv_changed_list);
+	prv_lazy_cache_count = 0;
 }
 
 /**
@@ -44,14 +56,20 @@ static int prv_type_to_size(enum user_setting_type type)
 	case USER_SETTINGS_TYPE_U32:
 	case USER_SETTINGS_TYPE_I32:
 		return 4;
+	case USER_SETTINGS_TYPE_F32:
+		return sizeof(float);
 	case USER_SETTINGS_TYPE_U64:
 	case USER_SETTINGS_TYPE_I64:
 		return 8;
+	case USER_SETTINGS_TYPE_F64:
+		return sizeof(double);
 	case USER_SETTINGS_TYPE_CRON_JOB:
 		// 8 characters + null terminator
 		return 9;
 	case USER_SETTINGS_TYPE_STR:
 	case USER_SETTINGS_TYPE_BYTES:
+	case USER_SETTINGS_TYPE_ARRAY:
+	case USER_SETTINGS_TYPE_RECORD:
 		__ASSERT(false,
 			 "String and bytes type should not be used when calling this function");
 	}
@@ -60,7 +78,8 @@ static int prv_type_to_size(enum user_setting_type type)
 }
 
 struct user_setting *prv_user_settings_list_add(uint16_t id, const char *key,
-						enum user_setting_type type, size_t size)
+						enum user_setting_type type, size_t size,
+						const void *default_data, size_t default_len)
 {
 	void *mem;
 
@@ -86,29 +105,40 @@ struct user_setting *prv_user_settings_list_add(uint16_t id, const char *key,
 	us->max_size = size;
 	us->is_set = false;
 	us->data_len = 0;
-	us->default_data_len = 0;
-	us->default_is_set = 0;
 	us->has_changed_recently = 0;
 	us->on_change_cb = NULL;
+	sys_slist_init(&us->subscribers);
 
-	/* allocate space for setting value */
-	mem = k_heap_aligned_alloc(&prv_heap, 8, size, K_NO_WAIT);
-	__ASSERT(mem,
-		 "Unable to allocate %d bytes for %s setting value. Consider "
-		 "Increasing CONFIG_USER_SETTINGS_HEAP_SIZE",
-		 size, key);
-	memset(mem, 0, size);
-	us->data = mem;
+	if (type == USER_SETTINGS_TYPE_CRON_JOB) {
+		us->cron = k_heap_aligned_alloc(&prv_heap, 8, sizeof(*us->cron), K_NO_WAIT);
+		__ASSERT(us->cron,
+			 "Unable to allocate the schedule of %s setting. Consider Increasing "
+			 "CONFIG_USER_SETTINGS_HEAP_SIZE",
+			 key);
+		memset(us->cron, 0, sizeof(*us->cron));
+		us->cron->heap_index = -1;
+	}
 
-	/* allocate space for setting default value */
-	mem = k_heap_aligned_alloc(&prv_heap, 8, size, K_NO_WAIT);
-	__ASSERT(mem,
-		 "Unable to allocate %d bytes for %s setting default value. Consider "
-		 "Increasing CONFIG_USER_SETTINGS_HEAP_SIZE",
-		 size, key);
-	memset(mem, 0, size);
+	/* space for the value is allocated when a value is stored */
+
+	if (default_data) {
+		/* compile-time default, space is only allocated if it is overridden */
+		__ASSERT(default_len <= size, "Default value of %s is too large", key);
+		us->default_data = default_data;
+		us->default_data_len = default_len;
+		us->default_is_set = true;
+	} else {
+		/* allocate space for setting default value */
+		mem = k_heap_aligned_alloc(&prv_heap, 8, size, K_NO_WAIT);
+		__ASSERT(mem,
+			 "Unable to allocate %d bytes for %s setting default value. Consider "
+			 "Increasing CONFIG_USER_SETTINGS_HEAP_SIZE",
+			 size, key);
+		memset(mem, 0, size);
 
-	us->default_data = mem;
+		us->default_buf = mem;
+		us->default_data = mem;
+	}
 
 	/* add new struct to linked list */
 	sys_slist_append(&prv_user_settings_list, &us->list_node);
@@ -119,7 +149,7 @@ struct user_setting *prv_user_settings_list_add(uint16_t id, const char *key,
 struct user_setting *user_settings_list_add_fixed_size(uint16_t id, const char *key,
 						       enum user_setting_type type)
 {
-	return prv_user_settings_list_add(id, key, type, prv_type_to_size(type));
+	return prv_user_settings_list_add(id, key, type, prv_type_to_size(type), NULL, 0);
 }
 
 struct user_setting *user_settings_list_add_variable_size(uint16_t id, const char *key,
@@ -128,7 +158,335 @@ struct user_setting *user_settings_list_add_variable_size(uint16_t id, const cha
 	__ASSERT(type == USER_SETTINGS_TYPE_STR || type == USER_SETTINGS_TYPE_BYTES,
 		 "This function only supports string and bytes types");
 
-	return prv_user_settings_list_add(id, key, type, size);
+	return prv_user_settings_list_add(id, key, type, size, NULL, 0);
+}
+
+struct user_setting *user_settings_list_add_fixed_size_with_default(uint16_t id, const char *key,
+								    enum user_setting_type type,
+								    const void *default_data,
+								    size_t default_len)
+{
+	__ASSERT(default_data, "Default value must not be NULL");
+
+	return prv_user_settings_list_add(id, key, type, prv_type_to_size(type), default_data,
+					  default_len);
+}
+
+struct user_setting *user_settings_list_add_variable_size_with_default(uint16_t id, const char *key,
+								       enum user_setting_type type,
+								       size_t size,
+								       const void *default_data,
+								       size_t default_len)
+{
+	__ASSERT(type == USER_SETTINGS_TYPE_STR || type == USER_SETTINGS_TYPE_BYTES,
+		 "This function only supports string and bytes types");
+	__ASSERT(default_data, "Default value must not be NULL");
+
+	return prv_user_settings_list_add(id, key, type, size, default_data, default_len);
+}
+
+struct user_setting *user_settings_list_add_array(uint16_t id, const char *key,
+						  enum user_setting_type elem_type, size_t count,
+						  const void *default_data, size_t default_len)
+{
+	__ASSERT(elem_type <= USER_SETTINGS_TYPE_I64 || elem_type == USER_SETTINGS_TYPE_F32 ||
+			 elem_type == USER_SETTINGS_TYPE_F64,
+		 "Array elements must be of a numeric or bool type");
+	__ASSERT(count > 0, "Array %s must have at least one element", key);
+
+	size_t size = prv_type_to_size(elem_type) * count;
+	__ASSERT(size <= UINT8_MAX, "Array %s is larger than 255 bytes", key);
+	__ASSERT(!default_data || default_len == size, "Default value of %s must hold all elements",
+		 key);
+
+	struct user_setting *us = prv_user_settings_list_add(id, key, USER_SETTINGS_TYPE_ARRAY, size,
+							     default_data, default_len);
+	us->elem_type = elem_type;
+
+	return us;
+}
+
+size_t user_settings_list_array_elem_size(const struct user_setting *us)
+{
+	__ASSERT(us->type == USER_SETTINGS_TYPE_ARRAY, "%s is not an array setting", us->key);
+
+	return prv_type_to_size(us->elem_type);
+}
+
+struct user_setting *user_settings_list_add_record(uint16_t id, const char *key,
+						   const struct user_settings_record_field *fields,
+						   size_t num_fields, size_t size,
+						   const void *default_data, size_t default_len)
+{
+	__ASSERT(fields && num_fields > 0, "Record %s must have at least one field", key);
+	__ASSERT(size <= UINT8_MAX, "Record %s is larger than 255 bytes", key);
+
+	for (size_t i = 0; i < num_fields; i++) {
+		__ASSERT(fields[i].type <= USER_SETTINGS_TYPE_I64 ||
+				 fields[i].type == USER_SETTINGS_TYPE_F32 ||
+				 fields[i].type == USER_SETTINGS_TYPE_F64,
+			 "Record fields must be of a numeric or bool type");
+		__ASSERT(fields[i].offset + prv_type_to_size(fields[i].type) <= size,
+			 "Field %s does not fit into record %s", fields[i].name, key);
+	}
+
+	__ASSERT(!default_data || default_len == size, "Default value of %s must hold all fields",
+		 key);
+
+	struct user_setting *us = prv_user_settings_list_add(id, key, USER_SETTINGS_TYPE_RECORD,
+							     size, default_data, default_len);
+	us->fields = fields;
+	us->num_fields = num_fields;
+
+	return us;
+}
+
+const struct user_settings_record_field *
+user_settings_list_record_field_get(const struct user_setting *us, const char *name)
+{
+	__ASSERT(us->type == USER_SETTINGS_TYPE_RECORD, "%s is not a record setting", us->key);
+
+	for (size_t i = 0; i < us->num_fields; i++) {
+		if (strcmp(us->fields[i].name, name) == 0) {
+			return &us->fields[i];
+		}
+	}
+
+	return NULL;
+}
+
+size_t user_settings_list_record_field_size(const struct user_settings_record_field *field)
+{
+	return prv_type_to_size(field->type);
+}
+
+int user_settings_list_default_buf_alloc(struct user_setting *us)
+{
+	if (us->default_buf) {
+		return 0;
+	}
+
+	us->default_buf = k_heap_aligned_alloc(&prv_heap, 8, us->max_size, K_NO_WAIT);
+	if (!us->default_buf) {
+		LOG_ERR("Unable to allocate %d bytes for %s setting default value. Consider "
+			"Increasing CONFIG_USER_SETTINGS_HEAP_SIZE",
+			us->max_size, us->key);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+int user_settings_list_constraints_alloc(struct user_setting *us)
+{
+	if (us->constraints) {
+		return 0;
+	}
+
+	us->constraints = k_heap_aligned_alloc(&prv_heap, 8, sizeof(*us->constraints), K_NO_WAIT);
+	if (!us->constraints) {
+		LOG_ERR("Unable to allocate constraints of %s setting. Consider "
+			"Increasing CONFIG_USER_SETTINGS_HEAP_SIZE",
+			us->key);
+		return -ENOMEM;
+	}
+
+	memset(us->constraints, 0, sizeof(*us->constraints));
+	return 0;
+}
+
+int user_settings_list_data_alloc(struct user_setting *us)
+{
+	if (us->data) {
+		return 0;
+	}
+
+	us->data = k_heap_aligned_alloc(&prv_heap, 8, us->max_size, K_NO_WAIT);
+	if (!us->data) {
+		LOG_ERR("Unable to allocate %d bytes for %s setting value. Consider "
+			"Increasing CONFIG_USER_SETTINGS_HEAP_SIZE",
+			us->max_size, us->key);
+		return -ENOMEM;
+	}
+
+	if (us->value_is_default) {
+		memcpy(us->data, us->default_data, us->data_len);
+		us->value_is_default = false;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Remove a setting from the lazy cache, if it is in it
+ */
+static void prv_lazy_cache_remove(struct user_setting *us)
+{
+	for (size_t i = 0; i < prv_lazy_cache_count; i++) {
+		if (prv_lazy_cache[i] == us) {
+			memmove(&prv_lazy_cache[i], &prv_lazy_cache[i + 1],
+				(prv_lazy_cache_count - i - 1) * sizeof(prv_lazy_cache[0]));
+			prv_lazy_cache_count--;
+			return;
+		}
+	}
+}
+
+/**
+ * @brief Add a setting to the lazy cache as the most recently used one
+ */
+static void prv_lazy_cache_push(struct user_setting *us)
+{
+	memmove(&prv_lazy_cache[1], &prv_lazy_cache[0],
+		prv_lazy_cache_count * sizeof(prv_lazy_cache[0]));
+	prv_lazy_cache[0] = us;
+	prv_lazy_cache_count++;
+}
+
+/**
+ * @brief Fetch the value of a lazy setting into the cache
+ *
+ * @retval 0 on success
+ * @retval -ENOMEM if there is no space for the value
+ * @retval Other negative errno code returned by the fetch function
+ */
+static int prv_lazy_fetch(struct user_setting *us)
+{
+	__ASSERT(prv_fetch_cb, "No fetch function set for lazy settings");
+
+	if (prv_lazy_cache_count == ARRAY_SIZE(prv_lazy_cache)) {
+		user_settings_list_lazy_drop(prv_lazy_cache[prv_lazy_cache_count - 1]);
+	}
+
+	/* only as large as the current value, the cached value is dropped when it changes */
+	us->data = k_heap_aligned_alloc(&prv_heap, 8, MAX(us->data_len, 1), K_NO_WAIT);
+	if (!us->data) {
+		LOG_ERR("Unable to allocate %d bytes to fetch %s. Consider "
+			"Increasing CONFIG_USER_SETTINGS_HEAP_SIZE",
+			us->data_len, us->key);
+		return -ENOMEM;
+	}
+
+	int err = prv_fetch_cb(us, us->data);
+	if (err) {
+		k_heap_free(&prv_heap, us->data);
+		us->data = NULL;
+		return err;
+	}
+
+	prv_lazy_cache_push(us);
+
+	return 0;
+}
+
+void user_settings_list_data_free(struct user_setting *us)
+{
+	__ASSERT(!us->is_set, "Value of %s is still set", us->key);
+
+	prv_lazy_cache_remove(us);
+	k_heap_free(&prv_heap, us->data);
+	us->data = NULL;
+	us->value_is_default = false;
+}
+
+void user_settings_list_data_use_default(struct user_setting *us)
+{
+	__ASSERT(us->is_set && us->default_is_set && us->data_len == us->default_data_len,
+		 "Value of %s can not use the default value", us->key);
+
+	prv_lazy_cache_remove(us);
+	k_heap_free(&prv_heap, us->data);
+	us->data = NULL;
+	us->value_is_default = true;
+}
+
+int user_settings_list_data_pin(struct user_setting *us)
+{
+	if (!us->value_is_default) {
+		return 0;
+	}
+
+	if (us->is_lazy) {
+		/* the value is still stored, it is fetched from there again */
+		us->value_is_default = false;
+		return 0;
+	}
+
+	return user_settings_list_data_alloc(us);
+}
+
+void user_settings_list_set_fetch_cb(user_settings_list_fetch_t fetch)
+{
+	prv_fetch_cb = fetch;
+}
+
+const void *user_settings_list_data_get(struct user_setting *us, size_t *len)
+{
+	if (!us->is_set) {
+		return NULL;
+	}
+
+	if (us->value_is_default) {
+		if (len) {
+			*len = us->default_data_len;
+		}
+		return us->default_data;
+	}
+
+	if (us->is_lazy) {
+		if (us->data) {
+			/* cache hit, make it the most recently used one */
+			prv_lazy_cache_remove(us);
+			prv_lazy_cache_push(us);
+		} else if (prv_lazy_fetch(us)) {
+			return NULL;
+		}
+	}
+
+	if (len) {
+		*len = us->data_len;
+	}
+	return us->data;
+}
+
+void user_settings_list_lazy_drop(struct user_setting *us)
+{
+	prv_lazy_cache_remove(us);
+	k_heap_free(&prv_heap, us->data);
+	us->data = NULL;
+	us->value_is_default = false;
+}
+
+void *user_settings_list_buf_alloc(size_t size)
+{
+	void *buf = k_heap_aligned_alloc(&prv_heap, 8, size, K_NO_WAIT);
+	if (!buf) {
+		LOG_ERR("Unable to allocate %d bytes. Consider increasing "
+			"CONFIG_USER_SETTINGS_HEAP_SIZE",
+			size);
+	}
+	return buf;
+}
+
+void user_settings_list_buf_free(void *buf)
+{
+	k_heap_free(&prv_heap, buf);
+}
+
+const void *user_settings_list_value_get(struct user_setting *us, size_t *len)
+{
+	if (us->is_set) {
+		return user_settings_list_data_get(us, len);
+	}
+
+	if (us->default_is_set) {
+		if (len) {
+			*len = us->default_data_len;
+		}
+		return us->default_data;
+	}
+
+	return NULL;
 }
 
 struct user_setting *user_settings_list_get_by_key(const char *key)
@@ -175,14 +533,80 @@ struct user_setting *user_settings_list_iter_next(void)
 	return SYS_SLIST_CONTAINER(prv_iter_list_node, us, list_node);
 }
 
+struct user_setting *user_settings_list_next(struct user_setting *us)
+{
+	sys_snode_t *node = us ? sys_slist_peek_next(&us->list_node)
+			       : sys_slist_peek_head(&prv_user_settings_list);
+
+	struct user_setting *next = NULL;
+	return SYS_SLIST_CONTAINER(node, next, list_node);
+}
+
+/* The node user_settings_list_changed_iter_next() returns next. It is fetched before the current
+ * item is returned, so the flag of the current item can be cleared during iteration. */
+static sys_snode_t *prv_changed_iter_node = NULL;
+static bool changed_iter_start = false;
+
+void user_settings_list_changed_update(struct user_setting *us)
+{
+	if (us->has_changed_recently) {
+		sys_slist_append(&prv_changed_list, &us->changed_node);
+	} else {
+		/* keep an iteration in progress on the list */
+		if (prv_changed_iter_node == &us->changed_node) {
+			prv_changed_iter_node = sys_slist_peek_next(prv_changed_iter_node);
+		}
+		sys_slist_find_and_remove(&prv_changed_list, &us->changed_node);
+	}
+}
+
+void user_settings_list_changed_iter_start(void)
+{
+	changed_iter_start = true;
+	prv_changed_iter_node = NULL;
+}
+
+struct user_setting *user_settings_list_changed_iter_next(void)
+{
+	if (changed_iter_start) {
+		prv_changed_iter_node = sys_slist_peek_head(&prv_changed_list);
+		changed_iter_start = false;
+	}
+
+	sys_snode_t *node = prv_changed_iter_node;
+	if (node) {
+		prv_changed_iter_node = sys_slist_peek_next(node);
+	}
+
+	struct user_setting *us = NULL;
+	return SYS_SLIST_CONTAINER(node, us, changed_node);
+}
+
+struct user_setting *user_settings_list_changed_next(struct user_setting *us)
+{
+	sys_snode_t *node = us ? sys_slist_peek_next(&us->changed_node)
+			       : sys_slist_peek_head(&prv_changed_list);
+
+	struct user_setting *next = NULL;
+	return SYS_SLIST_CONTAINER(node, next, changed_node);
+}
+
+struct user_setting *user_settings_list_changed_peek(void)
+{
+	struct user_setting *us = NULL;
+	return SYS_SLIST_PEEK_HEAD_CONTAINER(&prv_changed_list, us, changed_node);
+}
+
 void user_settings_list_free(void)
 {
-	/* free data, default_data, setting struct, remove from list */
+	/* free data, default_buf, setting struct, remove from list */
 
 	struct user_setting *us;
 	SYS_SLIST_FOR_EACH_CONTAINER(&prv_user_settings_list, us, list_node) {
 		k_heap_free(&prv_heap, us->data);
-		k_heap_free(&prv_heap, us->default_data);
+		k_heap_free(&prv_heap, us->default_buf);
+		k_heap_free(&prv_heap, us->constraints);
+		k_heap_free(&prv_heap, us->cron);
 		k_heap_free(&prv_heap, us);
 	}
 
@@ -14,8 +14,56 @@ extern "C" {
 #endif
 
 #include <zephyr/kernel.h>
+#include <user_settings_cron.h>
 #include <user_settings_types.h>
 
+/**
+ * @brief Constraints of the values of a setting
+ *
+ * Allocated from the user settings heap when the first constraint of a setting is set.
+ */
+struct user_setting_constraints {
+	/** Set if min, max and step apply */
+	bool has_range;
+
+	/** Smallest allowed value. Compared as unsigned for the unsigned types. */
+	int64_t min;
+
+	/** Largest allowed value. Compared as unsigned for the unsigned types. */
+	int64_t max;
+
+	/** Allowed values are min + n * step. 0 allows every value in the range. */
+	uint64_t step;
+
+	/** The allowed values, owned by the application. NULL if any value is allowed. */
+	const int64_t *enum_values;
+
+	/** Number of values in enum_values */
+	size_t num_enum_values;
+
+	/** Validator callback. Can be NULL. */
+	user_settings_validator_t validator;
+};
+
+/**
+ * @brief Schedule of a cron job setting
+ *
+ * Allocated from the user settings heap when a cron job setting is added.
+ */
+struct user_setting_cron {
+	/** The parsed value, or default if no value is set. Only valid if is_valid is set. */
+	struct user_settings_cron schedule;
+
+	/** Set if the setting has a value or default that parsed */
+	bool is_valid;
+
+	/** Next fire time. Only valid while the setting is in the heap. */
+	int64_t next;
+
+	/** Position of the setting in the heap of next fire times, -1 if it is not in the heap */
+	int16_t heap_index;
+};
+
 /**
  * @brief Internal representation of a user_setting.
  *
@@ -41,15 +89,31 @@ struct user_setting {
 	/** Its type */
 	enum user_setting_type type;
 
+	/** Type of the elements of an array setting. Unused for the other types. */
+	enum user_setting_type elem_type;
+
+	/** The fields of a record setting, owned by the application. NULL for the other types. */
+	const struct user_settings_record_field *fields;
+
+	/** Number of entries in fields */
+	size_t num_fields;
+
 	/** Maximum size in bytes. This is fixed for the numeric types and user
 	 * specified for the string and bytes type. This should never be decreased in consecutive
 	 * firmware releases. */
 	size_t max_size;
 
-	/** Space for the setting is dynamically allocated during initialization
-	 * and the pointer is stored here */
+	/** Space for the setting value. It is allocated when a value is first stored and freed
+	 * when the value is deleted, so settings that keep their default value use no space for
+	 * a value. NULL while no space is allocated. Only valid to read while is_set is true.
+	 * For lazy settings, this is only allocated while the value is in the cache, use
+	 * user_settings_list_data_get() to read it. */
 	void *data;
 
+	/** Set while the value is the same as the default value and its space is freed, see
+	 * user_settings_list_data_use_default(). */
+	bool value_is_default;
+
 	/** The length (in bytes) of the data in use. This is always <= max_size */
 	size_t data_len;
 
@@ -57,9 +121,14 @@ struct user_setting {
 	 * Is false if no value for this setting is available */
 	bool is_set;
 
-	/** Space for the setting default value is dynamically allocated during initialization
-	 * and the pointer is stored here. */
-	void *default_data;
+	/** The default value. Points to default_buf, or to a compile-time default (in rodata) given
+	 * when the setting was added. Must never be written through. */
+	const void *default_data;
+
+	/** Space for a default value that is set at runtime or loaded from NVS. It is allocated
+	 * during initialization, unless the setting has a compile-time default, in which case it is
+	 * only allocated once the default is overridden. */
+	void *default_buf;
 
 	/** The length (in bytes) of the default data. This is always <= max_size */
 	size_t default_data_len;
@@ -70,9 +139,47 @@ struct user_setting {
 	/* This is set to true when setting data is changed. It is reset by calling ...TODO*/
 	bool has_changed_recently;
 
+	/** Lazy settings are not read at load. Their value is fetched from the storage backend
+	 * when it is needed and kept in a small cache. */
+	bool is_lazy;
+
+	/** Set if the on change callbacks were deferred while the setting changed. They are
+	 * called when the deferred callbacks are flushed. */
+	bool notify_pending;
+
+	/** Set while the on change callbacks of the setting wait in the work queue, with
+	 * CONFIG_USER_SETTINGS_NOTIFY_ASYNC. */
+	bool notify_queued;
+
+	/** Set while notify_queued is set but the setting did not fit into the queue, with
+	 * CONFIG_USER_SETTINGS_NOTIFY_ASYNC. */
+	bool notify_overflow;
+
+	/** Used for storing the setting in the list of changed settings while
+	 * has_changed_recently is set. This keeps enumerating changed settings O(changed). */
+	sys_snode_t changed_node;
+
 	/** On change callback for this specific setting. Can be NULL. This will be called
 	 * by the settings module when this setting is updated. */
 	user_settings_on_change_t on_change_cb;
+
+	/** Subscriptions to this specific setting (struct user_settings_subscription). */
+	sys_slist_t subscribers;
+
+	/** Constraints of the values of this setting. NULL if any value is allowed. */
+	struct user_setting_constraints *constraints;
+
+	/** Schedule of a cron job setting. NULL for the other types. */
+	struct user_setting_cron *cron;
+
+#if defined(CONFIG_USER_SETTINGS_WEAR_STATS)
+	/** Flash write counters of this setting. */
+	struct user_settings_wear_stats wear;
+
+	/** Set if the counters changed since they were last stored, with
+	 * CONFIG_USER_SETTINGS_WEAR_STATS_PERSIST. */
+	bool wear_dirty;
+#endif
 };
 
 /**
@@ -87,8 +194,8 @@ void user_settings_list_init(void);
 /**
  * @brief Add a new user_setting to the list with known size
  *
- * This will allocate the required number of bytes of space for the data and default_data
- * pointers in the returned struct user_setting.
+ * This will allocate the required number of bytes of space for the default_data pointer in the
+ * returned struct user_setting. Space for the value is allocated once a value is stored.
  * The size required is inferred from the type.
  *
  * This will assert if
@@ -111,8 +218,8 @@ struct user_setting *user_settings_list_add_fixed_size(uint16_t id, const char *
 /**
  * @brief Add a new user_setting to the list with known size
  *
- * This will allocate @p size bytes of space for the data and default_data
- * pointers in the returned struct user_setting.
+ * This will allocate @p size bytes of space for the default_data pointer in the returned struct
+ * user_setting. Space for the value is allocated once a value is stored.
  *
  * @note This will assert if:
  *  - if the type is not string or bytes
@@ -129,6 +236,262 @@ struct user_setting *user_settings_list_add_fixed_size(uint16_t id, const char *
 struct user_setting *user_settings_list_add_variable_size(uint16_t id, const char *key,
 							  enum user_setting_type type, size_t size);
 
+/**
+ * @brief Add a new user_setting with a compile-time default to the list with known size
+ *
+ * Same as user_settings_list_add_fixed_size(), but the default_data pointer of the returned
+ * struct user_setting points to @p default_data and no space is allocated for the default value.
+ *
+ * @param[in] id The ID of the setting to add
+ * @param[in] key The key of the setting to add
+ * @param[in] type The type of the setting
+ * @param[in] default_data The default value. Must live for the lifetime of the program
+ * @param[in] default_len The length of the default value (in bytes)
+ *
+ * @return struct user_setting* The newly created setting
+ */
+struct user_setting *user_settings_list_add_fixed_size_with_default(uint16_t id, const char *key,
+								    enum user_setting_type type,
+								    const void *default_data,
+								    size_t default_len);
+
+/**
+ * @brief Add a new user_setting with a compile-time default to the list with variable size
+ *
+ * Same as user_settings_list_add_variable_size(), but the default_data pointer of the returned
+ * struct user_setting points to @p default_data and no space is allocated for the default value.
+ *
+ * @param[in] id The ID of the setting to add
+ * @param[in] key The key of the setting to add
+ * @param[in] type The type of the setting
+ * @param[in] size The size of the setting (in bytes)
+ * @param[in] default_data The default value. Must live for the lifetime of the program
+ * @param[in] default_len The length of the default value (in bytes)
+ *
+ * @return struct user_setting* The newly created setting
+ */
+struct user_setting *user_settings_list_add_variable_size_with_default(uint16_t id, const char *key,
+								       enum user_setting_type type,
+								       size_t size,
+								       const void *default_data,
+								       size_t default_len);
+
+/**
+ * @brief Add a new array user_setting to the list
+ *
+ * The maximum size of the setting is @p count times the size of @p elem_type. Arrays are always
+ * stored whole, so a value always holds all elements.
+ *
+ * @note This will assert if:
+ *  - @p elem_type is not a numeric or bool type
+ *  - the array is larger than 255 bytes
+ *  - a setting with the same ID is already in the list
+ *  - a setting with the same key is already in the list
+ *
+ * @param[in] id The ID of the setting to add
+ * @param[in] key The key of the setting to add
+ * @param[in] elem_type The type of the elements
+ * @param[in] count The number of elements
+ * @param[in] default_data The compile-time default value, NULL if none. Must live for the
+ * lifetime of the program
+ * @param[in] default_len The length of the default value (in bytes)
+ *
+ * @return struct user_setting* The newly created setting
+ */
+struct user_setting *user_settings_list_add_array(uint16_t id, const char *key,
+						  enum user_setting_type elem_type, size_t count,
+						  const void *default_data, size_t default_len);
+
+/**
+ * @brief Get the size of one element of an array setting
+ *
+ * @param[in] us The array setting
+ *
+ * @return size_t The size of an element (in bytes)
+ */
+size_t user_settings_list_array_elem_size(const struct user_setting *us);
+
+/**
+ * @brief Add a new record user_setting to the list
+ *
+ * Records are always stored whole, so a value always holds all @p size bytes.
+ *
+ * @note This will assert if:
+ *  - a field is not of a numeric or bool type or does not fit into @p size
+ *  - @p size is larger than 255 bytes
+ *  - a setting with the same ID is already in the list
+ *  - a setting with the same key is already in the list
+ *
+ * @param[in] id The ID of the setting to add
+ * @param[in] key The key of the setting to add
+ * @param[in] fields The fields of the record. Must live for the lifetime of the program
+ * @param[in] num_fields The number of fields
+ * @param[in] size The size of the record (in bytes)
+ * @param[in] default_data The compile-time default value, NULL if none. Must live for the
+ * lifetime of the program
+ * @param[in] default_len The length of the default value (in bytes)
+ *
+ * @return struct user_setting* The newly created setting
+ */
+struct user_setting *user_settings_list_add_record(uint16_t id, const char *key,
+						   const struct user_settings_record_field *fields,
+						   size_t num_fields, size_t size,
+						   const void *default_data, size_t default_len);
+
+/**
+ * @brief Find a field of a record setting by its name
+ *
+ * @param[in] us The record setting
+ * @param[in] name The name of the field
+ *
+ * @return The field, NULL if the record has no field with this name
+ */
+const struct user_settings_record_field *
+user_settings_list_record_field_get(const struct user_setting *us, const char *name);
+
+/**
+ * @brief Get the size of a field of a record setting
+ *
+ * @param[in] field The field
+ *
+ * @return size_t The size of the field (in bytes)
+ */
+size_t user_settings_list_record_field_size(const struct user_settings_record_field *field);
+
+/**
+ * @brief Make sure the default_buf of a setting is allocated
+ *
+ * @param[in] us The setting
+ *
+ * @retval 0 on success
+ * @retval -ENOMEM if CONFIG_USER_SETTINGS_HEAP_SIZE is too small
+ */
+int user_settings_list_default_buf_alloc(struct user_setting *us);
+
+/**
+ * @brief Make sure the constraints of a setting are allocated
+ *
+ * Newly allocated constraints allow any value.
+ *
+ * @param[in] us The setting
+ *
+ * @retval 0 on success
+ * @retval -ENOMEM if CONFIG_USER_SETTINGS_HEAP_SIZE is too small
+ */
+int user_settings_list_constraints_alloc(struct user_setting *us);
+
+/**
+ * @brief Make sure the data buffer of a setting is allocated
+ *
+ * If the value uses the default value, the default value is copied into the new buffer.
+ *
+ * @param[in] us The setting
+ *
+ * @retval 0 on success
+ * @retval -ENOMEM if CONFIG_USER_SETTINGS_HEAP_SIZE is too small
+ */
+int user_settings_list_data_alloc(struct user_setting *us);
+
+/**
+ * @brief Free the data buffer of a setting whose value is the same as its default value
+ *
+ * The setting stays set, and user_settings_list_data_get() returns the default value until a
+ * new value is stored. Call user_settings_list_data_pin() before the default value changes.
+ *
+ * @param[in] us The setting
+ */
+void user_settings_list_data_use_default(struct user_setting *us);
+
+/**
+ * @brief Give the value of a setting its own space again if it uses the default value
+ *
+ * Must be called before the default value of a setting changes.
+ *
+ * @param[in] us The setting
+ *
+ * @retval 0 on success
+ * @retval -ENOMEM if CONFIG_USER_SETTINGS_HEAP_SIZE is too small
+ */
+int user_settings_list_data_pin(struct user_setting *us);
+
+/**
+ * @brief Free the data buffer of a setting
+ *
+ * The setting must not be set anymore.
+ *
+ * @param[in] us The setting
+ */
+void user_settings_list_data_free(struct user_setting *us);
+
+/**
+ * @brief Reads the value of a lazy setting from the storage backend
+ *
+ * @param[in] us The setting
+ * @param[out] buf The buffer to read into, at least us->data_len bytes long
+ *
+ * @retval 0 on success
+ * @retval Negative errno code if the value could not be read
+ */
+typedef int (*user_settings_list_fetch_t)(struct user_setting *us, void *buf);
+
+/**
+ * @brief Set the function that reads values of lazy settings
+ *
+ * @param[in] fetch The function
+ */
+void user_settings_list_set_fetch_cb(user_settings_list_fetch_t fetch);
+
+/**
+ * @brief Get the value of a setting
+ *
+ * The value of a lazy setting is fetched into the cache if it is not there yet. The least
+ * recently used value is dropped from the cache if it is full. The returned pointer is valid
+ * until the next value is fetched or the value changes.
+ *
+ * @param[in] us The setting
+ * @param[out] len The length of the value. Can be NULL
+ *
+ * @return The value. NULL if the value is not set or could not be fetched
+ */
+const void *user_settings_list_data_get(struct user_setting *us, size_t *len);
+
+/**
+ * @brief Drop the value of a lazy setting from the cache
+ *
+ * Must be called when the stored value of a lazy setting changes. The value no longer uses the
+ * default value.
+ *
+ * @param[in] us The setting
+ */
+void user_settings_list_lazy_drop(struct user_setting *us);
+
+/**
+ * @brief Allocate a temporary buffer from the user settings heap
+ *
+ * @param[in] size The size of the buffer (in bytes)
+ *
+ * @return The buffer or NULL if CONFIG_USER_SETTINGS_HEAP_SIZE is too small
+ */
+void *user_settings_list_buf_alloc(size_t size);
+
+/**
+ * @brief Free a buffer allocated with user_settings_list_buf_alloc()
+ *
+ * @param[in] buf The buffer. Can be NULL.
+ */
+void user_settings_list_buf_free(void *buf);
+
+/**
+ * @brief Get the current value of a setting
+ *
+ * @param[in] us The setting
+ * @param[out] len The length of the value. Can be NULL
+ *
+ * @return The value if it is set, else the default value. NULL if neither is set or the value
+ * could not be fetched
+ */
+const void *user_settings_list_value_get(struct user_setting *us, size_t *len);
+
 /**
  * @brief Free all items in the list
  *
@@ -150,6 +513,62 @@ void user_settings_list_iter_start(void);
  */
 struct user_setting *user_settings_list_iter_next(void);
 
+/**
+ * @brief Get the item after @p us in the list
+ *
+ * Unlike user_settings_list_iter_next(), this keeps no state, so iteration with it is not
+ * disturbed by other code iterating the list at the same time.
+ *
+ * @param[in] us The current item. NULL to get the first item.
+ *
+ * @return struct user_setting* The next item in the list. NULL after the last item
+ */
+struct user_setting *user_settings_list_next(struct user_setting *us);
+
+/**
+ * @brief Update the membership of an item in the list of changed items
+ *
+ * Must be called every time has_changed_recently of an item in the list changes value.
+ *
+ * @param[in] us The item whose has_changed_recently flag changed
+ */
+void user_settings_list_changed_update(struct user_setting *us);
+
+/**
+ * @brief Start iteration over the items with has_changed_recently set
+ *
+ * Items are returned in the order in which they were marked changed.
+ */
+void user_settings_list_changed_iter_start(void);
+
+/**
+ * @brief Get the next item with has_changed_recently set
+ *
+ * Will return NULL after all changed items have been returned. Clearing the flag of any item
+ * during the iteration is safe, items whose flag is cleared before they are reached are skipped.
+ *
+ * @return struct user_setting* The next changed item
+ */
+struct user_setting *user_settings_list_changed_iter_next(void);
+
+/**
+ * @brief Get the item after @p us in the list of changed items
+ *
+ * Like user_settings_list_next(), this keeps no state. The flag of @p us must still be set.
+ *
+ * @param[in] us The current item. NULL to get the first changed item.
+ *
+ * @return struct user_setting* The next changed item. NULL after the last one
+ */
+struct user_setting *user_settings_list_changed_next(struct user_setting *us);
+
+/**
+ * @brief Get the first item with has_changed_recently set
+ *
+ * @return struct user_setting* The first changed item. NULL if no item is changed
+ */
+struct user_setting *user_settings_list_changed_peek(void);
+
 /**
  * @brief Get item in list by key
  *
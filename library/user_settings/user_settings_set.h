@@ -0,0 +1,36 @@
+/** @file user_settings_set.h
+ *
+ * @brief Internal interface for modules of the library that already found a setting
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2023 Irnas.  All rights reserved.
+ */
+
+#ifndef USER_SETTINGS_SET_H
+#define USER_SETTINGS_SET_H
+
+#include "user_settings_list.h"
+
+/**
+ * @brief Set the value of a setting
+ *
+ * Same as user_settings_set_with_key(), without looking the setting up again.
+ *
+ * @param[in] us The setting
+ * @param[in] data The new value
+ * @param[in] len The length of the new value
+ *
+ * @retval See user_settings_set_with_key()
+ */
+int user_settings_set_setting(struct user_setting *us, const void *data, size_t len);
+
+/**
+ * @brief Mark a setting changed
+ *
+ * Same as user_settings_set_changed_with_key(), without looking the setting up again.
+ *
+ * @param[in] us The setting
+ */
+void user_settings_set_changed_setting(struct user_setting *us);
+
+#endif /* USER_SETTINGS_SET_H */
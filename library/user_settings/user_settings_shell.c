@@ -10,6 +10,7 @@
 #include "user_settings_list.h"
 
 #include <user_settings.h>
+#include <user_settings_stats.h>
 
 #include <zephyr/shell/shell.h>
 #include <zephyr/sys/util.h>
@@ -18,19 +19,25 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(CONFIG_USER_SETTINGS_PROTOCOL_BINARY) && defined(CONFIG_USER_SETTINGS_PROTOCOL_EXECUTOR)
+#define PRV_SHELL_EXEC 1
+#include <user_settings_protocol_binary.h>
+#include <user_settings_protocol_executor.h>
+#endif
+
 #define FMT_SETTING(fmt)                     "id: %d, key: \"%s\", value: " fmt ", default: " fmt
 #define FMT_SETTING_NO_VALUE(fmt)            "id: %d, key: \"%s\", value: /, default: " fmt
 #define FMT_SETTING_NO_DEFAULT(fmt)          "id: %d, key: \"%s\", value: " fmt ", default: /"
 #define FMT_SETTING_NO_VALUE_NO_DEFAULT(fmt) "id: %d, key: \"%s\", value: /, default: /"
 
-#define SETTING_PRINT(setting, fmt, cast)                                                          \
+#define SETTING_PRINT(setting, value, fmt, cast)                                                   \
 	do {                                                                                       \
 		if (setting->is_set && setting->default_is_set) {                                  \
 			shell_print(shell_ptr, FMT_SETTING(fmt), setting->id, setting->key,        \
-				    cast setting->data, cast setting->default_data);               \
+				    cast value, cast setting->default_data);                       \
 		} else if (setting->is_set && !setting->default_is_set) {                          \
 			shell_print(shell_ptr, FMT_SETTING_NO_DEFAULT(fmt), setting->id,           \
-				    setting->key, cast setting->data);                             \
+				    setting->key, cast value);                                     \
 		} else if (!setting->is_set && setting->default_is_set) {                          \
 			shell_print(shell_ptr, FMT_SETTING_NO_VALUE(fmt), setting->id,             \
 				    setting->key, cast setting->default_data);                     \
@@ -40,6 +47,92 @@
 		}                                                                                  \
 	} while (0);
 
+/**
+ * @brief Print an element of an array or a field of a record
+ */
+static void prv_shell_print_elem(const struct shell *shell_ptr, enum user_setting_type type,
+				 const void *elem)
+{
+	switch (type) {
+	case USER_SETTINGS_TYPE_BOOL:
+		shell_fprintf(shell_ptr, SHELL_NORMAL, "%d", *(bool *)elem);
+		break;
+	case USER_SETTINGS_TYPE_U8:
+		shell_fprintf(shell_ptr, SHELL_NORMAL, "%u", *(uint8_t *)elem);
+		break;
+	case USER_SETTINGS_TYPE_I8:
+		shell_fprintf(shell_ptr, SHELL_NORMAL, "%d", *(int8_t *)elem);
+		break;
+	case USER_SETTINGS_TYPE_U16:
+		shell_fprintf(shell_ptr, SHELL_NORMAL, "%u", *(uint16_t *)elem);
+		break;
+	case USER_SETTINGS_TYPE_I16:
+		shell_fprintf(shell_ptr, SHELL_NORMAL, "%d", *(int16_t *)elem);
+		break;
+	case USER_SETTINGS_TYPE_U32:
+		shell_fprintf(shell_ptr, SHELL_NORMAL, "%u", *(uint32_t *)elem);
+		break;
+	case USER_SETTINGS_TYPE_I32:
+		shell_fprintf(shell_ptr, SHELL_NORMAL, "%d", *(int32_t *)elem);
+		break;
+	case USER_SETTINGS_TYPE_U64:
+		shell_fprintf(shell_ptr, SHELL_NORMAL, "%llu", *(uint64_t *)elem);
+		break;
+	case USER_SETTINGS_TYPE_I64:
+		shell_fprintf(shell_ptr, SHELL_NORMAL, "%lld", *(int64_t *)elem);
+		break;
+	case USER_SETTINGS_TYPE_F32:
+		shell_fprintf(shell_ptr, SHELL_NORMAL, "%.9g", (double)*(float *)elem);
+		break;
+	case USER_SETTINGS_TYPE_F64:
+		shell_fprintf(shell_ptr, SHELL_NORMAL, "%.17g", *(double *)elem);
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * @brief Print the elements of an array value, i.e. [1, 2, 3]
+ */
+static void prv_shell_print_elems(const struct shell *shell_ptr, struct user_setting *setting,
+				  const void *data, size_t len)
+{
+	const uint8_t *elems = data;
+	size_t elem_size = user_settings_list_array_elem_size(setting);
+
+	shell_fprintf(shell_ptr, SHELL_NORMAL, "[");
+	for (size_t i = 0; i + elem_size <= len; i += elem_size) {
+		if (i > 0) {
+			shell_fprintf(shell_ptr, SHELL_NORMAL, ", ");
+		}
+		prv_shell_print_elem(shell_ptr, setting->elem_type, &elems[i]);
+	}
+	shell_fprintf(shell_ptr, SHELL_NORMAL, "]");
+}
+
+/**
+ * @brief Print the fields of a record value, i.e. {kp: 1.5, ki: 0.25}
+ */
+static void prv_shell_print_fields(const struct shell *shell_ptr, struct user_setting *setting,
+				   const void *data, size_t len)
+{
+	const uint8_t *record = data;
+
+	shell_fprintf(shell_ptr, SHELL_NORMAL, "{");
+	for (size_t i = 0; i < setting->num_fields; i++) {
+		const struct user_settings_record_field *field = &setting->fields[i];
+
+		if (field->offset + user_settings_list_record_field_size(field) > len) {
+			continue;
+		}
+
+		shell_fprintf(shell_ptr, SHELL_NORMAL, "%s%s: ", i > 0 ? ", " : "", field->name);
+		prv_shell_print_elem(shell_ptr, field->type, &record[field->offset]);
+	}
+	shell_fprintf(shell_ptr, SHELL_NORMAL, "}");
+}
+
 /*
  * Format to print:
  *
@@ -47,39 +140,53 @@
  */
 static void prv_shell_print_setting(const struct shell *shell_ptr, struct user_setting *setting)
 {
+	/* make sure the value of a lazy setting is cached while it is printed */
+	const void *value = user_settings_list_data_get(setting, NULL);
+	if (setting->is_set && !value) {
+		shell_error(shell_ptr, "id: %d, key: \"%s\", value could not be read", setting->id,
+			    setting->key);
+		return;
+	}
+
 	switch (setting->type) {
 	case USER_SETTINGS_TYPE_BOOL:
-		SETTING_PRINT(setting, "%d", *(bool *));
+		SETTING_PRINT(setting, value, "%d", *(bool *));
 		break;
 	case USER_SETTINGS_TYPE_U8:
-		SETTING_PRINT(setting, "%u", *(uint8_t *));
+		SETTING_PRINT(setting, value, "%u", *(uint8_t *));
 		break;
 	case USER_SETTINGS_TYPE_I8:
-		SETTING_PRINT(setting, "%d", *(int8_t *));
+		SETTING_PRINT(setting, value, "%d", *(int8_t *));
 		break;
 	case USER_SETTINGS_TYPE_U16:
-		SETTING_PRINT(setting, "%u", *(uint16_t *));
+		SETTING_PRINT(setting, value, "%u", *(uint16_t *));
 		break;
 	case USER_SETTINGS_TYPE_I16:
-		SETTING_PRINT(setting, "%d", *(int16_t *));
+		SETTING_PRINT(setting, value, "%d", *(int16_t *));
 		break;
 	case USER_SETTINGS_TYPE_U32:
-		SETTING_PRINT(setting, "%u", *(uint32_t *));
+		SETTING_PRINT(setting, value, "%u", *(uint32_t *));
 		break;
 	case USER_SETTINGS_TYPE_I32:
-		SETTING_PRINT(setting, "%d", *(int32_t *));
+		SETTING_PRINT(setting, value, "%d", *(int32_t *));
 		break;
 	case USER_SETTINGS_TYPE_U64:
-		SETTING_PRINT(setting, "%llu", *(uint64_t *));
+		SETTING_PRINT(setting, value, "%llu", *(uint64_t *));
 		break;
 	case USER_SETTINGS_TYPE_I64:
-		SETTING_PRINT(setting, "%lld", *(int64_t *));
+		SETTING_PRINT(setting, value, "%lld", *(int64_t *));
+		break;
+	case USER_SETTINGS_TYPE_F32:
+		SETTING_PRINT(setting, value, "%.9g", (double)*(float *));
+		break;
+	case USER_SETTINGS_TYPE_F64:
+		SETTING_PRINT(setting, value, "%.17g", *(double *));
 		break;
 	case USER_SETTINGS_TYPE_STR:
-		SETTING_PRINT(setting, "\"%s\"", (char *));
+		SETTING_PRINT(setting, value, "\"%s\"", (char *));
 		break;
 	case USER_SETTINGS_TYPE_CRON_JOB:
-		SETTING_PRINT(setting, "\"%s\"", (char *));
+		SETTING_PRINT(setting, value, "\"%s\"", (char *));
 		break;
 	case USER_SETTINGS_TYPE_BYTES:
 		/* bytes can not be handled with the above macro */
@@ -89,7 +196,7 @@ static void prv_shell_print_setting(const struct shell *shell_ptr, struct user_s
 		if (setting->is_set) {
 			for (int i = 0; i < setting->data_len; i++) {
 				shell_fprintf(shell_ptr, SHELL_NORMAL, "%02X",
-					      ((uint8_t *)setting->data)[i]);
+					      ((const uint8_t *)value)[i]);
 			}
 		} else {
 			shell_fprintf(shell_ptr, SHELL_NORMAL, "/");
@@ -106,14 +213,49 @@ static void prv_shell_print_setting(const struct shell *shell_ptr, struct user_s
 		}
 		shell_fprintf(shell_ptr, SHELL_NORMAL, "\n");
 		break;
+	case USER_SETTINGS_TYPE_ARRAY:
+		shell_fprintf(shell_ptr, SHELL_NORMAL, "id: %d, key: \"%s\", value: ", setting->id,
+			      setting->key);
+		if (setting->is_set) {
+			prv_shell_print_elems(shell_ptr, setting, value, setting->data_len);
+		} else {
+			shell_fprintf(shell_ptr, SHELL_NORMAL, "/");
+		}
+		shell_fprintf(shell_ptr, SHELL_NORMAL, ", default: ");
+
+		if (setting->default_is_set) {
+			prv_shell_print_elems(shell_ptr, setting, setting->default_data,
+					      setting->default_data_len);
+		} else {
+			shell_fprintf(shell_ptr, SHELL_NORMAL, "/");
+		}
+		shell_fprintf(shell_ptr, SHELL_NORMAL, "\n");
+		break;
+	case USER_SETTINGS_TYPE_RECORD:
+		shell_fprintf(shell_ptr, SHELL_NORMAL, "id: %d, key: \"%s\", value: ", setting->id,
+			      setting->key);
+		if (setting->is_set) {
+			prv_shell_print_fields(shell_ptr, setting, value, setting->data_len);
+		} else {
+			shell_fprintf(shell_ptr, SHELL_NORMAL, "/");
+		}
+		shell_fprintf(shell_ptr, SHELL_NORMAL, ", default: ");
+
+		if (setting->default_is_set) {
+			prv_shell_print_fields(shell_ptr, setting, setting->default_data,
+					       setting->default_data_len);
+		} else {
+			shell_fprintf(shell_ptr, SHELL_NORMAL, "/");
+		}
+		shell_fprintf(shell_ptr, SHELL_NORMAL, "\n");
+		break;
 	}
 }
 
 static int cmd_list(const struct shell *shell_ptr, size_t argc, char *argv[])
 {
-	user_settings_list_iter_start();
-	struct user_setting *setting;
-	while ((setting = user_settings_list_iter_next()) != NULL) {
+	struct user_setting *setting = NULL;
+	while ((setting = user_settings_list_next(setting)) != NULL) {
 		prv_shell_print_setting(shell_ptr, setting);
 	}
 
@@ -122,12 +264,9 @@ static int cmd_list(const struct shell *shell_ptr, size_t argc, char *argv[])
 
 static int cmd_list_changed(const struct shell *shell_ptr, size_t argc, char *argv[])
 {
-	user_settings_list_iter_start();
-	struct user_setting *setting;
-	while ((setting = user_settings_list_iter_next()) != NULL) {
-		if (setting->has_changed_recently) {
-			prv_shell_print_setting(shell_ptr, setting);
-		}
+	struct user_setting *setting = NULL;
+	while ((setting = user_settings_list_changed_next(setting)) != NULL) {
+		prv_shell_print_setting(shell_ptr, setting);
 	}
 
 	return 0;
@@ -149,22 +288,63 @@ static int cmd_get(const struct shell *shell_ptr, size_t argc, char *argv[])
 }
 
 /**
-* @brief parse_time_string attempts to parse cron job string to seperate components
-* @retval 0 parsed sucsessfully
-* @retval -1 Invalid time string
+ * @brief Parse one element of an array setting
+ *
+ * @param[in] type The type of the element
+ * @param[in] str The string to parse
+ * @param[out] end Set to the first character after the element
+ * @param[out] out The element
  */
-bool is_valid_time_setting(const char *time_str, int *minute, int *hour, int *day_of_week) {
-	// Check maximum string length and check format for mm-hh-dd
-    	if (strlen(time_str) != 8 || sscanf(time_str, "%2d-%2d-%2d", minute, hour, day_of_week) != 3) {
-        	return false;
-    	}
-
-	// Ensure mm<60, hh<24, dd<7
-    	if (*minute < 0 || *minute >= 60 || *hour < 0 || *hour >= 24 || *day_of_week < 0 || *day_of_week >= 7) {
-        	return false;
-    	}
-
-    return true;
+static void prv_parse_elem(enum user_setting_type type, const char *str, char **end, void *out)
+{
+	switch (type) {
+	case USER_SETTINGS_TYPE_BOOL: {
+		bool v = strtol(str, end, 10);
+		memcpy(out, &v, sizeof(v));
+		break;
+	}
+	case USER_SETTINGS_TYPE_U8:
+	case USER_SETTINGS_TYPE_I8: {
+		uint8_t v = strtol(str, end, 10);
+		memcpy(out, &v, sizeof(v));
+		break;
+	}
+	case USER_SETTINGS_TYPE_U16:
+	case USER_SETTINGS_TYPE_I16: {
+		uint16_t v = strtol(str, end, 10);
+		memcpy(out, &v, sizeof(v));
+		break;
+	}
+	case USER_SETTINGS_TYPE_U32:
+	case USER_SETTINGS_TYPE_I32: {
+		uint32_t v = strtoll(str, end, 10);
+		memcpy(out, &v, sizeof(v));
+		break;
+	}
+	case USER_SETTINGS_TYPE_U64: {
+		uint64_t v = strtoull(str, end, 10);
+		memcpy(out, &v, sizeof(v));
+		break;
+	}
+	case USER_SETTINGS_TYPE_I64: {
+		int64_t v = strtoll(str, end, 10);
+		memcpy(out, &v, sizeof(v));
+		break;
+	}
+	case USER_SETTINGS_TYPE_F32: {
+		float v = strtof(str, end);
+		memcpy(out, &v, sizeof(v));
+		break;
+	}
+	case USER_SETTINGS_TYPE_F64: {
+		double v = strtod(str, end);
+		memcpy(out, &v, sizeof(v));
+		break;
+	}
+	default:
+		*end = (char *)str;
+		break;
+	}
 }
 
 static int prv_set_helper(const char *value, struct user_setting *s,
@@ -208,16 +388,21 @@ static int prv_set_helper(const char *value, struct user_setting *s,
 		uint64_t v = strtoll(value, NULL, 10);
 		return setter_f(s->key, &v, sizeof(v));
 	}
+	case USER_SETTINGS_TYPE_F32: {
+		float v = strtof(value, NULL);
+		return setter_f(s->key, &v, sizeof(v));
+	}
+	case USER_SETTINGS_TYPE_F64: {
+		double v = strtod(value, NULL);
+		return setter_f(s->key, &v, sizeof(v));
+	}
 	case USER_SETTINGS_TYPE_STR: {
 		char *v = (char *)value;
 		return setter_f(s->key, v, strlen(value) + 1);
 	}
 	case USER_SETTINGS_TYPE_CRON_JOB: {
+		/* invalid cron jobs are rejected by the setter */
 		char *v = (char *)value;
-		int minute, hour, day_of_week;
-		if (!is_valid_time_setting(v, &minute, &hour, &day_of_week)) {
-			v = "00-00-00"; // Default value
-		}
 		return setter_f(s->key, v, strlen(value));
 	}
 	case USER_SETTINGS_TYPE_BYTES: {
@@ -230,6 +415,46 @@ static int prv_set_helper(const char *value, struct user_setting *s,
 		}
 		return setter_f(s->key, bytes, bytes_len);
 	}
+	case USER_SETTINGS_TYPE_ARRAY: {
+		/* comma separated elements, i.e. 1,2,3 */
+		uint8_t elems[s->max_size];
+		size_t elem_size = user_settings_list_array_elem_size(s);
+		size_t len = 0;
+		char *end;
+
+		while (*value && len + elem_size <= s->max_size) {
+			prv_parse_elem(s->elem_type, value, &end, &elems[len]);
+			if (end == value) {
+				return -EINVAL;
+			}
+			len += elem_size;
+			value = *end == ',' ? end + 1 : end;
+		}
+		return setter_f(s->key, elems, len);
+	}
+	case USER_SETTINGS_TYPE_RECORD: {
+		/* comma separated fields in the order of the table, i.e. 1.5,0.25. Fields that are
+		 * not given keep their value.
+		 */
+		uint8_t record[s->max_size];
+		size_t record_len;
+		const void *current = user_settings_list_value_get(s, &record_len);
+		char *end;
+
+		memset(record, 0, sizeof(record));
+		if (current) {
+			memcpy(record, current, MIN(record_len, sizeof(record)));
+		}
+
+		for (size_t i = 0; *value && i < s->num_fields; i++) {
+			prv_parse_elem(s->fields[i].type, value, &end, &record[s->fields[i].offset]);
+			if (end == value) {
+				return -EINVAL;
+			}
+			value = *end == ',' ? end + 1 : end;
+		}
+		return setter_f(s->key, record, sizeof(record));
+	}
 	}
 
 	__ASSERT(0, "How did we get here? All setting types should be handled by the above switch");
@@ -266,6 +491,65 @@ static int cmd_set_default(const struct shell *shell_ptr, size_t argc, char *arg
 	return prv_set_helper(value, s, user_settings_set_default_with_key);
 }
 
+static int cmd_set_elem(const struct shell *shell_ptr, size_t argc, char *argv[])
+{
+	const char *name = argv[1];
+	size_t index = strtoul(argv[2], NULL, 10);
+	const char *value = argv[3];
+
+	/* Check if key exists */
+	struct user_setting *s = user_settings_list_get_by_key(name);
+	if (!s) {
+		shell_error(shell_ptr, "Setting with this key not found: %s", name);
+		return -ENOENT;
+	}
+	if (s->type != USER_SETTINGS_TYPE_ARRAY) {
+		shell_error(shell_ptr, "Setting is not an array: %s", name);
+		return -EINVAL;
+	}
+
+	/* large enough for any element */
+	uint64_t elem;
+	char *end;
+	prv_parse_elem(s->elem_type, value, &end, &elem);
+
+	return user_settings_set_elem_with_key(s->key, index, &elem,
+					       user_settings_list_array_elem_size(s));
+}
+
+static int cmd_set_field(const struct shell *shell_ptr, size_t argc, char *argv[])
+{
+	const char *name = argv[1];
+	const char *field_name = argv[2];
+	const char *value = argv[3];
+
+	/* Check if key exists */
+	struct user_setting *s = user_settings_list_get_by_key(name);
+	if (!s) {
+		shell_error(shell_ptr, "Setting with this key not found: %s", name);
+		return -ENOENT;
+	}
+	if (s->type != USER_SETTINGS_TYPE_RECORD) {
+		shell_error(shell_ptr, "Setting is not a record: %s", name);
+		return -EINVAL;
+	}
+
+	const struct user_settings_record_field *field =
+		user_settings_list_record_field_get(s, field_name);
+	if (!field) {
+		shell_error(shell_ptr, "Record has no field: %s", field_name);
+		return -ENOENT;
+	}
+
+	/* large enough for any field */
+	uint64_t v;
+	char *end;
+	prv_parse_elem(field->type, value, &end, &v);
+
+	return user_settings_set_field_with_key(s->key, field->name, &v,
+						user_settings_list_record_field_size(field));
+}
+
 static int cmd_restore(const struct shell *shell_ptr, size_t argc, char *argv[])
 {
 	user_settings_restore_defaults();
@@ -316,10 +600,9 @@ static int cmd_clear_changed_one(const struct shell *shell_ptr, size_t argc, cha
  */
 static struct user_setting *prv_get_us_by_idx(size_t idx)
 {
-	user_settings_list_iter_start();
-	struct user_setting *setting;
+	struct user_setting *setting = NULL;
 	int c = 0;
-	while ((setting = user_settings_list_iter_next()) != NULL) {
+	while ((setting = user_settings_list_next(setting)) != NULL) {
 		if (idx == c) {
 			return setting;
 		}
@@ -329,6 +612,206 @@ static struct user_setting *prv_get_us_by_idx(size_t idx)
 	return NULL;
 }
 
+static int cmd_export(const struct shell *shell_ptr, size_t argc, char *argv[])
+{
+	uint8_t chunk[32];
+	struct user_settings_export_cursor cursor = {0};
+	int len;
+
+	while ((len = user_settings_export_binary(chunk, sizeof(chunk), &cursor)) > 0) {
+		for (int i = 0; i < len; i++) {
+			shell_fprintf(shell_ptr, SHELL_NORMAL, "%02X", chunk[i]);
+		}
+		shell_fprintf(shell_ptr, SHELL_NORMAL, "\n");
+	}
+
+	if (len < 0) {
+		shell_error(shell_ptr, "Export failed, err: %d", len);
+		return len;
+	}
+
+	return 0;
+}
+
+static int cmd_import(const struct shell *shell_ptr, size_t argc, char *argv[])
+{
+	const char *hex = argv[2];
+	uint8_t chunk[128];
+
+	size_t offset = strtoul(argv[1], NULL, 0);
+	size_t len = hex2bin(hex, strlen(hex), chunk, sizeof(chunk));
+	if (len == 0) {
+		shell_error(shell_ptr, "Chunk must be a hex string of at most %d bytes",
+			    (int)sizeof(chunk));
+		return -EINVAL;
+	}
+
+	int err = user_settings_import_binary_chunk(offset, chunk, len);
+	if (err) {
+		shell_error(shell_ptr, "Adding chunk failed, err: %d", err);
+		return err;
+	}
+
+	return 0;
+}
+
+static int cmd_import_commit(const struct shell *shell_ptr, size_t argc, char *argv[])
+{
+	int err = user_settings_import_binary_commit();
+	if (err) {
+		shell_error(shell_ptr, "Import failed, err: %d", err);
+		return err;
+	}
+
+	shell_print(shell_ptr, "Import done");
+	return 0;
+}
+
+static int cmd_wear(const struct shell *shell_ptr, size_t argc, char *argv[])
+{
+	struct user_settings_wear_totals totals;
+	int err = user_settings_get_wear_totals(&totals);
+	if (err) {
+		shell_error(shell_ptr, "Wear stats are not available, err: %d", err);
+		return err;
+	}
+
+	if (argc > 1) {
+		struct user_setting *s = user_settings_list_get_by_key(argv[1]);
+		if (!s) {
+			shell_error(shell_ptr, "Setting with this key not found: %s", argv[1]);
+			return -ENOENT;
+		}
+
+		struct user_settings_wear_stats stats;
+		user_settings_get_wear_stats_with_id(s->id, &stats);
+		shell_print(shell_ptr, "id: %d, key: \"%s\", writes: %u, bytes: %u, skipped: %u", s->id,
+			    s->key, stats.writes, stats.bytes, stats.skipped);
+		return 0;
+	}
+
+	shell_print(shell_ptr, "total writes: %u, bytes: %u, skipped: %u", totals.sum.writes,
+		    totals.sum.bytes, totals.sum.skipped);
+	shell_print(shell_ptr, "since boot: %u writes, %u writes/h", totals.boot_writes,
+		    totals.writes_per_hour);
+
+	/* Only settings that were written are listed */
+	struct user_setting *s = NULL;
+	while ((s = user_settings_list_next(s)) != NULL) {
+		struct user_settings_wear_stats stats;
+		user_settings_get_wear_stats_with_id(s->id, &stats);
+		if (stats.writes == 0 && stats.skipped == 0) {
+			continue;
+		}
+		shell_print(shell_ptr, "id: %d, key: \"%s\", writes: %u, bytes: %u, skipped: %u", s->id,
+			    s->key, stats.writes, stats.bytes, stats.skipped);
+	}
+
+	return 0;
+}
+
+static int cmd_wear_save(const struct shell *shell_ptr, size_t argc, char *argv[])
+{
+	int err = user_settings_save_wear_stats();
+	if (err) {
+		shell_error(shell_ptr, "Saving wear stats failed, err: %d", err);
+		return err;
+	}
+
+	return 0;
+}
+
+static int cmd_wear_reset(const struct shell *shell_ptr, size_t argc, char *argv[])
+{
+	int err = user_settings_reset_wear_stats();
+	if (err) {
+		shell_error(shell_ptr, "Resetting wear stats failed, err: %d", err);
+		return err;
+	}
+
+	return 0;
+}
+
+static void prv_print_stat(const char *name, uint32_t value, void *arg)
+{
+	const struct shell *shell_ptr = arg;
+
+	shell_print(shell_ptr, "%s: %u", name, value);
+}
+
+static int cmd_stats(const struct shell *shell_ptr, size_t argc, char *argv[])
+{
+	int err = user_settings_stats_walk(prv_print_stat, (void *)shell_ptr);
+	if (err) {
+		shell_error(shell_ptr, "Stats are not available, err: %d", err);
+		return err;
+	}
+
+	return 0;
+}
+
+static int cmd_stats_reset(const struct shell *shell_ptr, size_t argc, char *argv[])
+{
+	int err = user_settings_stats_reset();
+	if (err) {
+		shell_error(shell_ptr, "Resetting stats failed, err: %d", err);
+		return err;
+	}
+
+	return 0;
+}
+
+#ifdef PRV_SHELL_EXEC
+
+/**
+ * @brief Print a response of the binary protocol executor as a hex string
+ *
+ * @param[in] buffer The encoded response
+ * @param[in] len The length of the response
+ * @param[in] user_data The shell to print to
+ *
+ * @return 0 (always)
+ */
+static int prv_shell_write_response(uint8_t *buffer, size_t len, void *user_data)
+{
+	const struct shell *shell_ptr = user_data;
+
+	for (size_t i = 0; i < len; i++) {
+		shell_fprintf(shell_ptr, SHELL_NORMAL, "%02X", buffer[i]);
+	}
+	shell_fprintf(shell_ptr, SHELL_NORMAL, "\n");
+
+	return 0;
+}
+
+static uint8_t prv_exec_resp_buffer[512];
+static struct usp_executor prv_shell_executor = USP_BINARY_EXECUTOR_DECLARE(
+	prv_exec_resp_buffer, sizeof(prv_exec_resp_buffer), prv_shell_write_response);
+
+static int cmd_exec(const struct shell *shell_ptr, size_t argc, char *argv[])
+{
+	const char *hex = argv[1];
+	/* Fits the longest command: type, sequence number, ID, length and 255 bytes of value */
+	uint8_t cmd[264];
+
+	size_t len = hex2bin(hex, strlen(hex), cmd, sizeof(cmd));
+	if (len == 0) {
+		shell_error(shell_ptr, "Command must be a hex string of at most %d bytes",
+			    (int)sizeof(cmd));
+		return -EINVAL;
+	}
+
+	int err = usp_executor_parse_and_execute(&prv_shell_executor, cmd, len, (void *)shell_ptr);
+	if (err) {
+		shell_error(shell_ptr, "Executing command failed, err: %d", err);
+		return err;
+	}
+
+	return 0;
+}
+
+#endif /* PRV_SHELL_EXEC */
+
 /**
  * @brief Provide a list of user settings keys as dynamic subcommands
  *
@@ -357,6 +840,12 @@ SHELL_STATIC_SUBCMD_SET_CREATE(
 	SHELL_CMD_ARG(set_default, &dsub_setting_key,
 		      "<name> <value> Set the default value for one user setting", cmd_set_default,
 		      3, 0),
+	SHELL_CMD_ARG(set_elem, &dsub_setting_key,
+		      "<name> <index> <value> Set one element of an array setting", cmd_set_elem, 4,
+		      0),
+	SHELL_CMD_ARG(set_field, &dsub_setting_key,
+		      "<name> <field> <value> Set one field of a record setting", cmd_set_field, 4,
+		      0),
 	SHELL_CMD_ARG(restore, NULL, "Restore all settings to default values", cmd_restore, 1, 0),
 	SHELL_CMD_ARG(restore_one, NULL, "Restore one setting to its default value",
 		      cmd_restore_one, 2, 0),
@@ -364,6 +853,25 @@ SHELL_STATIC_SUBCMD_SET_CREATE(
 		      cmd_clear_changed, 1, 0),
 	SHELL_CMD_ARG(clear_changed_one, NULL, "Clear the changed flag for one setting",
 		      cmd_clear_changed_one, 2, 0),
+	SHELL_CMD_ARG(export, NULL, "Export all settings as a hex encoded bulk blob", cmd_export, 1,
+		      0),
+	SHELL_CMD_ARG(import, NULL,
+		      "<offset> <hex> Add a chunk of a hex encoded bulk blob to import",
+		      cmd_import, 3, 0),
+	SHELL_CMD_ARG(import_commit, NULL, "Import the collected bulk blob", cmd_import_commit, 1,
+		      0),
+	SHELL_CMD_ARG(wear, &dsub_setting_key,
+		      "[name] Show the flash write counters of all settings or one setting",
+		      cmd_wear, 1, 1),
+	SHELL_CMD_ARG(wear_save, NULL, "Store the flash write counters", cmd_wear_save, 1, 0),
+	SHELL_CMD_ARG(wear_reset, NULL, "Reset the flash write counters", cmd_wear_reset, 1, 0),
+	SHELL_CMD_ARG(stats, NULL, "Print the operation counters", cmd_stats, 1, 0),
+	SHELL_CMD_ARG(stats_reset, NULL, "Reset the operation counters", cmd_stats_reset, 1, 0),
+#ifdef PRV_SHELL_EXEC
+	SHELL_CMD_ARG(exec, NULL,
+		      "<hex> Execute a binary protocol command and print the responses as hex",
+		      cmd_exec, 2, 0),
+#endif
 	SHELL_SUBCMD_SET_END);
 
 static int cmd_settings(const struct shell *shell_ptr, size_t argc, char **argv)
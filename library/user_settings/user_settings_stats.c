@@ -0,0 +1,241 @@
+/** @file user_settings_stats.c
+ *
+ * @brief Statistics of user settings operations
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2023 Irnas.  All rights reserved.
+ */
+
+#include <user_settings_protocol_types.h>
+#include <user_settings_stats.h>
+
+#include <errno.h>
+
+#if defined(CONFIG_USER_SETTINGS_STATS)
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(user_settings, CONFIG_USER_SETTINGS_LOG_LEVEL);
+
+STATS_SECT_DECL(user_settings) user_settings_stats;
+
+/* clang-format off */
+STATS_NAME_START(user_settings)
+	STATS_NAME(user_settings, get_key)
+	STATS_NAME(user_settings, get_id)
+	STATS_NAME(user_settings, set_key)
+	STATS_NAME(user_settings, set_id)
+	STATS_NAME(user_settings, set_unchanged)
+	STATS_NAME(user_settings, lookup_miss)
+	STATS_NAME(user_settings, err_nomem)
+	STATS_NAME(user_settings, err_io)
+	STATS_NAME(user_settings, writes)
+	STATS_NAME(user_settings, write_err)
+	STATS_NAME(user_settings, cmd_get)
+	STATS_NAME(user_settings, cmd_get_full)
+	STATS_NAME(user_settings, cmd_list)
+	STATS_NAME(user_settings, cmd_list_full)
+	STATS_NAME(user_settings, cmd_set)
+	STATS_NAME(user_settings, cmd_set_default)
+	STATS_NAME(user_settings, cmd_restore)
+	STATS_NAME(user_settings, cmd_list_some)
+	STATS_NAME(user_settings, cmd_list_some_full)
+	STATS_NAME(user_settings, cmd_list_changed)
+	STATS_NAME(user_settings, cmd_list_changed_full)
+	STATS_NAME(user_settings, cmd_export)
+	STATS_NAME(user_settings, cmd_import)
+	STATS_NAME(user_settings, cmd_import_commit)
+	STATS_NAME(user_settings, cmd_read_at)
+	STATS_NAME(user_settings, cmd_write_at)
+	STATS_NAME(user_settings, cmd_write_commit)
+	STATS_NAME(user_settings, cmd_wear_stats)
+	STATS_NAME(user_settings, cmd_wear_totals)
+	STATS_NAME(user_settings, cmd_stats)
+	STATS_NAME(user_settings, cmd_err)
+	STATS_NAME(user_settings, bt_notify_fail)
+#if defined(CONFIG_USER_SETTINGS_STATS_LATENCY)
+	STATS_NAME(user_settings, write_lt_1ms)
+	STATS_NAME(user_settings, write_lt_10ms)
+	STATS_NAME(user_settings, write_lt_100ms)
+	STATS_NAME(user_settings, write_ge_100ms)
+	STATS_NAME(user_settings, write_max_us)
+#endif
+STATS_NAME_END(user_settings);
+/* clang-format on */
+
+int user_settings_stats_init(void)
+{
+	int err = stats_init_and_reg(&user_settings_stats.s_hdr,
+				     STATS_SIZE_INIT_PARMS(user_settings_stats, STATS_SIZE_32),
+				     STATS_NAME_INIT_PARMS(user_settings), "usettings");
+	if (err) {
+		LOG_ERR("stats_init_and_reg, err: %d", err);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+void user_settings_stats_count_command(uint8_t type, int ret)
+{
+	switch (type) {
+	case USPC_GET:
+		USER_SETTINGS_STATS_INC(cmd_get);
+		break;
+	case USPC_GET_FULL:
+		USER_SETTINGS_STATS_INC(cmd_get_full);
+		break;
+	case USPC_LIST:
+		USER_SETTINGS_STATS_INC(cmd_list);
+		break;
+	case USPC_LIST_FULL:
+		USER_SETTINGS_STATS_INC(cmd_list_full);
+		break;
+	case USPC_SET:
+		USER_SETTINGS_STATS_INC(cmd_set);
+		break;
+	case USPC_SET_DEFAULT:
+		USER_SETTINGS_STATS_INC(cmd_set_default);
+		break;
+	case USPC_RESTORE:
+		USER_SETTINGS_STATS_INC(cmd_restore);
+		break;
+	case USPC_LIST_SOME:
+		USER_SETTINGS_STATS_INC(cmd_list_some);
+		break;
+	case USPC_LIST_SOME_FULL:
+		USER_SETTINGS_STATS_INC(cmd_list_some_full);
+		break;
+	case USPC_LIST_CHANGED:
+		USER_SETTINGS_STATS_INC(cmd_list_changed);
+		break;
+	case USPC_LIST_CHANGED_FULL:
+		USER_SETTINGS_STATS_INC(cmd_list_changed_full);
+		break;
+	case USPC_EXPORT:
+		USER_SETTINGS_STATS_INC(cmd_export);
+		break;
+	case USPC_IMPORT:
+		USER_SETTINGS_STATS_INC(cmd_import);
+		break;
+	case USPC_IMPORT_COMMIT:
+		USER_SETTINGS_STATS_INC(cmd_import_commit);
+		break;
+	case USPC_READ_AT:
+		USER_SETTINGS_STATS_INC(cmd_read_at);
+		break;
+	case USPC_WRITE_AT:
+		USER_SETTINGS_STATS_INC(cmd_write_at);
+		break;
+	case USPC_WRITE_COMMIT:
+		USER_SETTINGS_STATS_INC(cmd_write_commit);
+		break;
+	case USPC_WEAR_STATS:
+		USER_SETTINGS_STATS_INC(cmd_wear_stats);
+		break;
+	case USPC_WEAR_TOTALS:
+		USER_SETTINGS_STATS_INC(cmd_wear_totals);
+		break;
+	case USPC_STATS:
+		USER_SETTINGS_STATS_INC(cmd_stats);
+		break;
+	default:
+		/* Commands that could not be parsed have no type */
+		break;
+	}
+
+	if (ret < 0) {
+		USER_SETTINGS_STATS_INC(cmd_err);
+	}
+}
+
+struct prv_read_ctx {
+	uint32_t *values;
+	size_t max_values;
+	size_t num_values;
+};
+
+static int prv_read_walk(struct stats_hdr *hdr, void *arg, const char *name, uint16_t off)
+{
+	struct prv_read_ctx *ctx = arg;
+
+	if (ctx->num_values == ctx->max_values) {
+		return -ENOMEM;
+	}
+
+	ctx->values[ctx->num_values++] = *(uint32_t *)((uint8_t *)hdr + off);
+	return 0;
+}
+
+int user_settings_stats_read(uint32_t *values, size_t max_values)
+{
+	struct prv_read_ctx ctx = {
+		.values = values,
+		.max_values = max_values,
+	};
+
+	int err = stats_walk(&user_settings_stats.s_hdr, prv_read_walk, &ctx);
+	if (err) {
+		return err;
+	}
+
+	return ctx.num_values;
+}
+
+struct prv_print_ctx {
+	void (*print)(const char *name, uint32_t value, void *arg);
+	void *arg;
+};
+
+static int prv_print_walk(struct stats_hdr *hdr, void *arg, const char *name, uint16_t off)
+{
+	struct prv_print_ctx *ctx = arg;
+
+	ctx->print(name, *(uint32_t *)((uint8_t *)hdr + off), ctx->arg);
+	return 0;
+}
+
+int user_settings_stats_walk(void (*print)(const char *name, uint32_t value, void *arg),
+			     void *arg)
+{
+	struct prv_print_ctx ctx = {
+		.print = print,
+		.arg = arg,
+	};
+
+	return stats_walk(&user_settings_stats.s_hdr, prv_print_walk, &ctx);
+}
+
+int user_settings_stats_reset(void)
+{
+	stats_reset(&user_settings_stats.s_hdr);
+	return 0;
+}
+
+#else /* CONFIG_USER_SETTINGS_STATS */
+
+int user_settings_stats_init(void)
+{
+	return 0;
+}
+
+void user_settings_stats_count_command(uint8_t type, int ret)
+{
+}
+
+int user_settings_stats_read(uint32_t *values, size_t max_values)
+{
+	return -ENOTSUP;
+}
+
+int user_settings_stats_walk(void (*print)(const char *name, uint32_t value, void *arg),
+			     void *arg)
+{
+	return -ENOTSUP;
+}
+
+int user_settings_stats_reset(void)
+{
+	return -ENOTSUP;
+}
+
+#endif /* CONFIG_USER_SETTINGS_STATS */
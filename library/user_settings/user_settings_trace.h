@@ -0,0 +1,59 @@
+/** @file user_settings_trace.h
+ *
+ * @brief Tracing hooks of the user settings library
+ *
+ * With CONFIG_USER_SETTINGS_TRACING, each hook emits a named event that is recorded by the
+ * tracing backend, i.e. CTF on native_sim. A traced section emits "us_<name>_enter" with @p arg
+ * when it starts and "us_<name>_exit" with @p arg and the result when it ends, so the time spent
+ * in it can be read from the trace. Without it, the hooks compile to nothing.
+ *
+ * Names are short, since the CTF backend truncates event names to 19 characters.
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2023 Irnas.  All rights reserved.
+ */
+
+#ifndef USER_SETTINGS_TRACE_H
+#define USER_SETTINGS_TRACE_H
+
+#include <zephyr/sys/util.h>
+
+#if defined(CONFIG_USER_SETTINGS_TRACING)
+
+#include <zephyr/tracing/tracing.h>
+
+/**
+ * @brief Mark the start of a traced section
+ *
+ * @param[in] name The name of the section, a string literal
+ * @param[in] arg A number identifying the work, i.e. a setting ID or a command type
+ */
+#define USER_SETTINGS_TRACE_ENTER(name, arg)                                                       \
+	sys_trace_named_event("us_" name "_enter", (uint32_t)(arg), 0)
+
+/**
+ * @brief Mark the end of a traced section
+ *
+ * @param[in] name The name of the section, same as in USER_SETTINGS_TRACE_ENTER()
+ * @param[in] arg The same number as in USER_SETTINGS_TRACE_ENTER()
+ * @param[in] ret The result of the section, i.e. 0 or a negative error code
+ */
+#define USER_SETTINGS_TRACE_EXIT(name, arg, ret)                                                   \
+	sys_trace_named_event("us_" name "_exit", (uint32_t)(arg), (uint32_t)(ret))
+
+#else
+
+#define USER_SETTINGS_TRACE_ENTER(name, arg)                                                       \
+	do {                                                                                       \
+		ARG_UNUSED(arg);                                                                   \
+	} while (0)
+
+#define USER_SETTINGS_TRACE_EXIT(name, arg, ret)                                                   \
+	do {                                                                                       \
+		ARG_UNUSED(arg);                                                                   \
+		ARG_UNUSED(ret);                                                                   \
+	} while (0)
+
+#endif /* CONFIG_USER_SETTINGS_TRACING */
+
+#endif /* USER_SETTINGS_TRACE_H */
@@ -0,0 +1,56 @@
+/** @file user_settings_zbus.c
+ *
+ * @brief zbus bridge for user settings change events
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2023 Irnas. All rights reserved.
+ */
+
+#include <user_settings_zbus.h>
+
+#include "user_settings_list.h"
+#include "user_settings_zbus_publish.h"
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(user_settings_zbus, CONFIG_USER_SETTINGS_LOG_LEVEL);
+
+ZBUS_CHAN_DEFINE(user_settings_chan, struct user_settings_zbus_msg, NULL, NULL,
+		 ZBUS_OBSERVERS_EMPTY, ZBUS_MSG_INIT(0));
+
+void user_settings_zbus_publish(struct user_setting *us)
+{
+	struct user_settings_zbus_msg msg = {
+		.id = us->id,
+		.type = us->type,
+	};
+
+	switch (us->type) {
+	case USER_SETTINGS_TYPE_STR:
+	case USER_SETTINGS_TYPE_BYTES:
+	case USER_SETTINGS_TYPE_CRON_JOB:
+	case USER_SETTINGS_TYPE_ARRAY:
+	case USER_SETTINGS_TYPE_RECORD:
+		/* only the length, without fetching the value of a lazy setting */
+		msg.len = us->is_set ? us->data_len : us->default_data_len;
+		break;
+	default: {
+		size_t len;
+		const void *value = user_settings_list_value_get(us, &len);
+		if (value && len <= sizeof(msg.value)) {
+			memcpy(msg.value.raw, value, len);
+			msg.len = len;
+			msg.is_inline = true;
+		}
+		break;
+	}
+	}
+
+	int err = zbus_chan_pub(&user_settings_chan, &msg,
+				K_MSEC(CONFIG_USER_SETTINGS_ZBUS_PUB_TIMEOUT_MS));
+	if (err) {
+		LOG_ERR("zbus_chan_pub, id: %d, err: %d", us->id, err);
+	}
+}
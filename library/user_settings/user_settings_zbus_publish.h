@@ -0,0 +1,23 @@
+/** @file user_settings_zbus_publish.h
+ *
+ * @brief Internal interface between the user settings module and its zbus bridge
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2023 Irnas.  All rights reserved.
+ */
+
+#ifndef USER_SETTINGS_ZBUS_PUBLISH_H
+#define USER_SETTINGS_ZBUS_PUBLISH_H
+
+#include "user_settings_list.h"
+
+/**
+ * @brief Publish the change of a setting on user_settings_chan
+ *
+ * Called by the user settings module together with the on change callbacks.
+ *
+ * @param[in] us The changed setting
+ */
+void user_settings_zbus_publish(struct user_setting *us);
+
+#endif /* USER_SETTINGS_ZBUS_PUBLISH_H */
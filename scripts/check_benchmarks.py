@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""Compare the results of the benchmark test suite with thresholds.
+
+The benchmarks in tests/benchmarks print one line per measurement:
+
+    BENCHMARK {"name": ..., "settings": ..., "ops": ..., "total_ns": ..., "ns_per_op": ...,
+    "flash_bytes": ...}
+
+This script collects these lines from the Twister handler logs, prints them as a table and
+exits with a non-zero code if any measurement is above its threshold.
+
+Usage:
+    scripts/check_benchmarks.py [--thresholds FILE] [--json OUT] [TWISTER_OUT_DIR]
+"""
+
+import argparse
+import json
+import sys
+from pathlib import Path
+
+PREFIX = "BENCHMARK "
+
+
+def parse_logs(out_dir):
+    """Collect benchmark results from all handler logs in a Twister output directory.
+
+    Args:
+        out_dir: The Twister output directory.
+
+    Returns:
+        A list of result dictionaries.
+    """
+    results = []
+    for log in sorted(Path(out_dir).rglob("handler.log")):
+        for line in log.read_text(errors="replace").splitlines():
+            idx = line.find(PREFIX)
+            if idx < 0:
+                continue
+            try:
+                results.append(json.loads(line[idx + len(PREFIX) :]))
+            except json.JSONDecodeError:
+                print(f"Malformed benchmark line in {log}: {line}", file=sys.stderr)
+    return results
+
+
+def check(results, thresholds):
+    """Compare the results with the thresholds.
+
+    Args:
+        results: The results returned by parse_logs().
+        thresholds: The parsed thresholds file.
+
+    Returns:
+        A list of violation messages, empty if all results are within the thresholds.
+    """
+    default = thresholds.get("default", {})
+    per_name = thresholds.get("benchmarks", {})
+    violations = []
+
+    for r in results:
+        limits = {**default, **per_name.get(r["name"], {})}
+        label = f"{r['name']} ({r['settings']} settings)"
+
+        max_ns = limits.get("ns_per_op")
+        if max_ns is not None and r["ns_per_op"] > max_ns:
+            violations.append(f"{label}: {r['ns_per_op']} ns/op > {max_ns} ns/op")
+
+        max_flash = limits.get("flash_bytes_per_op")
+        flash_per_op = r["flash_bytes"] / max(r["ops"], 1)
+        if max_flash is not None and flash_per_op > max_flash:
+            violations.append(f"{label}: {flash_per_op:.1f} flash B/op > {max_flash} flash B/op")
+
+    return violations
+
+
+def main():
+    """Run the script."""
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("out_dir", nargs="?", default="twister-out", help="Twister output dir")
+    parser.add_argument(
+        "--thresholds",
+        default=Path(__file__).parent.parent / "tests" / "benchmarks" / "thresholds.json",
+        help="Thresholds file",
+    )
+    parser.add_argument("--json", help="Also write all results to this file")
+    args = parser.parse_args()
+
+    results = parse_logs(args.out_dir)
+    if not results:
+        print(f"No benchmark results found in {args.out_dir}", file=sys.stderr)
+        return 1
+
+    print(f"{'benchmark':<24}{'settings':>10}{'ops':>10}{'ns/op':>14}{'flash B':>10}")
+    for r in sorted(results, key=lambda r: (r["name"], r["settings"])):
+        print(
+            f"{r['name']:<24}{r['settings']:>10}{r['ops']:>10}"
+            f"{r['ns_per_op']:>14}{r['flash_bytes']:>10}"
+        )
+
+    if args.json:
+        Path(args.json).write_text(json.dumps(results, indent=2) + "\n")
+
+    thresholds = json.loads(Path(args.thresholds).read_text())
+    violations = check(results, thresholds)
+    for v in violations:
+        print(f"FAIL: {v}", file=sys.stderr)
+
+    return 1 if violations else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,21 @@
+/** @file bench_host_clock.c
+ *
+ * @brief Host clock for benchmarks on native targets
+ *
+ * This file is built for the host side of the native simulator, where the host C library is
+ * available.
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2023 Irnas. All rights reserved.
+ */
+
+#include <stdint.h>
+#include <time.h>
+
+uint64_t bench_host_clock_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
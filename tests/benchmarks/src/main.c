@@ -0,0 +1,324 @@
+#include <user_settings.h>
+#include <user_settings_json.h>
+#include <user_settings_list.h>
+#include <user_settings_protocol_binary.h>
+#include <user_settings_protocol_executor.h>
+
+#include "uart_uss_cobs.h"
+
+#include <stdio.h>
+#include <zephyr/fs/nvs.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/ztest.h>
+
+/*
+ * Each benchmark prints one line that CI can parse:
+ *
+ * BENCHMARK {"name":"get_with_key","settings":100,"ops":10000,"total_ns":..,"ns_per_op":..,
+ * "flash_bytes":0}
+ *
+ * flash_bytes is the NVS space used by the benchmark, so writes that are not needed show up even
+ * if they are fast. scripts/check_benchmarks.py compares the lines with thresholds.json.
+ */
+
+#define NUM_SETTINGS CONFIG_BENCHMARK_NUM_SETTINGS
+
+/* Operations that do not write are repeated, so they take long enough to be measured */
+#define READ_REPEAT 100
+
+static char keys[NUM_SETTINGS][8];
+static struct user_setting *handles[NUM_SETTINGS];
+static struct nvs_fs *nvs;
+
+static uint8_t blob[NUM_SETTINGS * 16 + 64];
+static char json[NUM_SETTINGS * 24 + 64];
+
+/* The loopback benchmark runs the UART service path without the UART driver: commands are COBS
+ * decoded in place and executed, and each response is COBS encoded into a TX buffer. */
+static int loopback_write_response(uint8_t *buffer, size_t len, void *user_data);
+
+static uint8_t loopback_resp[512];
+static struct usp_executor loopback_executor =
+	USP_BINARY_EXECUTOR_DECLARE(loopback_resp, sizeof(loopback_resp), loopback_write_response);
+static uint8_t loopback_tx[UART_USS_COBS_MAX_ENCODED_LEN(sizeof(loopback_resp))];
+static uint32_t loopback_responses;
+
+#if defined(CONFIG_ARCH_POSIX)
+/* Implemented on the host side, see host/bench_host_clock.c */
+uint64_t bench_host_clock_ns(void);
+#endif
+
+static uint64_t bench_now_ns(void)
+{
+#if defined(CONFIG_ARCH_POSIX)
+	return bench_host_clock_ns();
+#else
+	return k_cyc_to_ns_floor64(k_cycle_get_64());
+#endif
+}
+
+static ssize_t bench_flash_free(void)
+{
+	return nvs ? nvs_calc_free_space(nvs) : 0;
+}
+
+struct bench {
+	uint64_t start_ns;
+	ssize_t start_free;
+};
+
+static void bench_start(struct bench *b)
+{
+	b->start_free = bench_flash_free();
+	b->start_ns = bench_now_ns();
+}
+
+static void bench_end(struct bench *b, const char *name, uint32_t ops)
+{
+	uint64_t total_ns = bench_now_ns() - b->start_ns;
+	ssize_t flash_bytes = MAX(b->start_free - bench_flash_free(), 0);
+
+	printk("BENCHMARK {\"name\":\"%s\",\"settings\":%d,\"ops\":%u,\"total_ns\":%llu,"
+	       "\"ns_per_op\":%llu,\"flash_bytes\":%d}\n",
+	       name, NUM_SETTINGS, ops, total_ns, total_ns / MAX(ops, 1), (int)flash_bytes);
+}
+
+static int loopback_write_response(uint8_t *buffer, size_t len, void *user_data)
+{
+	ARG_UNUSED(user_data);
+
+	uart_uss_cobs_encode(buffer, len, loopback_tx);
+	loopback_responses++;
+	return 0;
+}
+
+/**
+ * @brief COBS decode a frame into @p rx and execute it, like the UART service does
+ */
+static void loopback_execute(const uint8_t *frame, size_t frame_len, uint8_t *rx)
+{
+	/* decoding is done in place, so the frame is copied first, as if it was received */
+	memcpy(rx, frame, frame_len);
+	int len = uart_uss_cobs_decode(rx, frame_len - 1);
+	zassert_true(len > 0, "Invalid frame");
+	zassert_ok(usp_executor_parse_and_execute(&loopback_executor, rx, len, NULL),
+		   "Command failed");
+}
+
+static void *benchmarks_setup(void)
+{
+	struct bench b;
+
+	for (int i = 0; i < NUM_SETTINGS; i++) {
+		snprintf(keys[i], sizeof(keys[i]), "s%d", i);
+	}
+
+	bench_start(&b);
+	zassert_ok(user_settings_init(), "init failed");
+	bench_end(&b, "init", 1);
+
+	zassert_ok(settings_storage_get((void **)&nvs), "NVS backend is required");
+
+	bench_start(&b);
+	for (int i = 0; i < NUM_SETTINGS; i++) {
+		user_settings_add(i + 1, keys[i], USER_SETTINGS_TYPE_U32);
+	}
+	bench_end(&b, "add", NUM_SETTINGS);
+
+	/* store a value for each setting, so the load has records to read */
+	char name[SETTINGS_MAX_NAME_LEN + 1];
+	for (int i = 0; i < NUM_SETTINGS; i++) {
+		uint32_t value = i;
+		snprintf(name, sizeof(name), "user/%s", keys[i]);
+		zassert_ok(settings_save_one(name, &value, sizeof(value)), "store failed");
+	}
+
+	bench_start(&b);
+	zassert_ok(user_settings_load(), "load failed");
+	bench_end(&b, "load", NUM_SETTINGS);
+
+	for (int i = 0; i < NUM_SETTINGS; i++) {
+		handles[i] = user_settings_list_get_by_id(i + 1);
+	}
+
+	return NULL;
+}
+
+ZTEST_SUITE(benchmarks, NULL, benchmarks_setup, NULL, NULL, NULL);
+
+ZTEST(benchmarks, test_get)
+{
+	struct bench b;
+	volatile uint32_t sum = 0;
+
+	bench_start(&b);
+	for (int r = 0; r < READ_REPEAT; r++) {
+		for (int i = 0; i < NUM_SETTINGS; i++) {
+			sum += *(uint32_t *)user_settings_get_with_key(keys[i], NULL);
+		}
+	}
+	bench_end(&b, "get_with_key", READ_REPEAT * NUM_SETTINGS);
+
+	bench_start(&b);
+	for (int r = 0; r < READ_REPEAT; r++) {
+		for (int i = 0; i < NUM_SETTINGS; i++) {
+			sum += *(uint32_t *)user_settings_get_with_id(i + 1, NULL);
+		}
+	}
+	bench_end(&b, "get_with_id", READ_REPEAT * NUM_SETTINGS);
+
+	/* There is no public handle API, a setting found once is the closest equivalent */
+	bench_start(&b);
+	for (int r = 0; r < READ_REPEAT; r++) {
+		for (int i = 0; i < NUM_SETTINGS; i++) {
+			sum += *(const uint32_t *)user_settings_list_value_get(handles[i], NULL);
+		}
+	}
+	bench_end(&b, "get_with_handle", READ_REPEAT * NUM_SETTINGS);
+}
+
+ZTEST(benchmarks, test_set)
+{
+	struct bench b;
+	uint32_t value;
+
+	bench_start(&b);
+	for (int i = 0; i < NUM_SETTINGS; i++) {
+		value = 1000000 + i;
+		zassert_ok(user_settings_set_with_key(keys[i], &value, sizeof(value)), "set failed");
+	}
+	bench_end(&b, "set_with_key", NUM_SETTINGS);
+
+	bench_start(&b);
+	for (int i = 0; i < NUM_SETTINGS; i++) {
+		value = 2000000 + i;
+		zassert_ok(user_settings_set_with_id(i + 1, &value, sizeof(value)), "set failed");
+	}
+	bench_end(&b, "set_with_id", NUM_SETTINGS);
+
+	/* setting the same values again must not write anything */
+	bench_start(&b);
+	for (int i = 0; i < NUM_SETTINGS; i++) {
+		value = 2000000 + i;
+		zassert_ok(user_settings_set_with_id(i + 1, &value, sizeof(value)), "set failed");
+	}
+	bench_end(&b, "set_same_value", NUM_SETTINGS);
+}
+
+ZTEST(benchmarks, test_export_import)
+{
+	struct bench b;
+	struct user_settings_json_cursor cursor = {0};
+	struct user_settings_export_cursor export_cursor = {0};
+	int len;
+
+	/* JSON */
+	size_t json_len = 0;
+	bench_start(&b);
+	while ((len = user_settings_json_write_all(&json[json_len], sizeof(json) - json_len,
+						    &cursor)) > 0) {
+		json_len += len;
+	}
+	bench_end(&b, "json_export", NUM_SETTINGS);
+	zassert_true(json_len < sizeof(json), "JSON buffer too small");
+
+	for (int i = 0; i < NUM_SETTINGS; i++) {
+		uint32_t value = 3000000 + i;
+		user_settings_set_with_id(i + 1, &value, sizeof(value));
+	}
+
+	struct user_settings_json_parser parser;
+	bench_start(&b);
+	user_settings_json_parser_init(&parser, false);
+	zassert_ok(user_settings_json_parser_feed(&parser, json, json_len), "JSON import failed");
+	zassert_ok(user_settings_json_parser_finish(&parser), "JSON import failed");
+	bench_end(&b, "json_import", NUM_SETTINGS);
+
+	/* binary */
+	size_t blob_len = 0;
+	bench_start(&b);
+	while ((len = user_settings_export_binary(&blob[blob_len], sizeof(blob) - blob_len,
+						  &export_cursor)) > 0) {
+		blob_len += len;
+	}
+	bench_end(&b, "binary_export", NUM_SETTINGS);
+	zassert_true(len == 0, "Binary buffer too small");
+
+	for (int i = 0; i < NUM_SETTINGS; i++) {
+		uint32_t value = 4000000 + i;
+		user_settings_set_with_id(i + 1, &value, sizeof(value));
+	}
+
+	bench_start(&b);
+	/* The import also allocates an export of all settings for the rollback */
+	zassert_ok(user_settings_import_binary(blob, blob_len),
+		   "Binary import failed, does the heap fit the rollback snapshot?");
+	bench_end(&b, "binary_import", NUM_SETTINGS);
+}
+
+ZTEST(benchmarks, test_restore_defaults)
+{
+	struct bench b;
+
+	bench_start(&b);
+	for (int i = 0; i < NUM_SETTINGS; i++) {
+		uint32_t value = i;
+		/* -EALREADY if a previous run already set the default */
+		user_settings_set_default_with_id(i + 1, &value, sizeof(value));
+	}
+	bench_end(&b, "set_default", NUM_SETTINGS);
+
+	for (int i = 0; i < NUM_SETTINGS; i++) {
+		uint32_t value = 5000000 + i;
+		user_settings_set_with_id(i + 1, &value, sizeof(value));
+	}
+
+	bench_start(&b);
+	user_settings_restore_defaults();
+	bench_end(&b, "restore_defaults", NUM_SETTINGS);
+
+	/* nothing differs from the defaults anymore, so nothing must be written */
+	bench_start(&b);
+	user_settings_restore_defaults();
+	bench_end(&b, "restore_defaults_noop", NUM_SETTINGS);
+}
+
+ZTEST(benchmarks, test_protocol_loopback)
+{
+	struct bench b;
+	/* type and ID of a GET command */
+	uint8_t cmd[3];
+	static uint8_t frames[NUM_SETTINGS][UART_USS_COBS_MAX_ENCODED_LEN(sizeof(cmd))];
+	static size_t frame_lens[NUM_SETTINGS];
+	uint8_t rx[sizeof(frames[0])];
+
+	/* a GET command for each setting, encoded before the measurement */
+	for (int i = 0; i < NUM_SETTINGS; i++) {
+		cmd[0] = USPC_GET;
+		sys_put_le16(i + 1, &cmd[1]);
+		frame_lens[i] = uart_uss_cobs_encode(cmd, sizeof(cmd), frames[i]);
+	}
+
+	loopback_responses = 0;
+	bench_start(&b);
+	for (int r = 0; r < READ_REPEAT; r++) {
+		for (int i = 0; i < NUM_SETTINGS; i++) {
+			loopback_execute(frames[i], frame_lens[i], rx);
+		}
+	}
+	bench_end(&b, "protocol_loopback_get", READ_REPEAT * NUM_SETTINGS);
+	zassert_equal(loopback_responses, READ_REPEAT * NUM_SETTINGS, "Responses are missing");
+
+	/* one LIST command, one response per setting */
+	cmd[0] = USPC_LIST;
+	frame_lens[0] = uart_uss_cobs_encode(cmd, 1, frames[0]);
+
+	loopback_responses = 0;
+	bench_start(&b);
+	for (int r = 0; r < READ_REPEAT; r++) {
+		loopback_execute(frames[0], frame_lens[0], rx);
+	}
+	bench_end(&b, "protocol_loopback_list", READ_REPEAT * NUM_SETTINGS);
+	zassert_equal(loopback_responses, READ_REPEAT * NUM_SETTINGS, "Responses are missing");
+}
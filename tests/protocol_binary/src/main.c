@@ -16,6 +16,20 @@ struct helper_id_value {
 	uint8_t data[100];
 } __attribute__((packed));
 
+/* The encoder reads values through the settings list, which is not part of this test. The test
+ * settings are never lazy, so their data is returned directly. */
+const void *user_settings_list_data_get(struct user_setting *us, size_t *len)
+{
+	if (!us->is_set) {
+		return NULL;
+	}
+
+	if (len) {
+		*len = us->data_len;
+	}
+	return us->data;
+}
+
 ZTEST_SUITE(protocol_binary_suite, NULL, NULL, NULL, NULL, NULL);
 
 ZTEST(protocol_binary_suite, test_bad_command_type)
@@ -41,6 +55,10 @@ ZTEST(protocol_binary_suite, test_commands_without_id)
 		USPC_LIST,
 		USPC_LIST_FULL,
 		USPC_RESTORE,
+		USPC_LIST_CHANGED,
+		USPC_LIST_CHANGED_FULL,
+		USPC_EXPORT,
+		USPC_IMPORT_COMMIT,
 	};
 
 	for (int i = 0; i < ARRAY_SIZE(cmds_without_id); i++) {
@@ -60,6 +78,7 @@ ZTEST(protocol_binary_suite, test_commands_with_id)
 	struct helper_id_only cmds_with_id[] = {
 		{USPC_GET, 1},
 		{USPC_GET_FULL, 2},
+		{USPC_WRITE_COMMIT, 3},
 	};
 
 	for (int i = 0; i < ARRAY_SIZE(cmds_with_id); i++) {
@@ -112,6 +131,107 @@ ZTEST(protocol_binary_suite, test_commands_with_id_and_value)
 	}
 }
 
+ZTEST(protocol_binary_suite, test_import_command)
+{
+	int err;
+	struct user_settings_protocol_command cmd;
+
+	/* chunk 0xAA 0xBB at offset 0x0102 */
+	uint8_t import[] = {USPC_IMPORT, 6, 0x02, 0x01, 0x00, 0x00, 0xAA, 0xBB};
+	err = user_settings_protocol_binary_decode_command(import, sizeof(import), &cmd);
+	zassert_equal(err, sizeof(import), "All bytes should be decoded");
+	zassert_equal(cmd.type, USPC_IMPORT, "type should be parsed correctly");
+	zassert_equal(cmd.value_len, 6, "value length should be parsed correctly");
+	zassert_mem_equal(cmd.value, &import[2], 6, "value should hold the offset and the chunk");
+
+	/* the length must match the command and hold at least the offset and one byte */
+	err = user_settings_protocol_binary_decode_command(import, sizeof(import) - 1, &cmd);
+	zassert_true(err < 0, "Decoding should fail on a truncated command");
+	err = user_settings_protocol_binary_decode_command(import, 6, &cmd);
+	zassert_true(err < 0, "Decoding should fail without chunk data");
+}
+
+ZTEST(protocol_binary_suite, test_chunked_commands)
+{
+	int err;
+	struct user_settings_protocol_command cmd;
+
+	/* read up to 200 bytes at offset 0x0190 of setting 11 */
+	uint8_t read_at[] = {USPC_READ_AT, 0x0B, 0x00, 0x90, 0x01, 0x00, 0x00, 0xC8};
+	err = user_settings_protocol_binary_decode_command(read_at, sizeof(read_at), &cmd);
+	zassert_equal(err, sizeof(read_at), "All bytes should be decoded");
+	zassert_equal(cmd.type, USPC_READ_AT, "type should be parsed correctly");
+	zassert_equal(cmd.id, 11, "Id should be parsed correctly");
+	zassert_equal(cmd.value_len, 5, "value should hold the offset and the length");
+	zassert_mem_equal(cmd.value, &read_at[3], 5, "value should hold the offset and the length");
+
+	err = user_settings_protocol_binary_decode_command(read_at, sizeof(read_at) - 1, &cmd);
+	zassert_true(err < 0, "Decoding should fail on a truncated command");
+
+	/* write chunk 0xAA 0xBB at offset 0x0102 of setting 11 */
+	uint8_t write_at[] = {USPC_WRITE_AT, 0x0B, 0x00, 6, 0x02, 0x01, 0x00, 0x00, 0xAA, 0xBB};
+	err = user_settings_protocol_binary_decode_command(write_at, sizeof(write_at), &cmd);
+	zassert_equal(err, sizeof(write_at), "All bytes should be decoded");
+	zassert_equal(cmd.type, USPC_WRITE_AT, "type should be parsed correctly");
+	zassert_equal(cmd.id, 11, "Id should be parsed correctly");
+	zassert_equal(cmd.value_len, 6, "value length should be parsed correctly");
+	zassert_mem_equal(cmd.value, &write_at[4], 6, "value should hold the offset and the chunk");
+
+	err = user_settings_protocol_binary_decode_command(write_at, sizeof(write_at) - 1, &cmd);
+	zassert_true(err < 0, "Decoding should fail on a truncated command");
+	err = user_settings_protocol_binary_decode_command(write_at, 8, &cmd);
+	zassert_true(err < 0, "Decoding should fail without chunk data");
+}
+
+ZTEST(protocol_binary_suite, test_commands_with_sequence_number)
+{
+	int err;
+	struct user_settings_protocol_command cmd;
+
+	/* GET id 13 with sequence number 0x1234 */
+	uint8_t get[] = {USPC_GET | USP_BINARY_SEQ_FLAG, 0x34, 0x12, 0x0D, 0x00};
+	err = user_settings_protocol_binary_decode_command(get, sizeof(get), &cmd);
+	zassert_equal(err, sizeof(get), "All bytes should be decoded");
+	zassert_equal(cmd.type, USPC_GET, "type should be parsed without the sequence flag");
+	zassert_true(cmd.has_seq, "sequence number should be present");
+	zassert_equal(cmd.seq, 0x1234, "sequence number should be parsed correctly");
+	zassert_equal(cmd.id, 13, "Id should be parsed correctly");
+
+	/* Sequence number missing */
+	err = user_settings_protocol_binary_decode_command(get, 2, &cmd);
+	zassert_equal(err, -EPROTO, "Decoding should fail without a full sequence number");
+
+	/* Commands without the flag have no sequence number */
+	uint8_t plain_get[] = {USPC_GET, 0x0D, 0x00};
+	err = user_settings_protocol_binary_decode_command(plain_get, sizeof(plain_get), &cmd);
+	zassert_equal(err, sizeof(plain_get), "All bytes should be decoded");
+	zassert_false(cmd.has_seq, "sequence number should not be present");
+}
+
+ZTEST(protocol_binary_suite, test_encode_response_header)
+{
+	int err;
+	uint8_t buffer[4];
+	struct user_settings_protocol_command cmd = {
+		.type = USPC_SET,
+		.has_seq = true,
+		.seq = 0x0102,
+	};
+
+	err = user_settings_protocol_binary_encode_header(&cmd, USP_RESPONSE_DATA, 0, buffer,
+							  sizeof(buffer));
+	zassert_equal(err, 3, "data header should be 3 bytes");
+	zassert_mem_equal(buffer, ((uint8_t[]){0x02, 0x01, 0x00}), 3, "wrong data header");
+
+	err = user_settings_protocol_binary_encode_header(&cmd, USP_RESPONSE_DONE, -ENOENT, buffer,
+							  sizeof(buffer));
+	zassert_equal(err, 4, "done header should be 4 bytes");
+	zassert_mem_equal(buffer, ((uint8_t[]){0x02, 0x01, 0x01, ENOENT}), 4, "wrong done header");
+
+	err = user_settings_protocol_binary_encode_header(&cmd, USP_RESPONSE_DONE, 0, buffer, 3);
+	zassert_equal(err, -ENOMEM, "encoding should fail when buffer is to small");
+}
+
 ZTEST(protocol_binary_suite, test_user_setting_encode_buffer_to_small)
 {
 	int err;
@@ -349,6 +469,72 @@ ZTEST(protocol_binary_suite, test_user_setting_encode_correct_bytes_full)
 	zassert_equal(buffer[13], us.max_size, "max size should be here");
 }
 
+ZTEST(protocol_binary_suite, test_user_setting_encode_long_value)
+{
+	int err;
+	uint8_t buffer[255];
+
+	/* values longer than 255 bytes do not fit the length byte */
+	static uint8_t value[300];
+	static uint8_t default_value[256];
+
+	struct user_setting us = {
+		.id = 1,
+		.key = "1",
+		.type = USER_SETTINGS_TYPE_BYTES,
+		.max_size = sizeof(value),
+		.data = value,
+		.data_len = sizeof(value),
+		.is_set = true,
+		.default_data = default_value,
+		.default_data_len = sizeof(default_value),
+		.default_is_set = true,
+	};
+
+	err = user_settings_protocol_binary_encode(&us, buffer, sizeof(buffer));
+	zassert_equal(err, 6, "encoding should take exactly 6 bytes (got: %d)", err);
+	zassert_equal(buffer[5], 0, "a long value should be encoded without a value");
+
+	err = user_settings_protocol_binary_encode_full(&us, buffer, sizeof(buffer));
+	zassert_equal(err, 8, "encoding should take exactly 8 bytes (got: %d)", err);
+	zassert_equal(buffer[5], 0, "a long value should be encoded without a value");
+	zassert_equal(buffer[6], 0, "a long default should be encoded without a value");
+	zassert_equal(buffer[7], UINT8_MAX, "max size should be clamped");
+}
+
+ZTEST(protocol_binary_suite, test_user_setting_encode_array_full)
+{
+	int err;
+	uint8_t buffer[255];
+
+	/* create valid array user setting */
+	uint16_t value[] = {1, 2, 3};
+
+	struct user_setting us = {
+		.id = 1,
+		.key = "1",
+		.type = USER_SETTINGS_TYPE_ARRAY,
+		.elem_type = USER_SETTINGS_TYPE_U16,
+		.max_size = sizeof(value),
+		.data = value,
+		.data_len = sizeof(value),
+		.is_set = true,
+		.default_is_set = false,
+	};
+
+	err = user_settings_protocol_binary_encode_full(&us, buffer, 14);
+	zassert_equal(err, -ENOMEM, "encoding should fail without space for the element type");
+
+	err = user_settings_protocol_binary_encode_full(&us, buffer, sizeof(buffer));
+	zassert_equal(err, 15, "encoding should take exactly 15 bytes (got: %d)", err);
+	zassert_equal(buffer[4], us.type, "Type should be here");
+	zassert_equal(buffer[5], us.data_len, "length should be here");
+	zassert_mem_equal(&buffer[6], value, sizeof(value), "Value should be here");
+	zassert_equal(buffer[12], 0, "default length should be 0");
+	zassert_equal(buffer[13], us.max_size, "max size should be here");
+	zassert_equal(buffer[14], USER_SETTINGS_TYPE_U16, "element type should follow max size");
+}
+
 /* TODO: test list_some commands */
 /* TODO: test that the number of bytes decoded is correct for each command */
 
@@ -0,0 +1,77 @@
+#include <uart_uss_cobs.h>
+
+#include <errno.h>
+#include <string.h>
+#include <zephyr/ztest.h>
+
+ZTEST_SUITE(uart_uss_cobs_suite, NULL, NULL, NULL, NULL, NULL);
+
+/**
+ * @brief Encode @p data, compare it with @p expected and decode it back
+ */
+static void helper_check_vector(const uint8_t *data, size_t len, const uint8_t *expected,
+				size_t expected_len)
+{
+	uint8_t encoded[UART_USS_COBS_MAX_ENCODED_LEN(8)];
+
+	size_t encoded_len = uart_uss_cobs_encode(data, len, encoded);
+	zassert_equal(encoded_len, expected_len, "Encoded length should be %zu, is %zu",
+		      expected_len, encoded_len);
+	zassert_mem_equal(encoded, expected, expected_len, "Encoding is not correct");
+
+	/* the delimiter is not passed to the decoder */
+	int ret = uart_uss_cobs_decode(encoded, encoded_len - 1);
+	zassert_equal(ret, len, "Decoded length should be %zu, is %d", len, ret);
+	zassert_mem_equal(encoded, data, len, "Decoded data should match the original");
+}
+
+ZTEST(uart_uss_cobs_suite, test_vectors)
+{
+	helper_check_vector((uint8_t[]){0x00}, 0, (uint8_t[]){0x01, 0x00}, 2);
+	helper_check_vector((uint8_t[]){0x00}, 1, (uint8_t[]){0x01, 0x01, 0x00}, 3);
+	helper_check_vector((uint8_t[]){0x00, 0x00}, 2, (uint8_t[]){0x01, 0x01, 0x01, 0x00}, 4);
+	helper_check_vector((uint8_t[]){0x11, 0x22, 0x00, 0x33}, 4,
+			    (uint8_t[]){0x03, 0x11, 0x22, 0x02, 0x33, 0x00}, 6);
+	helper_check_vector((uint8_t[]){0x11, 0x22, 0x33, 0x44}, 4,
+			    (uint8_t[]){0x05, 0x11, 0x22, 0x33, 0x44, 0x00}, 6);
+	helper_check_vector((uint8_t[]){0x11, 0x00, 0x00, 0x00}, 4,
+			    (uint8_t[]){0x02, 0x11, 0x01, 0x01, 0x01, 0x00}, 6);
+}
+
+ZTEST(uart_uss_cobs_suite, test_long_runs)
+{
+	/* runs of 254 and more non-zero bytes need an extra code byte */
+	uint8_t data[600];
+	uint8_t encoded[UART_USS_COBS_MAX_ENCODED_LEN(sizeof(data))];
+
+	for (size_t len = 250; len <= sizeof(data); len++) {
+		for (size_t i = 0; i < len; i++) {
+			/* zeros only near the end, so the first run is as long as possible */
+			data[i] = i < len - 50 ? (i % 255) + 1 : (i * 7) % 5;
+		}
+
+		size_t encoded_len = uart_uss_cobs_encode(data, len, encoded);
+		zassert_true(encoded_len <= UART_USS_COBS_MAX_ENCODED_LEN(len),
+			     "Encoding of %zu bytes is too long: %zu", len, encoded_len);
+		zassert_equal(encoded[encoded_len - 1], 0x00, "Frame should end with a delimiter");
+		zassert_is_null(memchr(encoded, 0x00, encoded_len - 1),
+				"Frame should not contain a 0x00 before the delimiter");
+
+		int ret = uart_uss_cobs_decode(encoded, encoded_len - 1);
+		zassert_equal(ret, len, "Decoded length should be %zu, is %d", len, ret);
+		zassert_mem_equal(encoded, data, len, "Decoded data should match the original");
+	}
+}
+
+ZTEST(uart_uss_cobs_suite, test_decode_invalid)
+{
+	/* a zero code byte can not appear inside a frame */
+	uint8_t zero_code[] = {0x02, 0x11, 0x00, 0x22};
+	zassert_equal(uart_uss_cobs_decode(zero_code, sizeof(zero_code)), -EPROTO,
+		      "Decoding should fail on a zero code byte");
+
+	/* the code byte points past the end of the frame */
+	uint8_t too_short[] = {0x05, 0x11, 0x22};
+	zassert_equal(uart_uss_cobs_decode(too_short, sizeof(too_short)), -EPROTO,
+		      "Decoding should fail if the frame is too short");
+}
@@ -1,10 +1,61 @@
 #include <user_settings.h>
+#include <user_settings_cron.h>
 #include <user_settings_list.h>
+#include <user_settings_stats.h>
 
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/crc.h>
 #include <zephyr/ztest.h>
 #include <zephyr/ztest_error_hook.h>
 
-#define NUM_SETTINGS 5
+#define NUM_SETTINGS 10
+
+static int on_load_calls;
+struct test_record {
+	float gain;
+	int16_t offset;
+	bool enabled;
+};
+
+static const struct user_settings_record_field test_record_fields[] = {
+	USER_SETTINGS_RECORD_FIELD(struct test_record, gain, USER_SETTINGS_TYPE_F32),
+	USER_SETTINGS_RECORD_FIELD(struct test_record, offset, USER_SETTINGS_TYPE_I16),
+	USER_SETTINGS_RECORD_FIELD(struct test_record, enabled, USER_SETTINGS_TYPE_BOOL),
+};
+
+static uint16_t on_load_max_id;
+static uint32_t on_load_bitmap[NUM_SETTINGS / 32 + 1];
+static bool on_load_is_set[NUM_SETTINGS + 1];
+static void on_load(const uint32_t *loaded, uint16_t max_id)
+{
+	on_load_calls++;
+	on_load_max_id = max_id;
+
+	/* the bitmap is only valid during the call, and NULL if it could not be allocated */
+	if (loaded) {
+		memcpy(on_load_bitmap, loaded, sizeof(on_load_bitmap));
+	}
+	for (uint16_t id = 1; id <= NUM_SETTINGS; id++) {
+		on_load_is_set[id] = user_settings_list_get_by_id(id)->is_set;
+	}
+}
+
+/* on change callbacks called during the load */
+static int on_change_load_calls;
+static void on_change_load(uint32_t id, const char *key)
+{
+	on_change_load_calls++;
+}
+
+/* Wait for the on change callbacks, they are called from a work queue with
+ * CONFIG_USER_SETTINGS_NOTIFY_ASYNC */
+static void wait_for_callbacks(void)
+{
+#if defined(CONFIG_USER_SETTINGS_NOTIFY_ASYNC)
+	k_work_queue_drain(&k_sys_work_q, false);
+#endif
+}
 
 static void *user_settings_suite_setup(void)
 {
@@ -16,8 +67,24 @@ static void *user_settings_suite_setup(void)
 	user_settings_add(3, "t3", USER_SETTINGS_TYPE_I8);
 	user_settings_add_sized(4, "t4", USER_SETTINGS_TYPE_STR, 10);
 	user_settings_add(5, "t5", USER_SETTINGS_TYPE_U32);
-
+	user_settings_add_sized(6, "t6", USER_SETTINGS_TYPE_BYTES, 64);
+	user_settings_set_lazy_with_id(6);
+	user_settings_add_array(7, "t7", USER_SETTINGS_TYPE_U16, 4);
+	user_settings_add_record(8, "t8", test_record_fields, ARRAY_SIZE(test_record_fields),
+				 sizeof(struct test_record));
+	user_settings_add(9, "t9", USER_SETTINGS_TYPE_CRON_JOB);
+	/* never has a value, only used by test_settings_import_binary_rollback */
+	user_settings_add(10, "t10", USER_SETTINGS_TYPE_U32);
+
+	/* store a value as a previous boot would have, so the load has something to report */
+	bool stored_value1 = true;
+	settings_save_one("user/t1", &stored_value1, sizeof(stored_value1));
+
+	user_settings_set_on_load_cb(on_load);
+	user_settings_set_global_on_change_cb(on_change_load);
 	user_settings_load();
+	wait_for_callbacks();
+	user_settings_set_global_on_change_cb(NULL);
 
 	return NULL;
 }
@@ -26,6 +93,7 @@ void user_settings_suite_before_each(void *fixture)
 {
 	/* create default state for each setting */
 	user_settings_set_global_on_change_cb(NULL);
+	user_settings_set_batch_on_change_cb(NULL);
 	user_settings_set_on_change_cb_with_id(1, NULL);
 	user_settings_set_on_change_cb_with_id(2, NULL);
 	user_settings_set_on_change_cb_with_id(3, NULL);
@@ -39,11 +107,42 @@ void user_settings_suite_before_each(void *fixture)
 	user_settings_set_with_id(3, &value3, 1);
 	char value4[] = "";
 	user_settings_set_with_id(4, &value4, strlen(value4) + 1);
+
+	wait_for_callbacks();
 }
 
 ZTEST_SUITE(user_settings_suite, NULL, user_settings_suite_setup, user_settings_suite_before_each,
 	    NULL, NULL);
 
+ZTEST(user_settings_suite, test_settings_on_load_cb)
+{
+	zassert_equal(on_load_calls, 1, "On load callback should be called once");
+	zassert_equal(on_load_max_id, NUM_SETTINGS, "Max ID should be %d", NUM_SETTINGS);
+
+	zassert_true(on_load_bitmap[0] & BIT(1), "The stored setting should be loaded");
+	zassert_false(on_load_bitmap[0] & BIT(0), "There is no setting with ID 0");
+	for (uint16_t id = 1; id <= NUM_SETTINGS; id++) {
+		bool loaded = on_load_bitmap[id / 32] & BIT(id % 32);
+		zassert_equal(loaded, on_load_is_set[id], "Bit %d should match the loaded value", id);
+	}
+	zassert_equal(on_load_bitmap[0] & ~BIT_MASK(NUM_SETTINGS + 1), 0,
+		      "No bits should be set above the max ID");
+}
+
+ZTEST(user_settings_suite, test_settings_load_quiet)
+{
+	int loaded = 0;
+	for (uint16_t id = 1; id <= NUM_SETTINGS; id++) {
+		loaded += on_load_is_set[id];
+	}
+
+	if (IS_ENABLED(CONFIG_USER_SETTINGS_LOAD_QUIET)) {
+		zassert_equal(on_change_load_calls, 0, "Loaded values should not notify");
+	} else {
+		zassert_equal(on_change_load_calls, loaded, "Each loaded value should notify");
+	}
+}
+
 ZTEST(user_settings_suite, test_settings_exist)
 {
 	zassert_equal(user_settings_exists_with_id(1), true, "Setting should exist");
@@ -182,6 +281,54 @@ ZTEST(user_settings_suite, test_settings_restore_one)
 		      default_value);
 }
 
+ZTEST(user_settings_suite, test_settings_restore_at_default_writes_nothing)
+{
+	struct user_settings_wear_stats before;
+	struct user_settings_wear_stats after;
+
+	/* make sure the setting has a default, it might already be set by another test */
+	int8_t default_value = 0;
+	user_settings_set_default_with_id(3, &default_value, sizeof(default_value));
+	default_value = *(int8_t *)user_settings_get_default_with_id(3, NULL);
+
+	/* set the value to the default explicitly and clear the changed flag */
+	user_settings_set_with_id(3, &default_value, sizeof(default_value));
+	user_settings_clear_changed_with_id(3);
+
+	user_settings_get_wear_stats_with_id(3, &before);
+	zassert_ok(user_settings_restore_default_with_id(3), "Restore should succeed");
+	user_settings_restore_defaults();
+	user_settings_get_wear_stats_with_id(3, &after);
+
+	zassert_equal(after.writes, before.writes, "A value at its default should not be written");
+	zassert_true(user_settings_is_set_with_id(3), "The value should not be deleted");
+	zassert_false(user_settings_list_get_by_id(3)->has_changed_recently,
+		      "The changed flag should not be set");
+}
+
+ZTEST(user_settings_suite, test_settings_restore_frees_value)
+{
+	int8_t default_value = 0;
+	user_settings_set_default_with_id(3, &default_value, sizeof(default_value));
+	default_value = *(int8_t *)user_settings_get_default_with_id(3, NULL);
+
+	int8_t value = default_value + 1;
+	zassert_ok(user_settings_set_with_id(3, &value, sizeof(value)), "Set should succeed");
+	zassert_not_null(user_settings_list_get_by_id(3)->data, "The value should have space");
+
+	zassert_ok(user_settings_restore_default_with_id(3), "Restore should succeed");
+
+	/* with and without CONFIG_USER_SETTINGS_RESTORE_DELETE, the value uses the default */
+	zassert_is_null(user_settings_list_get_by_id(3)->data, "The value space should be freed");
+	zassert_equal(*(int8_t *)user_settings_get_with_id(3, NULL), default_value,
+		      "The value should be the default value");
+
+	/* setting the value again gives it space of its own */
+	zassert_ok(user_settings_set_with_id(3, &value, sizeof(value)), "Set should succeed");
+	zassert_equal(*(int8_t *)user_settings_get_with_id(3, NULL), value,
+		      "The value should be the new value");
+}
+
 static uint32_t on_change_id_store;
 static const char *on_change_key_store;
 void on_change(uint32_t id, const char *key)
@@ -196,6 +343,7 @@ ZTEST(user_settings_suite, test_settings_on_change)
 
 	uint32_t value = 1337;
 	user_settings_set_with_id(2, &value, 4);
+	wait_for_callbacks();
 
 	zassert_equal(on_change_id_store, 2, "On change callback should have been called");
 	zassert_ok(strcmp(on_change_key_store, "t2"), "On change callback should have been called");
@@ -207,6 +355,7 @@ ZTEST(user_settings_suite, test_settings_global_on_change)
 
 	uint32_t value = 1337;
 	user_settings_set_with_id(2, &value, 4);
+	wait_for_callbacks();
 
 	zassert_equal(on_change_id_store, 2, "global on change callback should have been called");
 	zassert_ok(strcmp(on_change_key_store, "t2"),
@@ -214,11 +363,171 @@ ZTEST(user_settings_suite, test_settings_global_on_change)
 
 	int8_t value2 = -1;
 	user_settings_set_with_id(3, &value2, 1);
+	wait_for_callbacks();
 	zassert_equal(on_change_id_store, 3, "global on change callback should have been called");
 	zassert_ok(strcmp(on_change_key_store, "t3"),
 		   "global on change callback should have been called");
 }
 
+static uint16_t on_change_batch_ids[NUM_SETTINGS];
+static size_t on_change_batch_count;
+void on_change_batch(const uint16_t *ids, size_t count)
+{
+	memcpy(on_change_batch_ids, ids, count * sizeof(ids[0]));
+	on_change_batch_count = count;
+}
+
+ZTEST(user_settings_suite, test_settings_batch_on_change)
+{
+	user_settings_set_batch_on_change_cb(on_change_batch);
+
+	on_change_batch_count = 0;
+	uint32_t value = 4242;
+	user_settings_set_with_id(2, &value, 4);
+	wait_for_callbacks();
+
+	/* a single change is a batch of one, also with CONFIG_USER_SETTINGS_NOTIFY_ASYNC */
+	zassert_equal(on_change_batch_count, 1, "Batch should hold one setting");
+	zassert_equal(on_change_batch_ids[0], 2, "Batch should hold the changed setting");
+
+	/* setting the same value does not notify */
+	on_change_batch_count = 0;
+	user_settings_set_with_id(2, &value, 4);
+	wait_for_callbacks();
+	zassert_equal(on_change_batch_count, 0, "Batch callback should not have been called");
+}
+
+#if defined(CONFIG_USER_SETTINGS_NOTIFY_ASYNC)
+static K_THREAD_STACK_DEFINE(async_work_q_stack, 1024);
+static struct k_work_q async_work_q;
+static struct k_work async_block_work;
+static K_SEM_DEFINE(async_block_sem, 0, 1);
+
+/* Keeps the work queue busy, so changes are queued until the semaphore is given */
+static void async_block(struct k_work *work)
+{
+	k_sem_take(&async_block_sem, K_FOREVER);
+}
+
+static int on_change_async_calls[NUM_SETTINGS + 1];
+void on_change_async(uint32_t id, const char *key)
+{
+	on_change_async_calls[id]++;
+}
+
+static size_t on_change_async_batches;
+static size_t on_change_async_batch_max;
+void on_change_async_batch(const uint16_t *ids, size_t count)
+{
+	on_change_async_batches++;
+	on_change_async_batch_max = MAX(on_change_async_batch_max, count);
+}
+
+ZTEST(user_settings_suite, test_settings_notify_async)
+{
+	memset(on_change_async_calls, 0, sizeof(on_change_async_calls));
+	on_change_async_batches = 0;
+	on_change_async_batch_max = 0;
+
+	k_work_queue_start(&async_work_q, async_work_q_stack,
+			   K_THREAD_STACK_SIZEOF(async_work_q_stack), K_PRIO_PREEMPT(1), NULL);
+	k_work_init(&async_block_work, async_block);
+	k_work_submit_to_queue(&async_work_q, &async_block_work);
+
+	user_settings_set_notify_work_q(&async_work_q);
+	user_settings_set_global_on_change_cb(on_change_async);
+	user_settings_set_batch_on_change_cb(on_change_async_batch);
+
+	/* changes of a queued setting are coalesced */
+	for (uint32_t value2 = 1; value2 <= 3; value2++) {
+		user_settings_set_with_id(2, &value2, sizeof(value2));
+	}
+
+	/* more changed settings than CONFIG_USER_SETTINGS_NOTIFY_ASYNC_EVENTS overflow the queue */
+	bool value1 = true;
+	user_settings_set_with_id(1, &value1, sizeof(value1));
+	int8_t value3 = 1;
+	user_settings_set_with_id(3, &value3, sizeof(value3));
+	char value4[] = "async";
+	user_settings_set_with_id(4, value4, sizeof(value4));
+	const uint32_t *current5 = user_settings_get_with_id(5, NULL);
+	uint32_t value5 = current5 ? *current5 + 1 : 0;
+	user_settings_set_with_id(5, &value5, sizeof(value5));
+
+	zassert_equal(on_change_async_batches, 0, "No callback should be called before the work");
+
+	k_sem_give(&async_block_sem);
+	k_work_queue_drain(&async_work_q, false);
+
+	for (uint16_t id = 1; id <= 5; id++) {
+		zassert_equal(on_change_async_calls[id], 1, "Setting %d should be notified once (%d)",
+			      id, on_change_async_calls[id]);
+	}
+	zassert_true(on_change_async_batches > 1, "The overflow should take more batches");
+	zassert_true(on_change_async_batch_max <= CONFIG_USER_SETTINGS_NOTIFY_ASYNC_EVENTS,
+		     "A batch should not be larger than the queue");
+
+	user_settings_set_notify_work_q(NULL);
+}
+#endif /* CONFIG_USER_SETTINGS_NOTIFY_ASYNC */
+
+static int subscriber_a_calls;
+static int subscriber_b_calls;
+static int subscriber_range_calls;
+void on_change_subscriber_a(uint32_t id, const char *key)
+{
+	subscriber_a_calls++;
+}
+void on_change_subscriber_b(uint32_t id, const char *key)
+{
+	subscriber_b_calls++;
+}
+void on_change_subscriber_range(uint32_t id, const char *key)
+{
+	subscriber_range_calls++;
+}
+
+ZTEST(user_settings_suite, test_settings_subscriptions)
+{
+	struct user_settings_subscription sub_a;
+	struct user_settings_subscription sub_b;
+	struct user_settings_subscription sub_range;
+	struct user_settings_subscription sub_prefix;
+
+	user_settings_subscribe_with_id(&sub_a, 2, on_change_subscriber_a);
+	user_settings_subscribe_with_key(&sub_b, "t2", on_change_subscriber_b);
+	user_settings_subscribe_id_range(&sub_range, 2, 3, on_change_subscriber_range);
+	user_settings_subscribe_key_prefix(&sub_prefix, "t", on_change);
+
+	subscriber_a_calls = 0;
+	subscriber_b_calls = 0;
+	subscriber_range_calls = 0;
+
+	uint32_t value2 = 7;
+	user_settings_set_with_id(2, &value2, sizeof(value2));
+	int8_t value3 = 7;
+	user_settings_set_with_id(3, &value3, sizeof(value3));
+	wait_for_callbacks();
+
+	zassert_equal(subscriber_a_calls, 1, "Both subscribers of a setting should be called");
+	zassert_equal(subscriber_b_calls, 1, "Both subscribers of a setting should be called");
+	zassert_equal(subscriber_range_calls, 2, "Range subscriber should be called for each");
+	zassert_equal(on_change_id_store, 3, "Prefix subscriber should have been called");
+
+	/* removed subscriptions are not called anymore */
+	user_settings_unsubscribe(&sub_a);
+	user_settings_unsubscribe(&sub_range);
+	value2 = 8;
+	user_settings_set_with_id(2, &value2, sizeof(value2));
+	wait_for_callbacks();
+	zassert_equal(subscriber_a_calls, 1, "Removed subscriber should not be called");
+	zassert_equal(subscriber_b_calls, 2, "Remaining subscriber should still be called");
+	zassert_equal(subscriber_range_calls, 2, "Removed subscriber should not be called");
+
+	user_settings_unsubscribe(&sub_b);
+	user_settings_unsubscribe(&sub_prefix);
+}
+
 ZTEST(user_settings_suite, test_settings_callback_is_called_on_restore)
 {
 	/* Set default value */
@@ -228,21 +537,142 @@ ZTEST(user_settings_suite, test_settings_callback_is_called_on_restore)
 	/* set value different from default */
 	bool value = true;
 	user_settings_set_with_id(1, &value, sizeof(value));
+	wait_for_callbacks();
 
 	/* Register callback for setting */
 	user_settings_set_on_change_cb_with_id(1, on_change);
 
 	/* restore */
 	user_settings_restore_default_with_id(1);
+	wait_for_callbacks();
 	/* callback should be triggered */
 	zassert_equal(on_change_id_store, 1, "on change callback should have been called");
 
 	/* restoring again should not trigger callback */
 	on_change_id_store = 0;
 	user_settings_restore_default_with_id(1);
+	wait_for_callbacks();
 	zassert_equal(on_change_id_store, 0, "on change callback should not have been called");
 }
 
+static int restore_all_cb_count;
+static bool restore_all_cb_saw_final_state;
+void on_change_restore_all(uint32_t id, const char *key)
+{
+	if (restore_all_cb_count++ > 0) {
+		return;
+	}
+
+	/* both settings must already be restored when the first callback is called */
+	restore_all_cb_saw_final_state =
+		*(uint32_t *)user_settings_get_with_id(2, NULL) ==
+			*(uint32_t *)user_settings_get_default_with_id(2, NULL) &&
+		*(int8_t *)user_settings_get_with_id(3, NULL) ==
+			*(int8_t *)user_settings_get_default_with_id(3, NULL);
+}
+
+ZTEST(user_settings_suite, test_settings_restore_all_defers_callbacks)
+{
+	/* make sure both settings have a default, it might already be set by another test */
+	uint32_t default_value2 = 2;
+	int8_t default_value3 = 3;
+	user_settings_set_default_with_id(2, &default_value2, sizeof(default_value2));
+	user_settings_set_default_with_id(3, &default_value3, sizeof(default_value3));
+
+	/* set values different from the defaults */
+	uint32_t value2 = *(uint32_t *)user_settings_get_default_with_id(2, NULL) + 1;
+	int8_t value3 = *(int8_t *)user_settings_get_default_with_id(3, NULL) + 1;
+	user_settings_set_with_id(2, &value2, sizeof(value2));
+	user_settings_set_with_id(3, &value3, sizeof(value3));
+	wait_for_callbacks();
+
+	restore_all_cb_count = 0;
+	user_settings_set_on_change_cb_with_id(2, on_change_restore_all);
+	user_settings_set_on_change_cb_with_id(3, on_change_restore_all);
+
+	user_settings_restore_defaults();
+	wait_for_callbacks();
+
+	zassert_equal(restore_all_cb_count, 2, "Each restored setting should be notified once");
+	zassert_true(restore_all_cb_saw_final_state,
+		     "Callbacks should be called after all settings are restored");
+
+	/* restoring again should not write or notify anything */
+	restore_all_cb_count = 0;
+	user_settings_restore_defaults();
+	wait_for_callbacks();
+	zassert_equal(restore_all_cb_count, 0, "Restoring twice should not notify");
+}
+
+ZTEST(user_settings_suite, test_settings_lazy)
+{
+	uint8_t value[64];
+	uint8_t out[64];
+	size_t len;
+
+	memset(value, 0xA5, sizeof(value));
+	zassert_ok(user_settings_set_with_id(6, value, sizeof(value)), "set should not error here");
+
+	/* read into a caller buffer */
+	zassert_equal(user_settings_read_with_id(6, out, sizeof(out)), sizeof(value),
+		      "Whole value should be read");
+	zassert_mem_equal(out, value, sizeof(value), "Read value should match");
+	zassert_equal(user_settings_read_with_id(6, out, sizeof(out) - 1), -ENOMEM,
+		      "Reading into a too small buffer should fail");
+
+	/* get fetches the value into the cache */
+	uint8_t *cached = user_settings_get_with_id(6, &len);
+	zassert_not_null(cached, "Lazy value should be fetched");
+	zassert_equal(len, sizeof(value), "Length should match");
+	zassert_mem_equal(cached, value, sizeof(value), "Fetched value should match");
+
+	/* a new value replaces the cached one */
+	value[0] = 0x11;
+	zassert_ok(user_settings_set_with_id(6, value, sizeof(value)), "set should not error here");
+	cached = user_settings_get_with_id(6, NULL);
+	zassert_equal(cached[0], 0x11, "New value should be fetched");
+}
+
+ZTEST(user_settings_suite, test_settings_read_write_at)
+{
+	uint8_t value[64];
+	uint8_t chunk[10];
+
+	for (int i = 0; i < sizeof(value); i++) {
+		value[i] = i;
+	}
+
+	/* write in chunks, nothing is stored until commit */
+	zassert_equal(user_settings_write_commit_with_id(6), -EINVAL,
+		      "Commit without a write should fail");
+	for (size_t offset = 0; offset < sizeof(value); offset += sizeof(chunk)) {
+		size_t len = MIN(sizeof(chunk), sizeof(value) - offset);
+		zassert_ok(user_settings_write_at_with_id(6, offset, &value[offset], len),
+			   "write_at should not error here");
+	}
+	zassert_equal(user_settings_write_at_with_id(6, 3, value, 1), -EINVAL,
+		      "Chunks must follow each other");
+	zassert_ok(user_settings_write_commit_with_id(6), "Commit should succeed");
+
+	/* read back in chunks */
+	int len = user_settings_read_at_with_id(6, 60, chunk, sizeof(chunk));
+	zassert_equal(len, 4, "Last chunk should be shorter");
+	zassert_mem_equal(chunk, &value[60], 4, "Chunk should match");
+	zassert_equal(user_settings_read_at_with_id(6, 64, chunk, sizeof(chunk)), 0,
+		      "Reading past the end should return 0");
+
+	/* a write larger than the setting is discarded */
+	zassert_ok(user_settings_write_at_with_id(6, 0, value, sizeof(value)), "write_at failed");
+	zassert_equal(user_settings_write_at_with_id(6, sizeof(value), value, 1), -ENOMEM,
+		      "Value larger than max size should fail");
+	zassert_equal(user_settings_write_commit_with_id(6), -EINVAL,
+		      "Discarded write should not be committed");
+
+	/* only string and bytes settings can be accessed in chunks */
+	zassert_equal(user_settings_read_at_with_id(2, 0, chunk, sizeof(chunk)), -EINVAL,
+		      "Chunked read of a u32 should fail");
+}
+
 ZTEST(user_settings_suite, test_settings_get_max_len)
 {
 	/* Each user setting should return the correct max length */
@@ -327,7 +757,27 @@ ZTEST(user_settings_suite, test_settings_iter_correct_key_and_id)
 	zassert_equal(id, 5, "Id should be 5, was %d", id);
 	zassert_ok(strcmp(key, "t5"), "Key should be t5, was: %s", key);
 
-	/* Since we have 5 settings, we should get NULL here */
+	ret = user_settings_iter_next(&key, &id);
+	zassert_true(ret, "Return value should be true");
+	zassert_equal(id, 6, "Id should be 6, was %d", id);
+	zassert_ok(strcmp(key, "t6"), "Key should be t6, was: %s", key);
+
+	ret = user_settings_iter_next(&key, &id);
+	zassert_true(ret, "Return value should be true");
+	zassert_equal(id, 7, "Id should be 7, was %d", id);
+	zassert_ok(strcmp(key, "t7"), "Key should be t7, was: %s", key);
+
+	ret = user_settings_iter_next(&key, &id);
+	zassert_true(ret, "Return value should be true");
+	zassert_equal(id, 8, "Id should be 8, was %d", id);
+	zassert_ok(strcmp(key, "t8"), "Key should be t8, was: %s", key);
+
+	ret = user_settings_iter_next(&key, &id);
+	zassert_true(ret, "Return value should be true");
+	zassert_equal(id, 9, "Id should be 9, was %d", id);
+	zassert_ok(strcmp(key, "t9"), "Key should be t9, was: %s", key);
+
+	/* Since we have 9 settings, we should get NULL here */
 	ret = user_settings_iter_next(&key, &id);
 	zassert_false(ret, "Return value should be false");
 }
@@ -447,6 +897,50 @@ ZTEST(user_settings_suite, test_settings_changed_recently)
 	zassert_equal(n_changed, 0, "we cleared all, number of changed settings should be 0");
 }
 
+ZTEST(user_settings_suite, test_settings_changed_iter_clear)
+{
+	char *key = NULL;
+	uint16_t id = 0;
+	uint16_t ids[3];
+	int n_changed = 0;
+
+	user_settings_clear_changed();
+
+	/* mark changed in an order other than the order the settings were added */
+	user_settings_set_changed_with_id(3);
+	user_settings_set_changed_with_id(1);
+	user_settings_set_changed_with_id(2);
+
+	/* settings come in the order they were marked, clearing each one does not stop the walk */
+	user_settings_iter_start();
+	while (user_settings_iter_next_changed(&key, &id)) {
+		zassert_true(n_changed < ARRAY_SIZE(ids), "Too many changed settings");
+		ids[n_changed++] = id;
+		user_settings_clear_changed_with_id(id);
+	}
+	zassert_equal(n_changed, 3, "All changed settings should be visited, were %d", n_changed);
+	zassert_equal(ids[0], 3, "Setting 3 was marked first");
+	zassert_equal(ids[1], 1, "Setting 1 was marked second");
+	zassert_equal(ids[2], 2, "Setting 2 was marked third");
+	zassert_false(user_settings_any_changed(), "All flags should be cleared");
+
+	/* clearing a setting that was not reached yet skips it */
+	user_settings_set_changed_with_id(1);
+	user_settings_set_changed_with_id(2);
+	user_settings_set_changed_with_id(3);
+
+	n_changed = 0;
+	user_settings_iter_start();
+	while (user_settings_iter_next_changed(&key, &id)) {
+		zassert_not_equal(id, 2, "Cleared setting should be skipped");
+		n_changed++;
+		user_settings_clear_changed_with_id(2);
+	}
+	zassert_equal(n_changed, 2, "Two changed settings should be visited, were %d", n_changed);
+
+	user_settings_clear_changed();
+}
+
 ZTEST(user_settings_suite, test_settings_user_settings_any_changed)
 {
 	bool c;
@@ -483,6 +977,402 @@ ZTEST(user_settings_suite, test_settings_user_settings_any_changed)
 	c = user_settings_any_changed();
 	zassert_false(c, "No setting should be marked changed");
 }
+ZTEST(user_settings_suite, test_settings_export_import_binary)
+{
+	static uint8_t blob[512];
+	static uint8_t chunked[512];
+	size_t blob_len = 0;
+	struct user_settings_export_cursor cursor = {0};
+	int len;
+
+	/* export in one piece */
+	len = user_settings_export_binary(blob, sizeof(blob), &cursor);
+	zassert_true(len > 0 && len < sizeof(blob), "Export should fit into the buffer");
+	blob_len = len;
+	zassert_equal(cursor.offset, blob_len, "Offset should be advanced");
+	zassert_equal(user_settings_export_binary(blob, sizeof(blob), &cursor), 0,
+		      "Export should be done");
+
+	/* export in chunks of every size, the chunks must fit together */
+	for (size_t chunk = 1; chunk <= 16; chunk++) {
+		size_t chunked_len = 0;
+		memset(&cursor, 0, sizeof(cursor));
+		while ((len = user_settings_export_binary(&chunked[chunked_len], chunk,
+							  &cursor)) > 0) {
+			chunked_len += len;
+		}
+		zassert_equal(len, 0, "Chunked export failed");
+		zassert_equal(chunked_len, blob_len, "Chunk size %zu gives another length", chunk);
+		zassert_mem_equal(chunked, blob, blob_len, "Chunk size %zu gives another blob",
+				  chunk);
+	}
+
+	/* modify the store after the export */
+	uint32_t value2 = 42;
+	user_settings_set_with_id(2, &value2, sizeof(value2));
+	user_settings_set_with_key("t4", "pear", strlen("pear") + 1);
+
+	/* a corrupted blob is rejected and nothing is changed */
+	blob[blob_len / 2] ^= 0xFF;
+	zassert_equal(user_settings_import_binary(blob, blob_len), -EINVAL,
+		      "Corrupted blob should be rejected");
+	blob[blob_len / 2] ^= 0xFF;
+	zassert_equal(*(uint32_t *)user_settings_get_with_id(2, NULL), 42,
+		      "Failed import should not change settings");
+
+	/* import restores the exported state */
+	zassert_ok(user_settings_import_binary(blob, blob_len), "Import should succeed");
+	zassert_equal(*(uint32_t *)user_settings_get_with_id(2, NULL), 0,
+		      "Import should restore the exported value");
+	zassert_ok(strcmp(user_settings_get_with_id(4, NULL), ""),
+		   "Import should restore the exported value");
+}
+
+static int count_records_cb(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg,
+			    void *param)
+{
+	(*(int *)param)++;
+	return 0;
+}
+
+ZTEST(user_settings_suite, test_settings_import_binary_rollback)
+{
+	static uint8_t blob[64];
+	static uint8_t snapshot[512];
+	static void *fill[1024];
+	size_t n_fill = 0;
+	size_t len = 0;
+
+	/* t10 first gets a default and then a value. Both records are valid, but the value can
+	 * not be stored, because there is no space for it. */
+	memcpy(&blob[len], "USB\x01", 4);
+	len += 4 + 4;
+	sys_put_le16(2, &blob[len]);
+	len += 2;
+
+	sys_put_le16(10, &blob[len]);
+	blob[len + 2] = USER_SETTINGS_TYPE_U32;
+	blob[len + 3] = BIT(1);
+	sys_put_le16(sizeof(uint32_t), &blob[len + 4]);
+	sys_put_le32(7, &blob[len + 6]);
+	len += 10;
+
+	sys_put_le16(10, &blob[len]);
+	blob[len + 2] = USER_SETTINGS_TYPE_U32;
+	blob[len + 3] = BIT(0);
+	sys_put_le16(sizeof(uint32_t), &blob[len + 4]);
+	sys_put_le32(9, &blob[len + 6]);
+	len += 10;
+
+	sys_put_le32(len + 4, &blob[4]);
+	sys_put_le32(crc32_ieee(blob, len), &blob[len]);
+	len += 4;
+
+	/* Leave exactly the space for the rollback snapshot, which is an export of all settings */
+	struct user_settings_export_cursor cursor = {0};
+	int snapshot_len = user_settings_export_binary(snapshot, sizeof(snapshot), &cursor);
+	zassert_true(snapshot_len > 0, "Export should fit into the buffer");
+
+	void *reserved = user_settings_list_buf_alloc(snapshot_len);
+	zassert_not_null(reserved, "Heap should have space for the snapshot");
+	while (n_fill < ARRAY_SIZE(fill) && (fill[n_fill] = user_settings_list_buf_alloc(1))) {
+		n_fill++;
+	}
+	zassert_true(n_fill < ARRAY_SIZE(fill), "Heap should be full");
+	user_settings_list_buf_free(reserved);
+
+	int err = user_settings_import_binary(blob, len);
+
+	for (size_t i = 0; i < n_fill; i++) {
+		user_settings_list_buf_free(fill[i]);
+	}
+
+	zassert_equal(err, -EIO, "Import should fail when the value can not be stored");
+
+	/* The default stored before the failure is rolled back, also from NVS */
+	zassert_false(user_settings_is_set_with_id(10), "Value should not be set");
+	zassert_is_null(user_settings_get_default_with_id(10, NULL),
+			"Default should be rolled back");
+
+	int records = 0;
+	zassert_ok(settings_load_subtree_direct("user_default/t10", count_records_cb, &records),
+		   "Loading the default should not fail");
+	zassert_equal(records, 0, "Default should be deleted from NVS");
+}
+
+ZTEST(user_settings_suite, test_settings_wear_stats)
+{
+	struct user_settings_wear_stats before;
+	struct user_settings_wear_stats after;
+
+	zassert_ok(user_settings_get_wear_stats_with_id(2, &before), "Wear stats should be enabled");
+
+	/* a new value writes the value and the changed flag */
+	uint32_t value2 = 1234;
+	user_settings_clear_changed_with_id(2);
+	user_settings_get_wear_stats_with_id(2, &before);
+	user_settings_set_with_id(2, &value2, sizeof(value2));
+	user_settings_get_wear_stats_with_id(2, &after);
+	zassert_equal(after.writes, before.writes + 2, "Value and flag should be counted");
+	zassert_equal(after.bytes, before.bytes + sizeof(value2) + sizeof(bool),
+		      "Written bytes should be counted");
+	zassert_equal(after.skipped, before.skipped, "Nothing should be skipped");
+
+	/* the same value writes nothing */
+	user_settings_set_with_id(2, &value2, sizeof(value2));
+	user_settings_get_wear_stats_with_key("t2", &before);
+	zassert_equal(before.writes, after.writes, "Same value should not be written");
+	zassert_equal(before.skipped, after.skipped + 1, "Same value should be counted as skipped");
+
+	struct user_settings_wear_totals totals;
+	zassert_ok(user_settings_get_wear_totals(&totals), "Totals should be available");
+	zassert_true(totals.sum.writes >= before.writes, "Totals should include the setting");
+	zassert_true(totals.boot_writes > 0, "Writes since boot should be counted");
+
+	zassert_ok(user_settings_reset_wear_stats(), "Reset should succeed");
+	user_settings_get_wear_stats_with_id(2, &after);
+	zassert_equal(after.writes + after.bytes + after.skipped, 0, "Counters should be reset");
+}
+
+#if defined(CONFIG_USER_SETTINGS_WEAR_STATS_PERSIST)
+static int wear_stored_cb(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg,
+			  void *param)
+{
+	/* only the exact key */
+	if (key == NULL && len == sizeof(struct user_settings_wear_stats)) {
+		read_cb(cb_arg, param, len);
+	}
+	return 0;
+}
+
+ZTEST(user_settings_suite, test_settings_wear_stats_persist)
+{
+	struct user_settings_wear_stats stored;
+	struct user_settings_wear_stats current;
+
+	/* start with the changed flag set and nothing left to store */
+	user_settings_set_changed_with_id(2);
+	zassert_ok(user_settings_save_wear_stats(), "Save should succeed");
+
+	/* the flag, the value and the flag again, CONFIG_USER_SETTINGS_WEAR_STATS_SAVE_INTERVAL is
+	 * reached by the value, in the middle of the set */
+	user_settings_clear_changed_with_id(2);
+	uint32_t value2 = *(uint32_t *)user_settings_get_with_id(2, NULL) + 1;
+	user_settings_set_with_id(2, &value2, sizeof(value2));
+
+	memset(&stored, 0, sizeof(stored));
+	settings_load_subtree_direct("user_wear/t2", wear_stored_cb, &stored);
+	user_settings_get_wear_stats_with_id(2, &current);
+	zassert_equal(stored.writes, current.writes, "Counters should be stored after the set");
+	zassert_equal(stored.bytes, current.bytes, "Counters should be stored after the set");
+
+	/* a skipped set does not make the counters dirty */
+	user_settings_set_with_id(2, &value2, sizeof(value2));
+	zassert_ok(user_settings_save_wear_stats(), "Save should succeed");
+	settings_load_subtree_direct("user_wear/t2", wear_stored_cb, &stored);
+	zassert_equal(stored.skipped, current.skipped, "A skipped set should not be stored");
+}
+#endif /* CONFIG_USER_SETTINGS_WEAR_STATS_PERSIST */
+
+static bool validator_allow_zero;
+static bool validator_reject_zero(uint32_t id, const char *key, const void *data, size_t len)
+{
+	return validator_allow_zero || *(const int8_t *)data != 0;
+}
+
+ZTEST(user_settings_suite, test_settings_constraints)
+{
+	static const int64_t allowed[] = {-4, 0, 4, 5};
+	int8_t value;
+
+	zassert_ok(user_settings_set_range_with_id(3, -4, 4, 2), "Range should be set");
+
+	value = 2;
+	zassert_ok(user_settings_set_with_id(3, &value, 1), "Value in range should be set");
+	value = 6;
+	zassert_equal(user_settings_set_with_id(3, &value, 1), -EINVAL, "Above max should fail");
+	value = -6;
+	zassert_equal(user_settings_set_with_id(3, &value, 1), -EINVAL, "Below min should fail");
+	value = 1;
+	zassert_equal(user_settings_set_with_id(3, &value, 1), -EINVAL, "Off step should fail");
+	zassert_equal(*(int8_t *)user_settings_get_with_id(3, NULL), 2,
+		      "Rejected values should not be stored");
+
+	zassert_ok(user_settings_set_enum_with_key("t3", allowed, ARRAY_SIZE(allowed)),
+		   "Enum should be set");
+	value = -2;
+	zassert_equal(user_settings_set_with_id(3, &value, 1), -EINVAL, "Not in enum should fail");
+	value = 5;
+	zassert_equal(user_settings_validate_with_id(3, &value, 1), -EINVAL,
+		      "Range and enum should both apply");
+	value = 4;
+	zassert_ok(user_settings_validate_with_key("t3", &value, 1), "Value should be valid");
+
+	zassert_ok(user_settings_set_validator_with_id(3, validator_reject_zero),
+		   "Validator should be set");
+	value = 0;
+	zassert_equal(user_settings_set_with_id(3, &value, 1), -EINVAL,
+		      "Validator should reject the value");
+	validator_allow_zero = true;
+	zassert_ok(user_settings_set_with_id(3, &value, 1), "Validator should accept the value");
+
+	/* allow every value again for the other tests */
+	user_settings_set_validator_with_id(3, NULL);
+	user_settings_set_enum_with_id(3, NULL, 0);
+	user_settings_set_range_with_id(3, INT8_MIN, INT8_MAX, 0);
+}
+
+ZTEST(user_settings_suite, test_settings_stats)
+{
+	user_settings_clear_changed_with_id(2);
+	zassert_ok(user_settings_stats_reset(), "Stats should be enabled");
+
+	uint32_t value2 = 4321;
+	user_settings_set_with_id(2, &value2, sizeof(value2));
+	user_settings_set_with_key("t2", &value2, sizeof(value2));
+	user_settings_get_with_id(2, NULL);
+	user_settings_get_with_key("t2", NULL);
+	zassert_false(user_settings_exists_with_id(1000), "Setting should not exist");
+
+	zassert_equal(user_settings_stats.set_id, 1, "Set by ID should be counted");
+	zassert_equal(user_settings_stats.set_key, 1, "Set by key should be counted");
+	zassert_equal(user_settings_stats.set_unchanged, 1, "Same value should be counted");
+	zassert_equal(user_settings_stats.get_id, 1, "Get by ID should be counted");
+	zassert_equal(user_settings_stats.get_key, 1, "Get by key should be counted");
+	zassert_equal(user_settings_stats.lookup_miss, 1, "Miss should be counted");
+	zassert_equal(user_settings_stats.writes, 2, "Value and flag writes should be counted");
+
+	uint32_t values[64];
+	int num_values = user_settings_stats_read(values, ARRAY_SIZE(values));
+	zassert_true(num_values > 0, "Stats should be read");
+	zassert_equal(values[3], 1, "Set by ID should be the fourth counter");
+	zassert_equal(user_settings_stats_read(values, 1), -ENOMEM, "Too small should fail");
+}
+
+static int on_change_array_calls;
+static void on_change_array(uint32_t id, const char *key)
+{
+	on_change_array_calls++;
+}
+
+ZTEST(user_settings_suite, test_settings_array)
+{
+	uint16_t values[4] = {1, 2, 3, 4};
+	uint16_t elem;
+
+	zassert_equal(user_settings_get_type_with_id(7), USER_SETTINGS_TYPE_ARRAY,
+		      "Type should be array");
+	zassert_equal(user_settings_get_elem_type_with_key("t7"), USER_SETTINGS_TYPE_U16,
+		      "Element type should be U16");
+	zassert_equal(user_settings_set_with_id(7, values, 2 * sizeof(uint16_t)), -EINVAL,
+		      "Setting part of an array should fail");
+	zassert_ok(user_settings_set_with_id(7, values, sizeof(values)), "Set should succeed");
+	wait_for_callbacks();
+
+	on_change_array_calls = 0;
+	user_settings_set_on_change_cb_with_id(7, on_change_array);
+
+	elem = 42;
+	zassert_ok(user_settings_set_elem_with_key("t7", 2, &elem, sizeof(elem)),
+		   "Element set should succeed");
+	wait_for_callbacks();
+	zassert_equal(on_change_array_calls, 1, "Callback should be called once");
+	zassert_ok(user_settings_set_elem_with_id(7, 2, &elem, sizeof(elem)),
+		   "Same element set should succeed");
+	wait_for_callbacks();
+	zassert_equal(on_change_array_calls, 1, "Unchanged element should not notify");
+
+	zassert_equal(user_settings_get_elem_with_id(7, 2, &elem, sizeof(elem)), sizeof(elem),
+		      "Get should return the element size");
+	zassert_equal(elem, 42, "Element should be 42, was %d", elem);
+	zassert_equal(user_settings_get_elem_with_key("t7", 3, &elem, sizeof(elem)), sizeof(elem),
+		      "Get should return the element size");
+	zassert_equal(elem, 4, "Other elements should be kept");
+
+	zassert_equal(user_settings_set_elem_with_id(7, 4, &elem, sizeof(elem)), -EINVAL,
+		      "Index out of range should fail");
+	zassert_equal(user_settings_get_elem_with_id(7, 0, &elem, 1), -ENOMEM,
+		      "Too small buffer should fail");
+
+	user_settings_set_on_change_cb_with_id(7, NULL);
+}
+
+ZTEST(user_settings_suite, test_settings_record)
+{
+	struct test_record value = {.gain = 1.5f, .offset = -20, .enabled = true};
+	struct test_record read;
+	size_t num_fields;
+	int16_t offset;
+
+	zassert_equal(user_settings_get_type_with_key("t8"), USER_SETTINGS_TYPE_RECORD,
+		      "Type should be record");
+	zassert_equal(user_settings_get_record_fields_with_id(8, &num_fields), test_record_fields,
+		      "Fields should be the table the record was added with");
+	zassert_equal(num_fields, ARRAY_SIZE(test_record_fields), "Number of fields should match");
+
+	zassert_equal(user_settings_set_with_id(8, &value, sizeof(float)), -EINVAL,
+		      "Setting part of a record should fail");
+	zassert_ok(user_settings_set_with_id(8, &value, sizeof(value)), "Set should succeed");
+
+	offset = 35;
+	zassert_ok(user_settings_set_field_with_key("t8", "offset", &offset, sizeof(offset)),
+		   "Field set should succeed");
+	zassert_equal(user_settings_read_with_id(8, &read, sizeof(read)), sizeof(read),
+		      "Read should succeed");
+	zassert_equal(read.offset, 35, "Field should be 35, was %d", read.offset);
+	zassert_equal(read.gain, 1.5f, "Other fields should be kept");
+	zassert_true(read.enabled, "Other fields should be kept");
+
+	offset = 0;
+	zassert_equal(user_settings_get_field_with_id(8, "offset", &offset, sizeof(offset)),
+		      sizeof(offset), "Field get should succeed");
+	zassert_equal(offset, 35, "Field should be 35, was %d", offset);
+
+	zassert_equal(user_settings_set_field_with_id(8, "missing", &offset, sizeof(offset)),
+		      -EINVAL, "Unknown field should fail");
+	zassert_equal(user_settings_set_field_with_id(8, "offset", &offset, 1), -EINVAL,
+		      "Wrong field size should fail");
+}
+
+ZTEST(user_settings_suite, test_settings_cron)
+{
+	/* Thursday, 2023-06-15 12:00:00 UTC */
+	const int64_t now = 1686830400;
+	struct user_settings_cron cron;
+	int64_t next;
+	uint16_t id;
+
+	zassert_equal(user_settings_set_with_id(9, "60-08-01", 8), -EINVAL,
+		      "Invalid minute should fail");
+	zassert_equal(user_settings_set_with_id(9, "30-08", 5), -EINVAL,
+		      "Missing field should fail");
+
+	zassert_ok(user_settings_set_with_id(9, "30-08-01", 8), "Set should succeed");
+	zassert_ok(user_settings_get_cron_with_key("t9", &cron), "Get should succeed");
+	zassert_equal(cron.minutes, BIT64(30), "Minute should be 30");
+	zassert_equal(cron.hours, BIT(8), "Hour should be 8");
+	zassert_equal(cron.days_of_week, BIT(1), "Day should be Monday");
+
+	/* next Monday, 08:30 */
+	zassert_ok(user_settings_cron_next_with_id(9, now, &next), "Next should succeed");
+	zassert_equal(next, now + 333000, "Next should be on Monday, was %lld", next);
+
+	/* every minute from 12:00 to 12:59, every day */
+	zassert_ok(user_settings_set_with_id(9, "**-12-**", 8), "Set should succeed");
+	zassert_ok(user_settings_cron_peek(now, &id, &next), "Peek should succeed");
+	zassert_equal(id, 9, "Setting 9 should fire first");
+	zassert_equal(next, now + 60, "Setting should fire in a minute");
+
+	zassert_equal(user_settings_cron_pop(now, &id), -EAGAIN, "Nothing should be due");
+	zassert_ok(user_settings_cron_pop(now + 60, &id), "Setting should be due");
+	zassert_equal(id, 9, "Setting 9 should be due");
+	zassert_equal(user_settings_cron_pop(now + 60, &id), -EAGAIN,
+		      "Setting should be rescheduled");
+
+	zassert_ok(user_settings_cron_peek(now + 60, &id, &next), "Peek should succeed");
+	zassert_equal(next, now + 120, "Setting should fire in a minute");
+}
+
 /*
  * NOT TESTED:
  *
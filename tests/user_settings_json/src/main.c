@@ -9,6 +9,22 @@
 #include <cJSON.h>
 #include <cJSON_os.h>
 
+struct test_record {
+	float gain;
+	int16_t offset;
+	bool enabled;
+};
+
+static const struct user_settings_record_field test_record_fields[] = {
+	USER_SETTINGS_RECORD_FIELD(struct test_record, gain, USER_SETTINGS_TYPE_F32),
+	USER_SETTINGS_RECORD_FIELD(struct test_record, offset, USER_SETTINGS_TYPE_I16),
+	USER_SETTINGS_RECORD_FIELD(struct test_record, enabled, USER_SETTINGS_TYPE_BOOL),
+};
+
+static const int16_t test_array_default[] = {1, -2, 3};
+static const struct test_record test_record_default = {.gain = 0.5f, .offset = -1};
+static const uint8_t test_bytes_default[] = {0xA5};
+
 static void *user_settings_json_suite_setup(void)
 {
 	user_settings_init();
@@ -18,6 +34,19 @@ static void *user_settings_json_suite_setup(void)
 	user_settings_add(2, "t2", USER_SETTINGS_TYPE_U32);
 	user_settings_add_sized(3, "t3", USER_SETTINGS_TYPE_BYTES, 4);
 	user_settings_add_sized(4, "t4", USER_SETTINGS_TYPE_STR, 10);
+	user_settings_add(5, "t5", USER_SETTINGS_TYPE_F32);
+	user_settings_add(6, "t6", USER_SETTINGS_TYPE_F64);
+	user_settings_add_with_default(7, "t7", USER_SETTINGS_TYPE_CRON_JOB, "00-08-**", 8);
+	user_settings_add_array_with_default(8, "t8", USER_SETTINGS_TYPE_I16,
+					     ARRAY_SIZE(test_array_default), test_array_default,
+					     sizeof(test_array_default));
+	user_settings_add_record_with_default(9, "t9", test_record_fields,
+					      ARRAY_SIZE(test_record_fields), &test_record_default,
+					      sizeof(test_record_default));
+	/* one byte larger than the streaming parser can import */
+	user_settings_add_sized_with_default(10, "t10", USER_SETTINGS_TYPE_BYTES,
+					     CONFIG_USER_SETTINGS_JSON_PARSER_VALUE_SIZE + 1,
+					     test_bytes_default, sizeof(test_bytes_default));
 
 	user_settings_load();
 
@@ -41,6 +70,13 @@ void user_settings_json_suite_before_each(void *fixture)
 	user_settings_set_with_id(3, &value3, 4);
 	char value4[] = "";
 	user_settings_set_with_id(4, &value4, strlen(value4) + 1);
+	float value5 = 0;
+	user_settings_set_with_id(5, &value5, sizeof(value5));
+	double value6 = 0;
+	user_settings_set_with_id(6, &value6, sizeof(value6));
+	user_settings_set_with_id(8, test_array_default, sizeof(test_array_default));
+	user_settings_set_with_id(9, &test_record_default, sizeof(test_record_default));
+	user_settings_set_with_id(10, test_bytes_default, sizeof(test_bytes_default));
 }
 
 ZTEST_SUITE(user_settings_json_suite, NULL, user_settings_json_suite_setup,
@@ -153,6 +189,11 @@ ZTEST(user_settings_json_suite, test_settings_get_all_json)
 	zassert_ok(strcmp(new_str, setting->valuestring), 0,
 		   "What was set should be what was gotten");
 
+	setting = cJSON_GetObjectItem(settings, "t7");
+	zassert_not_null(setting, "cJSON object was NULL");
+	zassert_true(cJSON_IsString(setting), "Should be string");
+	zassert_ok(strcmp("00-08-**", setting->valuestring), "Default should be exported");
+
 	cJSON_Delete(settings);
 }
 
@@ -209,3 +250,462 @@ ZTEST(user_settings_json_suite, test_settings_get_changed_json)
 
 	cJSON_Delete(settings);
 }
+
+ZTEST(user_settings_json_suite, test_settings_json_write_all_chunked)
+{
+	int err;
+
+	bool value = true;
+	char new_str[] = "ban\"ana";
+	uint32_t new_val = 1000;
+	uint8_t new_bytes[] = {0xDE, 0xAD, 0xBE, 0xEF};
+
+	err = user_settings_set_with_id(1, &value, sizeof(value));
+	zassert_ok(err, "set should not error here");
+	err = user_settings_set_with_id(2, &new_val, sizeof(new_val));
+	zassert_ok(err, "set should not error here");
+	err = user_settings_set_with_id(3, &new_bytes, sizeof(new_bytes));
+	zassert_ok(err, "set should not error here");
+	err = user_settings_set_with_id(4, &new_str, strlen(new_str) + 1);
+	zassert_ok(err, "set should not error here");
+
+	/* Write the document in chunks of every size and put it back together */
+	char chunk[16];
+	char document[192];
+	const char expected[] = "{\"t1\":true,\"t2\":1000,\"t3\":\"DEADBEEF\",\"t4\":\"ban\\\"ana\","
+				"\"t5\":0,\"t6\":0,\"t7\":\"00-08-**\",\"t8\":[1,-2,3],"
+				"\"t9\":{\"gain\":0.5,\"offset\":-1,\"enabled\":false},"
+				"\"t10\":\"A5\"}";
+	int len;
+
+	for (size_t chunk_len = 1; chunk_len <= sizeof(chunk); chunk_len++) {
+		struct user_settings_json_cursor cursor = {0};
+
+		memset(document, 0, sizeof(document));
+		while ((len = user_settings_json_write_all(chunk, chunk_len, &cursor)) > 0) {
+			zassert_true(cursor.offset < sizeof(document), "document should fit");
+			memcpy(&document[cursor.offset - len], chunk, len);
+		}
+		zassert_equal(len, 0, "Writing should finish without an error");
+		zassert_ok(strcmp(document, expected), "Unexpected document with %zu byte chunks: %s",
+			   chunk_len, document);
+	}
+
+	/* The document must be valid JSON */
+	cJSON *settings = cJSON_Parse(document);
+	zassert_not_null(settings, "Written document should be valid JSON");
+
+	cJSON *setting = cJSON_GetObjectItem(settings, "t4");
+	zassert_not_null(setting, "cJSON object was NULL");
+	zassert_ok(strcmp(new_str, setting->valuestring), "What was set should be what was gotten");
+
+	cJSON_Delete(settings);
+}
+
+ZTEST(user_settings_json_suite, test_settings_json_write_changed_chunked)
+{
+	int err;
+
+	user_settings_clear_changed();
+
+	/* Settings are written in the order they were marked changed */
+	uint32_t new_val = 1000;
+	bool value = true;
+	err = user_settings_set_with_id(2, &new_val, sizeof(new_val));
+	zassert_ok(err, "set should not error here");
+	err = user_settings_set_with_id(1, &value, sizeof(value));
+	zassert_ok(err, "set should not error here");
+
+	char chunk[5];
+	char document[64] = {0};
+	struct user_settings_json_cursor cursor = {0};
+	int len;
+
+	while ((len = user_settings_json_write_changed(chunk, sizeof(chunk), &cursor)) > 0) {
+		zassert_true(cursor.offset < sizeof(document), "document should fit");
+		memcpy(&document[cursor.offset - len], chunk, len);
+	}
+	zassert_equal(len, 0, "Writing should finish without an error");
+	zassert_ok(strcmp(document, "{\"t2\":1000,\"t1\":true}"), "Unexpected document: %s",
+		   document);
+
+	/* Nothing changed, empty object */
+	user_settings_clear_changed();
+	memset(document, 0, sizeof(document));
+	cursor = (struct user_settings_json_cursor){0};
+	len = user_settings_json_write_changed(document, sizeof(document), &cursor);
+	zassert_equal(len, 2, "Only the braces should be written");
+	zassert_ok(strcmp(document, "{}"), "Unexpected document: %s", document);
+}
+
+ZTEST(user_settings_json_suite, test_settings_json_parser_fragments)
+{
+	int err;
+	const char doc[] = "{ \"t1\": true, \"unknown\": 5, \"t2\": 1000, \"t3\": \"DEADBEEF\", "
+			   "\"t4\": \"ban\\\"ana\" }";
+
+	/* Feed the document one character at a time, as if it came in network fragments */
+	struct user_settings_json_parser parser;
+	user_settings_json_parser_init(&parser, false);
+
+	for (size_t i = 0; i < strlen(doc); i++) {
+		err = user_settings_json_parser_feed(&parser, &doc[i], 1);
+		zassert_ok(err, "Feeding should not fail at character %zu", i);
+	}
+	zassert_ok(user_settings_json_parser_finish(&parser), "Document should be complete");
+
+	/* Check set values */
+	size_t size;
+	bool *out_bool = user_settings_get_with_id(1, &size);
+	zassert_equal(*out_bool, true, "What was set should be what was gotten");
+
+	uint32_t *out_number = user_settings_get_with_id(2, &size);
+	zassert_equal(*out_number, 1000, "What was set should be what was gotten");
+
+	uint8_t expected_bytes[] = {0xDE, 0xAD, 0xBE, 0xEF};
+	uint8_t *bytes_out = user_settings_get_with_id(3, &size);
+	zassert_equal(size, sizeof(expected_bytes), "Bytes should be hex decoded");
+	zassert_mem_equal(bytes_out, expected_bytes, size, "What was set should be what was gotten");
+
+	char *out_str = user_settings_get_with_id(4, &size);
+	zassert_ok(strcmp("ban\"ana", out_str), "What was set should be what was gotten");
+}
+
+ZTEST(user_settings_json_suite, test_settings_json_parser_invalid)
+{
+	struct user_settings_json_parser parser;
+
+	/* Members need a colon */
+	char no_colon[] = "{ \"t1\" true }";
+	user_settings_json_parser_init(&parser, false);
+	zassert_equal(user_settings_json_parser_feed(&parser, no_colon, strlen(no_colon)), -EINVAL,
+		      "Parsing invalid json should fail");
+
+	/* Nested structures are only skipped, the settings inside are not applied */
+	char nested[] = "{ \"settings\": {\"t1\": true}}";
+	user_settings_json_parser_init(&parser, false);
+	zassert_ok(user_settings_json_parser_feed(&parser, nested, strlen(nested)),
+		   "Parsing nested json should not fail");
+	zassert_ok(user_settings_json_parser_finish(&parser), "Document should be complete");
+
+	/* An incomplete document is detected on finish */
+	char incomplete[] = "{ \"t1\": tr";
+	user_settings_json_parser_init(&parser, false);
+	zassert_ok(user_settings_json_parser_feed(&parser, incomplete, strlen(incomplete)),
+		   "Feeding a valid fragment should not fail");
+	zassert_equal(user_settings_json_parser_finish(&parser), -EINVAL,
+		      "Finishing an incomplete document should fail");
+
+	/* make sure setting was not modified */
+	bool t1 = *(bool *)user_settings_get_with_id(1, NULL);
+	zassert_equal(t1, false, "Setting should be unmodified");
+}
+
+/**
+ * @brief Feed a bytes value of @p len bytes for t10 in fragments
+ */
+static int feed_bytes_value(size_t len)
+{
+	struct user_settings_json_parser parser;
+	int err;
+
+	user_settings_json_parser_init(&parser, false);
+
+	err = user_settings_json_parser_feed(&parser, "{\"t10\":\"", 8);
+	for (size_t i = 0; i < len && !err; i++) {
+		err = user_settings_json_parser_feed(&parser, "A5", 2);
+	}
+	if (!err) {
+		err = user_settings_json_parser_feed(&parser, "\"}", 2);
+	}
+
+	return err ? err : user_settings_json_parser_finish(&parser);
+}
+
+ZTEST(user_settings_json_suite, test_settings_json_parser_value_size)
+{
+	size_t size;
+
+	/* A value that exactly fills the value buffer is imported */
+	zassert_ok(feed_bytes_value(CONFIG_USER_SETTINGS_JSON_PARSER_VALUE_SIZE),
+		   "Value of the buffer size should be imported");
+	uint8_t *bytes_out = user_settings_get_with_id(10, &size);
+	zassert_not_null(bytes_out, "Value should be set");
+	zassert_equal(size, CONFIG_USER_SETTINGS_JSON_PARSER_VALUE_SIZE, "Value should be complete");
+	zassert_equal(bytes_out[size - 1], 0xA5, "What was set should be what was gotten");
+
+	/* A larger value is refused, even if the setting can hold it */
+	zassert_equal(feed_bytes_value(CONFIG_USER_SETTINGS_JSON_PARSER_VALUE_SIZE + 1), -ENOMEM,
+		      "Value larger than the buffer should be refused");
+	user_settings_get_with_id(10, &size);
+	zassert_equal(size, CONFIG_USER_SETTINGS_JSON_PARSER_VALUE_SIZE,
+		      "Value should be unmodified");
+}
+
+ZTEST(user_settings_json_suite, test_settings_json_parser_skip_nested)
+{
+	int err;
+	const char doc[] = "{ \"meta\": {\"fw\": \"1.2\", \"parts\": [1, {\"name\": \"}]\\\"\"}]}, "
+			   "\"tags\": [\"a\", \"b]\"], \"t1\": true, \"t8\": [4, \"x\", [1]], "
+			   "\"t9\": {\"gain\": {\"v\": 2}}, \"t2\": {\"a\": 1}, \"t2\": 1000 }";
+
+	/* Unknown keys and values of the wrong type are skipped, however deeply they nest */
+	for (size_t fragment_len = 1; fragment_len <= strlen(doc); fragment_len *= 4) {
+		struct user_settings_json_parser parser;
+		user_settings_json_parser_init(&parser, false);
+		user_settings_json_suite_before_each(NULL);
+
+		for (size_t i = 0; i < strlen(doc); i += fragment_len) {
+			err = user_settings_json_parser_feed(&parser, &doc[i],
+							     MIN(fragment_len, strlen(doc) - i));
+			zassert_ok(err, "Feeding should not fail at character %zu", i);
+		}
+		zassert_ok(user_settings_json_parser_finish(&parser), "Document should be complete");
+
+		bool t1 = *(bool *)user_settings_get_with_id(1, NULL);
+		zassert_true(t1, "Setting after a skipped value should be set");
+		uint32_t t2 = *(uint32_t *)user_settings_get_with_id(2, NULL);
+		zassert_equal(t2, 1000, "Setting after a skipped value should be set");
+
+		int16_t t8[ARRAY_SIZE(test_array_default)];
+		user_settings_read_with_id(8, t8, sizeof(t8));
+		zassert_mem_equal(t8, test_array_default, sizeof(t8), "Array should be unmodified");
+		struct test_record t9;
+		user_settings_read_with_id(9, &t9, sizeof(t9));
+		zassert_equal(t9.gain, test_record_default.gain, "Record should be unmodified");
+	}
+
+	/* The skipped value must still be complete */
+	char incomplete[] = "{ \"meta\": {\"fw\": [1, 2] }";
+	struct user_settings_json_parser parser;
+	user_settings_json_parser_init(&parser, false);
+	zassert_ok(user_settings_json_parser_feed(&parser, incomplete, strlen(incomplete)),
+		   "Feeding a valid fragment should not fail");
+	zassert_equal(user_settings_json_parser_finish(&parser), -EINVAL,
+		      "Finishing an incomplete document should fail");
+}
+
+ZTEST(user_settings_json_suite, test_settings_json_float_round_trip)
+{
+	int err;
+
+	/* Neither value is exactly representable in binary */
+	float f32 = 0.1f;
+	double f64 = 0.1;
+	float out_f32;
+	double out_f64;
+
+	user_settings_clear_changed();
+	err = user_settings_set_with_id(5, &f32, sizeof(f32));
+	zassert_ok(err, "set should not error here");
+	err = user_settings_set_with_id(6, &f64, sizeof(f64));
+	zassert_ok(err, "set should not error here");
+
+	char document[64] = {0};
+	struct user_settings_json_cursor cursor = {0};
+	int len = user_settings_json_write_changed(document, sizeof(document), &cursor);
+	zassert_true(len > 0, "Writing should not fail");
+	zassert_ok(strcmp(document, "{\"t5\":0.100000001,\"t6\":0.10000000000000001}"),
+		   "Unexpected document: %s", document);
+
+	/* Parse the document back with the streaming parser */
+	cJSON *settings = NULL;
+	user_settings_get_changed_json(&settings);
+	zassert_not_null(settings, "cJSON object was NULL");
+
+	user_settings_json_suite_before_each(NULL);
+
+	struct user_settings_json_parser parser;
+	user_settings_json_parser_init(&parser, false);
+	zassert_ok(user_settings_json_parser_feed(&parser, document, strlen(document)),
+		   "Parsing should not fail");
+	zassert_ok(user_settings_json_parser_finish(&parser), "Document should be complete");
+
+	user_settings_read_with_id(5, &out_f32, sizeof(out_f32));
+	zassert_mem_equal(&out_f32, &f32, sizeof(f32), "Float should round trip exactly");
+	user_settings_read_with_id(6, &out_f64, sizeof(out_f64));
+	zassert_mem_equal(&out_f64, &f64, sizeof(f64), "Double should round trip exactly");
+
+	/* And with cJSON */
+	user_settings_json_suite_before_each(NULL);
+
+	err = user_settings_set_from_json(settings, false);
+	zassert_ok(err, "Parsing json failed.");
+
+	user_settings_read_with_id(5, &out_f32, sizeof(out_f32));
+	zassert_mem_equal(&out_f32, &f32, sizeof(f32), "Float should round trip exactly");
+	user_settings_read_with_id(6, &out_f64, sizeof(out_f64));
+	zassert_mem_equal(&out_f64, &f64, sizeof(f64), "Double should round trip exactly");
+
+	cJSON_Delete(settings);
+}
+
+ZTEST(user_settings_json_suite, test_settings_json_array_round_trip)
+{
+	int err;
+	int16_t value[] = {100, -200, 300};
+	int16_t out[ARRAY_SIZE(value)];
+
+	user_settings_clear_changed();
+	err = user_settings_set_with_id(8, value, sizeof(value));
+	zassert_ok(err, "set should not error here");
+
+	char document[64] = {0};
+	struct user_settings_json_cursor cursor = {0};
+	int len = user_settings_json_write_changed(document, sizeof(document), &cursor);
+	zassert_true(len > 0, "Writing should not fail");
+	zassert_ok(strcmp(document, "{\"t8\":[100,-200,300]}"), "Unexpected document: %s",
+		   document);
+
+	cJSON *settings = NULL;
+	user_settings_get_changed_json(&settings);
+	zassert_not_null(settings, "cJSON object was NULL");
+
+	cJSON *setting = cJSON_GetObjectItem(settings, "t8");
+	zassert_true(cJSON_IsArray(setting), "Should be array");
+	zassert_equal(cJSON_GetArraySize(setting), ARRAY_SIZE(value), "Should hold all elements");
+	zassert_equal(cJSON_GetArrayItem(setting, 1)->valueint, -200,
+		      "What was set should be what was gotten");
+
+	/* Parse the document back with the streaming parser */
+	user_settings_json_suite_before_each(NULL);
+
+	struct user_settings_json_parser parser;
+	user_settings_json_parser_init(&parser, false);
+	zassert_ok(user_settings_json_parser_feed(&parser, document, strlen(document)),
+		   "Parsing should not fail");
+	zassert_ok(user_settings_json_parser_finish(&parser), "Document should be complete");
+
+	user_settings_read_with_id(8, out, sizeof(out));
+	zassert_mem_equal(out, value, sizeof(value), "Array should round trip");
+
+	/* And with cJSON */
+	user_settings_json_suite_before_each(NULL);
+
+	err = user_settings_set_from_json(settings, false);
+	zassert_ok(err, "Parsing json failed.");
+
+	user_settings_read_with_id(8, out, sizeof(out));
+	zassert_mem_equal(out, value, sizeof(value), "Array should round trip");
+
+	cJSON_Delete(settings);
+
+	/* Arrays must hold all elements, invalid values are skipped */
+	char partial[] = "{\"t8\":[1,2]}";
+	user_settings_json_parser_init(&parser, false);
+	zassert_ok(user_settings_json_parser_feed(&parser, partial, strlen(partial)),
+		   "Parsing should not fail");
+	zassert_ok(user_settings_json_parser_finish(&parser), "Document should be complete");
+
+	settings = cJSON_Parse(partial);
+	zassert_not_null(settings, "cJSON object was NULL");
+	zassert_ok(user_settings_set_from_json(settings, false), "Parsing json failed.");
+	cJSON_Delete(settings);
+
+	user_settings_read_with_id(8, out, sizeof(out));
+	zassert_mem_equal(out, value, sizeof(value), "Array should be unmodified");
+}
+
+ZTEST(user_settings_json_suite, test_settings_json_record_round_trip)
+{
+	int err;
+	struct test_record value = {.gain = 1.5f, .offset = -20, .enabled = true};
+	struct test_record out;
+
+	user_settings_clear_changed();
+	err = user_settings_set_with_id(9, &value, sizeof(value));
+	zassert_ok(err, "set should not error here");
+
+	char document[64] = {0};
+	struct user_settings_json_cursor cursor = {0};
+	int len = user_settings_json_write_changed(document, sizeof(document), &cursor);
+	zassert_true(len > 0, "Writing should not fail");
+	zassert_ok(strcmp(document, "{\"t9\":{\"gain\":1.5,\"offset\":-20,\"enabled\":true}}"),
+		   "Unexpected document: %s", document);
+
+	cJSON *settings = NULL;
+	user_settings_get_changed_json(&settings);
+	zassert_not_null(settings, "cJSON object was NULL");
+
+	cJSON *setting = cJSON_GetObjectItem(settings, "t9");
+	zassert_true(cJSON_IsObject(setting), "Should be object");
+	zassert_equal(cJSON_GetObjectItem(setting, "offset")->valueint, -20,
+		      "What was set should be what was gotten");
+	zassert_true(cJSON_IsTrue(cJSON_GetObjectItem(setting, "enabled")), "Should be true value");
+
+	/* Parse the document back with the streaming parser */
+	user_settings_json_suite_before_each(NULL);
+
+	struct user_settings_json_parser parser;
+	user_settings_json_parser_init(&parser, false);
+	zassert_ok(user_settings_json_parser_feed(&parser, document, strlen(document)),
+		   "Parsing should not fail");
+	zassert_ok(user_settings_json_parser_finish(&parser), "Document should be complete");
+
+	user_settings_read_with_id(9, &out, sizeof(out));
+	zassert_equal(out.gain, value.gain, "Record should round trip");
+	zassert_equal(out.offset, value.offset, "Record should round trip");
+	zassert_equal(out.enabled, value.enabled, "Record should round trip");
+
+	/* And with cJSON */
+	user_settings_json_suite_before_each(NULL);
+
+	err = user_settings_set_from_json(settings, false);
+	zassert_ok(err, "Parsing json failed.");
+
+	user_settings_read_with_id(9, &out, sizeof(out));
+	zassert_equal(out.gain, value.gain, "Record should round trip");
+	zassert_equal(out.offset, value.offset, "Record should round trip");
+	zassert_equal(out.enabled, value.enabled, "Record should round trip");
+
+	cJSON_Delete(settings);
+
+	/* Missing fields keep their value */
+	char partial[] = "{\"t9\":{\"offset\":7}}";
+	user_settings_json_parser_init(&parser, false);
+	zassert_ok(user_settings_json_parser_feed(&parser, partial, strlen(partial)),
+		   "Parsing should not fail");
+	zassert_ok(user_settings_json_parser_finish(&parser), "Document should be complete");
+
+	user_settings_read_with_id(9, &out, sizeof(out));
+	zassert_equal(out.offset, 7, "Field should be set");
+	zassert_equal(out.gain, value.gain, "Other fields should be kept");
+	zassert_equal(out.enabled, value.enabled, "Other fields should be kept");
+
+	/* Records with unknown fields are skipped */
+	char unknown[] = "{\"t9\":{\"scale\":2}}";
+	settings = cJSON_Parse(unknown);
+	zassert_not_null(settings, "cJSON object was NULL");
+	zassert_ok(user_settings_set_from_json(settings, false), "Parsing json failed.");
+	cJSON_Delete(settings);
+
+	user_settings_read_with_id(9, &out, sizeof(out));
+	zassert_equal(out.offset, 7, "Record should be unmodified");
+}
+
+ZTEST(user_settings_json_suite, test_settings_json_elem_out_of_range)
+{
+	int16_t array_out[3];
+	struct test_record record_out;
+	const char *documents[] = {
+		"{\"t8\":[1,40000,3]}",
+		"{\"t8\":[1,-40000,3]}",
+		"{\"t9\":{\"offset\":70000}}",
+		"{\"t9\":{\"gain\":1e300}}",
+	};
+
+	/* Out of range elements are skipped instead of wrapped */
+	for (size_t i = 0; i < ARRAY_SIZE(documents); i++) {
+		cJSON *settings = cJSON_Parse(documents[i]);
+		zassert_not_null(settings, "cJSON object was NULL");
+		zassert_ok(user_settings_set_from_json(settings, false), "Parsing json failed.");
+		cJSON_Delete(settings);
+	}
+
+	user_settings_read_with_id(8, array_out, sizeof(array_out));
+	zassert_equal(array_out[1], -2, "Array should be unmodified");
+
+	user_settings_read_with_id(9, &record_out, sizeof(record_out));
+	zassert_equal(record_out.offset, -1, "Record should be unmodified");
+	zassert_equal(record_out.gain, 0.5f, "Record should be unmodified");
+}
@@ -33,7 +33,7 @@ ZTEST(user_settings_list_suite, test_list_add_items)
 	zassert_equal(us->type, USER_SETTINGS_TYPE_BOOL,
 		      "User setting should have type set correctly");
 	zassert_equal(us->max_size, 1, "User setting should have max_size set correctly");
-	zassert_not_null(us->data, "User setting should have allocated data");
+	zassert_is_null(us->data, "Data should only be allocated once a value is stored");
 	zassert_equal(us->data_len, 0, "Data length should be zero since it was not set yet");
 	zassert_false(us->is_set, "Data should not be marked set");
 	zassert_not_null(us->default_data, "User setting should have allocated default data");
@@ -50,7 +50,7 @@ ZTEST(user_settings_list_suite, test_list_add_items)
 	zassert_equal(us->type, USER_SETTINGS_TYPE_U16,
 		      "User setting should have type set correctly");
 	zassert_equal(us->max_size, 2, "User setting should have max_size set correctly");
-	zassert_not_null(us->data, "User setting should have allocated data");
+	zassert_is_null(us->data, "Data should only be allocated once a value is stored");
 	zassert_equal(us->data_len, 0, "Data length should be zero since it was not set yet");
 	zassert_false(us->is_set, "Data should not be marked set");
 	zassert_not_null(us->default_data, "User setting should have allocated default data");
@@ -67,7 +67,7 @@ ZTEST(user_settings_list_suite, test_list_add_items)
 	zassert_equal(us->type, USER_SETTINGS_TYPE_U32,
 		      "User setting should have type set correctly");
 	zassert_equal(us->max_size, 4, "User setting should have max_size set correctly");
-	zassert_not_null(us->data, "User setting should have allocated data");
+	zassert_is_null(us->data, "Data should only be allocated once a value is stored");
 	zassert_equal(us->data_len, 0, "Data length should be zero since it was not set yet");
 	zassert_false(us->is_set, "Data should not be marked set");
 	zassert_not_null(us->default_data, "User setting should have allocated default data");
@@ -84,7 +84,7 @@ ZTEST(user_settings_list_suite, test_list_add_items)
 	zassert_equal(us->type, USER_SETTINGS_TYPE_STR,
 		      "User setting should have type set correctly");
 	zassert_equal(us->max_size, 10, "User setting should have max_size set correctly");
-	zassert_not_null(us->data, "User setting should have allocated data");
+	zassert_is_null(us->data, "Data should only be allocated once a value is stored");
 	zassert_equal(us->data_len, 0, "Data length should be zero since it was not set yet");
 	zassert_false(us->is_set, "Data should not be marked set");
 	zassert_not_null(us->default_data, "User setting should have allocated default data");
@@ -94,6 +94,46 @@ ZTEST(user_settings_list_suite, test_list_add_items)
 	zassert_is_null(us->on_change_cb, "on change callback should not be set");
 }
 
+ZTEST(user_settings_list_suite, test_list_add_items_with_default)
+{
+	static const uint32_t default_u32 = 1234;
+	static const char default_str[] = "abc";
+	struct user_setting *us;
+
+	us = user_settings_list_add_fixed_size_with_default(1, "t1", USER_SETTINGS_TYPE_U32,
+							    &default_u32, sizeof(default_u32));
+
+	zassert_not_null(us, "User setting should be returned");
+	zassert_equal(us->max_size, 4, "User setting should have max_size set correctly");
+	zassert_is_null(us->data, "Data should only be allocated once a value is stored");
+	zassert_equal_ptr(us->default_data, &default_u32,
+			  "Default data should point to the compile-time default");
+	zassert_is_null(us->default_buf, "No space should be allocated for the default");
+	zassert_equal(us->default_data_len, sizeof(default_u32),
+		      "default data length should be set correctly");
+	zassert_true(us->default_is_set, "default data should be marked set");
+
+	us = user_settings_list_add_variable_size_with_default(2, "t2", USER_SETTINGS_TYPE_STR, 10,
+							       default_str, sizeof(default_str));
+
+	zassert_not_null(us, "User setting should be returned");
+	zassert_equal(us->max_size, 10, "User setting should have max_size set correctly");
+	zassert_equal_ptr(us->default_data, default_str,
+			  "Default data should point to the compile-time default");
+	zassert_is_null(us->default_buf, "No space should be allocated for the default");
+	zassert_true(us->default_is_set, "default data should be marked set");
+
+	/* space for the value is allocated once a value is stored, and can be freed again */
+	zassert_ok(user_settings_list_data_alloc(us), "Allocation should succeed");
+	zassert_not_null(us->data, "Space for the value should be allocated");
+	user_settings_list_data_free(us);
+	zassert_is_null(us->data, "Space for the value should be freed");
+
+	/* space is allocated once the default is overridden */
+	zassert_ok(user_settings_list_default_buf_alloc(us), "Allocation should succeed");
+	zassert_not_null(us->default_buf, "Space for the default should be allocated");
+}
+
 ZTEST(user_settings_list_suite, test_list_add_repeated_ids_will_assert)
 {
 	user_settings_list_add_fixed_size(1, "t1", USER_SETTINGS_TYPE_BOOL);